@@ -20,6 +20,7 @@
 #include <memory.h>
 #include <stddef.h>
 #include <string.h>
+#include <atomic>
 #include <memory>
 #include <string>
 #include "base/raw_buffer.h"
@@ -124,15 +125,30 @@ inline int Slice::compare(const Slice &b) const {
     return r;
 }
 
+// The count of the references of a managed buffer, which is shared by the
+// slices of several threads so it is atomic
+struct SliceRefCount {
+    explicit SliceRefCount(bool header) : cnt(1), is_header(header) {}
+    std::atomic<int32_t> cnt;
+    // the count is the header of the buffer allocated by
+    // RefCountedSlice::Allocate, so they are freed together
+    bool is_header;
+};
+
 class RefCountedSlice : public Slice {
  public:
     ~RefCountedSlice();
 
-    // Create slice own the buffer
+    // Create slice own the buffer, which must be allocated by malloc
     inline static RefCountedSlice CreateManaged(int8_t *buf, size_t size) {
         return RefCountedSlice(buf, size, true);
     }
 
+    // Create slice own a new buffer of `size` bytes, the count of the
+    // references is allocated with the buffer as its header. Return an empty
+    // slice if it fails to allocate
+    static RefCountedSlice Allocate(size_t size);
+
     // Create slice without ownership
     inline static RefCountedSlice Create(int8_t *buf, size_t size) {
         return RefCountedSlice(buf, size, false);
@@ -153,16 +169,20 @@ class RefCountedSlice : public Slice {
  private:
     RefCountedSlice(int8_t *data, size_t size, bool managed)
         : Slice(reinterpret_cast<const char *>(data), size),
-          ref_cnt_(managed ? new int(1) : nullptr) {}
+          ref_cnt_(managed ? new SliceRefCount(false) : nullptr) {}
 
     RefCountedSlice(const char *data, size_t size, bool managed)
-        : Slice(data, size), ref_cnt_(managed ? new int(1) : nullptr) {}
+        : Slice(data, size),
+          ref_cnt_(managed ? new SliceRefCount(false) : nullptr) {}
+
+    RefCountedSlice(const char *data, size_t size, SliceRefCount *ref_cnt)
+        : Slice(data, size), ref_cnt_(ref_cnt) {}
 
     void Release();
 
     void Update(const RefCountedSlice &slice);
 
-    int32_t *ref_cnt_;
+    SliceRefCount *ref_cnt_;
 };
 
 }  // namespace base
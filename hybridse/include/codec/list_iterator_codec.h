@@ -17,9 +17,11 @@
 #ifndef HYBRIDSE_INCLUDE_CODEC_LIST_ITERATOR_CODEC_H_
 #define HYBRIDSE_INCLUDE_CODEC_LIST_ITERATOR_CODEC_H_
 #include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 #include "base/fe_object.h"
@@ -44,6 +46,55 @@ class ColumnImpl;
 template <class V>
 class ColumnIterator;
 
+template <class V>
+class ColumnarIterator;
+
+/// \brief The contiguous values of one fixed width column of a row list,
+/// in the same order as the rows of the list
+struct ColumnarArray {
+    uint32_t col_idx = 0;
+    uint32_t offset = 0;
+    uint32_t value_size = 0;
+    // `value_size` bytes for each row, the bytes of a null value are undefined
+    std::vector<int8_t> values;
+    // 1 if the value of the row is null
+    std::vector<int8_t> nulls;
+    // the keys of the rows, owned by the row list
+    const std::vector<uint64_t> *keys = nullptr;
+
+    uint64_t GetCount() const { return nulls.size(); }
+};
+
+/// \brief A row list which also keeps some fixed width columns of its rows
+/// in contiguous arrays, so the aggregations over these columns need not
+/// decode the rows one by one
+class ColumnarList {
+ public:
+    virtual ~ColumnarList() {}
+    /// Return the array of the column `col_idx` at `offset` of the slice
+    /// `row_idx`, or nullptr if the column is not kept
+    virtual const ColumnarArray *GetColumnarArray(int32_t row_idx,
+                                                  uint32_t col_idx,
+                                                  uint32_t offset) = 0;
+};
+
+/// \brief The row iterator of a storage which keeps some fixed width
+/// columns of the rows in contiguous arrays besides the encoded rows
+class ColumnarRowIterator : public RowIterator {
+ public:
+    /// Append the kept columns of `cnt` rows from the first row whose key is
+    /// not greater than `key`, in the order of the iteration. Return false if
+    /// the columns are not kept or the storage has been changed since the
+    /// iterator is created
+    virtual bool AppendColumnar(uint64_t key, uint64_t cnt,
+                                std::vector<ColumnarArray> *arrays) = 0;
+
+    /// Append the kept columns of a row which is not from the storage but has
+    /// the same schema, e.g. the request row
+    virtual bool AppendColumnar(const Row &row,
+                                std::vector<ColumnarArray> *arrays) = 0;
+};
+
 
 template <class V, class R>
 class WrapListImpl : public ListV<V> {
@@ -65,7 +116,18 @@ class ColumnImpl : public WrapListImpl<V, Row> {
           root_(impl),
           row_idx_(row_idx),
           col_idx_(col_idx),
-          offset_(offset) {}
+          offset_(offset),
+          columnar_(nullptr) {}
+
+    // iterate over the contiguous values of `columnar` instead of the rows
+    ColumnImpl(ListV<Row> *impl, int32_t row_idx, uint32_t col_idx,
+               uint32_t offset, const ColumnarArray *columnar)
+        : WrapListImpl<V, Row>(),
+          root_(impl),
+          row_idx_(row_idx),
+          col_idx_(col_idx),
+          offset_(offset),
+          columnar_(columnar) {}
 
     ~ColumnImpl() override {}
 
@@ -94,15 +156,42 @@ class ColumnImpl : public WrapListImpl<V, Row> {
 
     // TODO(xxx): iterator of nullable V
     std::unique_ptr<ConstIterator<uint64_t, V>> GetIterator() override {
-        auto iter = std::unique_ptr<ConstIterator<uint64_t, V>>(
-            new ColumnIterator<V>(root_, this));
-        return std::move(iter);
+        return std::unique_ptr<ConstIterator<uint64_t, V>>(GetRawIterator());
     }
     ConstIterator<uint64_t, V> *GetRawIterator() override {
+        if (columnar_ != nullptr) {
+            return new ColumnarIterator<V>(columnar_);
+        }
         return new ColumnIterator<V>(root_, this);
     }
-    const uint64_t GetCount() override { return root_->GetCount(); }
-    V At(uint64_t pos) override { return GetFieldUnsafe(root_->At(pos)); }
+    const uint64_t GetCount() override {
+        return columnar_ != nullptr ? columnar_->GetCount()
+                                    : root_->GetCount();
+    }
+    V At(uint64_t pos) override {
+        if (columnar_ != nullptr) {
+            return pos < columnar_->GetCount()
+                       ? reinterpret_cast<const V *>(
+                             columnar_->values.data())[pos]
+                       : V();
+        }
+        return GetFieldUnsafe(root_->At(pos));
+    }
+
+    bool GetContiguous(const V **values, const int8_t **nulls,
+                       uint64_t *count) override {
+        if (columnar_ == nullptr) {
+            return false;
+        }
+        *values = reinterpret_cast<const V *>(columnar_->values.data());
+        *count = columnar_->GetCount();
+        // the columns of a nullable schema rarely hold a null, so skip the
+        // bitmap if they do not
+        *nulls = std::memchr(columnar_->nulls.data(), 1, *count) == nullptr
+                     ? nullptr
+                     : columnar_->nulls.data();
+        return true;
+    }
 
     ListV<Row> *root() const override { return root_; }
 
@@ -111,6 +200,7 @@ class ColumnImpl : public WrapListImpl<V, Row> {
     const uint32_t row_idx_;
     const uint32_t col_idx_;
     const uint32_t offset_;
+    const ColumnarArray *columnar_;
 };
 
 class StringColumnImpl : public ColumnImpl<StringRef> {
@@ -181,6 +271,19 @@ class ArrayListV : public ListV<V> {
     }
     virtual const uint64_t GetCount() { return end_ - start_; }
     virtual V At(uint64_t pos) const { return buffer_->at(start_ + pos); }
+    bool GetContiguous(const V **values, const int8_t **nulls,
+                       uint64_t *count) override {
+        // std::vector<bool> and the vector of structs are not plain arrays
+        if constexpr (std::is_arithmetic<V>::value &&
+                      !std::is_same<V, bool>::value) {
+            *values = buffer_->data() + start_;
+            *nulls = nullptr;
+            *count = end_ - start_;
+            return true;
+        } else {
+            return false;
+        }
+    }
 
  protected:
     uint64_t start_;
@@ -493,6 +596,37 @@ class ColumnIterator : public ConstIterator<uint64_t, V> {
     V value_;
 };
 
+template <class V>
+class ColumnarIterator : public ConstIterator<uint64_t, V> {
+ public:
+    explicit ColumnarIterator(const ColumnarArray *array)
+        : ConstIterator<uint64_t, V>(),
+          values_(reinterpret_cast<const V *>(array->values.data())),
+          keys_(array->keys->data()),
+          count_(array->GetCount()),
+          pos_(0) {}
+    ~ColumnarIterator() {}
+    // the keys are in desc order as the rows of a window
+    void Seek(const uint64_t &key) override {
+        pos_ = 0;
+        while (pos_ < count_ && keys_[pos_] > key) {
+            pos_++;
+        }
+    }
+    void SeekToFirst() override { pos_ = 0; }
+    bool Valid() const override { return pos_ < count_; }
+    void Next() override { pos_++; }
+    const V &GetValue() override { return values_[pos_]; }
+    const uint64_t &GetKey() const override { return keys_[pos_]; }
+    bool IsSeekable() const override { return true; }
+
+ private:
+    const V *values_;
+    const uint64_t *keys_;
+    const uint64_t count_;
+    uint64_t pos_;
+};
+
 }  // namespace codec
 }  // namespace hybridse
 
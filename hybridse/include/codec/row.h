@@ -23,6 +23,7 @@
 #include <unordered_map>
 #include <utility>
 #include <vector>
+#include "absl/container/inlined_vector.h"
 #include "base/fe_slice.h"
 #include "base/raw_buffer.h"
 #include "proto/fe_type.pb.h"
@@ -38,6 +39,9 @@ class Row {
     Row();
     explicit Row(const std::string &str);
     Row(const Row &s);
+    Row(Row &&s) = default;
+    Row &operator=(const Row &s) = default;
+    Row &operator=(Row &&s) = default;
     explicit Row(size_t major_slices, const Row &major, size_t secondary_slices,
         const Row &secondary);
     explicit Row(const hybridse::base::RefCountedSlice &s, size_t secondary_slices,
@@ -92,11 +96,14 @@ class Row {
     }
 
  private:
-    void Append(const std::vector<hybridse::base::RefCountedSlice> &slices);
+    // the secondary slices of the rows of up to 4 slices are kept in the row
+    typedef absl::InlinedVector<RefCountedSlice, 3> Slices;
+
+    void Append(const Slices &slices);
     void Append(const Row &b);
 
     RefCountedSlice slice_;
-    std::vector<RefCountedSlice> slices_;
+    Slices slices_;
 };
 
 }  // namespace codec
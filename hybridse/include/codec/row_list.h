@@ -61,6 +61,18 @@ class ListV {
         }
         return iter->Valid() ? iter->GetValue() : V();
     }
+
+    /// \brief Return the values in a contiguous buffer, in the order of the
+    /// iterator, if the list keeps them so
+    ///
+    /// `nulls` is set to nullptr if no value is null, otherwise to a byte per
+    /// value which is 1 if the value is null. Return false if the values are
+    /// not contiguous, then the caller should traverse the list with the
+    /// iterator.
+    virtual bool GetContiguous(const V **values, const int8_t **nulls,
+                               uint64_t *count) {
+        return false;
+    }
 };
 }  // namespace codec
 }  // namespace hybridse
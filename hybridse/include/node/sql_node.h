@@ -2605,6 +2605,11 @@ class UdafDefNode : public FnDefNode {
 
     bool AllowMerge() const { return merge_ != nullptr; }
 
+    // name of the external function folding contiguous input lists into the
+    // state at once, empty if the udaf does not provide one
+    const std::string &vectorized_update() const { return vectorized_update_; }
+    void set_vectorized_update(const std::string &fname) { vectorized_update_ = fname; }
+
     base::Status Validate(const std::vector<const TypeNode *> &arg_types) const override;
 
     const TypeNode *GetElementType(size_t i) const;
@@ -2653,6 +2658,7 @@ class UdafDefNode : public FnDefNode {
     FnDefNode *update_;
     FnDefNode *merge_;
     FnDefNode *output_;
+    std::string vectorized_update_;
 };
 
 class PartitionMetaNode : public SqlNode {
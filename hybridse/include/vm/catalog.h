@@ -258,6 +258,16 @@ class TableHandler : public DataHandler {
         const std::string& index_name, const std::vector<std::string>& pks) {
         return std::shared_ptr<Tablet>();
     }
+
+    /// Set the key of the segment and the version of its rows. The version is
+    /// kept if the rows put are newer than all the rows of the segment, so
+    /// the rows read before are still valid and only the newer ones need to
+    /// be read. The rows at or before `expire_ts` are expired and not read.
+    /// Return false by default, the handler does not track the version.
+    virtual bool GetAppendVersion(std::string* key, uint64_t* version,
+                                  uint64_t* expire_ts) {
+        return false;
+    }
 };
 
 /// \brief A table dataset's error handler, representing a error table
@@ -369,6 +379,11 @@ class PartitionHandler : public TableHandler {
         return std::shared_ptr<TableHandler>();
     }
 
+    /// Fetch the segments of the keys in advance, so the following
+    /// GetSegment calls of them do not seek the partition one by one.
+    /// It is a hint and does nothing by default.
+    virtual void Prefetch(const std::vector<std::string>& keys) {}
+
     /// Return a sequence of table handles of specify segments binding to given
     /// keys set.
     virtual std::vector<std::shared_ptr<TableHandler>> GetSegments(
@@ -17,11 +17,13 @@
 #ifndef HYBRIDSE_INCLUDE_VM_ENGINE_H_
 #define HYBRIDSE_INCLUDE_VM_ENGINE_H_
 
+#include <condition_variable>  // NOLINT
 #include <map>
 #include <memory>
 #include <mutex>  //NOLINT
 #include <set>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 #include <unordered_map>
@@ -113,6 +115,41 @@ class EngineOptions {
         return enable_window_column_pruning_;
     }
 
+    /// Set the max number of the rows of the windows kept by a request union
+    /// of a sql, so the next request of a key reads the rows put after the
+    /// window only. a request agg union keeps the incremental aggregate of the
+    /// window instead of its rows. Default is `0`, which disables it.
+    inline EngineOptions* SetRequestWindowCacheRows(uint64_t rows) {
+        request_window_cache_rows_ = rows;
+        return this;
+    }
+    /// Return the max number of the rows of the windows kept by a request
+    /// union
+    inline uint64_t GetRequestWindowCacheRows() const {
+        return request_window_cache_rows_;
+    }
+
+    /// Set the number of the threads to run a window aggregation of the batch
+    /// mode, which split the partition keys. Default is `1`, which runs the
+    /// keys one by one.
+    inline EngineOptions* SetWindowAggParallelism(uint32_t parallelism) {
+        window_agg_parallelism_ = parallelism;
+        return this;
+    }
+    /// Return the number of the threads to run a window aggregation
+    inline uint32_t GetWindowAggParallelism() const {
+        return window_agg_parallelism_;
+    }
+
+    /// Set the number of the threads to sort a partition of the batch mode,
+    /// which split its segments. Default is `1`, see MemPartitionHandler::Sort
+    inline EngineOptions* SetSortParallelism(uint32_t parallelism) {
+        sort_parallelism_ = parallelism;
+        return this;
+    }
+    /// Return the number of the threads to sort a partition
+    inline uint32_t GetSortParallelism() const { return sort_parallelism_; }
+
     /// Set the maximum number of cache entries, default is `50`.
     inline void SetMaxSqlCacheSize(uint32_t size) {
         max_sql_cache_size_ = size;
@@ -120,6 +157,14 @@ class EngineOptions {
     /// Return the maximum number of entries we can hold for compiling cache.
     inline uint32_t GetMaxSqlCacheSize() const { return max_sql_cache_size_; }
 
+    /// Set the number of background threads compiling for Engine::GetAsync, default is `2`.
+    inline EngineOptions* SetCompileThreadNum(uint32_t num) {
+        compile_thread_num_ = num;
+        return this;
+    }
+    /// Return the number of background compiling threads.
+    inline uint32_t GetCompileThreadNum() const { return compile_thread_num_; }
+
     /// Return JitOptions
     inline hybridse::vm::JitOptions& jit_options() { return jit_options_; }
 
@@ -132,7 +177,11 @@ class EngineOptions {
     bool enable_expr_optimize_;
     bool enable_batch_window_parallelization_;
     bool enable_window_column_pruning_;
+    uint64_t request_window_cache_rows_;
+    uint32_t window_agg_parallelism_;
+    uint32_t sort_parallelism_;
     uint32_t max_sql_cache_size_;
+    uint32_t compile_thread_num_;
     JitOptions jit_options_;
 };
 
@@ -331,6 +380,44 @@ struct ExplainOutput {
 };
 
 
+/// \brief The result of a sql compiling which may be still in progress.
+///
+/// The callers compiling the same sql at the same time wait on one CompileFuture
+/// instead of compiling it again, and Engine::GetAsync returns one for a background compiling.
+class CompileFuture {
+ public:
+    CompileFuture() : mu_(), cv_(), done_(false), info_(), status_() {}
+
+    /// Block until the compiling finishes, return the compile information or `nullptr` if it fails.
+    std::shared_ptr<CompileInfo> Wait(base::Status* status);
+
+    /// Return `true` if the compiling has finished.
+    bool IsDone();
+
+ private:
+    void Finish(const std::shared_ptr<CompileInfo>& info, const base::Status& status);
+
+    std::mutex mu_;
+    std::condition_variable cv_;
+    bool done_;
+    std::shared_ptr<CompileInfo> info_;
+    base::Status status_;
+    friend Engine;
+};
+
+/// \brief The compile time histogram of a sql in a db.
+struct CompileTimeStats {
+    std::string db;
+    /// The hex digest of the sql string.
+    std::string sql_digest;
+    uint64_t count = 0;
+    uint64_t total_us = 0;
+    uint64_t max_us = 0;
+    /// `buckets[0]` counts the compilings faster than 1ms, `buckets[i]` the ones in [2^(i-1), 2^i) ms,
+    /// and the last bucket all the slower ones.
+    std::vector<uint64_t> buckets;
+};
+
 /// \brief An engine is responsible to compile SQL on the specific Catalog.
 ///
 /// An engine can be used to `compile sql and explain the compiling result.
@@ -361,6 +448,11 @@ class Engine {
 
     static void InitializeUnsafeRowOptFlag(bool isUnsafeRowOpt);
 
+    /// \brief Get the hit and miss counts of the jit object cache of the process
+    static void GetJitObjectCacheStats(uint64_t* hit_cnt, uint64_t* miss_cnt);
+    /// \brief Get the count of the objects removed from the jit object caches
+    static uint64_t GetJitObjectCacheEvictCount();
+
     ~Engine();
 
     /// \brief Compile sql in db and stored the results in the session
@@ -368,6 +460,17 @@ class Engine {
              RunSession& session,    // NOLINT
              base::Status& status);  // NOLINT
 
+    /// \brief Compile sql in db on the background threads of the engine.
+    ///
+    /// The compile information is cached and set into the session once the returned future is done,
+    /// so that a deployment can warm the request and batch request plans without blocking. The session
+    /// must not be used before the future is done.
+    std::shared_ptr<CompileFuture> GetAsync(const std::string& sql, const std::string& db,
+                                            std::shared_ptr<RunSession> session);
+
+    /// \brief Get the compile time histograms of the sqls compiled by the engine.
+    void GetCompileTimeStats(std::vector<CompileTimeStats>* stats);
+
     /// \brief Search all tables related to the specific sql in db.
     ///
     /// The tables' names are returned in tables
@@ -421,12 +524,24 @@ class Engine {
  private:
     bool GetDependentTables(const node::PlanNode* node, const std::string& default_db,
                             std::set<std::pair<std::string, std::string>>* db_tables, base::Status& status);  // NOLINT
-    std::shared_ptr<CompileInfo> GetCacheLocked(const std::string& db,
-                                                const std::string& sql,
-                                                EngineMode engine_mode);
-    bool SetCacheLocked(const std::string& db, const std::string& sql,
-                        EngineMode engine_mode,
-                        std::shared_ptr<CompileInfo> info);
+    class CompilePool;
+
+    // the caller must hold mu_
+    std::shared_ptr<CompileInfo> GetCache(const std::string& db,
+                                          const std::string& sql,
+                                          EngineMode engine_mode);
+    // the caller must hold mu_
+    std::pair<uint64_t, uint64_t> GetCacheVersion(const std::string& db) const;
+    // the caller must hold mu_
+    bool SetCache(const std::string& db, const std::string& sql,
+                  EngineMode engine_mode,
+                  std::shared_ptr<CompileInfo> info);
+
+    bool Compile(const std::string& sql, const std::string& db,
+                 RunSession& session,  // NOLINT
+                 std::shared_ptr<CompileInfo>* info,
+                 base::Status& status);  // NOLINT
+    void RecordCompileTime(const std::string& db, const std::string& sql, uint64_t time_us);
 
     bool IsCompatibleCache(RunSession& session,  // NOLINT
                            std::shared_ptr<CompileInfo> info,
@@ -440,6 +555,19 @@ class Engine {
     EngineOptions options_;
     base::SpinMutex mu_;
     EngineLRUCache lru_cache_;
+    // the compilings in progress, keyed by engine mode, db and sql
+    std::map<std::tuple<EngineMode, std::string, std::string>, std::shared_ptr<CompileFuture>> compiling_;
+    // increased by ClearCacheLocked of all the dbs, so the compilings started before it are not cached
+    uint64_t cache_version_;
+    // increased by ClearCacheLocked of a db, so only the compilings of that db are not cached
+    std::map<std::string, uint64_t> db_cache_versions_;
+
+    std::mutex stats_mu_;
+    std::map<std::pair<std::string, std::string>, CompileTimeStats> compile_stats_;
+
+    // destroyed first, the pending compilings use the members above
+    std::once_flag compile_pool_once_;
+    std::unique_ptr<CompilePool> compile_pool_;
 };
 
 /// \brief Local tablet is responsible to run a task locally.
@@ -101,11 +101,39 @@ class JitOptions {
     bool IsEnablePerf() const { return enable_perf_; }
     void SetEnablePerf(bool flag) { enable_perf_ = flag; }
 
+    /// The directory to persist the compiled object code, the object cache is
+    /// disabled if it is empty
+    const std::string& GetObjectCacheDir() const { return object_cache_dir_; }
+    void SetObjectCacheDir(const std::string& dir) { object_cache_dir_ = dir; }
+
+    /// The max total size of the objects in the cache directory, the least
+    /// recently used ones are removed beyond it. `0` means no limit
+    uint64_t GetObjectCacheMaxBytes() const { return object_cache_max_bytes_; }
+    void SetObjectCacheMaxBytes(uint64_t bytes) {
+        object_cache_max_bytes_ = bytes;
+    }
+
+    /// Compile the sql without optimization first, and recompile it with
+    /// aggressive optimization in background once a function gets hot. It is
+    /// only supported by the LLJIT
+    bool IsEnableTieredJit() const { return enable_tiered_jit_; }
+    void SetEnableTieredJit(bool flag) { enable_tiered_jit_ = flag; }
+
+    /// The number of calls to a function which triggers the recompiling
+    uint64_t GetTieredJitThreshold() const { return tiered_jit_threshold_; }
+    void SetTieredJitThreshold(uint64_t threshold) {
+        tiered_jit_threshold_ = threshold;
+    }
+
  private:
     bool enable_mcjit_ = false;
     bool enable_vtune_ = false;
     bool enable_gdb_ = false;
     bool enable_perf_ = false;
+    std::string object_cache_dir_;
+    uint64_t object_cache_max_bytes_ = 0;
+    bool enable_tiered_jit_ = false;
+    uint64_t tiered_jit_threshold_ = 1000;
 };
 }  // namespace vm
 }  // namespace hybridse
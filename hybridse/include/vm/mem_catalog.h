@@ -21,6 +21,7 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include <utility>
 #include <vector>
@@ -59,6 +60,13 @@ typedef std::vector<Row> MemTable;
 typedef std::map<std::string, MemTimeTable, std::greater<std::string>>
     MemSegmentMap;
 
+/// \brief Sort the rows by the keys, which keeps the order of the rows of the
+/// same key. The rows already sorted or sorted in the reverse order are
+/// detected in one pass, and a large table is sorted by a radix sort of the
+/// keys and the row indexes in a contiguous buffer instead of comparing the
+/// rows in the deque
+void SortTimeTable(MemTimeTable* table, bool is_asc);
+
 class MemTimeTableIterator : public RowIterator {
  public:
     MemTimeTableIterator(const MemTimeTable* table, const vm::Schema* schema);
@@ -239,6 +247,29 @@ class MemTimeTableHandler : public TableHandler {
     OrderType order_type_;
 };
 
+/// \brief The rows of a window which also keeps some fixed width columns
+/// of the rows in contiguous arrays. The rows must not be changed after the
+/// arrays are set
+class ColumnarTimeTableHandler : public MemTimeTableHandler,
+                                 public codec::ColumnarList {
+ public:
+    ColumnarTimeTableHandler();
+    ~ColumnarTimeTableHandler() override {}
+    /// Keep the arrays with one value for each row, return false and keep
+    /// nothing if the counts of the arrays mismatch the rows
+    bool SetColumnarArrays(std::vector<codec::ColumnarArray>&& arrays);
+    const codec::ColumnarArray* GetColumnarArray(int32_t row_idx,
+                                                 uint32_t col_idx,
+                                                 uint32_t offset) override;
+    const std::string GetHandlerTypeName() override {
+        return "ColumnarTimeTableHandler";
+    }
+
+ private:
+    std::vector<uint64_t> keys_;
+    std::vector<codec::ColumnarArray> arrays_;
+};
+
 class Window : public MemTimeTableHandler {
  public:
     enum WindowFrameType {
@@ -612,7 +643,10 @@ class MemPartitionHandler
     const std::string& GetDatabase() override;
     virtual std::unique_ptr<WindowIterator> GetWindowIterator();
     bool AddRow(const std::string& key, uint64_t ts, const Row& row);
-    void Sort(const bool is_asc);
+    /// Sort the rows of each segment. The segments of a partition of 64k rows
+    /// or more are sorted on up to `parallelism` threads, default is `1`, so
+    /// only the callers of the batch mode spawn threads.
+    void Sort(const bool is_asc, uint32_t parallelism = 1);
     void Reverse();
     void Print();
     virtual const uint64_t GetCount() { return partitions_.size(); }
@@ -635,6 +669,119 @@ class MemPartitionHandler
     IndexHint index_hint_;
     OrderType order_type_;
 };
+
+/// \brief The rows partitioned by the key like MemPartitionHandler, which
+/// finds the segment of a key by an open addressing hash table instead of an
+/// ordered map. The rows of all the segments are kept in one table grouped by
+/// the key once Finish is called, and the keys are sorted in the order of
+/// MemPartitionHandler only when the window iterator is required, so a lookup
+/// of GetSegment does not sort them. It is read only after Finish.
+class MemHashPartitionHandler
+    : public PartitionHandler,
+      public std::enable_shared_from_this<PartitionHandler> {
+ public:
+    explicit MemHashPartitionHandler(const Schema* schema);
+    ~MemHashPartitionHandler() {}
+    const Types& GetTypes() override { return types_; }
+    const IndexHint& GetIndex() override { return index_hint_; }
+    const Schema* GetSchema() override { return schema_; }
+    const std::string& GetName() override { return table_name_; }
+    const std::string& GetDatabase() override { return db_; }
+    std::unique_ptr<WindowIterator> GetWindowIterator() override;
+    void AddRow(const std::string& key, uint64_t ts, const Row& row);
+    /// Group the rows added by the key, which must be called before the rows
+    /// are read
+    void Finish();
+    const uint64_t GetCount() override { return keys_.size(); }
+    std::shared_ptr<TableHandler> GetSegment(const std::string& key) override;
+    void SetOrderType(const OrderType order_type) { order_type_ = order_type; }
+    const OrderType GetOrderType() const override { return order_type_; }
+    const std::string GetHandlerTypeName() override {
+        return "MemHashPartitionHandler";
+    }
+
+    /// Return the index of the segment of the key, or -1 if it is missing
+    int64_t FindSegment(const std::string& key) const;
+    const std::string& GetSegmentKey(uint32_t segment) const {
+        return keys_[segment];
+    }
+    RowIterator* NewSegmentIterator(uint32_t segment) const;
+    /// Return the segments in the descending order of the keys
+    const std::vector<uint32_t>& GetSortedSegments();
+
+ private:
+    uint32_t FindOrAddSegment(const std::string& key);
+    void Grow();
+
+    const std::string table_name_;
+    const std::string db_;
+    const Schema* schema_;
+    Types types_;
+    IndexHint index_hint_;
+    OrderType order_type_;
+
+    std::vector<std::string> keys_;
+    std::vector<uint64_t> hashes_;
+    // the index of the segment + 1 in a slot, 0 if the slot is empty
+    std::vector<uint32_t> slots_;
+    // the segments of the rows before Finish
+    std::vector<uint32_t> row_segments_;
+    // the rows of the segment i are in [offsets_[i], offsets_[i + 1]) after
+    // Finish
+    MemTimeTable rows_;
+    std::vector<uint32_t> offsets_;
+    std::once_flag sort_once_;
+    std::vector<uint32_t> sorted_segments_;
+};
+
+/// \brief The segment of a key of a MemHashPartitionHandler
+class MemHashSegmentHandler : public TableHandler {
+ public:
+    MemHashSegmentHandler(
+        std::shared_ptr<MemHashPartitionHandler> partition_handler,
+        int64_t segment)
+        : partition_handler_(partition_handler), segment_(segment) {}
+    ~MemHashSegmentHandler() {}
+    const Schema* GetSchema() override {
+        return partition_handler_->GetSchema();
+    }
+    const std::string& GetName() override {
+        return partition_handler_->GetName();
+    }
+    const std::string& GetDatabase() override {
+        return partition_handler_->GetDatabase();
+    }
+    const Types& GetTypes() override { return partition_handler_->GetTypes(); }
+    const IndexHint& GetIndex() override {
+        return partition_handler_->GetIndex();
+    }
+    const OrderType GetOrderType() const override {
+        return partition_handler_->GetOrderType();
+    }
+    std::unique_ptr<RowIterator> GetIterator() override {
+        return std::unique_ptr<RowIterator>(GetRawIterator());
+    }
+    RowIterator* GetRawIterator() override {
+        return segment_ < 0
+                   ? nullptr
+                   : partition_handler_->NewSegmentIterator(segment_);
+    }
+    std::unique_ptr<WindowIterator> GetWindowIterator(
+        const std::string& idx_name) override {
+        LOG(WARNING) << "SegmentHandler can't support window iterator";
+        return std::unique_ptr<WindowIterator>();
+    }
+    const uint64_t GetCount() override;
+    Row At(uint64_t pos) override;
+    const std::string GetHandlerTypeName() override {
+        return "MemHashSegmentHandler";
+    }
+
+ private:
+    std::shared_ptr<MemHashPartitionHandler> partition_handler_;
+    int64_t segment_;
+};
+
 class ConcatTableHandler : public MemTimeTableHandler {
  public:
     ConcatTableHandler(std::shared_ptr<TableHandler> left, size_t left_slices,
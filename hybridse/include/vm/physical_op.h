@@ -16,6 +16,8 @@
 
 #ifndef HYBRIDSE_INCLUDE_VM_PHYSICAL_OP_H_
 #define HYBRIDSE_INCLUDE_VM_PHYSICAL_OP_H_
+#include <atomic>
+#include <functional>
 #include <list>
 #include <memory>
 #include <set>
@@ -67,6 +69,54 @@ enum PhysicalOpType {
 enum PhysicalSchemaType { kSchemaTypeTable, kSchemaTypeRow, kSchemaTypeGroup };
 absl::string_view PhysicalOpTypeName(PhysicalOpType type);
 
+/**
+ * The address of a jit function shared by a FnInfo and the generators built
+ * from it, so that a tiered jit can replace it with the address of a better
+ * optimized function while the runners are calling it.
+ */
+class FnAddress {
+ public:
+    FnAddress() : ptr_(nullptr), hot_threshold_(0), calls_(0), on_hot_() {}
+    explicit FnAddress(const int8_t *ptr)
+        : ptr_(ptr), hot_threshold_(0), calls_(0), on_hot_() {}
+
+    /// Return the function address, counting the call if it is watched
+    const int8_t *Get() const {
+        if (hot_threshold_.load(std::memory_order_relaxed) > 0) {
+            CountCall();
+        }
+        return ptr_.load(std::memory_order_acquire);
+    }
+    /// Return the function address without counting the call
+    const int8_t *Peek() const {
+        return ptr_.load(std::memory_order_acquire);
+    }
+    void Set(const int8_t *ptr) { ptr_.store(ptr, std::memory_order_release); }
+
+    /// Call `on_hot` once when the function has been called `threshold` times,
+    /// it should be set before the function is called
+    void WatchCalls(uint64_t threshold, std::function<void()> on_hot) {
+        on_hot_ = std::move(on_hot);
+        hot_threshold_.store(threshold, std::memory_order_release);
+    }
+
+ private:
+    void CountCall() const {
+        uint64_t threshold = hot_threshold_.load(std::memory_order_acquire);
+        if (threshold > 0 &&
+            calls_.fetch_add(1, std::memory_order_relaxed) + 1 == threshold) {
+            // stop counting, the later calls only read the address
+            hot_threshold_.store(0, std::memory_order_relaxed);
+            on_hot_();
+        }
+    }
+
+    std::atomic<const int8_t *> ptr_;
+    mutable std::atomic<uint64_t> hot_threshold_;
+    mutable std::atomic<uint64_t> calls_;
+    std::function<void()> on_hot_;
+};
+
 /**
  * Function codegen information for physical node. It should
  * provide full information to generate execution code.
@@ -100,6 +150,13 @@ class FnInfo {
         primary_frame_ = frame;
     }
 
+    // the batch version of the function, which runs it on a batch of rows
+    // per call, see codegen::BatchFnIRBuilder
+    const std::string &batch_fn_name() const { return batch_fn_name_; }
+    void SetBatchFn(const std::string &batch_fn_name) {
+        batch_fn_name_ = batch_fn_name;
+    }
+
     void Clear() {
         fn_name_ = "";
         fn_schema_.Clear();
@@ -107,7 +164,9 @@ class FnInfo {
         primary_frame_ = nullptr;
         frames_.clear();
         schemas_ctx_ = nullptr;
-        fn_ptr_ = nullptr;
+        fn_ptr_->Set(nullptr);
+        batch_fn_name_ = "";
+        batch_fn_ptr_->Set(nullptr);
     }
 
     const node::FrameNode *GetFrame(size_t idx) const {
@@ -119,9 +178,40 @@ class FnInfo {
     const node::FrameNode *GetPrimaryFrame() const { return primary_frame_; }
 
     FnInfo() = default;
+    // a copy never shares the address with the origin
+    FnInfo(const FnInfo &other)
+        : fn_name_(other.fn_name_),
+          fn_schema_(other.fn_schema_),
+          fn_def_(other.fn_def_),
+          primary_frame_(other.primary_frame_),
+          frames_(other.frames_),
+          schemas_ctx_(other.schemas_ctx_),
+          fn_ptr_(std::make_shared<FnAddress>(other.fn_ptr_->Peek())),
+          batch_fn_name_(other.batch_fn_name_),
+          batch_fn_ptr_(
+              std::make_shared<FnAddress>(other.batch_fn_ptr_->Peek())) {}
+    FnInfo &operator=(const FnInfo &other) {
+        if (this != &other) {
+            fn_name_ = other.fn_name_;
+            fn_schema_ = other.fn_schema_;
+            fn_def_ = other.fn_def_;
+            primary_frame_ = other.primary_frame_;
+            frames_ = other.frames_;
+            schemas_ctx_ = other.schemas_ctx_;
+            fn_ptr_ = std::make_shared<FnAddress>(other.fn_ptr_->Peek());
+            batch_fn_name_ = other.batch_fn_name_;
+            batch_fn_ptr_ =
+                std::make_shared<FnAddress>(other.batch_fn_ptr_->Peek());
+        }
+        return *this;
+    }
 
-    const int8_t *fn_ptr() const { return fn_ptr_; }
-    void SetFnPtr(const int8_t *fn) { fn_ptr_ = fn; }
+    const int8_t *fn_ptr() const { return fn_ptr_->Get(); }
+    void SetFnPtr(const int8_t *fn) { fn_ptr_->Set(fn); }
+    const std::shared_ptr<FnAddress> &fn_address() const { return fn_ptr_; }
+    const std::shared_ptr<FnAddress> &batch_fn_address() const {
+        return batch_fn_ptr_;
+    }
 
  private:
     std::string fn_name_ = "";
@@ -138,7 +228,11 @@ class FnInfo {
     const SchemasContext *schemas_ctx_ = nullptr;
 
     // function ptr
-    const int8_t *fn_ptr_ = nullptr;
+    std::shared_ptr<FnAddress> fn_ptr_ = std::make_shared<FnAddress>();
+
+    // batch function, empty if the function is only called row by row
+    std::string batch_fn_name_ = "";
+    std::shared_ptr<FnAddress> batch_fn_ptr_ = std::make_shared<FnAddress>();
 };
 
 class FnComponent {
@@ -681,6 +775,7 @@ class PhysicalProjectNode : public PhysicalUnaryNode {
                                  PhysicalOpNode **out) override;
 
     const ColumnProjects &project() const { return project_; }
+    ColumnProjects *mutable_project() { return &project_; }
     const ProjectType project_type_;
 
  protected:
@@ -747,6 +842,7 @@ class PhysicalSimpleProjectNode : public PhysicalUnaryNode {
     static PhysicalSimpleProjectNode *CastFrom(PhysicalOpNode *node);
 
     const ColumnProjects &project() const { return project_; }
+    ColumnProjects *mutable_project() { return &project_; }
 
     base::Status WithNewChildren(node::NodeManager *nm,
                                  const std::vector<PhysicalOpNode *> &children,
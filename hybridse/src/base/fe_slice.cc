@@ -16,19 +16,41 @@
 
 #include "base/fe_slice.h"
 
+#include <cstddef>
+#include <new>
+
 namespace hybridse {
 namespace base {
 
+// the size of the header of a buffer allocated by Allocate, which keeps the
+// buffer aligned as malloc does
+static const size_t kSliceHeaderSize =
+    (sizeof(SliceRefCount) + alignof(std::max_align_t) - 1) /
+    alignof(std::max_align_t) * alignof(std::max_align_t);
+
+RefCountedSlice RefCountedSlice::Allocate(size_t size) {
+    auto header = reinterpret_cast<char*>(malloc(kSliceHeaderSize + size));
+    if (header == nullptr) {
+        return RefCountedSlice();
+    }
+    auto ref_cnt = new (header) SliceRefCount(true);
+    return RefCountedSlice(header + kSliceHeaderSize, size, ref_cnt);
+}
+
 RefCountedSlice::~RefCountedSlice() { Release(); }
 
 void RefCountedSlice::Release() {
     if (this->ref_cnt_ != nullptr) {
-        auto& cnt = *this->ref_cnt_;
-        cnt -= 1;
-        if (cnt == 0) {
-            free(buf());
-            delete this->ref_cnt_;
+        if (this->ref_cnt_->cnt.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            if (this->ref_cnt_->is_header) {
+                this->ref_cnt_->~SliceRefCount();
+                free(this->ref_cnt_);
+            } else {
+                free(buf());
+                delete this->ref_cnt_;
+            }
         }
+        this->ref_cnt_ = nullptr;
     }
 }
 
@@ -36,7 +58,7 @@ void RefCountedSlice::Update(const RefCountedSlice& slice) {
     reset(slice.data(), slice.size());
     this->ref_cnt_ = slice.ref_cnt_;
     if (this->ref_cnt_ != nullptr) {
-        (*this->ref_cnt_) += 1;
+        this->ref_cnt_->cnt.fetch_add(1, std::memory_order_relaxed);
     }
 }
 
@@ -44,8 +66,10 @@ RefCountedSlice::RefCountedSlice(const RefCountedSlice& slice) {
     this->Update(slice);
 }
 
-RefCountedSlice::RefCountedSlice(RefCountedSlice&& slice) {
-    this->Update(slice);
+// take the reference of the slice instead of counting a new one
+RefCountedSlice::RefCountedSlice(RefCountedSlice&& slice)
+    : Slice(slice.data(), slice.size()), ref_cnt_(slice.ref_cnt_) {
+    slice.ref_cnt_ = nullptr;
 }
 
 RefCountedSlice& RefCountedSlice::operator=(const RefCountedSlice& slice) {
@@ -62,7 +86,9 @@ RefCountedSlice& RefCountedSlice::operator=(RefCountedSlice&& slice) {
         return *this;
     }
     this->Release();
-    this->Update(slice);
+    reset(slice.data(), slice.size());
+    this->ref_cnt_ = slice.ref_cnt_;
+    slice.ref_cnt_ = nullptr;
     return *this;
 }
 
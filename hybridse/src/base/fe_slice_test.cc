@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 #include "base/fe_slice.h"
 #include "gtest/gtest.h"
 
@@ -46,6 +49,41 @@ TEST_F(SliceTest, ref_cnt_slice) {
     ASSERT_EQ(0, strcmp(reinterpret_cast<char*>(ref.buf()), "hello world"));
 }
 
+TEST_F(SliceTest, allocate_slice) {
+    RefCountedSlice ref;
+    {
+        auto slice = RefCountedSlice::Allocate(1024);
+        ASSERT_TRUE(slice.buf() != nullptr);
+        ASSERT_EQ(1024u, slice.size());
+        ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(slice.buf()) %
+                          alignof(std::max_align_t));
+        strcpy(reinterpret_cast<char*>(slice.buf()), "hello world");  // NOLINT
+        ref = slice;
+    }
+    ASSERT_EQ(0, strcmp(reinterpret_cast<char*>(ref.buf()), "hello world"));
+
+    // the moved slice keeps the reference
+    RefCountedSlice moved(std::move(ref));
+    ASSERT_EQ(0, strcmp(reinterpret_cast<char*>(moved.buf()), "hello world"));
+}
+
+TEST_F(SliceTest, share_slice_by_threads) {
+    auto slice = RefCountedSlice::Allocate(16);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([&slice]() {
+            for (int k = 0; k < 100000; k++) {
+                RefCountedSlice copy = slice;
+                ASSERT_EQ(16u, copy.size());
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(16u, slice.size());
+}
+
 }  // namespace base
 }  // namespace hybridse
 
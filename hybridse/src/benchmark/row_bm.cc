@@ -0,0 +1,81 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include "benchmark/benchmark.h"
+#include "codec/row.h"
+
+namespace hybridse {
+namespace bm {
+
+static const size_t kRowSize = 128;
+
+// a row of range(0) bytes by malloc and a separate count of the references
+static void BM_NewManagedRow(benchmark::State& state) {  // NOLINT
+    for (auto _ : state) {
+        auto buf = reinterpret_cast<int8_t*>(malloc(state.range(0)));
+        memset(buf, 0, state.range(0));
+        codec::Row row(base::RefCountedSlice::CreateManaged(buf, state.range(0)));
+        benchmark::DoNotOptimize(row.buf());
+    }
+}
+
+// a row of range(0) bytes with the count of the references in its header
+static void BM_NewAllocatedRow(benchmark::State& state) {  // NOLINT
+    for (auto _ : state) {
+        auto slice = base::RefCountedSlice::Allocate(state.range(0));
+        memset(slice.buf(), 0, state.range(0));
+        codec::Row row(slice);
+        benchmark::DoNotOptimize(row.buf());
+    }
+}
+
+// copy a row of range(0) slices, the rows of up to 4 slices keep the slices
+// inline
+static void BM_CopyRow(benchmark::State& state) {  // NOLINT
+    codec::Row row(base::RefCountedSlice::Allocate(kRowSize));
+    for (int64_t i = 1; i < state.range(0); i++) {
+        row.Append(base::RefCountedSlice::Allocate(kRowSize));
+    }
+    for (auto _ : state) {
+        codec::Row copy(row);
+        benchmark::DoNotOptimize(copy.buf());
+    }
+}
+
+// join two rows of range(0) slices
+static void BM_JoinRow(benchmark::State& state) {  // NOLINT
+    codec::Row left(base::RefCountedSlice::Allocate(kRowSize));
+    codec::Row right(base::RefCountedSlice::Allocate(kRowSize));
+    for (int64_t i = 1; i < state.range(0); i++) {
+        left.Append(base::RefCountedSlice::Allocate(kRowSize));
+        right.Append(base::RefCountedSlice::Allocate(kRowSize));
+    }
+    for (auto _ : state) {
+        codec::Row row(state.range(0), left, state.range(0), right);
+        benchmark::DoNotOptimize(row.buf());
+    }
+}
+
+BENCHMARK(BM_NewManagedRow)->Arg(64)->Arg(1024);
+BENCHMARK(BM_NewAllocatedRow)->Arg(64)->Arg(1024);
+BENCHMARK(BM_CopyRow)->Arg(1)->Arg(2)->Arg(4)->Arg(8);
+BENCHMARK(BM_JoinRow)->Arg(1)->Arg(2)->Arg(4);
+}  // namespace bm
+}  // namespace hybridse
+
+BENCHMARK_MAIN();
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "vm/mem_catalog.h"
+
+namespace hybridse {
+namespace bm {
+
+enum SortInput { kRandomInput = 0, kSortedInput = 1, kReversedInput = 2 };
+
+// the timestamps of range(0) rows in the order of range(1), all the rows share
+// one buffer like the rows of a window
+static vm::MemTimeTable BuildTimeTable(int64_t rows_cnt, int64_t input) {
+    static const char buf[64] = {0};
+    codec::Row row(base::RefCountedSlice::Create(buf, sizeof(buf)));
+    std::mt19937_64 rand(42);
+    std::uniform_int_distribution<uint64_t> dist(1576571615000,
+                                                 1576571615000 + 1000000000);
+    std::vector<uint64_t> keys(rows_cnt);
+    for (auto& key : keys) {
+        key = dist(rand);
+    }
+    if (kSortedInput == input) {
+        std::sort(keys.begin(), keys.end());
+    } else if (kReversedInput == input) {
+        std::sort(keys.begin(), keys.end(), std::greater<uint64_t>());
+    }
+    vm::MemTimeTable table;
+    for (auto key : keys) {
+        table.push_back(std::make_pair(key, row));
+    }
+    return table;
+}
+
+// range(2) is 0 for std::sort, 1 for SortTimeTable
+static void BM_SortTimeTable(benchmark::State& state) {  // NOLINT
+    auto input = BuildTimeTable(state.range(0), state.range(1));
+    bool use_kernel = state.range(2) != 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        vm::MemTimeTable table = input;
+        state.ResumeTiming();
+        if (use_kernel) {
+            vm::SortTimeTable(&table, true);
+        } else {
+            std::sort(table.begin(), table.end(), vm::AscComparor());
+        }
+        benchmark::DoNotOptimize(table.front());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void SortArgs(benchmark::internal::Benchmark* b) {
+    for (int64_t rows_cnt : {1000, 10000, 100000, 1000000, 10000000}) {
+        for (int64_t input : {kRandomInput, kSortedInput, kReversedInput}) {
+            for (int64_t use_kernel : {0, 1}) {
+                b->Args({rows_cnt, input, use_kernel});
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_SortTimeTable)->Apply(SortArgs)->Unit(benchmark::kMicrosecond);
+}  // namespace bm
+}  // namespace hybridse
+
+BENCHMARK_MAIN();
@@ -41,6 +41,25 @@ static void BM_ArraySumColDouble(benchmark::State& state) {  // NOLINT
     SumArrayListCol(&state, BENCHMARK, state.range(0), "col4");
 }
 
+static void BM_VectorizedSumInt(benchmark::State& state) {  // NOLINT
+    SumIntArrayList(&state, BENCHMARK, state.range(0), true);
+}
+static void BM_ScalarSumInt(benchmark::State& state) {  // NOLINT
+    SumIntArrayList(&state, BENCHMARK, state.range(0), false);
+}
+static void BM_VectorizedSumDouble(benchmark::State& state) {  // NOLINT
+    SumDoubleArrayList(&state, BENCHMARK, state.range(0), true);
+}
+static void BM_ScalarSumDouble(benchmark::State& state) {  // NOLINT
+    SumDoubleArrayList(&state, BENCHMARK, state.range(0), false);
+}
+static void BM_VectorizedSumWhereInt(benchmark::State& state) {  // NOLINT
+    SumWhereIntArrayList(&state, BENCHMARK, state.range(0), true);
+}
+static void BM_ScalarSumWhereInt(benchmark::State& state) {  // NOLINT
+    SumWhereIntArrayList(&state, BENCHMARK, state.range(0), false);
+}
+
 static void BM_CopyMemSegment(benchmark::State& state) {  // NOLINT
     CopyMemSegment(&state, BENCHMARK, state.range(0));
 }
@@ -123,6 +142,13 @@ BENCHMARK(BM_ArraySumColDouble)
     ->Args({100})
     ->Args({1000})
     ->Args({10000});
+BENCHMARK(BM_VectorizedSumInt)->Args({100})->Args({1000})->Args({10000});
+BENCHMARK(BM_ScalarSumInt)->Args({100})->Args({1000})->Args({10000});
+BENCHMARK(BM_VectorizedSumDouble)->Args({100})->Args({1000})->Args({10000});
+BENCHMARK(BM_ScalarSumDouble)->Args({100})->Args({1000})->Args({10000});
+BENCHMARK(BM_VectorizedSumWhereInt)->Args({100})->Args({1000})->Args({10000});
+BENCHMARK(BM_ScalarSumWhereInt)->Args({100})->Args({1000})->Args({10000});
+
 BENCHMARK(BM_RequestUnionSumColDouble)
     ->Args({10})
     ->Args({100})
@@ -23,11 +23,15 @@
 #include "codec/type_codec.h"
 #include "codegen/ir_base_builder.h"
 #include "codegen/window_ir_builder.h"
+#include "gflags/gflags.h"
 #include "gtest/gtest.h"
 #include "udf/udf.h"
 #include "udf/udf_test.h"
 #include "vm/jit_runtime.h"
 #include "vm/mem_catalog.h"
+
+DECLARE_bool(enable_vectorized_udaf);
+
 namespace hybridse {
 namespace bm {
 using codec::ColumnImpl;
@@ -687,5 +691,63 @@ void RequestUnionWindowExcludeCurrentTime(benchmark::State* state, MODE mode,
         }
     }
 }
+template <typename V>
+void RunContiguousListUdaf(benchmark::State* state, MODE mode,
+                           int64_t data_size, bool vectorized, bool where) {
+    std::vector<V> values;
+    std::vector<int> conds;
+    V expect = 0;
+    for (int64_t i = 0; i < data_size; ++i) {
+        values.push_back(static_cast<V>(i % 100));
+        conds.push_back(i % 2);
+        if (!where || i % 2 == 1) {
+            expect += static_cast<V>(i % 100);
+        }
+    }
+    codec::ArrayListV<V> list(&values);
+    codec::ListRef<V> list_ref;
+    list_ref.list = reinterpret_cast<int8_t*>(&list);
+    codec::BoolArrayListV cond_list(&conds);
+    codec::ListRef<bool> cond_ref;
+    cond_ref.list = reinterpret_cast<int8_t*>(&cond_list);
+
+    FLAGS_enable_vectorized_udaf = vectorized;
+    auto sum = CreateSumFunc<V>();
+    auto sum_where = udf::UdfFunctionBuilder("sum_where")
+                         .args<codec::ListRef<V>, codec::ListRef<bool>>()
+                         .template returns<V>()
+                         .build();
+    switch (mode) {
+        case BENCHMARK: {
+            for (auto _ : *state) {
+                if (where) {
+                    benchmark::DoNotOptimize(sum_where(list_ref, cond_ref));
+                } else {
+                    benchmark::DoNotOptimize(sum(list_ref));
+                }
+            }
+            break;
+        }
+        case TEST: {
+            ASSERT_EQ(expect,
+                      where ? sum_where(list_ref, cond_ref) : sum(list_ref));
+            break;
+        }
+    }
+    FLAGS_enable_vectorized_udaf = true;
+}
+
+void SumIntArrayList(benchmark::State* state, MODE mode, int64_t data_size,
+                     bool vectorized) {
+    RunContiguousListUdaf<int32_t>(state, mode, data_size, vectorized, false);
+}
+void SumDoubleArrayList(benchmark::State* state, MODE mode, int64_t data_size,
+                        bool vectorized) {
+    RunContiguousListUdaf<double>(state, mode, data_size, vectorized, false);
+}
+void SumWhereIntArrayList(benchmark::State* state, MODE mode,
+                          int64_t data_size, bool vectorized) {
+    RunContiguousListUdaf<int32_t>(state, mode, data_size, vectorized, true);
+}
 }  // namespace bm
 }  // namespace hybridse
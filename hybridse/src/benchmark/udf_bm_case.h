@@ -28,6 +28,13 @@ void SumRequestUnionTableCol(benchmark::State* state, MODE mode,
                              int64_t data_size, const std::string& col_name);
 void SumArrayListCol(benchmark::State* state, MODE mode, int64_t data_size,
                      const std::string& col_name);
+// udafs over contiguous lists, with or without the vectorized update
+void SumIntArrayList(benchmark::State* state, MODE mode, int64_t data_size,
+                     bool vectorized);
+void SumDoubleArrayList(benchmark::State* state, MODE mode, int64_t data_size,
+                        bool vectorized);
+void SumWhereIntArrayList(benchmark::State* state, MODE mode,
+                          int64_t data_size, bool vectorized);
 void CopyMemTable(benchmark::State* state, MODE mode, int64_t data_size);
 void CopyMemSegment(benchmark::State* state, MODE mode, int64_t data_size);
 void CopyArrayList(benchmark::State* state, MODE mode, int64_t data_size);
@@ -31,6 +31,14 @@ TEST_F(UdfBMCaseTest, SumArrayListCol1_TEST) {
     SumArrayListCol(nullptr, TEST, 10000L, "col1");
 }
 
+TEST_F(UdfBMCaseTest, SumContiguousList_TEST) {
+    for (bool vectorized : {true, false}) {
+        SumIntArrayList(nullptr, TEST, 1000L, vectorized);
+        SumDoubleArrayList(nullptr, TEST, 1000L, vectorized);
+        SumWhereIntArrayList(nullptr, TEST, 1000L, vectorized);
+    }
+}
+
 TEST_F(UdfBMCaseTest, SumMemTableCol1_TEST) {
     SumMemTableCol(nullptr, TEST, 10L, "col1");
     SumMemTableCol(nullptr, TEST, 100L, "col1");
@@ -279,6 +279,29 @@ int32_t GetStrCol(int8_t* input, int32_t row_idx, uint32_t col_idx,
     return 0;
 }
 
+// the contiguous values of the column if the list keeps it, or nullptr
+static const ColumnarArray* FindColumnarArray(ListV<Row>* w, int32_t row_idx,
+                                              uint32_t col_idx, int32_t offset,
+                                              uint32_t value_size) {
+    auto columnar_list = dynamic_cast<ColumnarList*>(w);
+    if (columnar_list == nullptr) {
+        return nullptr;
+    }
+    auto array = columnar_list->GetColumnarArray(row_idx, col_idx, offset);
+    if (array == nullptr || array->value_size != value_size) {
+        return nullptr;
+    }
+    return array;
+}
+
+template <class V>
+static void NewColumn(ListV<Row>* w, int32_t row_idx, uint32_t col_idx,
+                      int32_t offset, int8_t* data) {
+    new (data) ColumnImpl<V>(
+        w, row_idx, col_idx, offset,
+        FindColumnarArray(w, row_idx, col_idx, offset, sizeof(V)));
+}
+
 int32_t GetCol(int8_t* input, int32_t row_idx, uint32_t col_idx, int32_t offset,
                int32_t type_id, int8_t* data) {
     hybridse::type::Type type = static_cast<hybridse::type::Type>(type_id);
@@ -289,36 +312,36 @@ int32_t GetCol(int8_t* input, int32_t row_idx, uint32_t col_idx, int32_t offset,
     ListV<Row>* w = reinterpret_cast<ListV<Row>*>(w_ref->list);
     switch (type) {
         case hybridse::type::kInt32: {
-            new (data) ColumnImpl<int>(w, row_idx, col_idx, offset);
+            NewColumn<int>(w, row_idx, col_idx, offset, data);
             break;
         }
         case hybridse::type::kInt16: {
-            new (data) ColumnImpl<int16_t>(w, row_idx, col_idx, offset);
+            NewColumn<int16_t>(w, row_idx, col_idx, offset, data);
             break;
         }
         case hybridse::type::kInt64: {
-            new (data) ColumnImpl<int64_t>(w, row_idx, col_idx, offset);
+            NewColumn<int64_t>(w, row_idx, col_idx, offset, data);
             break;
         }
         case hybridse::type::kFloat: {
-            new (data) ColumnImpl<float>(w, row_idx, col_idx, offset);
+            NewColumn<float>(w, row_idx, col_idx, offset, data);
             break;
         }
         case hybridse::type::kDouble: {
-            new (data) ColumnImpl<double>(w, row_idx, col_idx, offset);
+            NewColumn<double>(w, row_idx, col_idx, offset, data);
             break;
         }
         case hybridse::type::kTimestamp: {
-            new (data)
-                ColumnImpl<openmldb::base::Timestamp>(w, row_idx, col_idx, offset);
+            NewColumn<openmldb::base::Timestamp>(w, row_idx, col_idx, offset,
+                                                 data);
             break;
         }
         case hybridse::type::kDate: {
-            new (data) ColumnImpl<openmldb::base::Date>(w, row_idx, col_idx, offset);
+            NewColumn<openmldb::base::Date>(w, row_idx, col_idx, offset, data);
             break;
         }
         case hybridse::type::kBool: {
-            new (data) ColumnImpl<bool>(w, row_idx, col_idx, offset);
+            NewColumn<bool>(w, row_idx, col_idx, offset, data);
             break;
         }
         default: {
@@ -331,6 +354,23 @@ int32_t GetCol(int8_t* input, int32_t row_idx, uint32_t col_idx, int32_t offset,
     return 0;
 }
 
+int64_t GetColumnar(int8_t* input, int32_t row_idx, uint32_t col_idx,
+                    int32_t offset, int32_t value_size, int8_t** values,
+                    int8_t** nulls) {
+    if (nullptr == input || nullptr == values || nullptr == nulls) {
+        return -1;
+    }
+    ListRef<>* w_ref = reinterpret_cast<ListRef<>*>(input);
+    ListV<Row>* w = reinterpret_cast<ListV<Row>*>(w_ref->list);
+    auto array = FindColumnarArray(w, row_idx, col_idx, offset, value_size);
+    if (array == nullptr) {
+        return -1;
+    }
+    *values = const_cast<int8_t*>(array->values.data());
+    *nulls = const_cast<int8_t*>(array->nulls.data());
+    return array->GetCount();
+}
+
 int32_t GetInnerRangeList(int8_t* input, int64_t start_key,
                           int64_t start_offset, int64_t end_offset,
                           int8_t* data) {
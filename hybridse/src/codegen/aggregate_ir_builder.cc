@@ -589,6 +589,62 @@ base::Status ScheduleAggGenerators(
     return base::Status::OK();
 }
 
+bool AggregateIRBuilder::BuildGetColumnar(
+    ::llvm::IRBuilder<>* builder, ::llvm::Value* window_ptr,
+    std::unordered_map<std::string, std::pair<::llvm::Value*, ::llvm::Value*>>*
+        arrays,
+    ::llvm::Value** cnt, ::llvm::Value** is_columnar) {
+    auto row_format = schema_context_->GetRowFormat();
+    if (row_format == nullptr || agg_col_infos_.empty()) {
+        return false;
+    }
+    auto i32_ty = builder->getInt32Ty();
+    auto ptr_ty = builder->getInt8PtrTy();
+    auto get_columnar_func = module_->getOrInsertFunction(
+        "hybridse_storage_get_columnar",
+        ::llvm::FunctionType::get(
+            builder->getInt64Ty(),
+            {ptr_ty, i32_ty, i32_ty, i32_ty, i32_ty, ptr_ty->getPointerTo(),
+             ptr_ty->getPointerTo()},
+            false));
+    ::llvm::Value* all_kept = builder->getInt1(true);
+    for (auto& pair : agg_col_infos_) {
+        auto& info = pair.second;
+        const codec::ColInfo* col_info =
+            row_format->GetColumnInfo(info.schema_idx, info.col_idx);
+        ::llvm::Type* field_ty = nullptr;
+        // the arrays keep the numbers of 2, 4 or 8 bytes only
+        if (col_info == nullptr ||
+            !GetLlvmType(module_, info.col_type, &field_ty) ||
+            !(field_ty->isIntegerTy() || field_ty->isFloatingPointTy()) ||
+            field_ty->getPrimitiveSizeInBits() < 16) {
+            return false;
+        }
+        size_t slice_idx = row_format->GetSliceId(info.schema_idx);
+        ::llvm::Value* values_ptr =
+            CreateAllocaAtHead(builder, ptr_ty, "columnar_values");
+        ::llvm::Value* nulls_ptr =
+            CreateAllocaAtHead(builder, ptr_ty, "columnar_nulls");
+        ::llvm::Value* col_cnt = builder->CreateCall(
+            get_columnar_func,
+            {window_ptr, builder->getInt32(slice_idx),
+             builder->getInt32(col_info->idx), builder->getInt32(info.offset),
+             builder->getInt32(field_ty->getPrimitiveSizeInBits() / 8),
+             values_ptr, nulls_ptr});
+        all_kept = builder->CreateAnd(
+            all_kept,
+            builder->CreateICmpSGE(col_cnt, builder->getInt64(0)));
+        // all the arrays of a window have the same count
+        *cnt = col_cnt;
+        (*arrays)[info.GetColKey()] = {
+            builder->CreatePointerCast(builder->CreateLoad(values_ptr),
+                                       field_ty->getPointerTo()),
+            builder->CreateLoad(nulls_ptr)};
+    }
+    *is_columnar = all_kept;
+    return true;
+}
+
 base::Status AggregateIRBuilder::BuildMulti(const std::string& base_funcname,
                                     ExprIRBuilder* expr_ir_builder,
                                     VariableIRBuilder* variable_ir_builder,
@@ -644,7 +700,64 @@ base::Status AggregateIRBuilder::BuildMulti(const std::string& base_funcname,
     ::llvm::Value* input_arg = fn->arg_begin();
     ::llvm::Value* output_arg = fn->arg_begin() + 1;
 
+    ::llvm::BasicBlock* row_iter_block =
+        ::llvm::BasicBlock::Create(llvm_ctx, "row_iter", fn);
+    ::llvm::BasicBlock* output_block =
+        ::llvm::BasicBlock::Create(llvm_ctx, "output", fn);
+
+    // iterate over the column arrays instead of decoding the rows if the
+    // window keeps all the aggregated columns
+    std::unordered_map<std::string, std::pair<::llvm::Value*, ::llvm::Value*>>
+        columnar_arrays;
+    ::llvm::Value* columnar_cnt = nullptr;
+    ::llvm::Value* is_columnar = nullptr;
+    if (BuildGetColumnar(&builder, input_arg, &columnar_arrays, &columnar_cnt,
+                         &is_columnar)) {
+        ::llvm::BasicBlock* columnar_enter_block =
+            ::llvm::BasicBlock::Create(llvm_ctx, "enter_columnar", fn);
+        ::llvm::BasicBlock* columnar_body_block =
+            ::llvm::BasicBlock::Create(llvm_ctx, "columnar_body", fn);
+        ::llvm::Value* pos_ptr =
+            CreateAllocaAtHead(&builder, int64_ty, "columnar_pos");
+        builder.CreateStore(::llvm::ConstantInt::get(int64_ty, 0, true),
+                            pos_ptr);
+        builder.CreateCondBr(is_columnar, columnar_enter_block,
+                             row_iter_block);
+
+        builder.SetInsertPoint(columnar_enter_block);
+        ::llvm::Value* pos = builder.CreateLoad(pos_ptr);
+        builder.CreateCondBr(builder.CreateICmpSLT(pos, columnar_cnt),
+                             columnar_body_block, output_block);
+
+        builder.SetInsertPoint(columnar_body_block);
+        for (auto& agg_generator : generators) {
+            std::vector<::llvm::Value*> fields;
+            std::vector<::llvm::Value*> fields_is_null;
+            for (auto& key : agg_generator.GetColKeys()) {
+                auto iter = columnar_arrays.find(key);
+                CHECK_TRUE(iter != columnar_arrays.end(),
+                           common::kCodegenUdafError,
+                           "Fail to find column array of ", key)
+                ::llvm::Value* values = iter->second.first;
+                fields.push_back(builder.CreateLoad(builder.CreateInBoundsGEP(
+                    values->getType()->getPointerElementType(), values, pos)));
+                fields_is_null.push_back(builder.CreateICmpNE(
+                    builder.CreateLoad(builder.CreateInBoundsGEP(
+                        builder.getInt8Ty(), iter->second.second, pos)),
+                    builder.getInt8(0)));
+            }
+            agg_generator.GenUpdate(&builder, fields, fields_is_null);
+        }
+        builder.CreateStore(
+            builder.CreateAdd(pos, ::llvm::ConstantInt::get(int64_ty, 1, true)),
+            pos_ptr);
+        builder.CreateBr(columnar_enter_block);
+    } else {
+        builder.CreateBr(row_iter_block);
+    }
+
     // on stack unique pointer
+    builder.SetInsertPoint(row_iter_block);
     size_t iter_bytes = sizeof(std::unique_ptr<codec::RowIterator>);
     ::llvm::Value* iter_ptr = CreateAllocaAtHead(
         &builder, ::llvm::Type::getInt8Ty(llvm_ctx), "row_iter",
@@ -747,11 +860,13 @@ base::Status AggregateIRBuilder::BuildMulti(const std::string& base_funcname,
         "hybridse_storage_row_iter_delete",
         ::llvm::FunctionType::get(void_ty, {ptr_ty}, false));
     builder.CreateCall(delete_iter_func, {iter_ptr});
+    builder.CreateBr(output_block);
 
     // store results to output row
+    builder.SetInsertPoint(output_block);
     std::map<uint32_t, NativeValue> dummy_map;
     BufNativeEncoderIRBuilder output_encoder(&dummy_map, &output_schema,
-                                             exit_block);
+                                             output_block);
     for (auto& agg_generator : generators) {
         std::vector<std::pair<size_t, NativeValue>> outputs;
         agg_generator.GenOutputs(&builder, &outputs);
@@ -104,6 +104,16 @@ class AggregateIRBuilder {
     bool empty() const { return agg_col_infos_.empty(); }
 
  private:
+    // get the values and null flags arrays of the aggregated columns from
+    // the window, `is_columnar` is false at runtime if the window does not
+    // keep any of them. return false if the columns can not be read from
+    // arrays at all
+    bool BuildGetColumnar(
+        ::llvm::IRBuilder<>* builder, ::llvm::Value* window_ptr,
+        std::unordered_map<std::string,
+                           std::pair<::llvm::Value*, ::llvm::Value*>>* arrays,
+        ::llvm::Value** cnt, ::llvm::Value** is_columnar);
+
     const vm::SchemasContext* schema_context_;
     ::llvm::Module* module_;
     const node::FrameNode* frame_node_;
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "codegen/batch_fn_ir_builder.h"
+
+#include <vector>
+
+#include "glog/logging.h"
+#include "llvm/IR/IRBuilder.h"
+
+using ::hybridse::common::kCodegenError;
+
+namespace hybridse {
+namespace codegen {
+
+BatchFnIRBuilder::BatchFnIRBuilder(CodeGenContext* ctx) : ctx_(ctx) {}
+BatchFnIRBuilder::~BatchFnIRBuilder() {}
+
+Status BatchFnIRBuilder::Build(const std::string& name,
+                               const std::string& row_fn_name) {
+    ::llvm::Module* module = ctx_->GetModule();
+    ::llvm::LLVMContext& llvm_ctx = module->getContext();
+    CHECK_TRUE(module->getFunction(name) == nullptr, kCodegenError,
+               "function ", name, " already exists");
+    ::llvm::Function* row_fn = module->getFunction(row_fn_name);
+    CHECK_TRUE(row_fn != nullptr && row_fn->arg_size() == 5, kCodegenError,
+               "row function ", row_fn_name, " not found");
+
+    ::llvm::Type* i32_ty = ::llvm::Type::getInt32Ty(llvm_ctx);
+    ::llvm::Type* i64_ty = ::llvm::Type::getInt64Ty(llvm_ctx);
+    ::llvm::Type* ptr_ty = ::llvm::Type::getInt8PtrTy(llvm_ctx);
+    ::llvm::Type* ptr_ptr_ty = ptr_ty->getPointerTo();
+    std::vector<::llvm::Type*> args_llvm_type = {i32_ty, ptr_ptr_ty, ptr_ty,
+                                                 ptr_ptr_ty};
+    ::llvm::FunctionType* fnt =
+        ::llvm::FunctionType::get(i32_ty, args_llvm_type, false);
+    ::llvm::Function* fn = ::llvm::Function::Create(
+        fnt, ::llvm::Function::ExternalLinkage, name, module);
+    CHECK_TRUE(fn != nullptr, kCodegenError, "Fail to create fn with name ",
+               name);
+    auto arg_iter = fn->arg_begin();
+    ::llvm::Value* rows_cnt = &*arg_iter++;
+    ::llvm::Value* rows = &*arg_iter++;
+    ::llvm::Value* parameter = &*arg_iter++;
+    ::llvm::Value* outputs = &*arg_iter++;
+
+    auto entry_block = ::llvm::BasicBlock::Create(llvm_ctx, "entry", fn);
+    auto loop_block = ::llvm::BasicBlock::Create(llvm_ctx, "loop", fn);
+    auto next_block = ::llvm::BasicBlock::Create(llvm_ctx, "next", fn);
+    auto fail_block = ::llvm::BasicBlock::Create(llvm_ctx, "fail", fn);
+    auto exit_block = ::llvm::BasicBlock::Create(llvm_ctx, "exit", fn);
+
+    ::llvm::IRBuilder<> builder(entry_block);
+    ::llvm::Value* zero = builder.getInt32(0);
+    builder.CreateCondBr(builder.CreateICmpSGT(rows_cnt, zero), loop_block,
+                         exit_block);
+
+    // outputs[i] = row_fn(0, rows[i], nullptr, parameter)
+    builder.SetInsertPoint(loop_block);
+    ::llvm::PHINode* idx = builder.CreatePHI(i32_ty, 2);
+    idx->addIncoming(zero, entry_block);
+    ::llvm::Value* row = builder.CreateLoad(
+        ptr_ty, builder.CreateInBoundsGEP(ptr_ty, rows, idx));
+    ::llvm::Value* output = builder.CreateInBoundsGEP(ptr_ty, outputs, idx);
+    ::llvm::Value* ret = builder.CreateCall(
+        row_fn, {::llvm::ConstantInt::get(i64_ty, 0), row,
+                 ::llvm::ConstantPointerNull::get(
+                     ::llvm::cast<::llvm::PointerType>(ptr_ty)),
+                 parameter, output});
+    builder.CreateCondBr(builder.CreateICmpEQ(ret, zero), next_block,
+                         fail_block);
+
+    builder.SetInsertPoint(next_block);
+    ::llvm::Value* next_idx = builder.CreateAdd(idx, builder.getInt32(1));
+    idx->addIncoming(next_idx, next_block);
+    builder.CreateCondBr(builder.CreateICmpSLT(next_idx, rows_cnt), loop_block,
+                         exit_block);
+
+    builder.SetInsertPoint(fail_block);
+    builder.CreateRet(ret);
+
+    builder.SetInsertPoint(exit_block);
+    builder.CreateRet(zero);
+    return Status::OK();
+}
+
+}  // namespace codegen
+}  // namespace hybridse
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_SRC_CODEGEN_BATCH_FN_IR_BUILDER_H_
+#define HYBRIDSE_SRC_CODEGEN_BATCH_FN_IR_BUILDER_H_
+
+#include <string>
+
+#include "base/fe_status.h"
+#include "codegen/context.h"
+
+namespace hybridse {
+namespace codegen {
+
+using hybridse::base::Status;
+
+// Build the batch version of a row function built by RowFnLetIRBuilder:
+//
+//   int32_t batch_fn(int32_t n, int8_t** rows, int8_t* parameter,
+//                    int8_t** outputs)
+//
+// it calls the row function on rows[0, n) and writes the output buffer of
+// rows[i] into outputs[i], so a table is projected or filtered with one call
+// per batch and the row function can be inlined into the loop. it returns
+// the first non-zero code of the row function, the outputs of the rows after
+// the failed one are left untouched.
+class BatchFnIRBuilder {
+ public:
+    explicit BatchFnIRBuilder(CodeGenContext* ctx);
+
+    ~BatchFnIRBuilder();
+
+    Status Build(const std::string& name, const std::string& row_fn_name);
+
+ private:
+    CodeGenContext* ctx_;
+};
+
+}  // namespace codegen
+}  // namespace hybridse
+#endif  // HYBRIDSE_SRC_CODEGEN_BATCH_FN_IR_BUILDER_H_
@@ -535,6 +535,70 @@ Status UdfIRBuilder::BuildDynamicUdfCall(
     return BuildLlvmCall(fn, callee, arg_types, arg_nullable, new_args, fn->return_by_arg(), output);
 }
 
+Status UdfIRBuilder::BuildVectorizedUpdate(
+    const node::UdafDefNode* fn, const std::vector<::llvm::Value*>& list_ptrs,
+    const std::vector<::llvm::Value*>& states, ::llvm::IRBuilder<>* builder,
+    ::llvm::Value** ok) {
+    *ok = nullptr;
+    const std::string& fname = fn->vectorized_update();
+    if (fname.empty()) {
+        return Status::OK();
+    }
+    // the lists of nullable elements keep the values with their null flags,
+    // which are never contiguous. the nulls of a column list are passed as
+    // a bitmap by GetContiguous instead
+    for (size_t i = 0; i < fn->GetArgSize(); ++i) {
+        if (fn->IsElementNullable(i)) {
+            return Status::OK();
+        }
+    }
+    for (auto state : states) {
+        if (TypeIRBuilder::IsStructPtr(state->getType())) {
+            return Status::OK();
+        }
+    }
+
+    auto i8_ty = builder->getInt8Ty();
+    auto i8_ptr_ty = builder->getInt8PtrTy();
+    std::vector<::llvm::Type*> arg_tys;
+    std::vector<::llvm::Value*> call_args;
+    for (auto list_ptr : list_ptrs) {
+        arg_tys.push_back(i8_ptr_ty);
+        call_args.push_back(builder->CreatePointerCast(list_ptr, i8_ptr_ty));
+    }
+    // the bool states are passed as bytes, since the bits beyond the first
+    // one of an i1 in memory are unspecified
+    std::vector<::llvm::Value*> byte_states(states.size(), nullptr);
+    for (size_t i = 0; i < states.size(); ++i) {
+        auto state_ty = states[i]->getType()->getPointerElementType();
+        if (state_ty->isIntegerTy(1)) {
+            byte_states[i] =
+                CreateAllocaAtHead(builder, i8_ty, "vectorized_state");
+            builder->CreateStore(
+                builder->CreateZExt(builder->CreateLoad(states[i]), i8_ty),
+                byte_states[i]);
+            arg_tys.push_back(i8_ty->getPointerTo());
+            call_args.push_back(byte_states[i]);
+        } else {
+            arg_tys.push_back(states[i]->getType());
+            call_args.push_back(states[i]);
+        }
+    }
+    auto callee = ctx_->GetModule()->getOrInsertFunction(
+        fname,
+        ::llvm::FunctionType::get(builder->getInt1Ty(), arg_tys, false));
+    *ok = builder->CreateCall(callee, call_args);
+    for (size_t i = 0; i < states.size(); ++i) {
+        if (byte_states[i] != nullptr) {
+            builder->CreateStore(
+                builder->CreateICmpNE(builder->CreateLoad(byte_states[i]),
+                                      builder->getInt8(0)),
+                states[i]);
+        }
+    }
+    return Status::OK();
+}
+
 Status UdfIRBuilder::BuildUdafCall(
     const node::UdafDefNode* fn,
     const std::vector<NativeValue>& args, NativeValue* output) {
@@ -628,88 +692,99 @@ Status UdfIRBuilder::BuildUdafCall(
         }
     }
 
-    CHECK_STATUS(ctx_->CreateWhile(
-        [&](::llvm::Value** has_next) {
-            // enter
-            auto enter_block = ctx_->GetCurrentBlock();
-            builder.SetInsertPoint(enter_block);
-            ListIRBuilder iter_enter_builder(enter_block, nullptr);
-            for (size_t i = 0; i < input_num; ++i) {
-                ::llvm::Value* cur_has_next = nullptr;
-                CHECK_STATUS(iter_enter_builder.BuildIteratorHasNext(
-                                 iterators[i], elem_types[i], &cur_has_next),
-                             status.str());
-                if (*has_next == nullptr) {
-                    *has_next = cur_has_next;
-                } else {
-                    *has_next = builder.CreateAnd(cur_has_next, *has_next);
+    ::llvm::Value* vectorized_ok = nullptr;
+    CHECK_STATUS(BuildVectorizedUpdate(fn, list_ptrs, states_storage, &builder,
+                                       &vectorized_ok));
+
+    std::function<Status()> iterate = [&]() {
+        return ctx_->CreateWhile(
+            [&](::llvm::Value** has_next) {
+                // enter
+                auto enter_block = ctx_->GetCurrentBlock();
+                builder.SetInsertPoint(enter_block);
+                ListIRBuilder iter_enter_builder(enter_block, nullptr);
+                for (size_t i = 0; i < input_num; ++i) {
+                    ::llvm::Value* cur_has_next = nullptr;
+                    CHECK_STATUS(iter_enter_builder.BuildIteratorHasNext(
+                                     iterators[i], elem_types[i], &cur_has_next),
+                                 status.str());
+                    if (*has_next == nullptr) {
+                        *has_next = cur_has_next;
+                    } else {
+                        *has_next = builder.CreateAnd(cur_has_next, *has_next);
+                    }
                 }
-            }
-            return Status::OK();
-        },
-        [&]() {
-            // iter body
-            auto body_begin_block = ctx_->GetCurrentBlock();
-            ListIRBuilder iter_next_builder(body_begin_block, nullptr);
-            UdfIRBuilder sub_udf_builder(ctx_, frame_arg_, frame_);
-
-            std::vector<NativeValue> cur_state_values;
-            std::vector<NativeValue> update_args;
-            for (size_t i = 0; i < state_num; ++i) {
-                if (TypeIRBuilder::IsStructPtr(states_storage[i]->getType())) {
-                    cur_state_values.push_back(
-                        NativeValue::Create(states_storage[i]));
+                return Status::OK();
+            },
+            [&]() {
+                // iter body
+                auto body_begin_block = ctx_->GetCurrentBlock();
+                ListIRBuilder iter_next_builder(body_begin_block, nullptr);
+                UdfIRBuilder sub_udf_builder(ctx_, frame_arg_, frame_);
+
+                std::vector<NativeValue> cur_state_values;
+                std::vector<NativeValue> update_args;
+                for (size_t i = 0; i < state_num; ++i) {
+                    if (TypeIRBuilder::IsStructPtr(states_storage[i]->getType())) {
+                        cur_state_values.push_back(
+                            NativeValue::Create(states_storage[i]));
+                    } else {
+                        auto load_raw =
+                            ctx_->GetBuilder()->CreateLoad(states_storage[i]);
+                        cur_state_values.push_back(NativeValue::Create(load_raw));
+                    }
+                }
+                if (state_num > 1) {
+                    update_args.push_back(
+                        NativeValue::CreateTuple(cur_state_values));
                 } else {
-                    auto load_raw =
-                        ctx_->GetBuilder()->CreateLoad(states_storage[i]);
-                    cur_state_values.push_back(NativeValue::Create(load_raw));
+                    update_args.push_back(cur_state_values[0]);
+                }
+                for (size_t i = 0; i < input_num; ++i) {
+                    NativeValue next_val;
+                    CHECK_STATUS(iter_next_builder.BuildIteratorNext(
+                        iterators[i], elem_types[i], elem_nullable[i], &next_val));
+                    update_args.push_back(next_val);
                 }
-            }
-            if (state_num > 1) {
-                update_args.push_back(
-                    NativeValue::CreateTuple(cur_state_values));
-            } else {
-                update_args.push_back(cur_state_values[0]);
-            }
-            for (size_t i = 0; i < input_num; ++i) {
-                NativeValue next_val;
-                CHECK_STATUS(iter_next_builder.BuildIteratorNext(
-                    iterators[i], elem_types[i], elem_nullable[i], &next_val));
-                update_args.push_back(next_val);
-            }
 
-            NativeValue update_value;
-            std::vector<const node::TypeNode*> update_arg_types;
-            update_arg_types.push_back(state_type);
-            for (size_t i = 0; i < input_num; ++i) {
-                update_arg_types.push_back(elem_types[i]);
-            }
-            CHECK_TRUE(fn->update_func() != nullptr, kCodegenError);
-            CHECK_STATUS(sub_udf_builder.BuildCall(fn->update_func(),
-                                                   update_arg_types,
-                                                   update_args, &update_value));
-
-            builder.SetInsertPoint(ctx_->GetCurrentBlock());
-            if (update_value.IsTuple()) {
-                CHECK_TRUE(update_value.GetFieldNum() == state_num,
-                           kCodegenError);
-                for (size_t i = 0; i < state_num; ++i) {
-                    NativeValue sub = update_value.GetField(i);
-                    ::llvm::Value* raw_update = sub.GetValue(ctx_);
+                NativeValue update_value;
+                std::vector<const node::TypeNode*> update_arg_types;
+                update_arg_types.push_back(state_type);
+                for (size_t i = 0; i < input_num; ++i) {
+                    update_arg_types.push_back(elem_types[i]);
+                }
+                CHECK_TRUE(fn->update_func() != nullptr, kCodegenError);
+                CHECK_STATUS(sub_udf_builder.BuildCall(
+                    fn->update_func(), update_arg_types, update_args,
+                    &update_value));
+
+                builder.SetInsertPoint(ctx_->GetCurrentBlock());
+                if (update_value.IsTuple()) {
+                    CHECK_TRUE(update_value.GetFieldNum() == state_num,
+                               kCodegenError);
+                    for (size_t i = 0; i < state_num; ++i) {
+                        NativeValue sub = update_value.GetField(i);
+                        ::llvm::Value* raw_update = sub.GetValue(ctx_);
+                        if (TypeIRBuilder::IsStructPtr(raw_update->getType())) {
+                            raw_update = builder.CreateLoad(raw_update);
+                        }
+                        builder.CreateStore(raw_update, states_storage[i]);
+                    }
+                } else {
+                    ::llvm::Value* raw_update = update_value.GetValue(ctx_);
                     if (TypeIRBuilder::IsStructPtr(raw_update->getType())) {
                         raw_update = builder.CreateLoad(raw_update);
                     }
-                    builder.CreateStore(raw_update, states_storage[i]);
-                }
-            } else {
-                ::llvm::Value* raw_update = update_value.GetValue(ctx_);
-                if (TypeIRBuilder::IsStructPtr(raw_update->getType())) {
-                    raw_update = builder.CreateLoad(raw_update);
+                    builder.CreateStore(raw_update, states_storage[0]);
                 }
-                builder.CreateStore(raw_update, states_storage[0]);
-            }
-            return Status::OK();
-        }));
+                return Status::OK();
+            });
+    };
+    if (vectorized_ok != nullptr) {
+        CHECK_STATUS(ctx_->CreateBranchNot(vectorized_ok, iterate));
+    } else {
+        CHECK_STATUS(iterate());
+    }
 
     builder.SetInsertPoint(ctx_->GetCurrentBlock());
     std::vector<NativeValue> final_state_values;
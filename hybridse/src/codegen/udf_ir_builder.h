@@ -70,6 +70,15 @@ class UdfIRBuilder {
                         ::llvm::FunctionCallee* callee, bool* return_by_arg);
 
  private:
+    // Call the vectorized update of the udaf if it has one and the inputs
+    // and the states allow, `ok` is set to whether the states are updated
+    // already, or nullptr if the call is not built
+    Status BuildVectorizedUpdate(const node::UdafDefNode* fn,
+                                 const std::vector<::llvm::Value*>& list_ptrs,
+                                 const std::vector<::llvm::Value*>& states,
+                                 ::llvm::IRBuilder<>* builder,
+                                 ::llvm::Value** ok);
+
     Status ExpandLlvmCallArgs(const node::TypeNode* dtype, bool nullable,
                               const NativeValue& value,
                               ::llvm::IRBuilder<>* builder,
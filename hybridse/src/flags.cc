@@ -22,3 +22,7 @@ DEFINE_string(default_db_name, "_hybridse",
 // Offline Spark config
 DEFINE_bool(enable_spark_unsaferow_format, false,
             "config if codec uses Spark UnsafeRow format");
+
+// Udaf config
+DEFINE_bool(enable_vectorized_udaf, true,
+            "config if the builtin udafs fold contiguous values at once");
@@ -1020,8 +1020,10 @@ UdfByCodeGenDefNode* UdfByCodeGenDefNode::DeepCopy(NodeManager* nm) const {
 }
 
 UdafDefNode* UdafDefNode::ShadowCopy(NodeManager* nm) const {
-    return nm->MakeUdafDefNode(name_, arg_types_, init_expr_, update_, merge_,
-                               output_);
+    auto udaf = nm->MakeUdafDefNode(name_, arg_types_, init_expr_, update_,
+                                    merge_, output_);
+    udaf->set_vectorized_update(vectorized_update_);
+    return udaf;
 }
 
 UdafDefNode* UdafDefNode::DeepCopy(NodeManager* nm) const {
@@ -1029,8 +1031,10 @@ UdafDefNode* UdafDefNode::DeepCopy(NodeManager* nm) const {
     FnDefNode* new_update = update_ ? update_->DeepCopy(nm) : nullptr;
     FnDefNode* new_merge = merge_ ? merge_->DeepCopy(nm) : nullptr;
     FnDefNode* new_output = output_ ? output_->DeepCopy(nm) : nullptr;
-    return nm->MakeUdafDefNode(name_, arg_types_, new_init, new_update,
-                               new_merge, new_output);
+    auto udaf = nm->MakeUdafDefNode(name_, arg_types_, new_init, new_update,
+                                    new_merge, new_output);
+    udaf->set_vectorized_update(vectorized_update_);
+    return udaf;
 }
 
 // Default expr deep copy: shadow copy self and deep copy children
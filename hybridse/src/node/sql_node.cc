@@ -2407,7 +2407,8 @@ Status UdafDefNode::Validate(const std::vector<const TypeNode *> &arg_types) con
 bool UdafDefNode::Equals(const SqlNode *node) const {
     auto other = dynamic_cast<const UdafDefNode *>(node);
     return other != nullptr && init_expr_->Equals(other->init_expr()) && update_->Equals(other->update_) &&
-           FnDefEquals(merge_, other->merge_) && FnDefEquals(output_, other->output_);
+           FnDefEquals(merge_, other->merge_) && FnDefEquals(output_, other->output_) &&
+           vectorized_update_ == other->vectorized_update_;
 }
 
 void UdafDefNode::Print(std::ostream &output, const std::string &org_tab) const {
@@ -225,9 +225,11 @@ Status ExprInplaceTransformUp::VisitUdaf(
     }
 
     if (changed) {
-        *out = ctx_->node_manager()->MakeUdafDefNode(
+        auto new_udaf = ctx_->node_manager()->MakeUdafDefNode(
             udaf->GetName(), udaf->GetArgTypeList(), init, update, merge,
             output_fn);
+        new_udaf->set_vectorized_update(udaf->vectorized_update());
+        *out = new_udaf;
     } else {
         *out = udaf;
     }
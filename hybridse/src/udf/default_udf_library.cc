@@ -18,6 +18,7 @@
 
 #include <string>
 #include <tuple>
+#include <type_traits>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -29,6 +30,7 @@
 #include "udf/containers.h"
 #include "udf/udf.h"
 #include "udf/udf_registry.h"
+#include "udf/vectorized_udaf.h"
 
 using openmldb::base::Date;
 using openmldb::base::StringRef;
@@ -40,6 +42,23 @@ using hybridse::common::kCodegenError;
 namespace hybridse {
 namespace udf {
 
+// the builtin udafs over these element types fold contiguous lists at once,
+// see vectorized_udaf.h
+template <typename T>
+constexpr bool kVectorizedUdafType =
+    std::is_arithmetic<T>::value && !std::is_same<T, bool>::value;
+
+// min_where and max_where take the first kept value whatever it is, which
+// only agrees with the comparisons of the kernels if there is no NaN
+template <typename T>
+constexpr bool kVectorizedIntegralUdafType =
+    kVectorizedUdafType<T> && std::is_integral<T>::value;
+
+template <typename T>
+static std::string VectorizedUpdateName(const std::string& udaf) {
+    return udaf + ".vectorized." + DataTypeTrait<T>::to_string();
+}
+
 DefaultUdfLibrary* DefaultUdfLibrary::MakeDefaultUdf() {
     LOG(INFO) << "Creating DefaultUdfLibrary";
     return new DefaultUdfLibrary();
@@ -105,8 +124,8 @@ struct BuildGetSecondUdf {
 template <typename T>
 struct SumUdafDef {
     void operator()(UdafRegistryHelper& helper) {  // NOLINT
-        helper.templates<T, T, T>()
-            .const_init(T(0))
+        auto udaf = helper.templates<T, T, T>();
+        udaf.const_init(T(0))
             .update([](UdfResolveContext* ctx, ExprNode* cur_sum,
                        ExprNode* input) {
                 auto nm = ctx->node_manager();
@@ -116,14 +135,19 @@ struct SumUdafDef {
                 return nm->MakeCondExpr(is_null, cur_sum, new_sum);
             })
             .output("identity");
+        if constexpr (kVectorizedUdafType<T>) {
+            udaf.vectorized_update(
+                VectorizedUpdateName<T>("sum"),
+                reinterpret_cast<void*>(&v1::vectorized_sum<T>));
+        }
     }
 };
 
 template <typename T>
 struct MinUdafDef {
     void operator()(UdafRegistryHelper& helper) {  // NOLINT
-        helper.templates<T, Tuple<bool, T>, T>()
-            .const_init(MakeTuple(true, DataTypeTrait<T>::maximum_value()))
+        auto udaf = helper.templates<T, Tuple<bool, T>, T>();
+        udaf.const_init(MakeTuple(true, DataTypeTrait<T>::maximum_value()))
             .update([](UdfResolveContext* ctx, ExprNode* state,
                        ExprNode* input) {
                 auto nm = ctx->node_manager();
@@ -148,6 +172,11 @@ struct MinUdafDef {
                                      nm->MakeConstNode()),
                     cur_min);
             });
+        if constexpr (kVectorizedUdafType<T>) {
+            udaf.vectorized_update(
+                VectorizedUpdateName<T>("min"),
+                reinterpret_cast<void*>(&v1::vectorized_min<T>));
+        }
     }
 };
 
@@ -185,8 +214,8 @@ struct MinUdafDef<StringRef> {
 template <typename T>
 struct MaxUdafDef {
     void operator()(UdafRegistryHelper& helper) {  // NOLINT
-        helper.templates<T, Tuple<bool, T>, T>()
-            .const_init(MakeTuple(true, DataTypeTrait<T>::minimum_value()))
+        auto udaf = helper.templates<T, Tuple<bool, T>, T>();
+        udaf.const_init(MakeTuple(true, DataTypeTrait<T>::minimum_value()))
             .update([](UdfResolveContext* ctx, ExprNode* state,
                        ExprNode* input) {
                 auto nm = ctx->node_manager();
@@ -211,14 +240,19 @@ struct MaxUdafDef {
                                      nm->MakeConstNode()),
                     cur_max);
             });
+        if constexpr (kVectorizedUdafType<T>) {
+            udaf.vectorized_update(
+                VectorizedUpdateName<T>("max"),
+                reinterpret_cast<void*>(&v1::vectorized_max<T>));
+        }
     }
 };
 
 template <typename T>
 struct CountUdafDef {
     void operator()(UdafRegistryHelper& helper) {  // NOLINT
-        helper.templates<int64_t, int64_t, T>()
-            .const_init(0)
+        auto udaf = helper.templates<int64_t, int64_t, T>();
+        udaf.const_init(0)
             .update([](UdfResolveContext* ctx, ExprNode* cur_cnt,
                        ExprNode* input) {
                 auto nm = ctx->node_manager();
@@ -228,14 +262,19 @@ struct CountUdafDef {
                 return nm->MakeCondExpr(is_null, cur_cnt, new_cnt);
             })
             .output("identity");
+        if constexpr (kVectorizedUdafType<T>) {
+            udaf.vectorized_update(
+                VectorizedUpdateName<T>("count"),
+                reinterpret_cast<void*>(&v1::vectorized_count<T>));
+        }
     }
 };
 
 template <typename T>
 struct AvgUdafDef {
     void operator()(UdafRegistryHelper& helper) {  // NOLINT
-        helper.templates<double, Tuple<int64_t, double>, T>()
-            .const_init(MakeTuple(static_cast<int64_t>(0), 0.0))
+        auto udaf = helper.templates<double, Tuple<int64_t, double>, T>();
+        udaf.const_init(MakeTuple(static_cast<int64_t>(0), 0.0))
             .update(
                 [](UdfResolveContext* ctx, ExprNode* state, ExprNode* input) {
                     auto nm = ctx->node_manager();
@@ -258,6 +297,11 @@ struct AvgUdafDef {
                     nm->MakeBinaryExprNode(sum, cnt, node::kFnOpFDiv);
                 return avg;
             });
+        if constexpr (kVectorizedUdafType<T>) {
+            udaf.vectorized_update(
+                VectorizedUpdateName<T>("avg"),
+                reinterpret_cast<void*>(&v1::vectorized_avg<T>));
+        }
     }
 };
 
@@ -304,8 +348,8 @@ struct DistinctCountDef {
 template <typename T>
 struct SumWhereDef {
     void operator()(UdafRegistryHelper& helper) {  // NOLINT
-        helper.templates<T, T, T, bool>()
-            .const_init(0.0)
+        auto udaf = helper.templates<T, T, T, bool>();
+        udaf.const_init(0.0)
             .update([](UdfResolveContext* ctx, ExprNode* sum, ExprNode* elem,
                        ExprNode* cond) {
                 auto nm = ctx->node_manager();
@@ -318,14 +362,19 @@ struct SumWhereDef {
                 return update;
             })
             .output("identity");
+        if constexpr (kVectorizedUdafType<T>) {
+            udaf.vectorized_update(
+                VectorizedUpdateName<T>("sum_where"),
+                reinterpret_cast<void*>(&v1::vectorized_sum_where<T>));
+        }
     }
 };
 
 template <typename T>
 struct CountWhereDef {
     void operator()(UdafRegistryHelper& helper) {  // NOLINT
-        helper.templates<int64_t, int64_t, T, bool>()
-            .const_init(0)
+        auto udaf = helper.templates<int64_t, int64_t, T, bool>();
+        udaf.const_init(0)
             .update([](UdfResolveContext* ctx, ExprNode* cnt, ExprNode* elem,
                        ExprNode* cond) {
                 auto nm = ctx->node_manager();
@@ -338,14 +387,19 @@ struct CountWhereDef {
                 return update;
             })
             .output("identity");
+        if constexpr (kVectorizedUdafType<T>) {
+            udaf.vectorized_update(
+                VectorizedUpdateName<T>("count_where"),
+                reinterpret_cast<void*>(&v1::vectorized_count_where<T>));
+        }
     }
 };
 
 template <typename T>
 struct AvgWhereDef {
     void operator()(UdafRegistryHelper& helper) {  // NOLINT
-        helper.templates<double, Tuple<int64_t, double>, T, bool>()
-            .const_init(MakeTuple(static_cast<int64_t>(0), 0.0))
+        auto udaf = helper.templates<double, Tuple<int64_t, double>, T, bool>();
+        udaf.const_init(MakeTuple(static_cast<int64_t>(0), 0.0))
             .update([](UdfResolveContext* ctx, ExprNode* state, ExprNode* elem,
                        ExprNode* cond) {
                 auto nm = ctx->node_manager();
@@ -378,14 +432,19 @@ struct AvgWhereDef {
                     nm->MakeBinaryExprNode(sum, cnt, node::kFnOpFDiv);
                 return avg;
             });
+        if constexpr (kVectorizedUdafType<T>) {
+            udaf.vectorized_update(
+                VectorizedUpdateName<T>("avg_where"),
+                reinterpret_cast<void*>(&v1::vectorized_avg_where<T>));
+        }
     }
 };
 
 template <typename T>
 struct MinWhereDef {
     void operator()(UdafRegistryHelper& helper) {  // NOLINT
-        helper.templates<T, Tuple<bool, T>, T, bool>()
-            .const_init(MakeTuple(true, DataTypeTrait<T>::maximum_value()))
+        auto udaf = helper.templates<T, Tuple<bool, T>, T, bool>();
+        udaf.const_init(MakeTuple(true, DataTypeTrait<T>::maximum_value()))
             .update([](UdfResolveContext* ctx, ExprNode* acc, ExprNode* elem, ExprNode* cond) {
                 auto nm = ctx->node_manager();
                 if (elem->GetOutputType()->base() == node::kTimestamp) {
@@ -409,14 +468,19 @@ struct MinWhereDef {
                 return nm->MakeCondExpr(is_null,
                                         nm->MakeCastNode(DataTypeTrait<T>::to_type_enum(), nm->MakeConstNode()), val);
             });
+        if constexpr (kVectorizedIntegralUdafType<T>) {
+            udaf.vectorized_update(
+                VectorizedUpdateName<T>("min_where"),
+                reinterpret_cast<void*>(&v1::vectorized_min_where<T>));
+        }
     }
 };
 
 template <typename T>
 struct MaxWhereDef {
     void operator()(UdafRegistryHelper& helper) {  // NOLINT
-        helper.templates<T, Tuple<bool, T>, T, bool>()
-            .const_init(MakeTuple(true, DataTypeTrait<T>::minimum_value()))
+        auto udaf = helper.templates<T, Tuple<bool, T>, T, bool>();
+        udaf.const_init(MakeTuple(true, DataTypeTrait<T>::minimum_value()))
             .update([](UdfResolveContext* ctx, ExprNode* acc, ExprNode* elem, ExprNode* cond) {
                 auto nm = ctx->node_manager();
                 if (elem->GetOutputType()->base() == node::kTimestamp) {
@@ -440,6 +504,11 @@ struct MaxWhereDef {
                 return nm->MakeCondExpr(is_null,
                                         nm->MakeCastNode(DataTypeTrait<T>::to_type_enum(), nm->MakeConstNode()), val);
             });
+        if constexpr (kVectorizedIntegralUdafType<T>) {
+            udaf.vectorized_update(
+                VectorizedUpdateName<T>("max_where"),
+                reinterpret_cast<void*>(&v1::vectorized_max_where<T>));
+        }
     }
 };
 
@@ -14,8 +14,11 @@
  * limitations under the License.
  */
 
+#include "gflags/gflags.h"
 #include "udf/udf_test.h"
 
+DECLARE_bool(enable_vectorized_udaf);
+
 namespace hybridse {
 namespace udf {
 
@@ -840,6 +843,57 @@ TEST_F(UdafTest, top_n_key_avg_cate_where_test) {
                                MakeList<int32_t>({}), MakeList<int32_t>({}));
 }
 
+
+template <class T>
+ListRef<T> MakeRangeList(int64_t cnt) {
+    auto values = new std::vector<T>();
+    for (int64_t i = 0; i < cnt; ++i) {
+        values->push_back(static_cast<T>(i % 100 - 30));
+    }
+    ListRef<T> list_ref;
+    list_ref.list = reinterpret_cast<int8_t *>(new codec::ArrayListV<T>(values));
+    return list_ref;
+}
+
+ListRef<bool> MakeRangeBoolList(int64_t cnt) {
+    auto values = new std::vector<int>();
+    for (int64_t i = 0; i < cnt; ++i) {
+        values->push_back(i % 3 == 0);
+    }
+    ListRef<bool> list_ref;
+    list_ref.list = reinterpret_cast<int8_t *>(new codec::BoolArrayListV(values));
+    return list_ref;
+}
+
+// the builtin udafs over long contiguous lists agree with and without the
+// vectorized update
+TEST_F(UdafTest, VectorizedUpdateTest) {
+    for (bool vectorized : {true, false}) {
+        FLAGS_enable_vectorized_udaf = vectorized;
+        CheckUdf<int32_t, ListRef<int32_t>>("sum", 19500, MakeRangeList<int32_t>(1000));
+        CheckUdf<int16_t, ListRef<int16_t>>("sum", 19500, MakeRangeList<int16_t>(1000));
+        CheckUdf<double, ListRef<double>>("sum", 19500.0, MakeRangeList<double>(1000));
+        CheckUdf<int64_t, ListRef<int64_t>>("count", 1000, MakeRangeList<int64_t>(1000));
+        CheckUdf<double, ListRef<float>>("avg", 19.5, MakeRangeList<float>(1000));
+        CheckUdf<Nullable<int64_t>, ListRef<int64_t>>("min", -30, MakeRangeList<int64_t>(1000));
+        CheckUdf<Nullable<double>, ListRef<double>>("max", 69.0, MakeRangeList<double>(1000));
+        CheckUdf<Nullable<int32_t>, ListRef<int32_t>>("max", nullptr, MakeRangeList<int32_t>(0));
+
+        // rows of i % 3 == 0 are kept
+        CheckUdf<int32_t, ListRef<int32_t>, ListRef<bool>>("sum_where", 6513, MakeRangeList<int32_t>(1000),
+                                                           MakeRangeBoolList(1000));
+        CheckUdf<int64_t, ListRef<int32_t>, ListRef<bool>>("count_where", 334, MakeRangeList<int32_t>(1000),
+                                                           MakeRangeBoolList(1000));
+        CheckUdf<double, ListRef<double>, ListRef<bool>>("avg_where", 6513.0 / 334, MakeRangeList<double>(1000),
+                                                         MakeRangeBoolList(1000));
+        CheckUdf<int32_t, ListRef<int32_t>, ListRef<bool>>("min_where", -30, MakeRangeList<int32_t>(1000),
+                                                           MakeRangeBoolList(1000));
+        CheckUdf<int64_t, ListRef<int64_t>, ListRef<bool>>("max_where", 69, MakeRangeList<int64_t>(1000),
+                                                           MakeRangeBoolList(1000));
+    }
+    FLAGS_enable_vectorized_udaf = true;
+}
+
 }  // namespace udf
 }  // namespace hybridse
 
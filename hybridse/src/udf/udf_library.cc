@@ -22,6 +22,7 @@
 #include "boost/filesystem.hpp"
 #include "boost/filesystem/string_file.hpp"
 
+#include "base/fe_hash.h"
 #include "codegen/type_ir_builder.h"
 #include "plan/plan_api.h"
 #include "udf/udf.h"
@@ -397,6 +398,17 @@ void UdfLibrary::InitJITSymbols(vm::HybridSeJitWrapper* jit_ptr) {
     }
 }
 
+uint64_t UdfLibrary::GetExternalSymbolsHash() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    // combine with xor so the hash does not depend on the map order
+    uint64_t hash = external_symbols_.size();
+    for (auto& pair : external_symbols_) {
+        hash ^= base::MurmurHash64A(pair.first.data(), pair.first.size(),
+                                    0xe17a1465);
+    }
+    return hash;
+}
+
 const std::string GetArgSignature(const std::vector<node::ExprNode*>& args) {
     std::stringstream ss;
     for (size_t i = 0; i < args.size(); ++i) {
@@ -150,6 +150,10 @@ class UdfLibrary {
 
     void InitJITSymbols(vm::HybridSeJitWrapper* jit_ptr);
 
+    // the hash of the names of the external symbols, it changes if an
+    // external function is added or removed
+    uint64_t GetExternalSymbolsHash() const;
+
     node::NodeManager* node_manager() { return &nm_; }
 
     std::unordered_map<std::string, std::shared_ptr<UdfLibraryEntry>> GetAllRegistries() {
@@ -179,8 +179,10 @@ Status UdafRegistry::ResolveFunction(UdfResolveContext* ctx,
             udaf_gen_.output_gen->ResolveFunction(&output_ctx, &output_func),
             "Resolve output function of ", name(), " failed");
     }
-    *result = nm->MakeUdafDefNode(name(), list_types, init_expr, update_func,
-                                  merge_func, output_func);
+    auto udaf = nm->MakeUdafDefNode(name(), list_types, init_expr,
+                                    update_func, merge_func, output_func);
+    udaf->set_vectorized_update(udaf_gen_.vectorized_update);
+    *result = udaf;
     return Status::OK();
 }
 
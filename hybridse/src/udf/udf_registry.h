@@ -1480,6 +1480,9 @@ struct UdafDefGen {
     std::shared_ptr<UdfRegistry> output_gen = nullptr;
     node::TypeNode* state_type = nullptr;
     bool state_nullable = false;
+    // optional external function folding the whole input lists into the
+    // state at once, see UdafRegistryHelperImpl::vectorized_update
+    std::string vectorized_update;
 };
 
 class UdafRegistry : public UdfRegistry {
@@ -1739,6 +1742,21 @@ class UdafRegistryHelperImpl : UdfRegistryHelper {
         return *this;
     }
 
+    /// \brief Register an external function which folds all the input lists
+    /// into the state at once if the lists keep their values contiguously.
+    ///
+    /// It takes the input lists followed by pointers to each field of the
+    /// state, bool fields are passed as `int8_t*`. It returns false without
+    /// touching the state if it can not handle the lists, then the lists are
+    /// iterated with the update function. It is only used when the input
+    /// elements are not nullable and the state fields are scalars.
+    UdafRegistryHelperImpl& vectorized_update(const std::string& fname,
+                                              void* fn_ptr) {
+        udaf_gen_.vectorized_update = fname;
+        library()->AddExternalFunction(fname, fn_ptr);
+        return *this;
+    }
+
     UdafRegistryHelperImpl& output(const std::string& fname) {
         auto registry = library()->Find(fname, {state_ty_});
         if (registry != nullptr) {
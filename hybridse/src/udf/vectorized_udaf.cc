@@ -0,0 +1,462 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "udf/vectorized_udaf.h"
+#include <string.h>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+#include "codec/list_iterator_codec.h"
+#include "codec/type_codec.h"
+#include "gflags/gflags.h"
+
+DECLARE_bool(enable_vectorized_udaf);
+
+namespace hybridse {
+namespace udf {
+namespace vectorized {
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define VECTORIZED_AVX2 __attribute__((target("avx2")))
+bool CpuHasAvx2() {
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2;
+}
+#else
+#define VECTORIZED_AVX2
+bool CpuHasAvx2() { return false; }
+#endif
+
+// the implementations are inlined into the callers built for each
+// instruction set, so the vectors never cross a function boundary
+#define VECTORIZED_INLINE inline __attribute__((always_inline))
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+// 32 bytes of V, which are one AVX2 register or two SSE2 registers
+template <class V>
+struct Lanes {
+    static constexpr size_t kNum = 32 / sizeof(V);
+    // the integer of the same width, the comparisons produce masks of it
+    typedef typename std::conditional<
+        sizeof(V) == 8, int64_t,
+        typename std::conditional<sizeof(V) == 4, int32_t,
+                                  int16_t>::type>::type Int;
+    typedef V Vec __attribute__((vector_size(32)));
+    typedef Int Mask __attribute__((vector_size(32)));
+
+    static VECTORIZED_INLINE Vec Load(const V* values) {
+        Vec vec;
+        memcpy(&vec, values, sizeof(vec));
+        return vec;
+    }
+
+    static VECTORIZED_INLINE Vec Fill(V value) {
+        Vec vec;
+        for (size_t i = 0; i < kNum; i++) {
+            vec[i] = value;
+        }
+        return vec;
+    }
+
+    // all ones for the kept rows
+    static VECTORIZED_INLINE Mask LoadKeep(const int8_t* keep) {
+        Mask mask;
+        for (size_t i = 0; i < kNum; i++) {
+            mask[i] = keep[i] == 0 ? 0 : -1;
+        }
+        return mask;
+    }
+
+    static VECTORIZED_INLINE Vec Select(Mask mask, Vec left, Vec right) {
+        return (Vec)(((Mask)left & mask) | ((Mask)right & ~mask));
+    }
+};
+
+// the float sums are added in the row order, the same as the row updates,
+// since a sum reassociated across the lanes may differ in the low bits
+template <class V>
+VECTORIZED_INLINE V SequentialSum(const V* values, const int8_t* keep,
+                                  uint64_t cnt) {
+    V sum = 0;
+    for (uint64_t i = 0; i < cnt; i++) {
+        if (keep == nullptr || keep[i] != 0) {
+            sum += values[i];
+        }
+    }
+    return sum;
+}
+
+template <class V>
+VECTORIZED_INLINE V SumImpl(const V* values, const int8_t* keep,
+                            uint64_t cnt) {
+    if constexpr (std::is_floating_point<V>::value) {
+        return SequentialSum(values, keep, cnt);
+    } else {
+        // the integers are added as unsigned, whose overflow is well defined
+        typedef typename std::make_unsigned<V>::type Acc;
+        typedef Lanes<Acc> L;
+        const Acc* data = reinterpret_cast<const Acc*>(values);
+        typename L::Vec acc = L::Fill(0);
+        uint64_t i = 0;
+        for (; i + L::kNum <= cnt; i += L::kNum) {
+            typename L::Vec vec = L::Load(data + i);
+            if (keep != nullptr) {
+                vec = L::Select(L::LoadKeep(keep + i), vec, L::Fill(0));
+            }
+            acc += vec;
+        }
+        Acc sum = 0;
+        for (size_t j = 0; j < L::kNum; j++) {
+            sum += acc[j];
+        }
+        for (; i < cnt; i++) {
+            if (keep == nullptr || keep[i] != 0) {
+                sum += data[i];
+            }
+        }
+        return static_cast<V>(sum);
+    }
+}
+
+// the doubles are added in the row order for every input type, as the
+// integers beyond 2^53 are not exact in double either
+template <class V>
+VECTORIZED_INLINE double SumAsDoubleImpl(const V* values, const int8_t* keep,
+                                         uint64_t cnt) {
+    double sum = 0.0;
+    for (uint64_t i = 0; i < cnt; i++) {
+        if (keep == nullptr || keep[i] != 0) {
+            sum += static_cast<double>(values[i]);
+        }
+    }
+    return sum;
+}
+
+// take the value if it is less (or greater) than the current one, so NaN is
+// never taken as the row updates do
+template <bool kMin, class T>
+VECTORIZED_INLINE bool Better(const T& value, const T& cur) {
+    if constexpr (kMin) {
+        return value < cur;
+    } else {
+        return value > cur;
+    }
+}
+
+template <bool kMin, class V>
+VECTORIZED_INLINE V ExtremeImpl(const V* values, const int8_t* keep,
+                                uint64_t cnt, V init) {
+    typedef Lanes<V> L;
+    typename L::Vec acc = L::Fill(init);
+    uint64_t i = 0;
+    for (; i + L::kNum <= cnt; i += L::kNum) {
+        typename L::Vec vec = L::Load(values + i);
+        typename L::Mask take;
+        if constexpr (kMin) {
+            take = vec < acc;
+        } else {
+            take = vec > acc;
+        }
+        if (keep != nullptr) {
+            take &= L::LoadKeep(keep + i);
+        }
+        acc = L::Select(take, vec, acc);
+    }
+    V res = init;
+    for (size_t j = 0; j < L::kNum; j++) {
+        if (Better<kMin>(acc[j], res)) {
+            res = acc[j];
+        }
+    }
+    for (; i < cnt; i++) {
+        if ((keep == nullptr || keep[i] != 0) && Better<kMin>(values[i], res)) {
+            res = values[i];
+        }
+    }
+    return res;
+}
+
+template <class V>
+VECTORIZED_AVX2 V SumAvx2(const V* values, const int8_t* keep, uint64_t cnt) {
+    return SumImpl(values, keep, cnt);
+}
+
+template <class V>
+VECTORIZED_AVX2 double SumAsDoubleAvx2(const V* values, const int8_t* keep,
+                                       uint64_t cnt) {
+    return SumAsDoubleImpl(values, keep, cnt);
+}
+
+template <class V>
+VECTORIZED_AVX2 V MinAvx2(const V* values, const int8_t* keep, uint64_t cnt,
+                          V init) {
+    return ExtremeImpl<true>(values, keep, cnt, init);
+}
+
+template <class V>
+VECTORIZED_AVX2 V MaxAvx2(const V* values, const int8_t* keep, uint64_t cnt,
+                          V init) {
+    return ExtremeImpl<false>(values, keep, cnt, init);
+}
+
+uint64_t CountKept(const int8_t* keep, uint64_t cnt) {
+    if (keep == nullptr) {
+        return cnt;
+    }
+    uint64_t kept = 0;
+    for (uint64_t i = 0; i < cnt; i++) {
+        kept += keep[i] != 0;
+    }
+    return kept;
+}
+
+template <class V>
+V Sum(const V* values, const int8_t* keep, uint64_t cnt) {
+    return CpuHasAvx2() ? SumAvx2(values, keep, cnt)
+                        : SumImpl(values, keep, cnt);
+}
+
+template <class V>
+double SumAsDouble(const V* values, const int8_t* keep, uint64_t cnt) {
+    return CpuHasAvx2() ? SumAsDoubleAvx2(values, keep, cnt)
+                        : SumAsDoubleImpl(values, keep, cnt);
+}
+
+template <class V>
+V Min(const V* values, const int8_t* keep, uint64_t cnt, V init) {
+    return CpuHasAvx2() ? MinAvx2(values, keep, cnt, init)
+                        : ExtremeImpl<true>(values, keep, cnt, init);
+}
+
+template <class V>
+V Max(const V* values, const int8_t* keep, uint64_t cnt, V init) {
+    return CpuHasAvx2() ? MaxAvx2(values, keep, cnt, init)
+                        : ExtremeImpl<false>(values, keep, cnt, init);
+}
+
+#define INSTANTIATE_VECTORIZED_KERNELS(V)                                   \
+    template V Sum<V>(const V*, const int8_t*, uint64_t);                   \
+    template double SumAsDouble<V>(const V*, const int8_t*, uint64_t);      \
+    template V Min<V>(const V*, const int8_t*, uint64_t, V);                \
+    template V Max<V>(const V*, const int8_t*, uint64_t, V);
+
+INSTANTIATE_VECTORIZED_KERNELS(int16_t)
+INSTANTIATE_VECTORIZED_KERNELS(int32_t)
+INSTANTIATE_VECTORIZED_KERNELS(int64_t)
+INSTANTIATE_VECTORIZED_KERNELS(float)
+INSTANTIATE_VECTORIZED_KERNELS(double)
+
+}  // namespace vectorized
+
+namespace v1 {
+
+// the predicate bytes of the first `cnt` rows, a null predicate is false.
+// the list of the predicate is usually computed row by row, so it is
+// materialized into `buffer` then
+static const int8_t* GetCond(int8_t* input, uint64_t* cnt,
+                             std::vector<int8_t>* buffer) {
+    auto list_ref = reinterpret_cast<codec::ListRef<>*>(input);
+    auto list = reinterpret_cast<codec::ListV<bool>*>(list_ref->list);
+    const bool* values = nullptr;
+    const int8_t* nulls = nullptr;
+    uint64_t size = 0;
+    if (list->GetContiguous(&values, &nulls, &size)) {
+        *cnt = std::min(*cnt, size);
+        if (nulls == nullptr) {
+            return reinterpret_cast<const int8_t*>(values);
+        }
+        buffer->resize(*cnt);
+        for (uint64_t i = 0; i < *cnt; i++) {
+            (*buffer)[i] = values[i] && nulls[i] == 0 ? 1 : 0;
+        }
+        return buffer->data();
+    }
+    buffer->reserve(*cnt);
+    auto iter = list->GetIterator();
+    for (iter->SeekToFirst(); iter->Valid() && buffer->size() < *cnt;
+         iter->Next()) {
+        buffer->push_back(iter->GetValue() ? 1 : 0);
+    }
+    // the rows without predicate are not updated, as the iteration stops
+    buffer->resize(*cnt, 0);
+    return buffer->data();
+}
+
+// the contiguous values of an input list and the rows to fold, which are
+// the rows whose value is not null and whose predicate is true
+template <class V>
+struct Input {
+    const V* values = nullptr;
+    // nullptr if every row is folded
+    const int8_t* keep = nullptr;
+    uint64_t cnt = 0;
+    std::vector<int8_t> buffer;
+};
+
+template <class V>
+static bool GetInput(int8_t* input, int8_t* cond, Input<V>* res) {
+    if (!FLAGS_enable_vectorized_udaf || input == nullptr) {
+        return false;
+    }
+    auto list_ref = reinterpret_cast<codec::ListRef<>*>(input);
+    auto list = reinterpret_cast<codec::ListV<V>*>(list_ref->list);
+    const int8_t* nulls = nullptr;
+    if (list == nullptr ||
+        !list->GetContiguous(&res->values, &nulls, &res->cnt)) {
+        return false;
+    }
+    if (cond != nullptr) {
+        res->keep = GetCond(cond, &res->cnt, &res->buffer);
+    }
+    if (nulls != nullptr) {
+        // the null values are skipped as the row updates do
+        if (res->keep == nullptr) {
+            res->buffer.assign(res->cnt, 1);
+        } else if (res->buffer.empty()) {
+            res->buffer.assign(res->keep, res->keep + res->cnt);
+        }
+        for (uint64_t i = 0; i < res->cnt; i++) {
+            res->buffer[i] = res->buffer[i] != 0 && nulls[i] == 0 ? 1 : 0;
+        }
+        res->keep = res->buffer.data();
+    }
+    return true;
+}
+
+template <class V>
+static bool UpdateSum(int8_t* input, int8_t* cond, V* sum) {
+    Input<V> in;
+    if (!GetInput(input, cond, &in)) {
+        return false;
+    }
+    *sum += vectorized::Sum(in.values, in.keep, in.cnt);
+    return true;
+}
+
+template <class V>
+static bool UpdateAvg(int8_t* input, int8_t* cond, int64_t* cnt,
+                      double* sum) {
+    Input<V> in;
+    if (!GetInput(input, cond, &in)) {
+        return false;
+    }
+    *cnt += vectorized::CountKept(in.keep, in.cnt);
+    *sum += vectorized::SumAsDouble(in.values, in.keep, in.cnt);
+    return true;
+}
+
+template <class V>
+static bool UpdateCount(int8_t* input, int8_t* cond, int64_t* cnt) {
+    Input<V> in;
+    if (!GetInput(input, cond, &in)) {
+        return false;
+    }
+    *cnt += vectorized::CountKept(in.keep, in.cnt);
+    return true;
+}
+
+template <bool kMin, class V>
+static bool UpdateExtreme(int8_t* input, int8_t* cond, int8_t* is_empty,
+                          V* extreme) {
+    Input<V> in;
+    if (!GetInput(input, cond, &in)) {
+        return false;
+    }
+    *extreme = kMin ? vectorized::Min(in.values, in.keep, in.cnt, *extreme)
+                    : vectorized::Max(in.values, in.keep, in.cnt, *extreme);
+    if (vectorized::CountKept(in.keep, in.cnt) > 0) {
+        *is_empty = 0;
+    }
+    return true;
+}
+
+template <class V>
+bool vectorized_sum(int8_t* input, V* sum) {
+    return UpdateSum(input, nullptr, sum);
+}
+
+template <class V>
+bool vectorized_avg(int8_t* input, int64_t* cnt, double* sum) {
+    return UpdateAvg<V>(input, nullptr, cnt, sum);
+}
+
+template <class V>
+bool vectorized_count(int8_t* input, int64_t* cnt) {
+    return UpdateCount<V>(input, nullptr, cnt);
+}
+
+template <class V>
+bool vectorized_min(int8_t* input, int8_t* is_empty, V* min) {
+    return UpdateExtreme<true>(input, nullptr, is_empty, min);
+}
+
+template <class V>
+bool vectorized_max(int8_t* input, int8_t* is_empty, V* max) {
+    return UpdateExtreme<false>(input, nullptr, is_empty, max);
+}
+
+template <class V>
+bool vectorized_sum_where(int8_t* input, int8_t* cond, V* sum) {
+    return UpdateSum(input, cond, sum);
+}
+
+template <class V>
+bool vectorized_count_where(int8_t* input, int8_t* cond, int64_t* cnt) {
+    return UpdateCount<V>(input, cond, cnt);
+}
+
+template <class V>
+bool vectorized_avg_where(int8_t* input, int8_t* cond, int64_t* cnt,
+                          double* sum) {
+    return UpdateAvg<V>(input, cond, cnt, sum);
+}
+
+template <class V>
+bool vectorized_min_where(int8_t* input, int8_t* cond, int8_t* is_empty,
+                          V* min) {
+    return UpdateExtreme<true>(input, cond, is_empty, min);
+}
+
+template <class V>
+bool vectorized_max_where(int8_t* input, int8_t* cond, int8_t* is_empty,
+                          V* max) {
+    return UpdateExtreme<false>(input, cond, is_empty, max);
+}
+
+#define INSTANTIATE_VECTORIZED_UDAFS(V)                                      \
+    template bool vectorized_sum<V>(int8_t*, V*);                            \
+    template bool vectorized_avg<V>(int8_t*, int64_t*, double*);             \
+    template bool vectorized_count<V>(int8_t*, int64_t*);                    \
+    template bool vectorized_min<V>(int8_t*, int8_t*, V*);                   \
+    template bool vectorized_max<V>(int8_t*, int8_t*, V*);                   \
+    template bool vectorized_sum_where<V>(int8_t*, int8_t*, V*);             \
+    template bool vectorized_count_where<V>(int8_t*, int8_t*, int64_t*);     \
+    template bool vectorized_avg_where<V>(int8_t*, int8_t*, int64_t*,        \
+                                          double*);                          \
+    template bool vectorized_min_where<V>(int8_t*, int8_t*, int8_t*, V*);    \
+    template bool vectorized_max_where<V>(int8_t*, int8_t*, int8_t*, V*);
+
+INSTANTIATE_VECTORIZED_UDAFS(int16_t)
+INSTANTIATE_VECTORIZED_UDAFS(int32_t)
+INSTANTIATE_VECTORIZED_UDAFS(int64_t)
+INSTANTIATE_VECTORIZED_UDAFS(float)
+INSTANTIATE_VECTORIZED_UDAFS(double)
+
+}  // namespace v1
+}  // namespace udf
+}  // namespace hybridse
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_SRC_UDF_VECTORIZED_UDAF_H_
+#define HYBRIDSE_SRC_UDF_VECTORIZED_UDAF_H_
+#include <stdint.h>
+
+namespace hybridse {
+namespace udf {
+namespace vectorized {
+
+// The kernels over contiguous values. A row is skipped if `keep` is not
+// nullptr and its byte is 0, so `keep` can be a predicate or the negation of
+// a null bitmap. They run with AVX2 if the cpu supports it, and with the
+// baseline instruction set otherwise.
+
+bool CpuHasAvx2();
+
+uint64_t CountKept(const int8_t* keep, uint64_t cnt);
+
+// the integers are added with wraparound, the same as the row updates. the
+// floats are added in the row order, so the sums are the same bits too
+template <class V>
+V Sum(const V* values, const int8_t* keep, uint64_t cnt);
+
+// added in the row order
+template <class V>
+double SumAsDouble(const V* values, const int8_t* keep, uint64_t cnt);
+
+// `init` is returned if no value is kept or less than it
+template <class V>
+V Min(const V* values, const int8_t* keep, uint64_t cnt, V init);
+
+template <class V>
+V Max(const V* values, const int8_t* keep, uint64_t cnt, V init);
+
+}  // namespace vectorized
+
+namespace v1 {
+
+// The vectorized updates of the builtin udafs. Each one folds all the
+// values of the input lists into the udaf state at once if the lists keep
+// their values contiguously, otherwise it returns false and keeps the state
+// untouched, then the caller iterates the lists. The null values of the
+// lists are skipped as the row updates do. The bool states are passed as
+// bytes.
+
+template <class V>
+bool vectorized_sum(int8_t* input, V* sum);
+
+template <class V>
+bool vectorized_avg(int8_t* input, int64_t* cnt, double* sum);
+
+template <class V>
+bool vectorized_count(int8_t* input, int64_t* cnt);
+
+template <class V>
+bool vectorized_min(int8_t* input, int8_t* is_empty, V* min);
+
+template <class V>
+bool vectorized_max(int8_t* input, int8_t* is_empty, V* max);
+
+template <class V>
+bool vectorized_sum_where(int8_t* input, int8_t* cond, V* sum);
+
+template <class V>
+bool vectorized_count_where(int8_t* input, int8_t* cond, int64_t* cnt);
+
+template <class V>
+bool vectorized_avg_where(int8_t* input, int8_t* cond, int64_t* cnt,
+                          double* sum);
+
+template <class V>
+bool vectorized_min_where(int8_t* input, int8_t* cond, int8_t* is_empty,
+                          V* min);
+
+template <class V>
+bool vectorized_max_where(int8_t* input, int8_t* cond, int8_t* is_empty,
+                          V* max);
+
+}  // namespace v1
+}  // namespace udf
+}  // namespace hybridse
+#endif  // HYBRIDSE_SRC_UDF_VECTORIZED_UDAF_H_
@@ -0,0 +1,319 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "udf/vectorized_udaf.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+#include "codec/list_iterator_codec.h"
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+#include "udf/literal_traits.h"
+
+DECLARE_bool(enable_vectorized_udaf);
+
+namespace hybridse {
+namespace udf {
+
+class VectorizedUdafTest : public ::testing::Test {
+ public:
+    VectorizedUdafTest() {}
+    ~VectorizedUdafTest() {}
+};
+
+template <class V>
+static std::vector<V> RandomValues(size_t cnt, std::mt19937* rand) {
+    std::vector<V> values;
+    std::uniform_int_distribution<int> dist(-1000, 1000);
+    for (size_t i = 0; i < cnt; i++) {
+        values.push_back(static_cast<V>(dist(*rand)));
+    }
+    return values;
+}
+
+static std::vector<int8_t> RandomKeep(size_t cnt, std::mt19937* rand) {
+    std::vector<int8_t> keep;
+    for (size_t i = 0; i < cnt; i++) {
+        keep.push_back((*rand)() % 3 == 0 ? 0 : 1);
+    }
+    return keep;
+}
+
+// compare with the row by row updates, the values are small integers so the
+// float sums are exact in any order
+template <class V>
+static void CheckKernels(size_t cnt, std::mt19937* rand) {
+    auto values = RandomValues<V>(cnt, rand);
+    auto keep = RandomKeep(cnt, rand);
+    for (const int8_t* mask : {static_cast<const int8_t*>(nullptr),
+                               static_cast<const int8_t*>(keep.data())}) {
+        V sum = 0;
+        double sum_as_double = 0.0;
+        uint64_t kept = 0;
+        V min = std::numeric_limits<V>::max();
+        V max = std::numeric_limits<V>::lowest();
+        for (size_t i = 0; i < cnt; i++) {
+            if (mask != nullptr && mask[i] == 0) {
+                continue;
+            }
+            sum += values[i];
+            sum_as_double += static_cast<double>(values[i]);
+            kept++;
+            min = values[i] < min ? values[i] : min;
+            max = values[i] > max ? values[i] : max;
+        }
+        ASSERT_EQ(sum, vectorized::Sum(values.data(), mask, cnt));
+        ASSERT_EQ(sum_as_double,
+                  vectorized::SumAsDouble(values.data(), mask, cnt));
+        ASSERT_EQ(kept, vectorized::CountKept(mask, cnt));
+        ASSERT_EQ(min, vectorized::Min(values.data(), mask, cnt,
+                                       std::numeric_limits<V>::max()));
+        ASSERT_EQ(max, vectorized::Max(values.data(), mask, cnt,
+                                       std::numeric_limits<V>::lowest()));
+    }
+}
+
+TEST_F(VectorizedUdafTest, KernelsTest) {
+    std::mt19937 rand(42);
+    // cover the empty input, the tails and several full lanes
+    for (size_t cnt : {0, 1, 3, 15, 16, 17, 33, 100, 1001}) {
+        CheckKernels<int16_t>(cnt, &rand);
+        CheckKernels<int32_t>(cnt, &rand);
+        CheckKernels<int64_t>(cnt, &rand);
+        CheckKernels<float>(cnt, &rand);
+        CheckKernels<double>(cnt, &rand);
+    }
+}
+
+TEST_F(VectorizedUdafTest, SumWrapAroundTest) {
+    std::vector<int16_t> values(100, std::numeric_limits<int16_t>::max());
+    int16_t expect = 0;
+    for (auto value : values) {
+        expect = static_cast<int16_t>(expect + value);
+    }
+    ASSERT_EQ(expect, vectorized::Sum(values.data(), nullptr, values.size()));
+}
+
+TEST_F(VectorizedUdafTest, NaNTest) {
+    std::vector<double> values(37, 1.0);
+    values[3] = std::nan("");
+    values[20] = -2.0;
+    values[36] = 5.0;
+    ASSERT_EQ(-2.0, vectorized::Min(values.data(), nullptr, values.size(),
+                                    std::numeric_limits<double>::max()));
+    ASSERT_EQ(5.0, vectorized::Max(values.data(), nullptr, values.size(),
+                                   std::numeric_limits<double>::lowest()));
+    ASSERT_TRUE(std::isnan(
+        vectorized::Sum(values.data(), nullptr, values.size())));
+}
+
+// the float sums are the same bits as the row by row order, which a sum
+// reassociated across the lanes would lose
+TEST_F(VectorizedUdafTest, FloatSumOrderTest) {
+    std::mt19937 rand(7);
+    std::uniform_real_distribution<double> dist(-1e16, 1e16);
+    std::vector<double> doubles;
+    std::vector<float> floats;
+    std::vector<int64_t> longs;
+    for (size_t i = 0; i < 1001; i++) {
+        double value = i % 2 == 0 ? dist(rand) : 1.0 / (i + 1);
+        doubles.push_back(value);
+        floats.push_back(static_cast<float>(value));
+        longs.push_back(static_cast<int64_t>(value) * 100 + 1);
+    }
+    auto keep = RandomKeep(doubles.size(), &rand);
+    for (const int8_t* mask : {static_cast<const int8_t*>(nullptr),
+                               static_cast<const int8_t*>(keep.data())}) {
+        double double_sum = 0.0;
+        float float_sum = 0.0f;
+        double float_as_double = 0.0;
+        double long_as_double = 0.0;
+        for (size_t i = 0; i < doubles.size(); i++) {
+            if (mask != nullptr && mask[i] == 0) {
+                continue;
+            }
+            double_sum += doubles[i];
+            float_sum += floats[i];
+            float_as_double += static_cast<double>(floats[i]);
+            long_as_double += static_cast<double>(longs[i]);
+        }
+        ASSERT_EQ(double_sum,
+                  vectorized::Sum(doubles.data(), mask, doubles.size()));
+        ASSERT_EQ(float_sum,
+                  vectorized::Sum(floats.data(), mask, floats.size()));
+        ASSERT_EQ(float_as_double,
+                  vectorized::SumAsDouble(floats.data(), mask, floats.size()));
+        ASSERT_EQ(long_as_double,
+                  vectorized::SumAsDouble(longs.data(), mask, longs.size()));
+    }
+}
+
+TEST_F(VectorizedUdafTest, UdafUpdateTest) {
+    std::vector<int32_t> buffer;
+    std::vector<int> cond_buffer;
+    for (int i = 0; i < 100; i++) {
+        buffer.push_back(i);
+        cond_buffer.push_back(i % 2);
+    }
+    codec::ArrayListV<int32_t> list(&buffer);
+    codec::ListRef<> list_ref;
+    list_ref.list = reinterpret_cast<int8_t*>(&list);
+    int8_t* input = reinterpret_cast<int8_t*>(&list_ref);
+    // the predicate list is not contiguous and materialized
+    codec::BoolArrayListV cond_list(&cond_buffer);
+    codec::ListRef<> cond_ref;
+    cond_ref.list = reinterpret_cast<int8_t*>(&cond_list);
+    int8_t* cond = reinterpret_cast<int8_t*>(&cond_ref);
+
+    int32_t sum = 1;
+    ASSERT_TRUE(v1::vectorized_sum<int32_t>(input, &sum));
+    ASSERT_EQ(4951, sum);
+
+    int64_t cnt = 0;
+    double avg_sum = 0.0;
+    ASSERT_TRUE(v1::vectorized_avg<int32_t>(input, &cnt, &avg_sum));
+    ASSERT_EQ(100, cnt);
+    ASSERT_EQ(4950.0, avg_sum);
+
+    int8_t is_empty = 1;
+    int32_t min = std::numeric_limits<int32_t>::max();
+    ASSERT_TRUE(v1::vectorized_min<int32_t>(input, &is_empty, &min));
+    ASSERT_EQ(0, is_empty);
+    ASSERT_EQ(0, min);
+
+    sum = 0;
+    ASSERT_TRUE(v1::vectorized_sum_where<int32_t>(input, cond, &sum));
+    ASSERT_EQ(2500, sum);
+
+    cnt = 0;
+    ASSERT_TRUE(v1::vectorized_count_where<int32_t>(input, cond, &cnt));
+    ASSERT_EQ(50, cnt);
+
+    is_empty = 1;
+    int32_t max = std::numeric_limits<int32_t>::lowest();
+    ASSERT_TRUE(
+        v1::vectorized_max_where<int32_t>(input, cond, &is_empty, &max));
+    ASSERT_EQ(0, is_empty);
+    ASSERT_EQ(99, max);
+
+    // the state is kept if the fast path is disabled
+    FLAGS_enable_vectorized_udaf = false;
+    sum = 7;
+    ASSERT_FALSE(v1::vectorized_sum<int32_t>(input, &sum));
+    ASSERT_EQ(7, sum);
+    FLAGS_enable_vectorized_udaf = true;
+}
+
+// the null values of a columnar column are skipped
+TEST_F(VectorizedUdafTest, NullableColumnTest) {
+    std::vector<uint64_t> keys;
+    codec::ColumnarArray array;
+    array.value_size = sizeof(int32_t);
+    array.keys = &keys;
+    std::vector<int> cond_buffer;
+    for (int32_t i = 0; i < 100; i++) {
+        bool is_null = i % 4 == 0;
+        // the bytes of a null value are undefined
+        int32_t value = is_null ? 1000000 : i;
+        const int8_t* bytes = reinterpret_cast<const int8_t*>(&value);
+        array.values.insert(array.values.end(), bytes, bytes + sizeof(value));
+        array.nulls.push_back(is_null ? 1 : 0);
+        keys.push_back(100 - i);
+        cond_buffer.push_back(i % 2);
+    }
+    codec::ColumnImpl<int32_t> column(nullptr, 0, 0, 0, &array);
+    const int32_t* values = nullptr;
+    const int8_t* nulls = nullptr;
+    uint64_t size = 0;
+    ASSERT_TRUE(column.GetContiguous(&values, &nulls, &size));
+    ASSERT_EQ(100u, size);
+    ASSERT_EQ(array.nulls.data(), nulls);
+
+    codec::ListRef<> list_ref;
+    list_ref.list = reinterpret_cast<int8_t*>(&column);
+    int8_t* input = reinterpret_cast<int8_t*>(&list_ref);
+    codec::BoolArrayListV cond_list(&cond_buffer);
+    codec::ListRef<> cond_ref;
+    cond_ref.list = reinterpret_cast<int8_t*>(&cond_list);
+    int8_t* cond = reinterpret_cast<int8_t*>(&cond_ref);
+
+    // 0, 4, ..., 96 are null
+    int32_t sum = 0;
+    ASSERT_TRUE(v1::vectorized_sum<int32_t>(input, &sum));
+    ASSERT_EQ(4950 - 1200, sum);
+
+    int64_t cnt = 0;
+    ASSERT_TRUE(v1::vectorized_count<int32_t>(input, &cnt));
+    ASSERT_EQ(75, cnt);
+
+    cnt = 0;
+    double avg_sum = 0.0;
+    ASSERT_TRUE(v1::vectorized_avg<int32_t>(input, &cnt, &avg_sum));
+    ASSERT_EQ(75, cnt);
+    ASSERT_EQ(3750.0, avg_sum);
+
+    int8_t is_empty = 1;
+    int32_t min = std::numeric_limits<int32_t>::max();
+    ASSERT_TRUE(v1::vectorized_min<int32_t>(input, &is_empty, &min));
+    ASSERT_EQ(0, is_empty);
+    ASSERT_EQ(1, min);
+
+    is_empty = 1;
+    int32_t max = std::numeric_limits<int32_t>::lowest();
+    ASSERT_TRUE(v1::vectorized_max<int32_t>(input, &is_empty, &max));
+    ASSERT_EQ(0, is_empty);
+    ASSERT_EQ(99, max);
+
+    // the odd rows are never null
+    sum = 0;
+    ASSERT_TRUE(v1::vectorized_sum_where<int32_t>(input, cond, &sum));
+    ASSERT_EQ(2500, sum);
+
+    // all the values are null
+    std::fill(array.nulls.begin(), array.nulls.end(), 1);
+    is_empty = 1;
+    min = std::numeric_limits<int32_t>::max();
+    ASSERT_TRUE(v1::vectorized_min<int32_t>(input, &is_empty, &min));
+    ASSERT_EQ(1, is_empty);
+    cnt = 0;
+    ASSERT_TRUE(v1::vectorized_count<int32_t>(input, &cnt));
+    ASSERT_EQ(0, cnt);
+
+    // the bitmap is skipped if no value is null
+    std::fill(array.nulls.begin(), array.nulls.end(), 0);
+    ASSERT_TRUE(column.GetContiguous(&values, &nulls, &size));
+    ASSERT_EQ(nullptr, nulls);
+}
+
+TEST_F(VectorizedUdafTest, NotContiguousTest) {
+    // the values of nullable elements are not plain arrays
+    std::vector<Nullable<int32_t>> buffer = {1, 2, nullptr};
+    codec::ArrayListV<Nullable<int32_t>> list(&buffer);
+    const Nullable<int32_t>* values = nullptr;
+    const int8_t* nulls = nullptr;
+    uint64_t cnt = 0;
+    ASSERT_FALSE(list.GetContiguous(&values, &nulls, &cnt));
+}
+
+}  // namespace udf
+}  // namespace hybridse
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
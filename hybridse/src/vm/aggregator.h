@@ -18,9 +18,13 @@
 #define HYBRIDSE_SRC_VM_AGGREGATOR_H_
 
 #include <algorithm>
+#include <cmath>
+#include <deque>
 #include <limits>
 #include <memory>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <boost/algorithm/string/compare.hpp>
 
 #include "codec/fe_row_codec.h"
@@ -454,6 +458,160 @@ std::enable_if_t<!std::is_arithmetic<T>{}> AggregatorUpdate(BaseAggregator* aggr
     }
 }
 
+enum class WindowAggOp { kSum, kCount, kAvg, kMin, kMax };
+
+// the aggregate of a sliding window updated incrementally. the values are
+// added in ascending order of ts and evicted from the oldest one: sum, count
+// and avg are invertible so an evicted value is subtracted, min and max keep
+// the monotonic deque of the values which can still be the extreme, so both
+// Add and EvictBefore are amortized O(1)
+class BaseWindowAggState {
+ public:
+    virtual ~BaseWindowAggState() {}
+
+    // the value is assumed to be not null and its ts not older than the
+    // values added before
+    virtual void Add(uint64_t ts, int64_t val) = 0;
+    virtual void Add(uint64_t ts, double val) = 0;
+    virtual void Add(uint64_t ts, const std::string& val) = 0;
+
+    // evict the values whose ts < `start`
+    virtual void EvictBefore(uint64_t start) = 0;
+
+    // update the aggregator with the aggregate of the values kept
+    virtual void Output(BaseAggregator* aggregator) const = 0;
+
+    virtual size_t GetCount() const = 0;
+};
+
+template <class T>
+class WindowAggState : public BaseWindowAggState {
+ public:
+    // the sum of the integers is kept in int64 and the one of the floating
+    // numbers in double, as SumAggregator and AvgAggregator do
+    using SumType = std::conditional_t<std::is_floating_point<T>{}, double, int64_t>;
+
+    explicit WindowAggState(WindowAggOp op) : op_(op) {}
+
+    void Add(uint64_t ts, int64_t val) override { AddValue(ts, val); }
+    void Add(uint64_t ts, double val) override { AddValue(ts, val); }
+    void Add(uint64_t ts, const std::string& val) override { AddValue(ts, val); }
+
+    void EvictBefore(uint64_t start) override {
+        while (!values_.empty() && values_.front().first < start) {
+            if constexpr (std::is_arithmetic<T>{}) {
+                Accumulate(-static_cast<SumType>(values_.front().second));
+            }
+            if (!extremes_.empty() && extremes_.front().first == begin_seq_) {
+                extremes_.pop_front();
+            }
+            values_.pop_front();
+            begin_seq_++;
+            evicted_cnt_++;
+        }
+        if constexpr (std::is_floating_point<T>{}) {
+            // the sum is compensated, and it is still recomputed in the order
+            // of ts once as many values are evicted as kept so the rounding
+            // errors of the subtractions do not pile up, which costs O(1)
+            // amortized
+            if (evicted_cnt_ > 0 && evicted_cnt_ >= values_.size()) {
+                sum_ = 0;
+                compensation_ = 0;
+                for (const auto& value : values_) {
+                    Accumulate(static_cast<SumType>(value.second));
+                }
+                evicted_cnt_ = 0;
+            }
+        }
+    }
+
+    void Output(BaseAggregator* aggregator) const override {
+        if (values_.empty()) {
+            return;
+        }
+        switch (op_) {
+            case WindowAggOp::kCount:
+                dynamic_cast<Aggregator<int64_t>*>(aggregator)->UpdateValue(values_.size());
+                break;
+            case WindowAggOp::kSum:
+                if constexpr (std::is_arithmetic<T>{}) {
+                    AggregatorUpdate(aggregator, GetSum());
+                }
+                break;
+            case WindowAggOp::kAvg:
+                if constexpr (std::is_arithmetic<T>{}) {
+                    dynamic_cast<AvgAggregator*>(aggregator)
+                        ->UpdateAvgValue(static_cast<double>(GetSum()), values_.size());
+                }
+                break;
+            case WindowAggOp::kMin:
+            case WindowAggOp::kMax:
+                AggregatorUpdate(aggregator, extremes_.front().second);
+                break;
+        }
+    }
+
+    size_t GetCount() const override {
+        return values_.size();
+    }
+
+ private:
+    // the floating sum is kept with the compensation of its rounding errors,
+    // see Neumaier's summation
+    void Accumulate(SumType val) {
+        if constexpr (std::is_floating_point<SumType>{}) {
+            SumType sum = sum_ + val;
+            if (std::abs(sum_) >= std::abs(val)) {
+                compensation_ += (sum_ - sum) + val;
+            } else {
+                compensation_ += (val - sum) + sum_;
+            }
+            sum_ = sum;
+        } else {
+            sum_ += val;
+        }
+    }
+
+    SumType GetSum() const {
+        return sum_ + compensation_;
+    }
+
+    template <class V>
+    void AddValue(uint64_t ts, const V& v) {
+        if constexpr (std::is_arithmetic<T>{} != std::is_arithmetic<V>{}) {
+            LOG(ERROR) << "window agg value type mismatch";
+            return;
+        } else {
+            T val = static_cast<T>(v);
+            if constexpr (std::is_arithmetic<T>{}) {
+                Accumulate(static_cast<SumType>(val));
+            }
+            if (op_ == WindowAggOp::kMin || op_ == WindowAggOp::kMax) {
+                // drop the values which are never the extreme again, since
+                // `val` is kept longer than them
+                while (!extremes_.empty() &&
+                       (op_ == WindowAggOp::kMin ? !(extremes_.back().second < val)
+                                                 : !(val < extremes_.back().second))) {
+                    extremes_.pop_back();
+                }
+                extremes_.emplace_back(begin_seq_ + values_.size(), val);
+            }
+            values_.emplace_back(ts, std::move(val));
+        }
+    }
+
+    const WindowAggOp op_;
+    // the values in ascending order of ts
+    std::deque<std::pair<uint64_t, T>> values_;
+    // the sequence number of the front of `values_`
+    uint64_t begin_seq_ = 0;
+    size_t evicted_cnt_ = 0;
+    SumType sum_ = 0;
+    SumType compensation_ = 0;
+    // the candidates of min or max, the front is the current one
+    std::deque<std::pair<uint64_t, T>> extremes_;
+};
+
 }  // namespace vm
 }  // namespace hybridse
 
@@ -14,6 +14,10 @@
 * limitations under the License.
 */
 
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "gtest/gtest.h"
 #include "proto/fe_type.pb.h"
 #include "vm/aggregator.h"
@@ -550,6 +554,99 @@ TEST_F(AggregatorVMTest, NullTest) {
     check_null(aggregator.get());
 }
 
+TEST(WindowAggStateTest, SlidingWindow) {
+    codec::Schema schema;
+    auto column = schema.Add();
+    column->set_type(type::kInt64);
+    column->set_name("val");
+    std::vector<std::pair<uint64_t, int64_t>> values;
+    for (uint64_t ts = 1; ts <= 200; ts++) {
+        values.emplace_back(ts, static_cast<int64_t>((ts * 37) % 101) - 50);
+    }
+    WindowAggState<int64_t> sum(WindowAggOp::kSum);
+    WindowAggState<int64_t> count(WindowAggOp::kCount);
+    WindowAggState<int64_t> avg(WindowAggOp::kAvg);
+    WindowAggState<int64_t> min(WindowAggOp::kMin);
+    WindowAggState<int64_t> max(WindowAggOp::kMax);
+    const uint64_t window_size = 20;
+    for (size_t i = 0; i < values.size(); i++) {
+        uint64_t ts = values[i].first;
+        for (auto state : std::vector<BaseWindowAggState*>{&sum, &count, &avg, &min, &max}) {
+            state->Add(ts, values[i].second);
+            state->EvictBefore(ts > window_size ? ts - window_size + 1 : 0);
+        }
+        int64_t expect_sum = 0;
+        int64_t expect_min = INT64_MAX;
+        int64_t expect_max = INT64_MIN;
+        int64_t expect_cnt = 0;
+        for (size_t j = 0; j <= i; j++) {
+            if (values[j].first + window_size <= ts) {
+                continue;
+            }
+            expect_sum += values[j].second;
+            expect_min = std::min(expect_min, values[j].second);
+            expect_max = std::max(expect_max, values[j].second);
+            expect_cnt++;
+        }
+        ASSERT_EQ(expect_cnt, count.GetCount());
+
+        SumAggregator<int64_t> sum_agg(type::kInt64, schema);
+        sum.Output(&sum_agg);
+        ASSERT_EQ(expect_sum, sum_agg.val());
+        CountAggregator count_agg(type::kInt64, schema);
+        count.Output(&count_agg);
+        ASSERT_EQ(expect_cnt, count_agg.val());
+        AvgAggregator avg_agg(type::kInt64, schema);
+        avg.Output(&avg_agg);
+        ASSERT_DOUBLE_EQ(static_cast<double>(expect_sum) / expect_cnt, avg_agg.val());
+        MinAggregator<int64_t> min_agg(type::kInt64, schema);
+        min.Output(&min_agg);
+        ASSERT_EQ(expect_min, min_agg.val());
+        MaxAggregator<int64_t> max_agg(type::kInt64, schema);
+        max.Output(&max_agg);
+        ASSERT_EQ(expect_max, max_agg.val());
+    }
+
+    // all the values are evicted
+    sum.EvictBefore(UINT64_MAX);
+    ASSERT_EQ(0u, sum.GetCount());
+    SumAggregator<int64_t> sum_agg(type::kInt64, schema);
+    sum.Output(&sum_agg);
+    ASSERT_TRUE(sum_agg.IsNull());
+}
+
+TEST(WindowAggStateTest, DoubleAndString) {
+    codec::Schema schema;
+    auto column = schema.Add();
+    column->set_type(type::kDouble);
+    column->set_name("val");
+    WindowAggState<double> sum(WindowAggOp::kSum);
+    // the sum of the kept values is not polluted by the large evicted ones
+    sum.Add(1, 1e17);
+    sum.Add(2, 1.5);
+    sum.Add(3, 2.25);
+    sum.EvictBefore(2);
+    SumAggregator<double> sum_agg(type::kDouble, schema);
+    sum.Output(&sum_agg);
+    ASSERT_DOUBLE_EQ(3.75, sum_agg.val());
+
+    column->set_type(type::kVarchar);
+    WindowAggState<std::string> min(WindowAggOp::kMin);
+    WindowAggState<std::string> max(WindowAggOp::kMax);
+    for (auto state : std::vector<BaseWindowAggState*>{&min, &max}) {
+        state->Add(1, std::string("b"));
+        state->Add(2, std::string("a"));
+        state->Add(3, std::string("c"));
+        state->EvictBefore(2);
+    }
+    MinAggregator<std::string> min_agg(type::kVarchar, schema);
+    min.Output(&min_agg);
+    ASSERT_EQ("a", min_agg.val());
+    MaxAggregator<std::string> max_agg(type::kVarchar, schema);
+    max.Output(&max_agg);
+    ASSERT_EQ("c", max_agg.val());
+}
+
 }  // namespace vm
 }  // namespace hybridse
 
@@ -18,6 +18,68 @@
 namespace hybridse {
 namespace vm {
 
+// the rows projected or filtered per call by the batch iterators
+#define ITERATOR_BATCH_SIZE 1024
+
+void IteratorBatchProjectWrapper::Next() {
+    if (pending_) {
+        iter_->Next();
+        NextBatch();
+    } else if (++pos_ >= values_.size()) {
+        NextBatch();
+    }
+}
+
+void IteratorBatchProjectWrapper::NextBatch() {
+    pending_ = false;
+    pos_ = 0;
+    keys_.clear();
+    rows_.clear();
+    values_.clear();
+    while (iter_->Valid() && rows_.size() < ITERATOR_BATCH_SIZE) {
+        keys_.push_back(iter_->GetKey());
+        rows_.push_back(iter_->GetValue());
+        iter_->Next();
+    }
+    if (!rows_.empty()) {
+        fun_->Batch(rows_, parameter_, &values_);
+    }
+}
+
+void IteratorBatchFilterWrapper::Next() {
+    if (pending_) {
+        iter_->Next();
+        NextBatch();
+    } else if (++pos_ >= rows_.size()) {
+        NextBatch();
+    }
+}
+
+void IteratorBatchFilterWrapper::NextBatch() {
+    pending_ = false;
+    pos_ = 0;
+    keys_.clear();
+    rows_.clear();
+    // move on until a row is selected or the rows run out
+    while (rows_.empty() && iter_->Valid()) {
+        while (iter_->Valid() && rows_.size() < ITERATOR_BATCH_SIZE) {
+            keys_.push_back(iter_->GetKey());
+            rows_.push_back(iter_->GetValue());
+            iter_->Next();
+        }
+        predicate_->Batch(rows_, parameter_, &selection_);
+        // compact the selected rows in place, the selection is ascending
+        for (size_t i = 0; i < selection_.size(); i++) {
+            if (selection_[i] != i) {
+                keys_[i] = keys_[selection_[i]];
+                rows_[i] = rows_[selection_[i]];
+            }
+        }
+        keys_.resize(selection_.size());
+        rows_.resize(selection_.size());
+    }
+}
+
 std::shared_ptr<TableHandler> PartitionProjectWrapper::GetSegment(
     const std::string& key) {
     auto segment = partition_handler_->GetSegment(key);
@@ -19,6 +19,7 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 #include "vm/catalog.h"
 namespace hybridse {
 namespace vm {
@@ -26,10 +27,30 @@ namespace vm {
 class ProjectFun {
  public:
     virtual Row operator()(const Row& row, const Row& parameter) const = 0;
+    // project a batch of rows into outputs, the output of rows[i] is
+    // outputs[i]
+    virtual void Batch(const std::vector<Row>& rows, const Row& parameter,
+                       std::vector<Row>* outputs) const {
+        outputs->clear();
+        for (const auto& row : rows) {
+            outputs->push_back(operator()(row, parameter));
+        }
+    }
 };
 class PredicateFun {
  public:
     virtual bool operator()(const Row& row, const Row& parameter) const = 0;
+    // select a batch of rows, the selection is the ascending indexes of the
+    // rows matched
+    virtual void Batch(const std::vector<Row>& rows, const Row& parameter,
+                       std::vector<uint32_t>* selection) const {
+        selection->clear();
+        for (uint32_t i = 0; i < rows.size(); i++) {
+            if (operator()(rows[i], parameter)) {
+                selection->push_back(i);
+            }
+        }
+    }
 };
 class IteratorProjectWrapper : public RowIterator {
  public:
@@ -89,6 +110,100 @@ class IteratorFilterWrapper : public RowIterator {
     const PredicateFun* predicate_;
 };
 
+// project the rows of iter batch by batch by ProjectFun::Batch, the rows are
+// read ahead so they must be kept valid after the inner iterator moves on,
+// like the rows of a MemTableHandler. the iterator behaves like
+// IteratorProjectWrapper until it is seeked or moved.
+class IteratorBatchProjectWrapper : public RowIterator {
+ public:
+    IteratorBatchProjectWrapper(std::unique_ptr<RowIterator> iter,
+                                const Row& parameter, const ProjectFun* fun)
+        : RowIterator(), iter_(std::move(iter)), parameter_(parameter), fun_(fun), value_(),
+          pending_(true), pos_(0) {}
+    virtual ~IteratorBatchProjectWrapper() {}
+    bool Valid() const override {
+        return pending_ ? iter_->Valid() : pos_ < values_.size();
+    }
+    void Next() override;
+    const uint64_t& GetKey() const override {
+        return pending_ ? iter_->GetKey() : keys_[pos_];
+    }
+    const Row& GetValue() override {
+        if (pending_) {
+            value_ = fun_->operator()(iter_->GetValue(), parameter_);
+            return value_;
+        }
+        return values_[pos_];
+    }
+    void Seek(const uint64_t& k) override {
+        iter_->Seek(k);
+        NextBatch();
+    }
+    void SeekToFirst() override {
+        iter_->SeekToFirst();
+        NextBatch();
+    }
+    bool IsSeekable() const override { return iter_->IsSeekable(); }
+
+ private:
+    void NextBatch();
+
+    std::unique_ptr<RowIterator> iter_;
+    const Row& parameter_;
+    const ProjectFun* fun_;
+    Row value_;
+    bool pending_;
+    size_t pos_;
+    std::vector<uint64_t> keys_;
+    std::vector<Row> rows_;
+    std::vector<Row> values_;
+};
+
+// filter the rows of iter batch by batch by PredicateFun::Batch, see
+// IteratorBatchProjectWrapper
+class IteratorBatchFilterWrapper : public RowIterator {
+ public:
+    IteratorBatchFilterWrapper(std::unique_ptr<RowIterator> iter,
+                               const Row& parameter, const PredicateFun* fun)
+        : RowIterator(), iter_(std::move(iter)), parameter_(parameter), predicate_(fun),
+          pending_(true), pos_(0) {}
+    virtual ~IteratorBatchFilterWrapper() {}
+    bool Valid() const override {
+        if (pending_) {
+            return iter_->Valid() && predicate_->operator()(iter_->GetValue(), parameter_);
+        }
+        return pos_ < rows_.size();
+    }
+    void Next() override;
+    const uint64_t& GetKey() const override {
+        return pending_ ? iter_->GetKey() : keys_[pos_];
+    }
+    const Row& GetValue() override {
+        return pending_ ? iter_->GetValue() : rows_[pos_];
+    }
+    void Seek(const uint64_t& k) override {
+        iter_->Seek(k);
+        NextBatch();
+    }
+    void SeekToFirst() override {
+        iter_->SeekToFirst();
+        NextBatch();
+    }
+    bool IsSeekable() const override { return iter_->IsSeekable(); }
+
+ private:
+    void NextBatch();
+
+    std::unique_ptr<RowIterator> iter_;
+    const Row& parameter_;
+    const PredicateFun* predicate_;
+    bool pending_;
+    size_t pos_;
+    std::vector<uint64_t> keys_;
+    std::vector<Row> rows_;
+    std::vector<uint32_t> selection_;
+};
+
 class WindowIteratorProjectWrapper : public WindowIterator {
  public:
     WindowIteratorProjectWrapper(std::unique_ptr<WindowIterator> iter,
@@ -279,20 +394,16 @@ class PartitionFilterWrapper : public PartitionHandler {
 };
 class TableProjectWrapper : public TableHandler {
  public:
+    // the rows are projected batch by batch if batch is true, see
+    // IteratorBatchProjectWrapper
     TableProjectWrapper(std::shared_ptr<TableHandler> table_handler,
                         const Row& parameter,
-                        const ProjectFun* fun)
-        : TableHandler(), table_hander_(table_handler), parameter_(parameter), value_(), fun_(fun) {}
+                        const ProjectFun* fun, bool batch = false)
+        : TableHandler(), table_hander_(table_handler), parameter_(parameter), value_(), fun_(fun), batch_(batch) {}
     virtual ~TableProjectWrapper() {}
 
     std::unique_ptr<RowIterator> GetIterator() {
-        auto iter = table_hander_->GetIterator();
-        if (!iter) {
-            return std::unique_ptr<RowIterator>();
-        } else {
-            return std::unique_ptr<RowIterator>(
-                new IteratorProjectWrapper(std::move(iter), parameter_, fun_));
-        }
+        return std::unique_ptr<RowIterator>(GetRawIterator());
     }
     const Types& GetTypes() override { return table_hander_->GetTypes(); }
     const IndexHint& GetIndex() override { return table_hander_->GetIndex(); }
@@ -315,6 +426,8 @@ class TableProjectWrapper : public TableHandler {
         auto iter = table_hander_->GetIterator();
         if (!iter) {
             return nullptr;
+        } else if (batch_) {
+            return new IteratorBatchProjectWrapper(std::move(iter), parameter_, fun_);
         } else {
             return new IteratorProjectWrapper(std::move(iter), parameter_, fun_);
         }
@@ -333,20 +446,26 @@ class TableProjectWrapper : public TableHandler {
     const Row& parameter_;
     Row value_;
     const ProjectFun* fun_;
+    const bool batch_;
 };
 
 class TableFilterWrapper : public TableHandler {
  public:
+    // the rows are filtered batch by batch if batch is true, see
+    // IteratorBatchFilterWrapper
     TableFilterWrapper(std::shared_ptr<TableHandler> table_handler,
                        const Row& parameter,
-                       const PredicateFun* fun)
-        : TableHandler(), table_hander_(table_handler), parameter_(parameter), fun_(fun) {}
+                       const PredicateFun* fun, bool batch = false)
+        : TableHandler(), table_hander_(table_handler), parameter_(parameter), fun_(fun), batch_(batch) {}
     virtual ~TableFilterWrapper() {}
 
     std::unique_ptr<RowIterator> GetIterator() {
         auto iter = table_hander_->GetIterator();
         if (!iter) {
             return std::unique_ptr<RowIterator>();
+        } else if (batch_) {
+            return std::unique_ptr<RowIterator>(
+                new IteratorBatchFilterWrapper(std::move(iter), parameter_, fun_));
         } else {
             return std::unique_ptr<RowIterator>(
                 new IteratorFilterWrapper(std::move(iter), parameter_, fun_));
@@ -370,11 +489,11 @@ class TableFilterWrapper : public TableHandler {
         return table_hander_->GetDatabase();
     }
     base::ConstIterator<uint64_t, Row>* GetRawIterator() override {
-        return new IteratorFilterWrapper(
-            static_cast<std::unique_ptr<RowIterator>>(
-                table_hander_->GetRawIterator()),
-            parameter_,
-            fun_);
+        std::unique_ptr<RowIterator> iter(table_hander_->GetRawIterator());
+        if (batch_) {
+            return new IteratorBatchFilterWrapper(std::move(iter), parameter_, fun_);
+        }
+        return new IteratorFilterWrapper(std::move(iter), parameter_, fun_);
     }
     virtual std::shared_ptr<PartitionHandler> GetPartition(
         const std::string& index_name);
@@ -385,6 +504,7 @@ class TableFilterWrapper : public TableHandler {
     const Row& parameter_;
     Row value_;
     const PredicateFun* fun_;
+    const bool batch_;
 };
 
 class RowProjectWrapper : public RowHandler {
@@ -352,11 +352,10 @@ bool CoreAPI::ComputeCondition(const hybridse::vm::RawPtrHandle fn,
 }
 
 hybridse::codec::Row CoreAPI::NewRow(size_t bytes) {
-    auto buf = reinterpret_cast<int8_t*>(malloc(bytes));
-    if (buf == nullptr) {
+    auto slice = base::RefCountedSlice::Allocate(bytes);
+    if (slice.buf() == nullptr) {
         return hybridse::codec::Row();
     }
-    auto slice = base::RefCountedSlice::CreateManaged(buf, bytes);
     return hybridse::codec::Row(slice);
 }
 
@@ -365,13 +364,12 @@ RawPtrHandle CoreAPI::GetRowBuf(hybridse::codec::Row* row, size_t idx) {
 }
 
 RawPtrHandle CoreAPI::AppendRow(hybridse::codec::Row* row, size_t bytes) {
-    auto buf = reinterpret_cast<int8_t*>(malloc(bytes));
-    if (buf == nullptr) {
+    auto slice = base::RefCountedSlice::Allocate(bytes);
+    if (slice.buf() == nullptr) {
         return nullptr;
     }
-    auto slice = base::RefCountedSlice::CreateManaged(buf, bytes);
     row->Append(slice);
-    return buf;
+    return slice.buf();
 }
 
 bool CoreAPI::EnableSignalTraceback() {
@@ -15,9 +15,17 @@
  */
 
 #include "vm/engine.h"
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cinttypes>
+#include <deque>
+#include <functional>
 #include <string>
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
+#include "base/fe_hash.h"
 #include "base/fe_strings.h"
 #include "boost/none.hpp"
 #include "boost/optional.hpp"
@@ -28,6 +36,7 @@
 #include "gflags/gflags.h"
 #include "llvm-c/Target.h"
 #include "udf/default_udf_library.h"
+#include "vm/jit_object_cache.h"
 #include "vm/local_tablet_handler.h"
 #include "vm/mem_catalog.h"
 #include "vm/sql_compiler.h"
@@ -41,6 +50,86 @@ namespace vm {
 
 static bool LLVM_IS_INITIALIZED = false;
 
+// the compile time histograms of more sqls are not recorded
+static const size_t MAX_COMPILE_STATS_SIZE = 4096;
+static const size_t COMPILE_TIME_BUCKETS = 16;
+
+/// The threads running the background compilings of an engine
+class Engine::CompilePool {
+ public:
+    explicit CompilePool(uint32_t thread_num) : mu_(), cv_(), tasks_(), stopped_(false), workers_() {
+        for (uint32_t i = 0; i < thread_num; i++) {
+            workers_.emplace_back(&CompilePool::Run, this);
+        }
+    }
+    // the pending tasks still run before the threads exit
+    ~CompilePool() {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            stopped_ = true;
+        }
+        cv_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    void AddTask(std::function<void()>&& task) {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            tasks_.push_back(std::move(task));
+        }
+        cv_.notify_one();
+    }
+
+ private:
+    void Run() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mu_);
+                cv_.wait(lock, [this] { return stopped_ || !tasks_.empty(); });
+                if (tasks_.empty()) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> tasks_;
+    bool stopped_;
+    std::vector<std::thread> workers_;
+};
+
+std::shared_ptr<CompileInfo> CompileFuture::Wait(base::Status* status) {
+    std::unique_lock<std::mutex> lock(mu_);
+    cv_.wait(lock, [this] { return done_; });
+    if (status != nullptr) {
+        *status = status_;
+    }
+    return info_;
+}
+
+bool CompileFuture::IsDone() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return done_;
+}
+
+void CompileFuture::Finish(const std::shared_ptr<CompileInfo>& info, const base::Status& status) {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        info_ = info;
+        status_ = status;
+        done_ = true;
+    }
+    cv_.notify_all();
+}
+
 EngineOptions::EngineOptions()
     : keep_ir_(false),
       compile_only_(false),
@@ -50,13 +139,23 @@ EngineOptions::EngineOptions()
       enable_expr_optimize_(true),
       enable_batch_window_parallelization_(false),
       enable_window_column_pruning_(false),
-      max_sql_cache_size_(50) {
+      request_window_cache_rows_(0),
+      window_agg_parallelism_(1),
+      sort_parallelism_(1),
+      max_sql_cache_size_(50),
+      compile_thread_num_(2) {
 }
 
-Engine::Engine(const std::shared_ptr<Catalog>& catalog) : cl_(catalog), options_(), mu_(), lru_cache_() {}
+Engine::Engine(const std::shared_ptr<Catalog>& catalog)
+    : cl_(catalog), options_(), mu_(), lru_cache_(), compiling_(), cache_version_(0), db_cache_versions_(), stats_mu_(),
+      compile_stats_(), compile_pool_once_(), compile_pool_() {}
 Engine::Engine(const std::shared_ptr<Catalog>& catalog, const EngineOptions& options)
-    : cl_(catalog), options_(options), mu_(), lru_cache_() {}
-Engine::~Engine() {}
+    : cl_(catalog), options_(options), mu_(), lru_cache_(), compiling_(), cache_version_(0), db_cache_versions_(),
+      stats_mu_(), compile_stats_(), compile_pool_once_(), compile_pool_() {}
+Engine::~Engine() {
+    // wait for the background compilings before destroying the other members
+    compile_pool_.reset();
+}
 void Engine::InitializeGlobalLLVM() {
     if (LLVM_IS_INITIALIZED) return;
     LLVMInitializeNativeTarget();
@@ -68,6 +167,13 @@ void Engine::InitializeUnsafeRowOptFlag(bool isUnsafeRowOpt) {
     FLAGS_enable_spark_unsaferow_format = isUnsafeRowOpt;
 }
 
+void Engine::GetJitObjectCacheStats(uint64_t* hit_cnt, uint64_t* miss_cnt) {
+    *hit_cnt = JitObjectCache::GetHitCount();
+    *miss_cnt = JitObjectCache::GetMissCount();
+}
+
+uint64_t Engine::GetJitObjectCacheEvictCount() { return JitObjectCache::GetEvictCount(); }
+
 bool Engine::GetDependentTables(const std::string& sql, const std::string& db, EngineMode engine_mode,
                                 std::set<std::pair<std::string, std::string>>* db_tables, base::Status& status) {
     auto info = std::make_shared<hybridse::vm::SqlCompileInfo>();
@@ -204,7 +310,30 @@ bool Engine::IsCompatibleCache(RunSession& session,  // NOLINT
 
 bool Engine::Get(const std::string& sql, const std::string& db, RunSession& session,
                  base::Status& status) {  // NOLINT (runtime/references)
-    std::shared_ptr<CompileInfo> cached_info = GetCacheLocked(db, sql, session.engine_mode());
+    auto key = std::make_tuple(session.engine_mode(), db, sql);
+    std::shared_ptr<CompileInfo> cached_info;
+    std::shared_ptr<CompileFuture> compiling;
+    bool is_leader = false;
+    std::pair<uint64_t, uint64_t> cache_version;
+    {
+        std::lock_guard<base::SpinMutex> lock(mu_);
+        cache_version = GetCacheVersion(db);
+        cached_info = GetCache(db, sql, session.engine_mode());
+        if (!cached_info) {
+            // only one caller compiles a missing sql, the others wait for its result
+            auto iter = compiling_.find(key);
+            if (iter == compiling_.end()) {
+                compiling = std::make_shared<CompileFuture>();
+                compiling_.emplace(key, compiling);
+                is_leader = true;
+            } else {
+                compiling = iter->second;
+            }
+        }
+    }
+    if (compiling && !is_leader) {
+        cached_info = compiling->Wait(nullptr);
+    }
     if (cached_info && IsCompatibleCache(session, cached_info, status)) {
         session.SetCompileInfo(cached_info);
         return true;
@@ -214,10 +343,49 @@ bool Engine::Get(const std::string& sql, const std::string& db, RunSession& sess
         LOG(WARNING) << status;
         status = base::Status::OK();
     }
+    std::shared_ptr<CompileInfo> info;
+    bool ok = Compile(sql, db, session, &info, status);
+    {
+        std::lock_guard<base::SpinMutex> lock(mu_);
+        if (ok && cache_version == GetCacheVersion(db)) {
+            SetCache(db, sql, session.engine_mode(), info);
+        }
+        if (is_leader) {
+            auto iter = compiling_.find(key);
+            if (iter != compiling_.end() && iter->second == compiling) {
+                compiling_.erase(iter);
+            }
+        }
+    }
+    if (is_leader) {
+        compiling->Finish(ok ? info : nullptr, status);
+    }
+    if (!ok) {
+        return false;
+    }
+    session.SetCompileInfo(info);
+    if (session.is_debug_) {
+        auto& sql_context = std::dynamic_pointer_cast<SqlCompileInfo>(info)->get_sql_context();
+        std::ostringstream plan_oss;
+        if (nullptr != sql_context.physical_plan) {
+            sql_context.physical_plan->Print(plan_oss, "");
+            LOG(INFO) << "physical plan:\n" << plan_oss.str() << std::endl;
+        }
+        std::ostringstream runner_oss;
+        sql_context.cluster_job.Print(runner_oss, "");
+        LOG(INFO) << "cluster job:\n" << runner_oss.str() << std::endl;
+    }
+    return true;
+}
+
+bool Engine::Compile(const std::string& sql, const std::string& db, RunSession& session,
+                     std::shared_ptr<CompileInfo>* compile_info,
+                     base::Status& status) {  // NOLINT (runtime/references)
     DLOG(INFO) << "Compile Engine ...";
+    auto start = std::chrono::steady_clock::now();
     status = base::Status::OK();
     std::shared_ptr<SqlCompileInfo> info = std::make_shared<SqlCompileInfo>();
-    auto& sql_context = std::dynamic_pointer_cast<SqlCompileInfo>(info)->get_sql_context();
+    auto& sql_context = info->get_sql_context();
     sql_context.sql = sql;
     sql_context.db = db;
     sql_context.engine_mode = session.engine_mode();
@@ -225,6 +393,9 @@ bool Engine::Get(const std::string& sql, const std::string& db, RunSession& sess
     sql_context.is_batch_request_optimized = options_.IsBatchRequestOptimized();
     sql_context.enable_batch_window_parallelization = options_.IsEnableBatchWindowParallelization();
     sql_context.enable_window_column_pruning = options_.IsEnableWindowColumnPruning();
+    sql_context.request_window_cache_rows = options_.GetRequestWindowCacheRows();
+    sql_context.window_agg_parallelism = options_.GetWindowAggParallelism();
+    sql_context.sort_parallelism = options_.GetSortParallelism();
     sql_context.enable_expr_optimize = options_.IsEnableExprOptimize();
     sql_context.jit_options = options_.jit_options();
     sql_context.options = session.GetOptions();
@@ -248,20 +419,59 @@ bool Engine::Get(const std::string& sql, const std::string& db, RunSession& sess
             return false;
         }
     }
+    RecordCompileTime(db, sql,
+                      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start)
+                          .count());
+    *compile_info = info;
+    return true;
+}
 
-    SetCacheLocked(db, sql, session.engine_mode(), info);
-    session.SetCompileInfo(info);
-    if (session.is_debug_) {
-        std::ostringstream plan_oss;
-        if (nullptr != sql_context.physical_plan) {
-            sql_context.physical_plan->Print(plan_oss, "");
-            LOG(INFO) << "physical plan:\n" << plan_oss.str() << std::endl;
+std::shared_ptr<CompileFuture> Engine::GetAsync(const std::string& sql, const std::string& db,
+                                                std::shared_ptr<RunSession> session) {
+    std::call_once(compile_pool_once_, [this]() {
+        compile_pool_.reset(new CompilePool(std::max(1u, options_.GetCompileThreadNum())));
+    });
+    auto future = std::make_shared<CompileFuture>();
+    compile_pool_->AddTask([this, sql, db, session, future]() {
+        base::Status status;
+        bool ok = Get(sql, db, *session, status);
+        future->Finish(ok ? session->GetCompileInfo() : nullptr, status);
+    });
+    return future;
+}
+
+void Engine::RecordCompileTime(const std::string& db, const std::string& sql, uint64_t time_us) {
+    char digest[17];
+    snprintf(digest, sizeof(digest), "%016" PRIx64, base::MurmurHash64A(sql.data(), sql.size(), 0xe17a1465));
+    size_t bucket = 0;
+    for (uint64_t time_ms = time_us / 1000; time_ms > 0 && bucket + 1 < COMPILE_TIME_BUCKETS; time_ms >>= 1) {
+        bucket++;
+    }
+    std::lock_guard<std::mutex> lock(stats_mu_);
+    auto key = std::make_pair(db, std::string(digest));
+    auto iter = compile_stats_.find(key);
+    if (iter == compile_stats_.end()) {
+        if (compile_stats_.size() >= MAX_COMPILE_STATS_SIZE) {
+            return;
         }
-        std::ostringstream runner_oss;
-        sql_context.cluster_job.Print(runner_oss, "");
-        LOG(INFO) << "cluster job:\n" << runner_oss.str() << std::endl;
+        iter = compile_stats_.emplace(key, CompileTimeStats()).first;
+        iter->second.db = db;
+        iter->second.sql_digest = digest;
+        iter->second.buckets.resize(COMPILE_TIME_BUCKETS, 0);
+    }
+    auto& stats = iter->second;
+    stats.count++;
+    stats.total_us += time_us;
+    stats.max_us = std::max(stats.max_us, time_us);
+    stats.buckets[bucket]++;
+}
+
+void Engine::GetCompileTimeStats(std::vector<CompileTimeStats>* stats) {
+    std::lock_guard<std::mutex> lock(stats_mu_);
+    stats->clear();
+    for (auto& kv : compile_stats_) {
+        stats->push_back(kv.second);
     }
-    return true;
 }
 
 base::Status Engine::RegisterExternalFunction(const std::string& name, node::DataType return_type,
@@ -368,8 +578,28 @@ bool Engine::Explain(const std::string& sql, const std::string& db, EngineMode e
     return Explain(sql, db, engine_mode, empty_schema, common_column_indices, explain_output, status);
 }
 
+std::pair<uint64_t, uint64_t> Engine::GetCacheVersion(const std::string& db) const {
+    auto iter = db_cache_versions_.find(db);
+    return std::make_pair(cache_version_, iter == db_cache_versions_.end() ? 0 : iter->second);
+}
+
 void Engine::ClearCacheLocked(const std::string& db) {
     std::lock_guard<base::SpinMutex> lock(mu_);
+    if (db.empty()) {
+        cache_version_++;
+        // the versions of the dbs are compared together with cache_version_, so they can start over
+        db_cache_versions_.clear();
+    } else {
+        db_cache_versions_[db]++;
+    }
+    // the later callers compile again rather than waiting for a compiling with the stale catalog
+    for (auto iter = compiling_.begin(); iter != compiling_.end();) {
+        if (db.empty() || std::get<1>(iter->first) == db) {
+            iter = compiling_.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
     if (db.empty()) {
         lru_cache_.clear();
         return;
@@ -384,9 +614,8 @@ EngineOptions Engine::GetEngineOptions() {
     return options_;
 }
 
-std::shared_ptr<CompileInfo> Engine::GetCacheLocked(const std::string& db, const std::string& sql,
-                                                    EngineMode engine_mode) {
-    std::lock_guard<base::SpinMutex> lock(mu_);
+std::shared_ptr<CompileInfo> Engine::GetCache(const std::string& db, const std::string& sql,
+                                              EngineMode engine_mode) {
     // Check mode
     auto mode_iter = lru_cache_.find(engine_mode);
     if (mode_iter == lru_cache_.end()) {
@@ -409,10 +638,8 @@ std::shared_ptr<CompileInfo> Engine::GetCacheLocked(const std::string& db, const
     }
 }
 
-bool Engine::SetCacheLocked(const std::string& db, const std::string& sql, EngineMode engine_mode,
-                            std::shared_ptr<CompileInfo> info) {
-    std::lock_guard<base::SpinMutex> lock(mu_);
-
+bool Engine::SetCache(const std::string& db, const std::string& sql, EngineMode engine_mode,
+                      std::shared_ptr<CompileInfo> info) {
     auto& mode_cache = lru_cache_[engine_mode];
     using BoostLRU = boost::compute::detail::lru_cache<std::string, std::shared_ptr<CompileInfo>>;
     std::map<std::string, BoostLRU>::iterator db_iter = mode_cache.find(db);
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <thread>  // NOLINT
 #include "case/case_data_mock.h"
 #include "gtest/gtest.h"
 #include "gtest/internal/gtest-param-util.h"
@@ -157,6 +158,122 @@ TEST_F(EngineCompileTest, EngineWithParameterizedLRUCacheTest) {
 }
 
 
+TEST_F(EngineCompileTest, EngineSingleFlightCompileTest) {
+    // Build Simple Catalog
+    auto catalog = BuildSimpleCatalog();
+    hybridse::type::Database db;
+    db.set_name("simple_db");
+    hybridse::type::TableDef table_def;
+    sqlcase::CaseSchemaMock::BuildTableDef(table_def);
+    table_def.set_name("t1");
+    ::hybridse::type::IndexDef* index = table_def.add_indexes();
+    index->set_name("index12");
+    index->add_first_keys("col1");
+    index->add_first_keys("col2");
+    index->set_second_key("col5");
+    AddTable(db, table_def);
+    catalog->AddDatabase(db);
+
+    EngineOptions options;
+    options.SetCompileOnly(true);
+    Engine engine(catalog, options);
+
+    // the concurrent callers share one compiling
+    std::string sql = "select col1, col2 from t1;";
+    std::vector<std::shared_ptr<CompileInfo>> infos(8);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < infos.size(); i++) {
+        threads.emplace_back([&engine, &sql, &infos, i]() {
+            base::Status get_status;
+            BatchRunSession session;
+            ASSERT_TRUE(engine.Get(sql, "simple_db", session, get_status)) << get_status;
+            infos[i] = session.GetCompileInfo();
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (auto& info : infos) {
+        ASSERT_TRUE(info != nullptr);
+        ASSERT_EQ(infos[0].get(), info.get());
+    }
+    std::vector<CompileTimeStats> stats;
+    engine.GetCompileTimeStats(&stats);
+    ASSERT_EQ(1u, stats.size());
+    ASSERT_EQ("simple_db", stats[0].db);
+    ASSERT_EQ(1u, stats[0].count);
+
+    // warm the request plan in the background
+    std::string sql2 = "select col1, col2 as cl2 from t1;";
+    auto session = std::make_shared<RequestRunSession>();
+    auto future = engine.GetAsync(sql2, "simple_db", session);
+    base::Status status;
+    auto info = future->Wait(&status);
+    ASSERT_TRUE(info != nullptr) << status;
+    ASSERT_TRUE(future->IsDone());
+    ASSERT_EQ(info.get(), session->GetCompileInfo().get());
+    RequestRunSession session2;
+    ASSERT_TRUE(engine.Get(sql2, "simple_db", session2, status)) << status;
+    ASSERT_EQ(info.get(), session2.GetCompileInfo().get());
+    engine.GetCompileTimeStats(&stats);
+    ASSERT_EQ(2u, stats.size());
+
+    // the failure is returned by the future
+    auto bad_future = engine.GetAsync("select not_exist from t1;", "simple_db",
+                                      std::make_shared<RequestRunSession>());
+    ASSERT_TRUE(bad_future->Wait(&status) == nullptr);
+    ASSERT_FALSE(status.isOK());
+}
+
+TEST_F(EngineCompileTest, EngineClearOtherDBCacheTest) {
+    auto catalog = BuildSimpleCatalog();
+    for (const std::string& db_name : {"simple_db", "other_db"}) {
+        hybridse::type::Database db;
+        db.set_name(db_name);
+        hybridse::type::TableDef table_def;
+        sqlcase::CaseSchemaMock::BuildTableDef(table_def);
+        table_def.set_name("t1");
+        ::hybridse::type::IndexDef* index = table_def.add_indexes();
+        index->set_name("index12");
+        index->add_first_keys("col1");
+        index->add_first_keys("col2");
+        index->set_second_key("col5");
+        AddTable(db, table_def);
+        catalog->AddDatabase(db);
+    }
+
+    EngineOptions options;
+    options.SetCompileOnly(true);
+    Engine engine(catalog, options);
+
+    // clearing the cache of other_db during the compiling of simple_db keeps
+    // its result in the cache
+    std::string sql = "select col1, col2 from t1;";
+    std::vector<std::shared_ptr<CompileFuture>> futures;
+    for (size_t i = 0; i < 4; i++) {
+        futures.push_back(engine.GetAsync(sql + std::string(i, ' '), "simple_db",
+                                          std::make_shared<RequestRunSession>()));
+        engine.ClearCacheLocked("other_db");
+    }
+    for (size_t i = 0; i < futures.size(); i++) {
+        base::Status status;
+        auto info = futures[i]->Wait(&status);
+        ASSERT_TRUE(info != nullptr) << status;
+        RequestRunSession session;
+        ASSERT_TRUE(engine.Get(sql + std::string(i, ' '), "simple_db", session, status)) << status;
+        ASSERT_EQ(info.get(), session.GetCompileInfo().get());
+    }
+
+    // clearing the cache of simple_db drops it
+    base::Status status;
+    RequestRunSession session;
+    ASSERT_TRUE(engine.Get(sql, "simple_db", session, status)) << status;
+    engine.ClearCacheLocked("simple_db");
+    RequestRunSession session2;
+    ASSERT_TRUE(engine.Get(sql, "simple_db", session2, status)) << status;
+    ASSERT_NE(session.GetCompileInfo().get(), session2.GetCompileInfo().get());
+}
+
 TEST_F(EngineCompileTest, EngineEmptyDefaultDBLRUCacheTest) {
     // Build Simple Catalog
     auto catalog = BuildSimpleCatalog();
@@ -663,6 +780,108 @@ TEST_F(EngineCompileTest, ExternalFunctionTest) {
     std::string sql2 = "select cut2(col0) from t1;";
     ASSERT_TRUE(engine.Get(sql2, "simple_db", session, get_status));
 }
+
+TEST_F(EngineCompileTest, WindowAggParallelismTest) {
+    // Build Simple Catalog
+    auto catalog = BuildSimpleCatalog();
+    hybridse::type::Database db;
+    db.set_name("simple_db");
+    hybridse::type::TableDef table_def;
+    std::vector<Row> rows;
+    // col1 has 100 keys
+    CaseDataMock::BuildOnePkTableData(table_def, rows, 2000);
+    table_def.set_name("t1");
+    AddTable(db, table_def);
+    catalog->AddDatabase(db);
+    ASSERT_TRUE(catalog->InsertRows("simple_db", "t1", rows));
+
+    std::string sql =
+        "select col1, col5, sum(col2) over w as w_sum, count(col0) over w as w_cnt from t1 "
+        "window w as (partition by col1 order by col5 rows between 10 preceding and current row);";
+    std::vector<std::vector<Row>> outputs;
+    for (uint32_t parallelism : {1, 4}) {
+        EngineOptions options;
+        options.SetWindowAggParallelism(parallelism);
+        Engine engine(catalog, options);
+        base::Status get_status;
+        BatchRunSession session;
+        ASSERT_TRUE(engine.Get(sql, "simple_db", session, get_status)) << get_status;
+        std::vector<Row> output;
+        ASSERT_EQ(0, session.Run(output));
+        outputs.push_back(output);
+    }
+    ASSERT_EQ(rows.size(), outputs[0].size());
+    ASSERT_EQ(outputs[0].size(), outputs[1].size());
+    for (size_t i = 0; i < outputs[0].size(); i++) {
+        ASSERT_EQ(0, outputs[0][i].compare(outputs[1][i])) << i;
+    }
+}
+
+// count the fn infos of the plan with a resolved batch function
+static size_t CountBatchFn(const PhysicalOpNode* node) {
+    size_t cnt = 0;
+    for (auto fn_info : node->GetFnInfos()) {
+        if (!fn_info->batch_fn_name().empty() && nullptr != fn_info->batch_fn_address()->Get()) {
+            cnt++;
+        }
+    }
+    for (auto producer : node->GetProducers()) {
+        cnt += CountBatchFn(producer);
+    }
+    return cnt;
+}
+
+TEST_F(EngineCompileTest, BatchFnTest) {
+    // Build Simple Catalog
+    auto catalog = BuildSimpleCatalog();
+    hybridse::type::Database db;
+    db.set_name("simple_db");
+    hybridse::type::TableDef table_def;
+    std::vector<Row> rows;
+    CaseDataMock::BuildOnePkTableData(table_def, rows, 3000);
+    table_def.set_name("t1");
+    AddTable(db, table_def);
+    catalog->AddDatabase(db);
+    ASSERT_TRUE(catalog->InsertRows("simple_db", "t1", rows));
+
+    // the window aggregation outputs a MemTableHandler, so the filter and the
+    // project over it run batch by batch
+    std::string window_sql =
+        "select col1, col5, sum(col1) over w as w_sum from t1 "
+        "window w as (partition by col1 order by col5 rows between 10 preceding and current row)";
+    std::string sql = "select col1, w_sum + 1 as w_sum_1 from (" + window_sql + ") as t where w_sum > 500;";
+    EngineOptions options;
+    Engine engine(catalog, options);
+
+    base::Status get_status;
+    BatchRunSession window_session;
+    ASSERT_TRUE(engine.Get(window_sql + ";", "simple_db", window_session, get_status)) << get_status;
+    std::vector<Row> window_output;
+    ASSERT_EQ(0, window_session.Run(window_output));
+    codec::RowView window_row_view(window_session.GetSchema());
+    std::vector<std::pair<int32_t, int32_t>> expect;
+    for (auto& row : window_output) {
+        window_row_view.Reset(row.buf());
+        int32_t w_sum = window_row_view.GetInt32Unsafe(2);
+        if (w_sum > 500) {
+            expect.push_back(std::make_pair(window_row_view.GetInt32Unsafe(0), w_sum + 1));
+        }
+    }
+    ASSERT_LT(0u, expect.size());
+
+    BatchRunSession session;
+    ASSERT_TRUE(engine.Get(sql, "simple_db", session, get_status)) << get_status;
+    ASSERT_LT(0u, CountBatchFn(session.GetCompileInfo()->GetPhysicalPlan()));
+    std::vector<Row> output;
+    ASSERT_EQ(0, session.Run(output));
+    ASSERT_EQ(expect.size(), output.size());
+    codec::RowView row_view(session.GetSchema());
+    for (size_t i = 0; i < output.size(); i++) {
+        row_view.Reset(output[i].buf());
+        ASSERT_EQ(expect[i].first, row_view.GetInt32Unsafe(0)) << i;
+        ASSERT_EQ(expect[i].second, row_view.GetInt32Unsafe(1)) << i;
+    }
+}
 }  // namespace vm
 }  // namespace hybridse
 
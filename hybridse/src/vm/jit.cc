@@ -15,13 +15,18 @@
  */
 
 #include "vm/jit.h"
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
 #include <string>
+#include <thread>  // NOLINT
 #include <utility>
 extern "C" {
 #include <cmath>
 #include <cstdlib>
 }
 #include "glog/logging.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/ExecutionEngine/JITEventListener.h"
 #include "llvm/ExecutionEngine/JITSymbol.h"
 #include "llvm/ExecutionEngine/Orc/CompileUtils.h"
@@ -36,10 +41,15 @@ extern "C" {
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Transforms/IPO.h"
+#include "llvm/Transforms/IPO/PassManagerBuilder.h"
 #include "llvm/Transforms/InstCombine/InstCombine.h"
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Transforms/Scalar/GVN.h"
 #include "llvm/Transforms/Utils.h"
+#include "vm/physical_op.h"
 #ifdef LLVM_EXT_ENABLE
 #include "llvm_ext/symbol_resolve.h"
 #endif
@@ -66,6 +76,32 @@ static void RunDefaultOptPasses(::llvm::Module* m) {
     }
 }
 
+static void RunAggressiveOptPasses(::llvm::Module* m,
+                                   ::llvm::TargetMachine* tm) {
+    ::llvm::PassManagerBuilder builder;
+    builder.OptLevel = 3;
+    builder.SizeLevel = 0;
+    builder.Inliner = ::llvm::createFunctionInliningPass(3, 0, false);
+    builder.LoopVectorize = true;
+    builder.SLPVectorize = true;
+    tm->adjustPassManager(builder);
+
+    ::llvm::legacy::FunctionPassManager fpm(m);
+    ::llvm::legacy::PassManager mpm;
+    fpm.add(::llvm::createTargetTransformInfoWrapperPass(
+        tm->getTargetIRAnalysis()));
+    mpm.add(::llvm::createTargetTransformInfoWrapperPass(
+        tm->getTargetIRAnalysis()));
+    builder.populateFunctionPassManager(fpm);
+    builder.populateModulePassManager(mpm);
+    fpm.doInitialization();
+    for (auto it = m->begin(); it != m->end(); ++it) {
+        fpm.run(*it);
+    }
+    fpm.doFinalization();
+    mpm.run(*m);
+}
+
 ::llvm::Error HybridSeJit::AddIRModule(::llvm::orc::JITDylib& jd,  // NOLINT
                                        ::llvm::orc::ThreadSafeModule tsm,
                                        ::llvm::orc::VModuleKey key) {
@@ -88,6 +124,32 @@ bool HybridSeJit::OptModule(::llvm::Module* m) {
     return true;
 }
 
+bool HybridSeJit::OptModule(::llvm::Module* m, JitTier tier,
+                            ::llvm::TargetMachine* tm) {
+    switch (tier) {
+        case kJitTierFast: {
+            if (auto err = applyDataLayout(*m)) {
+                return false;
+            }
+            return true;
+        }
+        case kJitTierOptimized: {
+            if (auto err = applyDataLayout(*m)) {
+                return false;
+            }
+            if (tm == nullptr) {
+                LOG(WARNING) << "no target machine to optimize module";
+                return false;
+            }
+            RunAggressiveOptPasses(m, tm);
+            DLOG(INFO) << "Module after aggressive opt:\n" << LlvmToString(*m);
+            return true;
+        }
+        default:
+            return OptModule(m);
+    }
+}
+
 ::llvm::orc::VModuleKey HybridSeJit::CreateVModule() {
     ::llvm::orc::VModuleKey key = ES->allocateVModule();
     DLOG(INFO) << "allocate a new module key " << key;
@@ -148,10 +210,128 @@ bool HybridSeJit::AddSymbol(::llvm::orc::JITDylib& jd,
     }
 }
 
+// the threads recompiling the hot modules, shared by all the jits. a tier up is
+// dropped if the queue is full, its functions stay on the fast tier
+class TierUpPool {
+ public:
+    static TierUpPool* Get() {
+        // never destroyed, the threads may be still compiling at the exit
+        static TierUpPool* pool = new TierUpPool();
+        return pool;
+    }
+
+    bool AddTask(std::function<void()>&& task) {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            if (tasks_.size() >= kMaxTasks) {
+                return false;
+            }
+            tasks_.push_back(std::move(task));
+        }
+        cv_.notify_one();
+        return true;
+    }
+
+ private:
+    static const size_t kThreadNum = 2;
+    static const size_t kMaxTasks = 64;
+
+    TierUpPool() {
+        for (size_t i = 0; i < kThreadNum; i++) {
+            std::thread(&TierUpPool::Run, this).detach();
+        }
+    }
+
+    void Run() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mu_);
+                cv_.wait(lock, [this] { return !tasks_.empty(); });
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> tasks_;
+};
+
+HybridSeLlvmJitWrapper::HybridSeLlvmJitWrapper(const JitOptions& jit_options,
+                                               JitTier tier)
+    : jit_options_(jit_options), tier_(tier) {
+    if (tier_ == kJitTierFast) {
+        tier_up_state_ = std::make_shared<TierUpState>(jit_options_);
+    }
+}
+
+HybridSeLlvmJitWrapper::~HybridSeLlvmJitWrapper() {
+    // a running tier up is not waited, it keeps the state and drops its result
+    if (tier_up_state_ != nullptr) {
+        std::lock_guard<std::mutex> lock(tier_up_state_->mu);
+        tier_up_state_->cancelled = true;
+    }
+}
+
 bool HybridSeLlvmJitWrapper::Init() {
     DLOG(INFO) << "Start to initialize hybridse jit";
-    auto jit = ::llvm::Expected<std::unique_ptr<HybridSeJit>>(
-        HybridSeJitBuilder().create());
+    HybridSeJitBuilder builder;
+    if (tier_ != kJitTierDefault) {
+        auto jtmb = ::llvm::orc::JITTargetMachineBuilder::detectHost();
+        if (!jtmb) {
+            LOG(WARNING) << "fail to detect host: "
+                         << LlvmToString(jtmb.takeError());
+            return false;
+        }
+        jtmb->setCodeGenOptLevel(tier_ == kJitTierFast
+                                     ? ::llvm::CodeGenOpt::None
+                                     : ::llvm::CodeGenOpt::Aggressive);
+        if (tier_ == kJitTierOptimized) {
+            auto tm = jtmb->createTargetMachine();
+            if (!tm) {
+                LOG(WARNING) << "fail to create target machine: "
+                             << LlvmToString(tm.takeError());
+                return false;
+            }
+            target_machine_ = std::move(*tm);
+        }
+        builder.setJITTargetMachineBuilder(std::move(*jtmb));
+    }
+    if (!jit_options_.GetObjectCacheDir().empty()) {
+        // the objects compiled with another codegen level or tiering are not
+        // shared
+        std::string jit_kind = tier_ == kJitTierFast
+                                   ? "lljit;O0"
+                                   : tier_ == kJitTierOptimized ? "lljit;O3"
+                                                                : "lljit;O2";
+        if (jit_options_.IsEnableTieredJit()) {
+            jit_kind.append(";tiered");
+        }
+        object_cache_ = JitObjectCache::Get(
+            jit_options_.GetObjectCacheDir(), jit_kind,
+            jit_options_.GetObjectCacheMaxBytes());
+        ::llvm::ObjectCache* cache = object_cache_.get();
+        builder.setCompileFunctionCreator(
+            [cache](::llvm::orc::JITTargetMachineBuilder jtmb)
+                -> ::llvm::Expected<
+                    ::llvm::orc::IRCompileLayer::CompileFunction> {
+                auto tm = jtmb.createTargetMachine();
+                if (!tm) {
+                    return tm.takeError();
+                }
+                // shared because the compile function is copied
+                std::shared_ptr<::llvm::TargetMachine> target(std::move(*tm));
+                return ::llvm::orc::IRCompileLayer::CompileFunction(
+                    [target, cache](::llvm::Module& m) {
+                        return ::llvm::orc::SimpleCompiler(*target, cache)(m);
+                    });
+            });
+    }
+    auto jit =
+        ::llvm::Expected<std::unique_ptr<HybridSeJit>>(builder.create());
     {
         ::llvm::Error e = jit.takeError();
         if (e) {
@@ -170,12 +350,17 @@ bool HybridSeLlvmJitWrapper::Init() {
 }
 
 bool HybridSeLlvmJitWrapper::OptModule(::llvm::Module* module) {
-    return jit_->OptModule(module);
+    return jit_->OptModule(module, tier_, target_machine_.get());
 }
 
 bool HybridSeLlvmJitWrapper::AddModule(
     std::unique_ptr<llvm::Module> module,
     std::unique_ptr<llvm::LLVMContext> llvm_ctx) {
+    if (tier_ == kJitTierFast) {
+        // a module can not be shared by two jits, so keep its ir and parse it
+        // into another context when it gets hot
+        tier_up_state_->module_ir = LlvmToString(*module);
+    }
     ::llvm::Error e = jit_->addIRModule(
         ::llvm::orc::ThreadSafeModule(std::move(module), std::move(llvm_ctx)));
     if (e) {
@@ -199,8 +384,114 @@ RawPtrHandle HybridSeLlvmJitWrapper::FindFunction(const std::string& funcname) {
     return reinterpret_cast<const int8_t*>(symbol->getAddress());
 }
 
+bool HybridSeLlvmJitWrapper::ResolveFunction(
+    const std::string& funcname, const std::shared_ptr<FnAddress>& address) {
+    if (!HybridSeJitWrapper::ResolveFunction(funcname, address)) {
+        return false;
+    }
+    if (tier_ != kJitTierFast) {
+        return true;
+    }
+    {
+        std::lock_guard<std::mutex> lock(tier_up_state_->mu);
+        tier_up_state_->addresses[funcname].push_back(address);
+    }
+    // the state keeps the addresses, so the callback does not keep the state
+    std::weak_ptr<TierUpState> state = tier_up_state_;
+    address->WatchCalls(jit_options_.GetTieredJitThreshold(),
+                        [state]() { OnFunctionHot(state.lock()); });
+    return true;
+}
+
+void HybridSeLlvmJitWrapper::OnFunctionHot(
+    const std::shared_ptr<TierUpState>& state) {
+    if (state == nullptr) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(state->mu);
+        if (state->cancelled || state->started) {
+            return;
+        }
+        state->started = true;
+    }
+    // the whole module is recompiled, the functions of a sql are usually
+    // called by the same runners
+    if (!TierUpPool::Get()->AddTask([state]() { TierUp(state); })) {
+        LOG(WARNING) << "too many hot modules to recompile, keep the fast tier";
+    }
+}
+
+void HybridSeLlvmJitWrapper::TierUp(const std::shared_ptr<TierUpState>& state) {
+    auto cancelled = [&state]() {
+        std::lock_guard<std::mutex> lock(state->mu);
+        return state->cancelled;
+    };
+    if (cancelled()) {
+        return;
+    }
+    DLOG(INFO) << "Start to recompile hot module";
+    std::unique_ptr<HybridSeLlvmJitWrapper> jit(
+        new HybridSeLlvmJitWrapper(state->jit_options, kJitTierOptimized));
+    if (!jit->Init()) {
+        LOG(WARNING) << "fail to init optimized jit";
+        return;
+    }
+    for (auto& symbol : state->extern_functions) {
+        jit->AddExternalFunction(symbol.first, symbol.second);
+    }
+    ::llvm::SMDiagnostic diagnostic;
+    auto llvm_ctx = ::llvm::make_unique<::llvm::LLVMContext>();
+    auto mem_buf = ::llvm::MemoryBuffer::getMemBuffer(state->module_ir);
+    auto module = ::llvm::parseIR(*mem_buf, diagnostic, *llvm_ctx);
+    if (module == nullptr) {
+        LOG(WARNING) << "fail to parse hot module: "
+                     << diagnostic.getMessage().str();
+        return;
+    }
+    if (cancelled()) {
+        return;
+    }
+    if (!jit->OptModule(module.get()) ||
+        !jit->AddModule(std::move(module), std::move(llvm_ctx))) {
+        LOG(WARNING) << "fail to compile hot module";
+        return;
+    }
+    std::map<std::string, std::vector<std::shared_ptr<FnAddress>>> addresses;
+    {
+        std::lock_guard<std::mutex> lock(state->mu);
+        addresses = state->addresses;
+    }
+    // the lookups materialize the module, so they are not under the lock
+    std::vector<std::pair<std::shared_ptr<FnAddress>, const int8_t*>> replaced;
+    for (auto& kv : addresses) {
+        if (cancelled()) {
+            return;
+        }
+        auto addr = jit->FindFunction(kv.first);
+        if (addr == nullptr) {
+            continue;
+        }
+        for (auto& address : kv.second) {
+            replaced.emplace_back(address, addr);
+        }
+    }
+    std::lock_guard<std::mutex> lock(state->mu);
+    if (state->cancelled) {
+        return;
+    }
+    for (auto& pair : replaced) {
+        pair.first->Set(pair.second);
+    }
+    state->optimized_jit = std::move(jit);
+    DLOG(INFO) << "Replace " << addresses.size() << " hot functions";
+}
+
 bool HybridSeLlvmJitWrapper::AddExternalFunction(const std::string& name,
                                                void* addr) {
+    if (tier_ == kJitTierFast) {
+        tier_up_state_->extern_functions.emplace_back(name, addr);
+    }
     return hybridse::vm::HybridSeJit::AddSymbol(jit_->getMainJITDylib(), *mi_,
                                                 name, addr);
 }
@@ -251,6 +542,12 @@ bool HybridSeMcJitWrapper::AddModule(
         for (auto& pair : extern_functions_) {
             resolver->addSymbol(pair.first, pair.second);
         }
+        if (!jit_options_.GetObjectCacheDir().empty()) {
+            object_cache_ = JitObjectCache::Get(
+                jit_options_.GetObjectCacheDir(), "mcjit",
+                jit_options_.GetObjectCacheMaxBytes());
+            execution_engine_->setObjectCache(object_cache_.get());
+        }
     } else {
         execution_engine_->addModule(std::move(module));
     }
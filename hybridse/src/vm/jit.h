@@ -19,9 +19,14 @@
 
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <utility>
+#include <vector>
 #include "llvm/ExecutionEngine/GenericValue.h"
 #include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/Target/TargetMachine.h"
+#include "vm/jit_object_cache.h"
 #include "vm/jit_wrapper.h"
 
 #ifdef LLVM_EXT_ENABLE
@@ -37,6 +42,16 @@ struct JitString {
     int8_t* data;
 };
 
+/// How much a module is optimized before compiling
+enum JitTier {
+    // no ir optimization, the first tier of a tiered jit
+    kJitTierFast,
+    kJitTierDefault,
+    // aggressive ir optimization and vectorization, the second tier of a
+    // tiered jit
+    kJitTierOptimized,
+};
+
 class HybridSeJit : public ::llvm::orc::LLJIT {
     template <typename, typename, typename>
     friend class ::llvm::orc::LLJITBuilderSetters;
@@ -50,6 +65,9 @@ class HybridSeJit : public ::llvm::orc::LLJIT {
 
     bool OptModule(::llvm::Module* m);
 
+    // the target machine is required by the vectorization
+    bool OptModule(::llvm::Module* m, JitTier tier, ::llvm::TargetMachine* tm);
+
     ::llvm::orc::VModuleKey CreateVModule();
 
     void ReleaseVModule(::llvm::orc::VModuleKey key);
@@ -87,8 +105,14 @@ std::string LlvmToString(const T& value) {
 
 class HybridSeLlvmJitWrapper : public HybridSeJitWrapper {
  public:
-    HybridSeLlvmJitWrapper() {}
-    ~HybridSeLlvmJitWrapper() {}
+    HybridSeLlvmJitWrapper() : tier_(kJitTierDefault) {}
+    explicit HybridSeLlvmJitWrapper(const JitOptions& jit_options)
+        : HybridSeLlvmJitWrapper(jit_options,
+                                 jit_options.IsEnableTieredJit()
+                                     ? kJitTierFast
+                                     : kJitTierDefault) {}
+    HybridSeLlvmJitWrapper(const JitOptions& jit_options, JitTier tier);
+    ~HybridSeLlvmJitWrapper();
 
     bool Init() override;
 
@@ -102,9 +126,44 @@ class HybridSeLlvmJitWrapper : public HybridSeJitWrapper {
     hybridse::vm::RawPtrHandle FindFunction(
         const std::string& funcname) override;
 
+    bool ResolveFunction(const std::string& funcname,
+                         const std::shared_ptr<FnAddress>& address) override;
+
  private:
+    // shared with the callbacks of the function addresses and the tier up
+    // task, which may outlive the wrapper
+    struct TierUpState {
+        explicit TierUpState(const JitOptions& options)
+            : jit_options(options) {}
+        const JitOptions jit_options;
+        // the fast tier keeps the ir and the symbols to compile it again
+        std::string module_ir;
+        std::vector<std::pair<std::string, void*>> extern_functions;
+        std::mutex mu;
+        // set when the wrapper is destroyed, the tier up task stops at the
+        // next step and never replaces the addresses
+        bool cancelled = false;
+        bool started = false;
+        std::map<std::string, std::vector<std::shared_ptr<FnAddress>>>
+            addresses;
+        // the functions of both tiers are kept, a runner may be still calling
+        // the replaced ones
+        std::unique_ptr<HybridSeLlvmJitWrapper> optimized_jit;
+    };
+    static void OnFunctionHot(const std::shared_ptr<TierUpState>& state);
+    // recompile the module with the optimized tier and replace the addresses
+    static void TierUp(const std::shared_ptr<TierUpState>& state);
+
+    const JitOptions jit_options_;
+    const JitTier tier_;
+    // declared before jit_ to outlive the compiler which uses it
+    std::shared_ptr<JitObjectCache> object_cache_;
+    std::unique_ptr<::llvm::TargetMachine> target_machine_;
     std::unique_ptr<HybridSeJit> jit_;
     std::unique_ptr<::llvm::orc::MangleAndInterner> mi_;
+
+    // only the fast tier has a state
+    std::shared_ptr<TierUpState> tier_up_state_;
 };
 
 #ifdef LLVM_EXT_ENABLE
@@ -133,6 +192,7 @@ class HybridSeMcJitWrapper : public HybridSeJitWrapper {
     const JitOptions jit_options_;
     std::string err_str_ = "";
     std::map<std::string, void*> extern_functions_;
+    std::shared_ptr<JitObjectCache> object_cache_;
     llvm::ExecutionEngine* execution_engine_ = nullptr;
 };
 #endif
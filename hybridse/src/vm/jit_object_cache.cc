@@ -0,0 +1,285 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vm/jit_object_cache.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <utime.h>
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "glog/logging.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "udf/default_udf_library.h"
+
+namespace hybridse {
+namespace vm {
+
+// change it if the objects compiled from the same ir are not compatible
+static const char OBJECT_CACHE_FORMAT[] = "1";
+
+static std::atomic<uint64_t> g_hit_cnt(0);
+static std::atomic<uint64_t> g_miss_cnt(0);
+static std::atomic<uint64_t> g_evict_cnt(0);
+static std::atomic<uint64_t> g_tmp_file_id(0);
+
+static std::string HostVersion(const std::string& jit_kind) {
+    std::string version = std::string(OBJECT_CACHE_FORMAT) + ";" +
+                          LLVM_VERSION_STRING + ";" + jit_kind + ";" +
+                          ::llvm::sys::getProcessTriple() + ";" +
+                          ::llvm::sys::getHostCPUName().str();
+    ::llvm::StringMap<bool> features;
+    if (::llvm::sys::getHostCPUFeatures(features)) {
+        std::vector<std::string> enabled;
+        for (auto& feature : features) {
+            if (feature.second) {
+                enabled.push_back(feature.first().str());
+            }
+        }
+        std::sort(enabled.begin(), enabled.end());
+        for (auto& name : enabled) {
+            version.append(";+").append(name);
+        }
+    }
+    return version;
+}
+
+// the object files of a directory ordered by their last use
+struct JitObjectCache::ObjectFiles {
+    explicit ObjectFiles(const std::string& dir_path);
+
+    // record the use of the object of key, and remove the least recently used
+    // objects once the total size exceeds max_bytes
+    void Use(const std::string& key, uint64_t size);
+
+    const std::string dir;
+    std::mutex mu;
+    uint64_t max_bytes = 0;
+    uint64_t total_bytes = 0;
+    uint64_t tick = 0;
+    // key -> the size and the tick of the last use
+    std::map<std::string, std::pair<uint64_t, uint64_t>> objects;
+    // the tick of the last use -> key
+    std::map<uint64_t, std::string> lru;
+};
+
+static const size_t OBJECT_KEY_SIZE = 32;
+
+JitObjectCache::ObjectFiles::ObjectFiles(const std::string& dir_path)
+    : dir(dir_path) {
+    auto err = ::llvm::sys::fs::create_directories(dir);
+    if (err) {
+        LOG(WARNING) << "fail to create jit object cache dir " << dir << ": "
+                     << err.message();
+        return;
+    }
+    // the objects left by the last run are ordered by their modification
+    // time, which is updated on every hit
+    std::vector<std::tuple<::llvm::sys::TimePoint<>, std::string, uint64_t>>
+        found;
+    std::error_code ec;
+    for (::llvm::sys::fs::directory_iterator it(dir, ec), end;
+         !ec && it != end; it.increment(ec)) {
+        auto name = ::llvm::sys::path::filename(it->path());
+        if (name.size() != OBJECT_KEY_SIZE + 2 || !name.endswith(".o")) {
+            continue;
+        }
+        ::llvm::sys::fs::file_status status;
+        if (::llvm::sys::fs::status(it->path(), status)) {
+            continue;
+        }
+        found.emplace_back(status.getLastModificationTime(),
+                           name.drop_back(2).str(), status.getSize());
+    }
+    std::sort(found.begin(), found.end());
+    for (auto& file : found) {
+        objects[std::get<1>(file)] = std::make_pair(std::get<2>(file), tick);
+        lru[tick++] = std::get<1>(file);
+        total_bytes += std::get<2>(file);
+    }
+}
+
+void JitObjectCache::ObjectFiles::Use(const std::string& key, uint64_t size) {
+    std::lock_guard<std::mutex> lock(mu);
+    auto it = objects.find(key);
+    if (it != objects.end()) {
+        lru.erase(it->second.second);
+        total_bytes -= it->second.first;
+    }
+    objects[key] = std::make_pair(size, tick);
+    lru[tick++] = key;
+    total_bytes += size;
+    // the object just used is kept even if it exceeds the limit alone
+    while (max_bytes > 0 && total_bytes > max_bytes && lru.size() > 1) {
+        auto oldest = lru.begin();
+        auto pos = objects.find(oldest->second);
+        std::string path = dir + "/" + oldest->second + ".o";
+        if (unlink(path.c_str()) != 0 && errno != ENOENT) {
+            LOG(WARNING) << "fail to remove jit object " << path;
+        }
+        total_bytes -= pos->second.first;
+        objects.erase(pos);
+        lru.erase(oldest);
+        g_evict_cnt.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// hash the printed module as it is written instead of keeping the text
+class HashStream : public ::llvm::raw_ostream {
+ public:
+    HashStream() : ::llvm::raw_ostream(), md5_(), pos_(0) {}
+    ~HashStream() override { flush(); }
+
+    std::string Digest() {
+        flush();
+        ::llvm::MD5::MD5Result result;
+        md5_.final(result);
+        return result.digest().str().str();
+    }
+
+ private:
+    void write_impl(const char* ptr, size_t size) override {
+        md5_.update(::llvm::StringRef(ptr, size));
+        pos_ += size;
+    }
+    uint64_t current_pos() const override { return pos_; }
+
+    ::llvm::MD5 md5_;
+    uint64_t pos_;
+};
+
+JitObjectCache::JitObjectCache(const std::string& dir,
+                               const std::string& jit_kind,
+                               const std::shared_ptr<ObjectFiles>& files)
+    : dir_(dir),
+      version_(HostVersion(jit_kind)),
+      files_(files),
+      mu_(),
+      pending_() {}
+
+std::shared_ptr<JitObjectCache> JitObjectCache::Get(
+    const std::string& dir, const std::string& jit_kind, uint64_t max_bytes) {
+    static std::mutex mu;
+    static std::map<std::string, std::shared_ptr<ObjectFiles>> dirs;
+    static std::map<std::pair<std::string, std::string>,
+                    std::shared_ptr<JitObjectCache>>
+        caches;
+    std::lock_guard<std::mutex> lock(mu);
+    auto& files = dirs[dir];
+    if (files == nullptr) {
+        files = std::make_shared<ObjectFiles>(dir);
+    }
+    {
+        std::lock_guard<std::mutex> files_lock(files->mu);
+        files->max_bytes = max_bytes;
+    }
+    auto& cache = caches[std::make_pair(dir, jit_kind)];
+    if (cache == nullptr) {
+        cache = std::make_shared<JitObjectCache>(dir, jit_kind, files);
+    }
+    return cache;
+}
+
+uint64_t JitObjectCache::GetHitCount() {
+    return g_hit_cnt.load(std::memory_order_relaxed);
+}
+
+uint64_t JitObjectCache::GetMissCount() {
+    return g_miss_cnt.load(std::memory_order_relaxed);
+}
+
+uint64_t JitObjectCache::GetEvictCount() {
+    return g_evict_cnt.load(std::memory_order_relaxed);
+}
+
+std::string JitObjectCache::GetKey(const ::llvm::Module* m) const {
+    HashStream ss;
+    ss << version_ << ";"
+       << udf::DefaultUdfLibrary::get()->GetExternalSymbolsHash() << "\n";
+    m->print(ss, nullptr);
+    return ss.Digest();
+}
+
+std::unique_ptr<::llvm::MemoryBuffer> JitObjectCache::getObject(
+    const ::llvm::Module* m) {
+    std::string key = GetKey(m);
+    std::string path = dir_ + "/" + key + ".o";
+    auto buf = ::llvm::MemoryBuffer::getFile(path, -1, false);
+    if (buf) {
+        g_hit_cnt.fetch_add(1, std::memory_order_relaxed);
+        DLOG(INFO) << "load jit object " << path;
+        // keep the order of the uses for the next run
+        utime(path.c_str(), nullptr);
+        files_->Use(key, buf.get()->getBufferSize());
+        return std::move(buf.get());
+    }
+    g_miss_cnt.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mu_);
+    pending_[m] = key;
+    return nullptr;
+}
+
+void JitObjectCache::notifyObjectCompiled(const ::llvm::Module* m,
+                                          ::llvm::MemoryBufferRef obj) {
+    std::string key;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        auto it = pending_.find(m);
+        if (it == pending_.end()) {
+            return;
+        }
+        key = it->second;
+        pending_.erase(it);
+    }
+    std::string path = dir_ + "/" + key + ".o";
+    // write a temporary file and rename it, so a reader never sees a part of
+    // the object even if several processes compile the same sql
+    std::string tmp_path =
+        path + ".tmp." + std::to_string(getpid()) + "." +
+        std::to_string(g_tmp_file_id.fetch_add(1, std::memory_order_relaxed));
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        out.write(obj.getBufferStart(), obj.getBufferSize());
+        out.close();
+        if (!out) {
+            LOG(WARNING) << "fail to write jit object " << tmp_path;
+            unlink(tmp_path.c_str());
+            return;
+        }
+    }
+    if (rename(tmp_path.c_str(), path.c_str()) != 0) {
+        LOG(WARNING) << "fail to rename jit object " << tmp_path << " to "
+                     << path;
+        unlink(tmp_path.c_str());
+        return;
+    }
+    files_->Use(key, obj.getBufferSize());
+    DLOG(INFO) << "save jit object " << path;
+}
+
+}  // namespace vm
+}  // namespace hybridse
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HYBRIDSE_SRC_VM_JIT_OBJECT_CACHE_H_
+#define HYBRIDSE_SRC_VM_JIT_OBJECT_CACHE_H_
+
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+namespace hybridse {
+namespace vm {
+
+/// The object code of the compiled modules persisted in a directory. An
+/// object is keyed by the hash of the optimized module ir, the host target,
+/// the jit kind and the external symbols of the udf library, so the same sql
+/// loads its machine code after a restart instead of compiling it again.
+///
+/// The objects of a directory are shared by its caches of all the jit kinds.
+/// Once their total size exceeds the limit, the least recently used ones are
+/// removed.
+class JitObjectCache : public ::llvm::ObjectCache {
+ public:
+    struct ObjectFiles;
+
+    JitObjectCache(const std::string& dir, const std::string& jit_kind,
+                   const std::shared_ptr<ObjectFiles>& files);
+    ~JitObjectCache() override {}
+
+    std::unique_ptr<::llvm::MemoryBuffer> getObject(
+        const ::llvm::Module* m) override;
+
+    void notifyObjectCompiled(const ::llvm::Module* m,
+                              ::llvm::MemoryBufferRef obj) override;
+
+    /// Return the cache shared by the jits of the directory and the jit kind.
+    /// `max_bytes` limits the total size of the objects of the directory, `0`
+    /// means no limit
+    static std::shared_ptr<JitObjectCache> Get(const std::string& dir,
+                                               const std::string& jit_kind,
+                                               uint64_t max_bytes = 0);
+
+    /// The hit, miss and eviction counts of all the caches of the process
+    static uint64_t GetHitCount();
+    static uint64_t GetMissCount();
+    static uint64_t GetEvictCount();
+
+ private:
+    std::string GetKey(const ::llvm::Module* m) const;
+
+    const std::string dir_;
+    const std::string version_;
+    const std::shared_ptr<ObjectFiles> files_;
+
+    std::mutex mu_;
+    // the keys of the modules compiled after a miss. the codegen passes may
+    // change a module before it is notified, so the key is not computed again
+    std::map<const ::llvm::Module*, std::string> pending_;
+};
+
+}  // namespace vm
+}  // namespace hybridse
+#endif  // HYBRIDSE_SRC_VM_JIT_OBJECT_CACHE_H_
@@ -39,6 +39,7 @@
 #include "udf/default_udf_library.h"
 #include "udf/udf.h"
 #include "vm/jit.h"
+#include "vm/physical_op.h"
 
 namespace hybridse {
 namespace vm {
@@ -59,6 +60,13 @@ bool HybridSeJitWrapper::AddModuleFromBuffer(const base::RawBuffer& buf) {
     return this->AddModule(std::move(llvm_module), std::move(llvm_ctx));
 }
 
+bool HybridSeJitWrapper::ResolveFunction(
+    const std::string& funcname, const std::shared_ptr<FnAddress>& address) {
+    auto addr = FindFunction(funcname);
+    address->Set(addr);
+    return addr != nullptr;
+}
+
 bool HybridSeJitWrapper::InitJitSymbols(HybridSeJitWrapper* jit) {
     InitBuiltinJitSymbols(jit);
     udf::DefaultUdfLibrary::get()->InitJITSymbols(jit);
@@ -73,17 +81,20 @@ HybridSeJitWrapper* HybridSeJitWrapper::Create(const JitOptions& jit_options) {
     if (jit_options.IsEnableMcjit()) {
 #ifdef LLVM_EXT_ENABLE
         LOG(INFO) << "Create McJit engine";
+        if (jit_options.IsEnableTieredJit()) {
+            LOG(WARNING) << "McJit do not support tiered jit";
+        }
         return new HybridSeMcJitWrapper(jit_options);
 #else
         LOG(WARNING) << "McJit support is not enabled";
-        return new HybridSeLlvmJitWrapper();
+        return new HybridSeLlvmJitWrapper(jit_options);
 #endif
     } else {
         if (jit_options.IsEnableVtune() || jit_options.IsEnablePerf() ||
             jit_options.IsEnableGdb()) {
             LOG(WARNING) << "LLJIT do not support jit events";
         }
-        return new HybridSeLlvmJitWrapper();
+        return new HybridSeLlvmJitWrapper(jit_options);
     }
 }
 
@@ -151,6 +162,9 @@ void InitBuiltinJitSymbols(HybridSeJitWrapper* jit) {
     jit->AddExternalFunction(
         "hybridse_storage_get_inner_rows_list",
         reinterpret_cast<void*>(&codec::v1::GetInnerRowsList));
+    jit->AddExternalFunction(
+        "hybridse_storage_get_columnar",
+        reinterpret_cast<void*>(&codec::v1::GetColumnar));
 
     // encode
     jit->AddExternalFunction("hybridse_storage_encode_int16_field",
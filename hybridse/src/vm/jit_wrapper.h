@@ -31,6 +31,7 @@ namespace hybridse {
 namespace vm {
 
 class JitOptions;
+class FnAddress;
 
 class HybridSeJitWrapper {
  public:
@@ -51,6 +52,11 @@ class HybridSeJitWrapper {
     virtual hybridse::vm::RawPtrHandle FindFunction(
         const std::string& funcname) = 0;
 
+    /// Find the function and set it into the address, which a tiered jit may
+    /// replace later
+    virtual bool ResolveFunction(const std::string& funcname,
+                                 const std::shared_ptr<FnAddress>& address);
+
     static HybridSeJitWrapper* Create(const JitOptions& jit_options);
     static HybridSeJitWrapper* Create();
     static void DeleteJit(HybridSeJitWrapper* jit);
@@ -15,10 +15,12 @@
  */
 
 #include "vm/jit_wrapper.h"
+#include <unistd.h>
 #include "codec/fe_row_codec.h"
 #include "gtest/gtest.h"
 #include "udf/udf.h"
 #include "vm/engine.h"
+#include "vm/jit_object_cache.h"
 #include "vm/simple_catalog.h"
 #include "vm/sql_compiler.h"
 
@@ -130,6 +132,113 @@ TEST_F(JitWrapperTest, test_mcjit) {
 }
 #endif
 
+TEST_F(JitWrapperTest, test_object_cache) {
+    EngineOptions options;
+    options.jit_options().SetObjectCacheDir(
+        "/tmp/hybridse_jit_object_cache_" + std::to_string(getpid()));
+    auto catalog = GetTestCatalog();
+    std::string sql = "select col_1, col_2 + 1 from t1;";
+    uint64_t hit_cnt = JitObjectCache::GetHitCount();
+    uint64_t miss_cnt = JitObjectCache::GetMissCount();
+    ASSERT_TRUE(Compile(sql, options, catalog) != nullptr);
+    ASSERT_EQ(hit_cnt, JitObjectCache::GetHitCount());
+    ASSERT_EQ(miss_cnt + 1, JitObjectCache::GetMissCount());
+
+    // another engine loads the object code instead of compiling it
+    auto compile_info = Compile(sql, options, catalog);
+    ASSERT_TRUE(compile_info != nullptr);
+    ASSERT_EQ(hit_cnt + 1, JitObjectCache::GetHitCount());
+    ASSERT_EQ(miss_cnt + 1, JitObjectCache::GetMissCount());
+
+    auto fn = compile_info->get_sql_context()
+                  .physical_plan->GetFnInfos()[0]
+                  ->fn_ptr();
+    ASSERT_TRUE(fn != nullptr);
+    int8_t buf[1024];
+    auto schema = catalog->GetTable("db", "t1")->GetSchema();
+    codec::RowBuilder row_builder(*schema);
+    row_builder.SetBuffer(buf, 1024);
+    row_builder.AppendDouble(3.14);
+    row_builder.AppendInt64(42);
+    hybridse::codec::Row empty_parameter;
+    hybridse::codec::Row row(base::RefCountedSlice::Create(buf, 1024));
+    hybridse::codec::Row output =
+        CoreAPI::RowProject(fn, row, empty_parameter);
+    codec::RowView row_view(*schema, output.buf(), output.size());
+    double c1;
+    int64_t c2;
+    ASSERT_EQ(row_view.GetDouble(0, &c1), 0);
+    ASSERT_EQ(row_view.GetInt64(1, &c2), 0);
+    ASSERT_EQ(c1, 3.14);
+    ASSERT_EQ(c2, 43);
+}
+
+TEST_F(JitWrapperTest, test_object_cache_evict) {
+    EngineOptions options;
+    options.jit_options().SetObjectCacheDir(
+        "/tmp/hybridse_jit_object_cache_evict_" + std::to_string(getpid()));
+    // only the object used last is kept
+    options.jit_options().SetObjectCacheMaxBytes(1);
+    auto catalog = GetTestCatalog();
+    std::string sql1 = "select col_1, col_2 + 1 from t1;";
+    std::string sql2 = "select col_1, col_2 + 2 from t1;";
+    uint64_t evict_cnt = JitObjectCache::GetEvictCount();
+    ASSERT_TRUE(Compile(sql1, options, catalog) != nullptr);
+    ASSERT_EQ(evict_cnt, JitObjectCache::GetEvictCount());
+    ASSERT_TRUE(Compile(sql2, options, catalog) != nullptr);
+    ASSERT_EQ(evict_cnt + 1, JitObjectCache::GetEvictCount());
+
+    // the object of sql1 is removed, so it is compiled again
+    uint64_t hit_cnt = JitObjectCache::GetHitCount();
+    uint64_t miss_cnt = JitObjectCache::GetMissCount();
+    ASSERT_TRUE(Compile(sql1, options, catalog) != nullptr);
+    ASSERT_EQ(hit_cnt, JitObjectCache::GetHitCount());
+    ASSERT_EQ(miss_cnt + 1, JitObjectCache::GetMissCount());
+}
+
+TEST_F(JitWrapperTest, test_tiered_jit) {
+    EngineOptions options;
+    options.jit_options().SetEnableTieredJit(true);
+    options.jit_options().SetTieredJitThreshold(10);
+    auto catalog = GetTestCatalog();
+    auto compile_info =
+        Compile("select col_1, col_2 + 1 from t1;", options, catalog);
+    ASSERT_TRUE(compile_info != nullptr);
+    auto fn_info = compile_info->get_sql_context()
+                       .physical_plan->GetFnInfos()[0];
+
+    int8_t buf[1024];
+    auto schema = catalog->GetTable("db", "t1")->GetSchema();
+    codec::RowBuilder row_builder(*schema);
+    row_builder.SetBuffer(buf, 1024);
+    row_builder.AppendDouble(3.14);
+    row_builder.AppendInt64(42);
+    hybridse::codec::Row empty_parameter;
+    hybridse::codec::Row row(base::RefCountedSlice::Create(buf, 1024));
+    auto check = [&](const int8_t *fn) {
+        ASSERT_TRUE(fn != nullptr);
+        hybridse::codec::Row output =
+            CoreAPI::RowProject(fn, row, empty_parameter);
+        codec::RowView row_view(*schema, output.buf(), output.size());
+        int64_t c2;
+        ASSERT_EQ(row_view.GetInt64(1, &c2), 0);
+        ASSERT_EQ(c2, 43);
+    };
+
+    // the hot function is replaced by the optimized one in background
+    auto fast_fn = fn_info->fn_ptr();
+    for (int i = 0; i < 20; i++) {
+        check(fn_info->fn_ptr());
+    }
+    for (int i = 0; i < 1000 && fn_info->fn_ptr() == fast_fn; i++) {
+        usleep(10000);
+    }
+    ASSERT_NE(fast_fn, fn_info->fn_ptr());
+    check(fn_info->fn_ptr());
+    // the replaced function is still valid for the running callers
+    check(fast_fn);
+}
+
 TEST_F(JitWrapperTest, test_window) {
     EngineOptions options;
     options.SetKeepIr(true);
@@ -17,11 +17,101 @@
 #include "vm/mem_catalog.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <thread>  // NOLINT
 
 #include "absl/strings/substitute.h"
+#include "base/fe_hash.h"
 
 namespace hybridse {
 namespace vm {
+
+// the tables of fewer rows are sorted by std::stable_sort
+static const size_t kRadixSortMinRows = 256;
+// the partitions of more rows are sorted by several threads in the batch mode
+static const size_t kParallelSortMinRows = 1 << 16;
+static const size_t kParallelSortMaxThreads = 8;
+
+// sort the keys and the row indexes by the least significant byte first, the
+// bytes of the same value in all the keys are skipped
+static void RadixSort(std::vector<std::pair<uint64_t, uint32_t>>* entries) {
+    size_t n = entries->size();
+    std::vector<std::array<uint32_t, 256>> counts(8);
+    for (auto& count : counts) {
+        count.fill(0);
+    }
+    for (auto& entry : *entries) {
+        for (int byte = 0; byte < 8; byte++) {
+            counts[byte][(entry.first >> (byte * 8)) & 0xFF]++;
+        }
+    }
+    std::vector<std::pair<uint64_t, uint32_t>> buffer(n);
+    for (int byte = 0; byte < 8; byte++) {
+        auto& count = counts[byte];
+        uint32_t digit = (entries->front().first >> (byte * 8)) & 0xFF;
+        if (count[digit] == n) {
+            continue;
+        }
+        uint32_t offset = 0;
+        for (auto& c : count) {
+            uint32_t cnt = c;
+            c = offset;
+            offset += cnt;
+        }
+        for (auto& entry : *entries) {
+            buffer[count[(entry.first >> (byte * 8)) & 0xFF]++] = entry;
+        }
+        entries->swap(buffer);
+    }
+}
+
+void SortTimeTable(MemTimeTable* table, bool is_asc) {
+    size_t n = table->size();
+    if (n < 2) {
+        return;
+    }
+    // detect the sorted rows and the rows sorted in the reverse order, the
+    // keys must be strictly reversed to keep the order of the same key
+    bool sorted = true;
+    bool reversed = true;
+    for (size_t i = 1; i < n && (sorted || reversed); i++) {
+        uint64_t prev = (*table)[i - 1].first;
+        uint64_t cur = (*table)[i].first;
+        if (is_asc ? prev > cur : prev < cur) {
+            sorted = false;
+        }
+        if (is_asc ? prev >= cur : prev <= cur) {
+            reversed = false;
+        }
+    }
+    if (sorted) {
+        return;
+    }
+    if (reversed) {
+        std::reverse(table->begin(), table->end());
+        return;
+    }
+    if (n < kRadixSortMinRows) {
+        if (is_asc) {
+            std::stable_sort(table->begin(), table->end(), AscComparor());
+        } else {
+            std::stable_sort(table->begin(), table->end(), DescComparor());
+        }
+        return;
+    }
+    std::vector<std::pair<uint64_t, uint32_t>> entries(n);
+    for (size_t i = 0; i < n; i++) {
+        uint64_t key = (*table)[i].first;
+        entries[i] = std::make_pair(is_asc ? key : ~key, static_cast<uint32_t>(i));
+    }
+    RadixSort(&entries);
+    MemTimeTable output;
+    for (auto& entry : entries) {
+        output.push_back(std::move((*table)[entry.second]));
+    }
+    table->swap(output);
+}
 MemTimeTableIterator::MemTimeTableIterator(const MemTimeTable* table,
                                            const vm::Schema* schema)
     : table_(table),
@@ -140,15 +230,8 @@ void MemTimeTableHandler::PopFrontRow() { table_.pop_front(); }
 const Types& MemTimeTableHandler::GetTypes() { return types_; }
 
 void MemTimeTableHandler::Sort(const bool is_asc) {
-    if (is_asc) {
-        AscComparor comparor;
-        std::sort(table_.begin(), table_.end(), comparor);
-        order_type_ = kAscOrder;
-    } else {
-        DescComparor comparor;
-        std::sort(table_.begin(), table_.end(), comparor);
-        order_type_ = kDescOrder;
-    }
+    SortTimeTable(&table_, is_asc);
+    order_type_ = is_asc ? kAscOrder : kDescOrder;
 }
 void MemTimeTableHandler::Reverse() {
     std::reverse(table_.begin(), table_.end());
@@ -160,6 +243,42 @@ RowIterator* MemTimeTableHandler::GetRawIterator() {
     return new MemTimeTableIterator(&table_, schema_);
 }
 
+ColumnarTimeTableHandler::ColumnarTimeTableHandler()
+    : MemTimeTableHandler(), keys_(), arrays_() {}
+
+bool ColumnarTimeTableHandler::SetColumnarArrays(
+    std::vector<codec::ColumnarArray>&& arrays) {
+    for (const auto& array : arrays) {
+        if (array.GetCount() != table_.size() ||
+            array.values.size() != table_.size() * array.value_size) {
+            return false;
+        }
+    }
+    keys_.clear();
+    for (const auto& row : table_) {
+        keys_.push_back(row.first);
+    }
+    arrays_ = std::move(arrays);
+    for (auto& array : arrays_) {
+        array.keys = &keys_;
+    }
+    return true;
+}
+
+const codec::ColumnarArray* ColumnarTimeTableHandler::GetColumnarArray(
+    int32_t row_idx, uint32_t col_idx, uint32_t offset) {
+    // only the first slice of the rows is from the storage
+    if (row_idx != 0) {
+        return nullptr;
+    }
+    for (const auto& array : arrays_) {
+        if (array.col_idx == col_idx && array.offset == offset) {
+            return &array;
+        }
+    }
+    return nullptr;
+}
+
 MemPartitionHandler::MemPartitionHandler()
     : PartitionHandler(),
       table_name_(""),
@@ -202,20 +321,38 @@ std::unique_ptr<WindowIterator> MemPartitionHandler::GetWindowIterator() {
     return std::unique_ptr<WindowIterator>(
         new MemWindowIterator(&partitions_, schema_));
 }
-void MemPartitionHandler::Sort(const bool is_asc) {
-    if (is_asc) {
-        AscComparor comparor;
-        for (auto& segment : partitions_) {
-            std::sort(segment.second.begin(), segment.second.end(), comparor);
-        }
-        order_type_ = kAscOrder;
-    } else {
-        DescComparor comparor;
-        for (auto& segment : partitions_) {
-            std::sort(segment.second.begin(), segment.second.end(), comparor);
+void MemPartitionHandler::Sort(const bool is_asc, uint32_t parallelism) {
+    std::vector<MemTimeTable*> segments;
+    size_t rows_cnt = 0;
+    for (auto& segment : partitions_) {
+        segments.push_back(&segment.second);
+        rows_cnt += segment.second.size();
+    }
+    // the threads take the next segment once they finish one
+    std::atomic<size_t> next_segment(0);
+    auto sort_segments = [&]() {
+        size_t i = next_segment.fetch_add(1, std::memory_order_relaxed);
+        while (i < segments.size()) {
+            SortTimeTable(segments[i], is_asc);
+            i = next_segment.fetch_add(1, std::memory_order_relaxed);
         }
-        order_type_ = kDescOrder;
+    };
+    size_t threads_cnt = 1;
+    if (parallelism > 1 && rows_cnt >= kParallelSortMinRows) {
+        threads_cnt = std::min(
+            {segments.size(), static_cast<size_t>(parallelism),
+             kParallelSortMaxThreads,
+             static_cast<size_t>(std::thread::hardware_concurrency())});
     }
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threads_cnt; i++) {
+        threads.emplace_back(sort_segments);
+    }
+    sort_segments();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    order_type_ = is_asc ? kAscOrder : kDescOrder;
 }
 void MemPartitionHandler::Reverse() {
     for (auto& segment : partitions_) {
@@ -236,6 +373,205 @@ void MemPartitionHandler::Print() {
     }
 }
 
+// the segments of a MemHashPartitionHandler in the descending order of the
+// keys, the same as MemWindowIterator
+class MemHashWindowIterator : public WindowIterator {
+ public:
+    MemHashWindowIterator(std::shared_ptr<PartitionHandler> partition,
+                          MemHashPartitionHandler* partition_handler)
+        : partition_(partition),
+          partition_handler_(partition_handler),
+          segments_(partition_handler->GetSortedSegments()),
+          pos_(0) {}
+    ~MemHashWindowIterator() {}
+
+    void Seek(const std::string& key) override {
+        // the keys are unique and sorted in the descending order
+        auto iter = std::lower_bound(
+            segments_.begin(), segments_.end(), key,
+            [this](uint32_t s, const std::string& k) {
+                return partition_handler_->GetSegmentKey(s) > k;
+            });
+        if (iter == segments_.end() ||
+            partition_handler_->GetSegmentKey(*iter) != key) {
+            pos_ = segments_.size();
+            return;
+        }
+        pos_ = iter - segments_.begin();
+    }
+    void SeekToFirst() override { pos_ = 0; }
+    void Next() override { pos_++; }
+    bool Valid() override { return pos_ < segments_.size(); }
+    std::unique_ptr<RowIterator> GetValue() override {
+        return std::unique_ptr<RowIterator>(GetRawValue());
+    }
+    RowIterator* GetRawValue() override {
+        return partition_handler_->NewSegmentIterator(segments_[pos_]);
+    }
+    const Row GetKey() override {
+        return Row(partition_handler_->GetSegmentKey(segments_[pos_]));
+    }
+
+ private:
+    // keep the partition alive
+    std::shared_ptr<PartitionHandler> partition_;
+    MemHashPartitionHandler* partition_handler_;
+    const std::vector<uint32_t>& segments_;
+    size_t pos_;
+};
+
+MemHashPartitionHandler::MemHashPartitionHandler(const Schema* schema)
+    : PartitionHandler(),
+      table_name_(""),
+      db_(""),
+      schema_(schema),
+      order_type_(kNoneOrder),
+      keys_(),
+      hashes_(),
+      slots_(),
+      row_segments_(),
+      rows_(),
+      offsets_(),
+      sort_once_(),
+      sorted_segments_() {}
+
+static inline uint64_t HashPartitionKey(const std::string& key) {
+    return base::MurmurHash64A(key.data(), key.size(), 0xe17a1465);
+}
+
+uint32_t MemHashPartitionHandler::FindOrAddSegment(const std::string& key) {
+    // keep the load factor at most 0.5
+    if ((keys_.size() + 1) * 2 > slots_.size()) {
+        Grow();
+    }
+    uint64_t hash = HashPartitionKey(key);
+    size_t mask = slots_.size() - 1;
+    size_t pos = hash & mask;
+    while (slots_[pos] != 0) {
+        uint32_t segment = slots_[pos] - 1;
+        if (hashes_[segment] == hash && keys_[segment] == key) {
+            return segment;
+        }
+        pos = (pos + 1) & mask;
+    }
+    uint32_t segment = keys_.size();
+    keys_.push_back(key);
+    hashes_.push_back(hash);
+    slots_[pos] = segment + 1;
+    return segment;
+}
+
+void MemHashPartitionHandler::Grow() {
+    std::vector<uint32_t> slots(slots_.empty() ? 16 : slots_.size() * 2, 0);
+    size_t mask = slots.size() - 1;
+    for (uint32_t segment = 0; segment < keys_.size(); segment++) {
+        size_t pos = hashes_[segment] & mask;
+        while (slots[pos] != 0) {
+            pos = (pos + 1) & mask;
+        }
+        slots[pos] = segment + 1;
+    }
+    slots_.swap(slots);
+}
+
+int64_t MemHashPartitionHandler::FindSegment(const std::string& key) const {
+    if (slots_.empty()) {
+        return -1;
+    }
+    uint64_t hash = HashPartitionKey(key);
+    size_t mask = slots_.size() - 1;
+    size_t pos = hash & mask;
+    while (slots_[pos] != 0) {
+        uint32_t segment = slots_[pos] - 1;
+        if (hashes_[segment] == hash && keys_[segment] == key) {
+            return segment;
+        }
+        pos = (pos + 1) & mask;
+    }
+    return -1;
+}
+
+void MemHashPartitionHandler::AddRow(const std::string& key, uint64_t ts,
+                                     const Row& row) {
+    row_segments_.push_back(FindOrAddSegment(key));
+    rows_.push_back(std::make_pair(ts, row));
+}
+
+void MemHashPartitionHandler::Finish() {
+    // a counting sort by the segment, which keeps the order of the rows of a
+    // segment as they are added
+    offsets_.assign(keys_.size() + 1, 0);
+    for (auto segment : row_segments_) {
+        offsets_[segment + 1]++;
+    }
+    for (size_t i = 1; i < offsets_.size(); i++) {
+        offsets_[i] += offsets_[i - 1];
+    }
+    std::vector<uint32_t> next(offsets_.begin(), offsets_.end() - 1);
+    MemTimeTable rows(rows_.size());
+    for (size_t i = 0; i < rows_.size(); i++) {
+        rows[next[row_segments_[i]]++] = std::move(rows_[i]);
+    }
+    rows_.swap(rows);
+    std::vector<uint32_t>().swap(row_segments_);
+}
+
+const std::vector<uint32_t>& MemHashPartitionHandler::GetSortedSegments() {
+    std::call_once(sort_once_, [this]() {
+        sorted_segments_.resize(keys_.size());
+        for (uint32_t segment = 0; segment < keys_.size(); segment++) {
+            sorted_segments_[segment] = segment;
+        }
+        std::sort(sorted_segments_.begin(), sorted_segments_.end(),
+                  [this](uint32_t l, uint32_t r) {
+                      return keys_[l] > keys_[r];
+                  });
+    });
+    return sorted_segments_;
+}
+
+RowIterator* MemHashPartitionHandler::NewSegmentIterator(
+    uint32_t segment) const {
+    return new MemTimeTableIterator(&rows_, schema_, offsets_[segment],
+                                    offsets_[segment + 1]);
+}
+
+std::unique_ptr<WindowIterator> MemHashPartitionHandler::GetWindowIterator() {
+    return std::unique_ptr<WindowIterator>(
+        new MemHashWindowIterator(shared_from_this(), this));
+}
+
+std::shared_ptr<TableHandler> MemHashPartitionHandler::GetSegment(
+    const std::string& key) {
+    return std::make_shared<MemHashSegmentHandler>(
+        std::dynamic_pointer_cast<MemHashPartitionHandler>(shared_from_this()),
+        FindSegment(key));
+}
+
+const uint64_t MemHashSegmentHandler::GetCount() {
+    std::unique_ptr<RowIterator> iter(GetRawIterator());
+    if (!iter) {
+        return 0;
+    }
+    uint64_t cnt = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        cnt++;
+    }
+    return cnt;
+}
+
+Row MemHashSegmentHandler::At(uint64_t pos) {
+    std::unique_ptr<RowIterator> iter(GetRawIterator());
+    if (!iter) {
+        return Row();
+    }
+    iter->SeekToFirst();
+    while (pos-- > 0 && iter->Valid()) {
+        iter->Next();
+    }
+    return iter->Valid() ? iter->GetValue() : Row();
+}
+
 std::unique_ptr<WindowIterator> MemTableHandler::GetWindowIterator(
     const std::string& idx_name) {
     return std::unique_ptr<WindowIterator>();
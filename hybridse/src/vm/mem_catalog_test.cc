@@ -179,6 +179,66 @@ TEST_F(MemCataLogTest, table_hander_wrapper_test) {
     ASSERT_EQ(3.1f, row_view.GetFloatUnsafe(1));
 }
 
+class EvenWrapperFun : public PredicateFun {
+ public:
+    explicit EvenWrapperFun(const vm::Schema* schema) : PredicateFun(), row_view_(*schema) {}
+    ~EvenWrapperFun() {}
+    bool operator()(const Row& row, const Row& parameter) const override {
+        int32_t value = 0;
+        row_view_.GetValue(row.buf(), 1, type::kInt32, &value);
+        return value % 2 == 0;
+    }
+    codec::RowView row_view_;
+};
+
+TEST_F(MemCataLogTest, table_batch_wrapper_test) {
+    std::vector<Row> rows;
+    ::hybridse::type::TableDef table;
+    BuildRows(table, rows);
+    // no row of the first batches is selected
+    std::shared_ptr<MemTableHandler> table_handler =
+        std::shared_ptr<MemTableHandler>(
+            new vm::MemTableHandler("t1", "temp", &(table.columns())));
+    for (int i = 0; i < 2500; i++) {
+        table_handler->AddRow(rows[0]);
+    }
+    for (int i = 0; i < 1000; i++) {
+        table_handler->AddRow(rows[i % rows.size()]);
+    }
+
+    SimpleWrapperFun project_fn;
+    EvenWrapperFun filter_fn(&(table.columns()));
+    Row parameter;
+    vm::TableProjectWrapper project_wrapper(table_handler, parameter, &project_fn);
+    vm::TableProjectWrapper batch_project_wrapper(table_handler, parameter, &project_fn, true);
+    vm::TableFilterWrapper filter_wrapper(table_handler, parameter, &filter_fn);
+    vm::TableFilterWrapper batch_filter_wrapper(table_handler, parameter, &filter_fn, true);
+
+    auto check = [](TableHandler* expect, TableHandler* actual, size_t expect_cnt) {
+        auto expect_iter = expect->GetIterator();
+        auto actual_iter = actual->GetIterator();
+        size_t cnt = 0;
+        // seek twice, the batch iterators restart from the first batch
+        for (int k = 0; k < 2; k++) {
+            cnt = 0;
+            expect_iter->SeekToFirst();
+            actual_iter->SeekToFirst();
+            while (expect_iter->Valid()) {
+                ASSERT_TRUE(actual_iter->Valid());
+                ASSERT_EQ(expect_iter->GetKey(), actual_iter->GetKey());
+                ASSERT_EQ(0, expect_iter->GetValue().compare(actual_iter->GetValue())) << cnt;
+                expect_iter->Next();
+                actual_iter->Next();
+                cnt++;
+            }
+            ASSERT_FALSE(actual_iter->Valid());
+        }
+        ASSERT_EQ(expect_cnt, cnt);
+    };
+    check(&project_wrapper, &batch_project_wrapper, 3500u);
+    check(&filter_wrapper, &batch_filter_wrapper, 400u);
+}
+
 TEST_F(MemCataLogTest, partition_hander_wrapper_test) {
     std::vector<Row> rows;
     ::hybridse::type::TableDef table;
@@ -285,6 +345,68 @@ TEST_F(MemCataLogTest, mem_time_table_handler_test) {
     ASSERT_FALSE(iter->Valid());
 }
 
+TEST_F(MemCataLogTest, columnar_time_table_handler_test) {
+    std::vector<Row> rows;
+    ::hybridse::type::TableDef table;
+    BuildRows(table, rows);
+    vm::ColumnarTimeTableHandler table_handler;
+    for (size_t i = 0; i < 3; i++) {
+        table_handler.AddRow(10 - i, rows[i]);
+    }
+    std::vector<codec::ColumnarArray> arrays(1);
+    arrays[0].col_idx = 1;
+    arrays[0].offset = 10;
+    arrays[0].value_size = sizeof(int64_t);
+    std::vector<int64_t> values = {30, 20, 10};
+    arrays[0].values.resize(2 * sizeof(int64_t));
+    arrays[0].nulls = {0, 1};
+    // the count mismatches the rows
+    ASSERT_FALSE(table_handler.SetColumnarArrays(std::move(arrays)));
+    arrays.resize(1);
+    arrays[0].col_idx = 1;
+    arrays[0].offset = 10;
+    arrays[0].value_size = sizeof(int64_t);
+    arrays[0].values.assign(
+        reinterpret_cast<const int8_t*>(values.data()),
+        reinterpret_cast<const int8_t*>(values.data() + values.size()));
+    arrays[0].nulls = {0, 1, 0};
+    ASSERT_TRUE(table_handler.SetColumnarArrays(std::move(arrays)));
+    ASSERT_TRUE(table_handler.GetColumnarArray(1, 1, 10) == nullptr);
+    ASSERT_TRUE(table_handler.GetColumnarArray(0, 2, 10) == nullptr);
+    auto array = table_handler.GetColumnarArray(0, 1, 10);
+    ASSERT_TRUE(array != nullptr);
+
+    codec::ColumnImpl<int64_t> column(&table_handler, 0, 1, 10, array);
+    ASSERT_EQ(3u, column.GetCount());
+    ASSERT_EQ(20, column.At(1));
+    auto iter = column.GetIterator();
+    iter->SeekToFirst();
+    for (size_t i = 0; i < 3; i++) {
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ(10 - i, iter->GetKey());
+        ASSERT_EQ(values[i], iter->GetValue());
+        iter->Next();
+    }
+    ASSERT_FALSE(iter->Valid());
+    iter->Seek(9);
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(20, iter->GetValue());
+
+    codec::ListRef<> list_ref;
+    list_ref.list = reinterpret_cast<int8_t*>(
+        static_cast<codec::ListV<Row>*>(&table_handler));
+    int8_t* col_values = nullptr;
+    int8_t* col_nulls = nullptr;
+    ASSERT_EQ(3, codec::v1::GetColumnar(reinterpret_cast<int8_t*>(&list_ref),
+                                        0, 1, 10, sizeof(int64_t), &col_values,
+                                        &col_nulls));
+    ASSERT_EQ(30, reinterpret_cast<int64_t*>(col_values)[0]);
+    ASSERT_EQ(1, col_nulls[1]);
+    ASSERT_EQ(-1, codec::v1::GetColumnar(reinterpret_cast<int8_t*>(&list_ref),
+                                         0, 1, 10, sizeof(int32_t),
+                                         &col_values, &col_nulls));
+}
+
 TEST_F(MemCataLogTest, mem_table_iterator_test) {
     std::vector<Row> rows;
     ::hybridse::type::TableDef table;
@@ -421,6 +543,158 @@ TEST_F(MemCataLogTest, mem_partition_test) {
     }
 }
 
+TEST_F(MemCataLogTest, mem_hash_partition_test) {
+    std::vector<Row> rows;
+    ::hybridse::type::TableDef table;
+    BuildRows(table, rows);
+    vm::MemPartitionHandler partition_handler("t1", "temp", &(table.columns()));
+    auto hash_partition_handler =
+        std::make_shared<vm::MemHashPartitionHandler>(&(table.columns()));
+
+    // enough keys to grow the hash table
+    uint64_t ts = 1;
+    for (int i = 0; i < 100; i++) {
+        std::string key = "group" + std::to_string(i % 37);
+        partition_handler.AddRow(key, ts, rows[i % rows.size()]);
+        hash_partition_handler->AddRow(key, ts, rows[i % rows.size()]);
+        ts++;
+    }
+    hash_partition_handler->Finish();
+    ASSERT_EQ(partition_handler.GetCount(), hash_partition_handler->GetCount());
+
+    // the same keys in the same order
+    auto window_iter = partition_handler.GetWindowIterator();
+    auto hash_window_iter = hash_partition_handler->GetWindowIterator();
+    window_iter->SeekToFirst();
+    hash_window_iter->SeekToFirst();
+    while (window_iter->Valid()) {
+        ASSERT_TRUE(hash_window_iter->Valid());
+        ASSERT_EQ(window_iter->GetKey().ToString(),
+                  hash_window_iter->GetKey().ToString());
+        auto iter = window_iter->GetValue();
+        auto hash_iter = hash_window_iter->GetValue();
+        iter->SeekToFirst();
+        hash_iter->SeekToFirst();
+        while (iter->Valid()) {
+            ASSERT_TRUE(hash_iter->Valid());
+            ASSERT_EQ(iter->GetKey(), hash_iter->GetKey());
+            ASSERT_TRUE(iter->GetValue().buf() == hash_iter->GetValue().buf());
+            iter->Next();
+            hash_iter->Next();
+        }
+        ASSERT_FALSE(hash_iter->Valid());
+        window_iter->Next();
+        hash_window_iter->Next();
+    }
+    ASSERT_FALSE(hash_window_iter->Valid());
+
+    hash_window_iter->Seek("group7");
+    ASSERT_TRUE(hash_window_iter->Valid());
+    ASSERT_EQ("group7", hash_window_iter->GetKey().ToString());
+    hash_window_iter->Seek("group99");
+    ASSERT_FALSE(hash_window_iter->Valid());
+
+    auto segment = hash_partition_handler->GetSegment("group3");
+    ASSERT_EQ(3u, segment->GetCount());
+    ASSERT_TRUE(segment->At(1).buf() == rows[40 % rows.size()].buf());
+    ASSERT_EQ(0u, hash_partition_handler->GetSegment("group99")->GetCount());
+    ASSERT_TRUE(hash_partition_handler->GetSegment("group99")->GetIterator() ==
+                nullptr);
+}
+
+TEST_F(MemCataLogTest, sort_time_table_test) {
+    std::vector<Row> rows;
+    ::hybridse::type::TableDef table;
+    BuildRows(table, rows);
+    // radix sort of the large tables, std::stable_sort of the small ones
+    for (size_t size : {10, 1000}) {
+        for (bool is_asc : {true, false}) {
+            vm::MemTimeTable input;
+            for (size_t i = 0; i < size; i++) {
+                // the same keys in different rows and the keys of high bytes
+                uint64_t key = (i * 7919) % 97 + (i % 3 == 0 ? (1ul << 40) : 0);
+                input.push_back(std::make_pair(key, rows[i % rows.size()]));
+            }
+            vm::MemTimeTable expected = input;
+            if (is_asc) {
+                std::stable_sort(expected.begin(), expected.end(),
+                                 vm::AscComparor());
+            } else {
+                std::stable_sort(expected.begin(), expected.end(),
+                                 vm::DescComparor());
+            }
+            vm::MemTimeTable output = input;
+            vm::SortTimeTable(&output, is_asc);
+            ASSERT_EQ(expected.size(), output.size());
+            for (size_t i = 0; i < size; i++) {
+                ASSERT_EQ(expected[i].first, output[i].first);
+                ASSERT_TRUE(expected[i].second.buf() == output[i].second.buf());
+            }
+
+            // sorted in the reverse order
+            vm::SortTimeTable(&output, !is_asc);
+            vm::SortTimeTable(&output, is_asc);
+            for (size_t i = 0; i + 1 < size; i++) {
+                ASSERT_TRUE(is_asc ? output[i].first <= output[i + 1].first
+                                   : output[i].first >= output[i + 1].first);
+            }
+        }
+    }
+}
+
+TEST_F(MemCataLogTest, mem_partition_parallel_sort_test) {
+    std::vector<Row> rows;
+    ::hybridse::type::TableDef table;
+    BuildRows(table, rows);
+    // 4 segments of 20000 rows, more than the rows to sort on several threads
+    vm::MemPartitionHandler serial("t1", "temp", &(table.columns()));
+    vm::MemPartitionHandler parallel("t1", "temp", &(table.columns()));
+    for (size_t i = 0; i < 80000; i++) {
+        std::string key = "group" + std::to_string(i % 4);
+        uint64_t ts = (i * 7919) % 10007;
+        serial.AddRow(key, ts, rows[i % rows.size()]);
+        parallel.AddRow(key, ts, rows[i % rows.size()]);
+    }
+    serial.Sort(true);
+    parallel.Sort(true, 4);
+    ASSERT_EQ(kAscOrder, parallel.GetOrderType());
+
+    auto serial_iter = serial.GetWindowIterator();
+    auto parallel_iter = parallel.GetWindowIterator();
+    serial_iter->SeekToFirst();
+    parallel_iter->SeekToFirst();
+    size_t segments_cnt = 0;
+    while (serial_iter->Valid()) {
+        ASSERT_TRUE(parallel_iter->Valid());
+        ASSERT_EQ(serial_iter->GetKey().ToString(),
+                  parallel_iter->GetKey().ToString());
+        auto serial_segment = serial_iter->GetValue();
+        auto parallel_segment = parallel_iter->GetValue();
+        serial_segment->SeekToFirst();
+        parallel_segment->SeekToFirst();
+        size_t rows_cnt = 0;
+        uint64_t last_ts = 0;
+        while (serial_segment->Valid()) {
+            ASSERT_TRUE(parallel_segment->Valid());
+            ASSERT_EQ(serial_segment->GetKey(), parallel_segment->GetKey());
+            ASSERT_TRUE(serial_segment->GetValue().buf() ==
+                        parallel_segment->GetValue().buf());
+            ASSERT_LE(last_ts, parallel_segment->GetKey());
+            last_ts = parallel_segment->GetKey();
+            serial_segment->Next();
+            parallel_segment->Next();
+            rows_cnt++;
+        }
+        ASSERT_FALSE(parallel_segment->Valid());
+        ASSERT_EQ(20000u, rows_cnt);
+        serial_iter->Next();
+        parallel_iter->Next();
+        segments_cnt++;
+    }
+    ASSERT_FALSE(parallel_iter->Valid());
+    ASSERT_EQ(4u, segments_cnt);
+}
+
 TEST_F(MemCataLogTest, mem_row_handler_test) {
     std::vector<Row> rows;
     ::hybridse::type::TableDef table;
@@ -16,8 +16,11 @@
 
 #include "vm/runner.h"
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 
@@ -36,6 +39,14 @@ namespace vm {
 #define MAX_DEBUG_BATCH_SiZE 5
 #define MAX_DEBUG_LINES_CNT 20
 #define MAX_DEBUG_COLUMN_MAX 20
+// the partition keys of a task of the parallel window aggregation
+#define WINDOW_AGG_KEYS_PER_TASK 16
+
+// the rows of a MemTableHandler are kept valid after its iterator moves on,
+// so they can be read ahead and run by the batch functions
+static bool IsBatchInput(const std::shared_ptr<DataHandler>& input) {
+    return nullptr != dynamic_cast<MemTableHandler*>(input.get());
+}
 
 // Build Runner for each physical node
 // return cluster task of given runner
@@ -242,6 +253,7 @@ ClusterTask RunnerBuilder::Build(PhysicalOpNode* node, Status& status) {
                         op->window_, op->project().fn_info(),
                         op->instance_not_in_window(),
                         op->exclude_current_time(), op->need_append_input());
+                    runner->SetParallelism(window_agg_parallelism_);
                     size_t input_slices =
                         input->output_schemas()->GetSchemaSourceSize();
                     if (!op->window_unions_.Empty()) {
@@ -270,6 +282,12 @@ ClusterTask RunnerBuilder::Build(PhysicalOpNode* node, Status& status) {
                                                   join_right_runner);
                         }
                     }
+                    runner->instance_window_gen_.sort_gen_.SetParallelism(
+                        sort_parallelism_);
+                    for (auto& window_gen :
+                         runner->windows_union_gen_.windows_gen_) {
+                        window_gen.sort_gen_.SetParallelism(sort_parallelism_);
+                    }
                     return RegisterTask(node,
                                         UnaryInheritTask(cluster_task, runner));
                 }
@@ -311,6 +329,9 @@ ClusterTask RunnerBuilder::Build(PhysicalOpNode* node, Status& status) {
                 &runner, id_++, node->schemas_ctx(), op->GetLimitCnt(),
                 op->window().range_, op->exclude_current_time(),
                 op->output_request_row());
+            if (request_window_cache_rows_ > 0) {
+                runner->EnableWindowCache(request_window_cache_rows_);
+            }
             Key index_key;
             if (!op->instance_not_in_window()) {
                 runner->AddWindowUnion(op->window_, right);
@@ -473,6 +494,28 @@ ClusterTask RunnerBuilder::Build(PhysicalOpNode* node, Status& status) {
                                       op->GetLimitCnt(), op->group());
             return RegisterTask(node, UnaryInheritTask(cluster_task, runner));
         }
+        case kPhysicalOpSortBy: {
+            if (support_cluster_optimized_) {
+                // Non-support sort under distribution env
+                status.msg = "fail to build cluster with sort node";
+                status.code = common::kExecutionPlanError;
+                LOG(WARNING) << status;
+                return fail;
+            }
+            auto cluster_task = Build(node->producers().at(0), status);
+            if (!cluster_task.IsValid()) {
+                status.msg = "fail to build input runner";
+                status.code = common::kExecutionPlanError;
+                LOG(WARNING) << status;
+                return fail;
+            }
+            auto op = dynamic_cast<const PhysicalSortNode*>(node);
+            SortRunner* runner = nullptr;
+            CreateRunner<SortRunner>(&runner, id_++, node->schemas_ctx(),
+                                     op->GetLimitCnt(), op->sort());
+            runner->sort_gen_.SetParallelism(sort_parallelism_);
+            return RegisterTask(node, UnaryInheritTask(cluster_task, runner));
+        }
         case kPhysicalOpFilter: {
             auto cluster_task =  // NOLINT
                 Build(node->producers().at(0), status);
@@ -572,6 +615,9 @@ ClusterTask RunnerBuilder::BuildRequestAggUnionTask(PhysicalOpNode* node, Status
         &runner, id_++, node->schemas_ctx(), op->GetLimitCnt(),
         op->window().range_, op->exclude_current_time(),
         op->output_request_row(), op->func_, op->agg_col_);
+    if (request_window_cache_rows_ > 0) {
+        runner->EnableWindowCache(request_window_cache_rows_);
+    }
     Key index_key;
     if (!op->instance_not_in_window()) {
         index_key = op->window_.index_key();
@@ -1102,6 +1148,7 @@ std::shared_ptr<DataHandlerList> Runner::BatchRequestRun(RunnerContext& ctx) {
     for (size_t idx = producers_.size(); idx > 0; idx--) {
         batch_inputs[idx - 1] = producers_[idx - 1]->BatchRequestRun(ctx);
     }
+    PrepareBatch(ctx, batch_inputs);
 
     for (size_t idx = 0; idx < ctx.GetRequestSize(); idx++) {
         inputs.clear();
@@ -1299,6 +1346,19 @@ std::shared_ptr<DataHandler> TableProjectRunner::Run(
         return std::shared_ptr<DataHandler>();
     }
     auto& parameter = ctx.GetParameterRow();
+    if (project_gen_.BatchValid() && IsBatchInput(input)) {
+        iter.reset(new IteratorBatchProjectWrapper(std::move(iter), parameter, &project_gen_.fun_));
+        iter->SeekToFirst();
+        int32_t cnt = 0;
+        while (iter->Valid()) {
+            if (limit_cnt_ > 0 && cnt++ >= limit_cnt_) {
+                break;
+            }
+            output_table->AddRow(iter->GetValue());
+            iter->Next();
+        }
+        return output_table;
+    }
     iter->SeekToFirst();
     int32_t cnt = 0;
     while (iter->Valid()) {
@@ -1342,7 +1402,7 @@ std::shared_ptr<DataHandler> SimpleProjectRunner::Run(
         case kTableHandler: {
             return std::shared_ptr<TableHandler>(new TableProjectWrapper(
                 std::dynamic_pointer_cast<TableHandler>(input),
-                parameter, &project_gen_.fun_));
+                parameter, &project_gen_.fun_, project_gen_.BatchValid() && IsBatchInput(input)));
         }
         case kPartitionHandler: {
             return std::shared_ptr<TableHandler>(new PartitionProjectWrapper(
@@ -1443,6 +1503,16 @@ std::shared_ptr<DataHandler> WindowAggRunner::Run(
     auto join_right_tables = windows_join_gen_.RunInputs(ctx);
 
     // Compute output
+    // the limit stops the serial run early, so it is not worth the threads
+    if (parallelism_ > 1 && limit_cnt_ <= 0) {
+        std::vector<std::string> keys;
+        while (instance_partition_iter->Valid()) {
+            keys.push_back(instance_partition_iter->GetKey().ToString());
+            instance_partition_iter->Next();
+        }
+        return RunWindowAggOnKeys(parameter, instance_partition,
+                                  union_partitions, join_right_tables, keys);
+    }
     std::shared_ptr<MemTableHandler> output_table = std::make_shared<MemTableHandler>();
     while (instance_partition_iter->Valid()) {
         auto key = instance_partition_iter->GetKey().ToString();
@@ -1453,6 +1523,57 @@ std::shared_ptr<DataHandler> WindowAggRunner::Run(
     return output_table;
 }
 
+// Run Window Aggeregation on the keys by parallelism_ threads. The keys are
+// split into the tasks of WINDOW_AGG_KEYS_PER_TASK keys, and a thread takes the
+// next task once it finishes one, so the threads with the large windows do not
+// hold the others. Each task outputs into its own table and the jit runtime of
+// its thread, and the tables are appended in the order of the keys, so the
+// output is the same as the serial one.
+std::shared_ptr<MemTableHandler> WindowAggRunner::RunWindowAggOnKeys(
+    const Row& parameter,
+    std::shared_ptr<PartitionHandler> instance_partition,
+    const std::vector<std::shared_ptr<PartitionHandler>>& union_partitions,
+    const std::vector<std::shared_ptr<DataHandler>>& join_right_tables,
+    const std::vector<std::string>& keys) {
+    size_t tasks_cnt = (keys.size() + WINDOW_AGG_KEYS_PER_TASK - 1) /
+                       WINDOW_AGG_KEYS_PER_TASK;
+    std::vector<std::shared_ptr<MemTableHandler>> task_outputs(tasks_cnt);
+    std::atomic<size_t> next_task(0);
+    auto run_tasks = [&]() {
+        size_t task = next_task.fetch_add(1, std::memory_order_relaxed);
+        while (task < tasks_cnt) {
+            auto output = std::make_shared<MemTableHandler>();
+            size_t end = std::min(keys.size(),
+                                  (task + 1) * WINDOW_AGG_KEYS_PER_TASK);
+            for (size_t i = task * WINDOW_AGG_KEYS_PER_TASK; i < end; i++) {
+                RunWindowAggOnKey(parameter, instance_partition,
+                                  union_partitions, join_right_tables, keys[i],
+                                  output);
+            }
+            task_outputs[task] = output;
+            task = next_task.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+    size_t threads_cnt = std::min(static_cast<size_t>(parallelism_), tasks_cnt);
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threads_cnt; i++) {
+        threads.emplace_back(run_tasks);
+    }
+    // the current thread runs the tasks too
+    run_tasks();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    auto output_table = std::make_shared<MemTableHandler>();
+    for (auto& output : task_outputs) {
+        for (uint64_t i = 0; i < output->GetCount(); i++) {
+            output_table->AddRow(output->At(i));
+        }
+    }
+    return output_table;
+}
+
 // Run Window Aggeregation on given key
 void WindowAggRunner::RunWindowAggOnKey(
     const Row& parameter,
@@ -1580,6 +1701,19 @@ std::shared_ptr<DataHandler> RequestLastJoinRunner::Run(
     }
 }
 
+void RequestLastJoinRunner::PrepareBatch(
+    RunnerContext& ctx,
+    const std::vector<std::shared_ptr<DataHandlerList>>& batch_inputs) {
+    // only the first request is run if the output is shared by the batch
+    if (need_batch_cache_ || batch_inputs.size() < 2u ||
+        ctx.GetRequestSize() < 2u) {
+        return;
+    }
+    join_gen_.PrefetchRightPartition(batch_inputs[0], batch_inputs[1],
+                                     ctx.GetRequestSize(),
+                                     ctx.GetParameterRow());
+}
+
 std::shared_ptr<DataHandler> LastJoinRunner::Run(RunnerContext& ctx,
                                                  const std::vector<std::shared_ptr<DataHandler>>& inputs) {
     auto fail_ptr = std::shared_ptr<DataHandler>();
@@ -1699,8 +1833,8 @@ std::shared_ptr<PartitionHandler> PartitionGenerator::Partition(
     if (!table) {
         return std::shared_ptr<PartitionHandler>();
     }
-    auto output_partitions = std::shared_ptr<MemPartitionHandler>(
-        new MemPartitionHandler(table->GetSchema()));
+    auto output_partitions =
+        std::make_shared<MemHashPartitionHandler>(table->GetSchema());
     auto partitions = std::dynamic_pointer_cast<PartitionHandler>(table);
     auto iter = partitions->GetWindowIterator();
     if (!iter) {
@@ -1715,17 +1849,19 @@ std::shared_ptr<PartitionHandler> PartitionGenerator::Partition(
             iter->Next();
             continue;
         }
-        auto segment_key = iter->GetKey().ToString();
+        std::string key = iter->GetKey().ToString() + "|";
+        size_t segment_key_size = key.size();
         segment_iter->SeekToFirst();
         while (segment_iter->Valid()) {
-            std::string keys = key_gen_.Gen(segment_iter->GetValue(), parameter);
-            output_partitions->AddRow(segment_key + "|" + keys,
-                                      segment_iter->GetKey(),
+            key.resize(segment_key_size);
+            key.append(key_gen_.Gen(segment_iter->GetValue(), parameter));
+            output_partitions->AddRow(key, segment_iter->GetKey(),
                                       segment_iter->GetValue());
             segment_iter->Next();
         }
         iter->Next();
     }
+    output_partitions->Finish();
     return output_partitions;
 }
 std::shared_ptr<PartitionHandler> PartitionGenerator::Partition(
@@ -1741,8 +1877,8 @@ std::shared_ptr<PartitionHandler> PartitionGenerator::Partition(
         return fail_ptr;
     }
 
-    auto output_partitions = std::shared_ptr<MemPartitionHandler>(
-        new MemPartitionHandler(table->GetSchema()));
+    auto output_partitions =
+        std::make_shared<MemHashPartitionHandler>(table->GetSchema());
 
     auto iter = std::dynamic_pointer_cast<TableHandler>(table)->GetIterator();
     if (!iter) {
@@ -1755,6 +1891,7 @@ std::shared_ptr<PartitionHandler> PartitionGenerator::Partition(
         output_partitions->AddRow(keys, iter->GetKey(), iter->GetValue());
         iter->Next();
     }
+    output_partitions->Finish();
     output_partitions->SetOrderType(table->GetOrderType());
     return output_partitions;
 }
@@ -1817,9 +1954,10 @@ std::shared_ptr<PartitionHandler> SortGenerator::Sort(
                            segment_iter->GetValue());
             segment_iter->Next();
         }
+        iter->Next();
     }
     if (order_gen_.Valid()) {
-        output->Sort(is_asc);
+        output->Sort(is_asc, parallelism_);
     } else if (is_asc && OrderType::kDescOrder == partition->GetOrderType()) {
         output->Reverse();
     }
@@ -1910,6 +2048,40 @@ Row JoinGenerator::RowLastJoin(const Row& left_row,
         }
     }
 }
+void JoinGenerator::PrefetchRightPartition(
+    std::shared_ptr<DataHandlerList> left,
+    std::shared_ptr<DataHandlerList> right, size_t size,
+    const Row& parameter) {
+    if (!index_key_gen_.Valid() || !left || !right) {
+        return;
+    }
+    std::shared_ptr<PartitionHandler> partition;
+    std::vector<std::string> keys;
+    keys.reserve(size);
+    for (size_t idx = 0; idx < size; idx++) {
+        auto left_handler = left->Get(idx);
+        auto right_handler = right->Get(idx);
+        if (!left_handler || !right_handler ||
+            kRowHandler != left_handler->GetHandlerType() ||
+            kPartitionHandler != right_handler->GetHandlerType()) {
+            return;
+        }
+        auto cur_partition =
+            std::dynamic_pointer_cast<PartitionHandler>(right_handler);
+        if (!partition) {
+            partition = cur_partition;
+        } else if (partition != cur_partition) {
+            // the right side is not shared by the batch
+            return;
+        }
+        keys.push_back(index_key_gen_.Gen(
+            std::dynamic_pointer_cast<RowHandler>(left_handler)->GetValue(),
+            parameter));
+    }
+    if (partition) {
+        partition->Prefetch(keys);
+    }
+}
 Row JoinGenerator::RowLastJoinPartition(
     const Row& left_row, std::shared_ptr<PartitionHandler> partition,
     const Row& parameter) {
@@ -2766,7 +2938,12 @@ std::shared_ptr<DataHandler> RequestAggUnionRunner::Run(
 
     // build window with start and end offset
     std::shared_ptr<TableHandler> window;
-    if (agg_segment) {
+    if (window_cache_ && union_segments[0]) {
+        window = CachedAggWindow(request, union_segments[0], ts_gen);
+    }
+    if (window) {
+        DLOG(INFO) << "Use the cached aggregate of the window";
+    } else if (agg_segment) {
         window = RequestUnionWindow(request, union_segments, ts_gen, range_gen_.window_range_, output_request_row_,
                                     exclude_current_time_);
     } else {
@@ -2783,6 +2960,144 @@ std::shared_ptr<DataHandler> RequestAggUnionRunner::Run(
     return window;
 }
 
+std::unique_ptr<BaseWindowAggState> RequestAggUnionRunner::CreateWindowAggState() const {
+    switch (agg_type_) {
+        case kCount:
+            return std::make_unique<WindowAggState<int64_t>>(WindowAggOp::kCount);
+        case kSum:
+        case kAvg: {
+            auto op = agg_type_ == kSum ? WindowAggOp::kSum : WindowAggOp::kAvg;
+            switch (agg_col_type_) {
+                case type::kInt16:
+                case type::kInt32:
+                case type::kTimestamp:
+                case type::kInt64:
+                    return std::make_unique<WindowAggState<int64_t>>(op);
+                case type::kFloat:
+                case type::kDouble:
+                    return std::make_unique<WindowAggState<double>>(op);
+                default:
+                    return nullptr;
+            }
+        }
+        case kMin:
+        case kMax: {
+            auto op = agg_type_ == kMin ? WindowAggOp::kMin : WindowAggOp::kMax;
+            switch (agg_col_type_) {
+                case type::kInt16:
+                    return std::make_unique<WindowAggState<int16_t>>(op);
+                case type::kInt32:
+                case type::kDate:
+                    return std::make_unique<WindowAggState<int32_t>>(op);
+                case type::kTimestamp:
+                case type::kInt64:
+                    return std::make_unique<WindowAggState<int64_t>>(op);
+                case type::kFloat:
+                    return std::make_unique<WindowAggState<float>>(op);
+                case type::kDouble:
+                    return std::make_unique<WindowAggState<double>>(op);
+                case type::kVarchar:
+                    return std::make_unique<WindowAggState<std::string>>(op);
+                default:
+                    return nullptr;
+            }
+        }
+        default:
+            return nullptr;
+    }
+}
+
+void RequestAggUnionRunner::AddWindowAggValue(BaseWindowAggState* state, uint64_t ts, const Row& row) const {
+    const auto row_parser = producers_[1]->row_parser();
+    if (!agg_col_name_.empty() && row_parser->IsNull(row, agg_col_name_)) {
+        return;
+    }
+    if (agg_type_ == kCount) {
+        state->Add(ts, static_cast<int64_t>(1));
+        return;
+    }
+    if (agg_col_name_.empty()) {
+        return;
+    }
+    switch (agg_col_type_) {
+        case type::Type::kInt16: {
+            int16_t val = 0;
+            row_parser->GetValue(row, agg_col_name_, agg_col_type_, &val);
+            state->Add(ts, static_cast<int64_t>(val));
+            break;
+        }
+        case type::Type::kDate:
+        case type::Type::kInt32: {
+            int32_t val = 0;
+            row_parser->GetValue(row, agg_col_name_, agg_col_type_, &val);
+            state->Add(ts, static_cast<int64_t>(val));
+            break;
+        }
+        case type::Type::kTimestamp:
+        case type::Type::kInt64: {
+            int64_t val = 0;
+            row_parser->GetValue(row, agg_col_name_, agg_col_type_, &val);
+            state->Add(ts, val);
+            break;
+        }
+        case type::Type::kFloat: {
+            float val = 0;
+            row_parser->GetValue(row, agg_col_name_, agg_col_type_, &val);
+            state->Add(ts, static_cast<double>(val));
+            break;
+        }
+        case type::Type::kDouble: {
+            double val = 0;
+            row_parser->GetValue(row, agg_col_name_, agg_col_type_, &val);
+            state->Add(ts, val);
+            break;
+        }
+        case type::Type::kVarchar: {
+            std::string val;
+            row_parser->GetString(row, agg_col_name_, &val);
+            state->Add(ts, val);
+            break;
+        }
+        default:
+            LOG(ERROR) << "Not support type: " << Type_Name(agg_col_type_);
+            break;
+    }
+}
+
+// the aggregate of the base rows in the window is kept by the window cache and
+// updated by the rows put after the last request of the key, so the pre-agg
+// table is not read
+std::shared_ptr<TableHandler> RequestAggUnionRunner::CachedAggWindow(const Row& request,
+                                                                     const std::shared_ptr<TableHandler>& segment,
+                                                                     int64_t ts_gen) const {
+    auto aggregator = CreateAggregator();
+    if (!aggregator) {
+        return nullptr;
+    }
+    const auto& window_range = range_gen_.window_range_;
+    bool ok = window_cache_->UpdateAggregator(
+        segment, ts_gen, window_range, exclude_current_time_, [this]() { return CreateWindowAggState(); },
+        [this](BaseWindowAggState* state, uint64_t ts, const Row& row) { AddWindowAggValue(state, ts, row); },
+        aggregator.get());
+    if (!ok) {
+        return nullptr;
+    }
+    if (output_request_row_) {
+        // the request row is the newest one, it is added to the aggregator
+        // rather than the cached state
+        auto state = CreateWindowAggState();
+        if (!state) {
+            return nullptr;
+        }
+        AddWindowAggValue(state.get(), ts_gen, request);
+        state->Output(aggregator.get());
+    }
+    int64_t start = (ts_gen + window_range.start_offset_) < 0 ? 0 : (ts_gen + window_range.start_offset_);
+    auto window_table = std::make_shared<MemTimeTableHandler>();
+    window_table->AddRow(start, aggregator->Output());
+    return window_table;
+}
+
 std::shared_ptr<TableHandler> RequestAggUnionRunner::RequestUnionWindow(
     const Row& request,
     std::vector<std::shared_ptr<TableHandler>> union_segments, int64_t ts_gen,
@@ -3108,6 +3423,14 @@ std::shared_ptr<DataHandler> RequestUnionRunner::Run(
     auto union_inputs = windows_union_gen_.RunInputs(ctx);
     auto union_segments =
         windows_union_gen_.GetRequestWindows(request, ctx.GetParameterRow(), union_inputs);
+    if (window_cache_ && 1 == union_segments.size() && union_segments[0]) {
+        auto window = window_cache_->GetWindow(
+            request, union_segments[0], ts_gen, range_gen_.window_range_,
+            output_request_row_, exclude_current_time_);
+        if (window) {
+            return window;
+        }
+    }
     // build window with start and end offset
     return RequestUnionWindow(request, union_segments, ts_gen,
                               range_gen_.window_range_, output_request_row_,
@@ -3138,9 +3461,6 @@ std::shared_ptr<TableHandler> RequestUnionRunner::RequestUnionWindow(
     }
     uint64_t request_key = ts_gen > 0 ? static_cast<uint64_t>(ts_gen) : 0;
 
-    auto window_table =
-        std::shared_ptr<MemTimeTableHandler>(new MemTimeTableHandler());
-
     size_t unions_cnt = union_segments.size();
     // Prepare Union Segment Iterators
     std::vector<std::unique_ptr<RowIterator>> union_segment_iters(unions_cnt);
@@ -3166,7 +3486,24 @@ std::shared_ptr<TableHandler> RequestUnionRunner::RequestUnionWindow(
     }
     int32_t max_union_pos = IteratorStatus::FindFirstIteratorWithMaximizeKey(union_segment_status);
 
+    // the storage of a single segment may keep some columns of the rows in
+    // arrays, take them if the window is a contiguous run of its rows
+    codec::ColumnarRowIterator* columnar_iter = nullptr;
+    if (1 == unions_cnt && union_segment_iters[0]) {
+        columnar_iter =
+            dynamic_cast<codec::ColumnarRowIterator*>(union_segment_iters[0].get());
+    }
+    std::shared_ptr<MemTimeTableHandler> window_table;
+    std::shared_ptr<ColumnarTimeTableHandler> columnar_table;
+    if (nullptr != columnar_iter) {
+        columnar_table = std::make_shared<ColumnarTimeTableHandler>();
+        window_table = columnar_table;
+    } else {
+        window_table = std::make_shared<MemTimeTableHandler>();
+    }
+
     uint64_t cnt = 0;
+    uint64_t storage_cnt = 0;
     auto range_status = window_range.GetWindowPositionStatus(
         cnt > rows_start_preceding, window_range.end_offset_ < 0,
         request_key < start);
@@ -3193,6 +3530,10 @@ std::shared_ptr<TableHandler> RequestUnionRunner::RequestUnionWindow(
                 union_segment_status[max_union_pos].key_,
                 union_segment_iters[max_union_pos]->GetValue());
             cnt++;
+            storage_cnt++;
+        } else {
+            // the rows of the window are not contiguous in the storage
+            columnar_iter = nullptr;
         }
         // Update Iterator Status
         union_segment_iters[max_union_pos]->Next();
@@ -3205,10 +3546,232 @@ std::shared_ptr<TableHandler> RequestUnionRunner::RequestUnionWindow(
         // Pick new mininum union pos
         max_union_pos = IteratorStatus::FindFirstIteratorWithMaximizeKey(union_segment_status);
     }
+    if (nullptr != columnar_iter) {
+        std::vector<codec::ColumnarArray> arrays;
+        if ((!output_request_row ||
+             columnar_iter->AppendColumnar(request, &arrays)) &&
+            columnar_iter->AppendColumnar(end, storage_cnt, &arrays)) {
+            columnar_table->SetColumnarArrays(std::move(arrays));
+        }
+    }
     DLOG(INFO) << "REQUEST UNION cnt = " << window_table->GetCount();
     return window_table;
 }
 
+// copy the row so it is still valid after the storage releases it
+static Row CopyRow(const Row& row) {
+    size_t size = row.size();
+    auto slice = base::RefCountedSlice::Allocate(size);
+    if (slice.buf() == nullptr) {
+        return Row();
+    }
+    memcpy(slice.buf(), row.buf(), size);
+    return Row(slice);
+}
+
+std::shared_ptr<RequestWindowCache::Entry> RequestWindowCache::Refresh(
+    const std::shared_ptr<TableHandler>& segment, int64_t ts_gen,
+    const WindowRange& window_range, bool exclude_current_time,
+    const std::function<void(State*, uint64_t, const Row&)>& add,
+    std::unique_lock<std::mutex>* lock, std::string* key, uint64_t* start,
+    uint64_t* expire_ts) {
+    if (ts_gen < 0 || window_range.frame_type_ != Window::kFrameRowsRange ||
+        window_range.max_size_ > 0) {
+        return nullptr;
+    }
+    uint64_t version = 0;
+    // the version is got before the rows are read, so a row put while they
+    // are read changes it and the window is not reused by the next request
+    if (!segment->GetAppendVersion(key, &version, expire_ts)) {
+        return nullptr;
+    }
+    *start = (ts_gen + window_range.start_offset_) < 0
+                 ? 0
+                 : (ts_gen + window_range.start_offset_);
+    uint64_t end = 0;
+    if (exclude_current_time && 0 == window_range.end_offset_) {
+        end = (ts_gen - 1) < 0 ? 0 : (ts_gen - 1);
+    } else {
+        end = (ts_gen + window_range.end_offset_) < 0
+                  ? 0
+                  : (ts_gen + window_range.end_offset_);
+    }
+    auto entry = GetEntry(*key);
+    *lock = std::unique_lock<std::mutex>(entry->mu);
+    State* state = &entry->state;
+    if (state->too_large) {
+        return nullptr;
+    }
+    if (!state->filled || state->version != version ||
+        state->ts_gen > ts_gen) {
+        // the rows may be put before the window, or the window moves back
+        *state = State();
+        state->version = version;
+    }
+    // read the rows after the newest row of the window, they are added after
+    // the read since the window is in ascending order of ts
+    auto iter = segment->GetIterator();
+    if (iter) {
+        std::vector<std::pair<uint64_t, Row>> new_rows;
+        for (iter->Seek(end); iter->Valid(); iter->Next()) {
+            uint64_t ts = iter->GetKey();
+            if (ts < *start || (state->filled && ts <= state->newest_ts)) {
+                break;
+            }
+            if (new_rows.size() >= max_rows_) {
+                // stop reading a long window, the pre-aggregate tables are
+                // read for it instead
+                SetTooLarge(*key, entry, lock);
+                return nullptr;
+            }
+            new_rows.emplace_back(ts, iter->GetValue());
+        }
+        if (!new_rows.empty()) {
+            state->newest_ts = std::max(state->newest_ts, new_rows[0].first);
+        }
+        // the iterator is still alive, so are the rows of the storage
+        for (auto it = new_rows.rbegin(); it != new_rows.rend(); ++it) {
+            add(state, it->first, it->second);
+        }
+    }
+    state->filled = true;
+    state->ts_gen = ts_gen;
+    return entry;
+}
+
+std::shared_ptr<TableHandler> RequestWindowCache::GetWindow(
+    const Row& request, const std::shared_ptr<TableHandler>& segment,
+    int64_t ts_gen, const WindowRange& window_range, bool output_request_row,
+    bool exclude_current_time) {
+    std::unique_lock<std::mutex> lock;
+    std::string key;
+    uint64_t start = 0;
+    uint64_t expire_ts = 0;
+    auto entry = Refresh(
+        segment, ts_gen, window_range, exclude_current_time,
+        [](State* state, uint64_t ts, const Row& row) {
+            state->rows.emplace_front(ts, CopyRow(row));
+        },
+        &lock, &key, &start, &expire_ts);
+    if (!entry) {
+        return nullptr;
+    }
+    auto& rows = entry->state.rows;
+    while (!rows.empty() &&
+           (rows.back().first < start ||
+            (expire_ts > 0 && rows.back().first <= expire_ts))) {
+        rows.pop_back();
+    }
+
+    auto window_table = std::make_shared<MemTimeTableHandler>();
+    if (output_request_row) {
+        window_table->AddRow(static_cast<uint64_t>(ts_gen), request);
+    }
+    for (const auto& row : rows) {
+        window_table->AddRow(row.first, row.second);
+    }
+    uint64_t rows_cnt = rows.size();
+    if (rows_cnt > max_rows_) {
+        SetTooLarge(key, entry, &lock);
+        return window_table;
+    }
+    lock.unlock();
+    UpdateRows(key, entry, rows_cnt);
+    return window_table;
+}
+
+bool RequestWindowCache::UpdateAggregator(
+    const std::shared_ptr<TableHandler>& segment, int64_t ts_gen,
+    const WindowRange& window_range, bool exclude_current_time,
+    const AggStateFactory& new_state, const AggStateAdd& add_row,
+    BaseAggregator* aggregator) {
+    std::unique_lock<std::mutex> lock;
+    std::string key;
+    uint64_t start = 0;
+    uint64_t expire_ts = 0;
+    auto entry = Refresh(
+        segment, ts_gen, window_range, exclude_current_time,
+        [&new_state, &add_row](State* state, uint64_t ts, const Row& row) {
+            if (!state->agg) {
+                state->agg = new_state();
+            }
+            if (state->agg) {
+                add_row(state->agg.get(), ts, row);
+            }
+        },
+        &lock, &key, &start, &expire_ts);
+    if (!entry) {
+        return false;
+    }
+    auto& state = entry->state;
+    if (!state.agg) {
+        state.agg = new_state();
+        if (!state.agg) {
+            return false;
+        }
+    }
+    uint64_t evict_end = start;
+    if (expire_ts > 0 && expire_ts + 1 > evict_end) {
+        evict_end = expire_ts + 1;
+    }
+    state.agg->EvictBefore(evict_end);
+    uint64_t rows_cnt = state.agg->GetCount();
+    if (rows_cnt > max_rows_) {
+        SetTooLarge(key, entry, &lock);
+        return false;
+    }
+    state.agg->Output(aggregator);
+    lock.unlock();
+    UpdateRows(key, entry, rows_cnt);
+    return true;
+}
+
+std::shared_ptr<RequestWindowCache::Entry> RequestWindowCache::GetEntry(
+    const std::string& key) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto iter = entries_.find(key);
+    if (iter != entries_.end()) {
+        lru_.splice(lru_.begin(), lru_, iter->second.second);
+        return iter->second.first;
+    }
+    lru_.push_front(key);
+    auto entry = std::make_shared<Entry>();
+    entries_.emplace(key, std::make_pair(entry, lru_.begin()));
+    return entry;
+}
+
+void RequestWindowCache::SetTooLarge(const std::string& key,
+                                     const std::shared_ptr<Entry>& entry,
+                                     std::unique_lock<std::mutex>* lock) {
+    entry->state = State();
+    entry->state.too_large = true;
+    lock->unlock();
+    UpdateRows(key, entry, 0);
+}
+
+void RequestWindowCache::UpdateRows(const std::string& key,
+                                    const std::shared_ptr<Entry>& entry,
+                                    uint64_t rows) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto iter = entries_.find(key);
+    if (iter == entries_.end() || iter->second.first != entry) {
+        // the entry is dropped while it is refreshed
+        return;
+    }
+    rows_cnt_ -= entry->cached_rows;
+    // an entry counts as a row besides its rows, so the empty windows are
+    // bounded as well
+    entry->cached_rows = rows + 1;
+    rows_cnt_ += entry->cached_rows;
+    while (rows_cnt_ > max_rows_ && !lru_.empty()) {
+        // the requests refreshing the dropped entry still hold it
+        auto last = entries_.find(lru_.back());
+        rows_cnt_ -= last->second.first->cached_rows;
+        entries_.erase(last);
+        lru_.pop_back();
+    }
+}
+
 std::shared_ptr<DataHandler> PostRequestUnionRunner::Run(
     RunnerContext& ctx,
     const std::vector<std::shared_ptr<DataHandler>>& inputs) {
@@ -3647,7 +4210,7 @@ std::shared_ptr<TableHandler> ProxyRequestRunner::RunWithRowsInput(
  * @return
  */
 const std::string KeyGenerator::GenConst(const Row& parameter) {
-    Row key_row = CoreAPI::RowConstProject(fn_, parameter, true);
+    Row key_row = CoreAPI::RowConstProject(fn_->Get(), parameter, true);
     RowView row_view(row_view_);
     if (!row_view.Reset(key_row.buf())) {
         LOG(WARNING) << "fail to gen key: row view reset fail";
@@ -3676,7 +4239,7 @@ const std::string KeyGenerator::Gen(const Row& row, const Row& parameter) {
     if (row.size() == 0) {
         return codec::NONETOKEN;
     }
-    Row key_row = CoreAPI::RowProject(fn_, row, parameter, true);
+    Row key_row = CoreAPI::RowProject(fn_->Get(), row, parameter, true);
     std::string keys = "";
     for (auto pos : idxs_) {
         if (!keys.empty()) {
@@ -3752,29 +4315,98 @@ const std::string KeyGenerator::Gen(const Row& row, const Row& parameter) {
 }
 
 const int64_t OrderGenerator::Gen(const Row& row) {
-    Row order_row = CoreAPI::RowProject(fn_, row, Row(), true);
+    Row order_row = CoreAPI::RowProject(fn_->Get(), row, Row(), true);
     return Runner::GetColumnInt64(order_row.buf(), &row_view_, idxs_[0],
                                   fn_schema_.Get(idxs_[0]).type());
 }
 
 const bool ConditionGenerator::Gen(const Row& row, const Row& parameter) const {
-    return CoreAPI::ComputeCondition(fn_, row, parameter, &row_view_, idxs_[0]);
+    return CoreAPI::ComputeCondition(fn_->Get(), row, parameter, &row_view_, idxs_[0]);
 }
 const bool ConditionGenerator::Gen(std::shared_ptr<TableHandler> table, const codec::Row& parameter) {
-    Row cond_row = Runner::GroupbyProject(fn_, parameter, table.get());
+    Row cond_row = Runner::GroupbyProject(fn_->Get(), parameter, table.get());
     return Runner::GetColumnBool(cond_row.buf(), &row_view_, idxs_[0],
                                  row_view_.GetSchema()->Get(idxs_[0]).type());
 }
+void ConditionGenerator::Gen(const std::vector<Row>& rows, const Row& parameter,
+                             std::vector<uint32_t>* selection) const {
+    selection->clear();
+    std::vector<int8_t*> bufs;
+    if (!Runner::BatchProject(batch_fn_->Get(), rows, parameter, &bufs)) {
+        for (uint32_t i = 0; i < rows.size(); i++) {
+            if (Gen(rows[i], parameter)) {
+                selection->push_back(i);
+            }
+        }
+        return;
+    }
+    auto type = row_view_.GetSchema()->Get(idxs_[0]).type();
+    for (uint32_t i = 0; i < bufs.size(); i++) {
+        if (Runner::GetColumnBool(bufs[i], &row_view_, idxs_[0], type)) {
+            selection->push_back(i);
+        }
+        free(bufs[i]);
+    }
+}
 const Row ProjectGenerator::Gen(const Row& row, const Row& parameter) {
-    return CoreAPI::RowProject(fn_, row, parameter, false);
+    return CoreAPI::RowProject(fn_->Get(), row, parameter, false);
+}
+
+void RowProjectFun::Batch(const std::vector<Row>& rows, const Row& parameter, std::vector<Row>* outputs) const {
+    std::vector<int8_t*> bufs;
+    if (!batch_fn_ || !Runner::BatchProject(batch_fn_->Get(), rows, parameter, &bufs)) {
+        ProjectFun::Batch(rows, parameter, outputs);
+        return;
+    }
+    outputs->clear();
+    outputs->reserve(bufs.size());
+    for (auto buf : bufs) {
+        outputs->emplace_back(base::RefCountedSlice::CreateManaged(buf, RowView::GetSize(buf)));
+    }
+}
+
+bool Runner::BatchProject(const int8_t* batch_fn, const std::vector<Row>& rows, const Row& parameter,
+                          std::vector<int8_t*>* bufs) {
+    if (nullptr == batch_fn) {
+        return false;
+    }
+    std::vector<const int8_t*> row_ptrs;
+    row_ptrs.reserve(rows.size());
+    for (const auto& row : rows) {
+        // the row functions are not called on the empty rows
+        if (row.empty()) {
+            return false;
+        }
+        row_ptrs.push_back(reinterpret_cast<const int8_t*>(&row));
+    }
+    bufs->assign(rows.size(), nullptr);
+
+    // Init current run step runtime
+    JitRuntime::get()->InitRunStep();
+    auto udf = reinterpret_cast<int32_t (*)(const int32_t, const int8_t**, const int8_t*, int8_t**)>(
+        const_cast<int8_t*>(batch_fn));
+    int32_t ret = udf(static_cast<int32_t>(rows.size()), row_ptrs.data(),
+                      reinterpret_cast<const int8_t*>(&parameter), bufs->data());
+    // Release current run step resources
+    JitRuntime::get()->ReleaseRunStep();
+
+    if (ret != 0) {
+        LOG(WARNING) << "fail to run batch udf " << ret;
+        for (auto buf : *bufs) {
+            free(buf);
+        }
+        bufs->clear();
+        return false;
+    }
+    return true;
 }
 
 const Row ConstProjectGenerator::Gen(const Row& parameter) {
-    return CoreAPI::RowConstProject(fn_, parameter, false);
+    return CoreAPI::RowConstProject(fn_->Get(), parameter, false);
 }
 
 const Row AggGenerator::Gen(const codec::Row& parameter_row, std::shared_ptr<TableHandler> table) {
-    return Runner::GroupbyProject(fn_, parameter_row, table.get());
+    return Runner::GroupbyProject(fn_->Get(), parameter_row, table.get());
 }
 
 Row Runner::GroupbyProject(const int8_t* fn, const codec::Row& parameter, TableHandler* table) {
@@ -3814,7 +4446,7 @@ const Row WindowProjectGenerator::Gen(const uint64_t key, const Row row,
                                       const codec::Row& parameter,
                                       bool is_instance, size_t append_slices,
                                       Window* window) {
-    return Runner::WindowProject(fn_, key, row, parameter, is_instance, append_slices,
+    return Runner::WindowProject(fn_->Get(), key, row, parameter, is_instance, append_slices,
                                  window);
 }
 
@@ -3996,7 +4628,8 @@ std::shared_ptr<DataHandler> FilterGenerator::Filter(
     if (!condition_gen_.Valid()) {
         return table;
     }
-    return std::shared_ptr<TableHandler>(new TableFilterWrapper(table, parameter, this));
+    return std::shared_ptr<TableHandler>(
+        new TableFilterWrapper(table, parameter, this, condition_gen_.BatchValid() && IsBatchInput(table)));
 }
 
 std::shared_ptr<DataHandlerList> RunnerContext::GetBatchCache(
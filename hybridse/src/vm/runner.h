@@ -17,8 +17,12 @@
 #ifndef HYBRIDSE_SRC_VM_RUNNER_H_
 #define HYBRIDSE_SRC_VM_RUNNER_H_
 
+#include <deque>
+#include <functional>
+#include <list>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -50,7 +54,8 @@ class RunnerContext;
 class FnGenerator {
  public:
     explicit FnGenerator(const FnInfo& info)
-        : fn_(info.fn_ptr()),
+        : fn_(info.fn_address()),
+          batch_fn_(info.batch_fn_address()),
           fn_schema_(*info.fn_schema()),
           row_view_(fn_schema_) {
         for (int32_t idx = 0; idx < fn_schema_.size(); idx++) {
@@ -58,8 +63,12 @@ class FnGenerator {
         }
     }
     virtual ~FnGenerator() {}
-    inline const bool Valid() const { return nullptr != fn_; }
-    const int8_t* fn_;
+    inline const bool Valid() const { return nullptr != fn_->Get(); }
+    // the batch function is only built for the batch plans
+    inline const bool BatchValid() const { return nullptr != batch_fn_->Get(); }
+    // may be replaced by a tiered jit, so it is loaded on every call
+    const std::shared_ptr<const FnAddress> fn_;
+    const std::shared_ptr<const FnAddress> batch_fn_;
     const Schema fn_schema_;
     const RowView row_view_;
     std::vector<int32_t> idxs_;
@@ -67,18 +76,22 @@ class FnGenerator {
 
 class RowProjectFun : public ProjectFun {
  public:
-    explicit RowProjectFun(const int8_t* fn) : ProjectFun(), fn_(fn) {}
+    explicit RowProjectFun(const std::shared_ptr<const FnAddress>& fn) : ProjectFun(), fn_(fn), batch_fn_() {}
+    RowProjectFun(const std::shared_ptr<const FnAddress>& fn, const std::shared_ptr<const FnAddress>& batch_fn)
+        : ProjectFun(), fn_(fn), batch_fn_(batch_fn) {}
     ~RowProjectFun() {}
     Row operator()(const Row& row, const Row& parameter) const override {
-        return CoreAPI::RowProject(fn_, row, parameter, false);
+        return CoreAPI::RowProject(fn_->Get(), row, parameter, false);
     }
-    const int8_t* fn_;
+    void Batch(const std::vector<Row>& rows, const Row& parameter, std::vector<Row>* outputs) const override;
+    const std::shared_ptr<const FnAddress> fn_;
+    const std::shared_ptr<const FnAddress> batch_fn_;
 };
 
 class ProjectGenerator : public FnGenerator {
  public:
     explicit ProjectGenerator(const FnInfo& info)
-        : FnGenerator(info), fun_(info.fn_ptr()) {}
+        : FnGenerator(info), fun_(info.fn_address(), info.batch_fn_address()) {}
     virtual ~ProjectGenerator() {}
     const Row Gen(const Row& row, const Row& parameter);
     RowProjectFun fun_;
@@ -87,7 +100,7 @@ class ProjectGenerator : public FnGenerator {
 class ConstProjectGenerator : public FnGenerator {
  public:
     explicit ConstProjectGenerator(const FnInfo& info)
-        : FnGenerator(info), fun_(info.fn_ptr()) {}
+        : FnGenerator(info), fun_(info.fn_address()) {}
     virtual ~ConstProjectGenerator() {}
     const Row Gen(const Row& parameter);
     RowProjectFun fun_;
@@ -124,6 +137,8 @@ class ConditionGenerator : public FnGenerator {
     virtual ~ConditionGenerator() {}
     const bool Gen(const Row& row, const Row& parameter) const;
     const bool Gen(std::shared_ptr<TableHandler> table, const codec::Row& parameter_row);
+    // select the rows matched by the batch function, see PredicateFun::Batch
+    void Gen(const std::vector<Row>& rows, const Row& parameter, std::vector<uint32_t>* selection) const;
 };
 class RangeGenerator {
  public:
@@ -217,10 +232,15 @@ class SortGenerator {
     explicit SortGenerator(const Sort& sort)
         : is_valid_(sort.ValidSort()),
           is_asc_(sort.is_asc()),
-          order_gen_(sort.fn_info()) {}
+          order_gen_(sort.fn_info()),
+          parallelism_(1) {}
     virtual ~SortGenerator() {}
 
     const bool Valid() const { return is_valid_; }
+    // sort the segments of a partition on `parallelism` threads, set by
+    // RunnerBuilder from EngineOptions::SetSortParallelism in the batch mode,
+    // see MemPartitionHandler::Sort. the tables are always sorted serially
+    void SetParallelism(uint32_t parallelism) { parallelism_ = parallelism; }
 
     std::shared_ptr<DataHandler> Sort(std::shared_ptr<DataHandler> input,
                                       const bool reverse = false);
@@ -235,6 +255,7 @@ class SortGenerator {
     bool is_valid_;
     bool is_asc_;
     OrderGenerator order_gen_;
+    uint32_t parallelism_;
 };
 
 class IndexSeekGenerator {
@@ -271,6 +292,14 @@ class FilterGenerator : public PredicateFun {
         }
         return condition_gen_.Gen(row, parameter);
     }
+    void Batch(const std::vector<Row>& rows, const Row& parameter,
+               std::vector<uint32_t>* selection) const override {
+        if (!condition_gen_.BatchValid()) {
+            PredicateFun::Batch(rows, parameter, selection);
+            return;
+        }
+        condition_gen_.Gen(rows, parameter, selection);
+    }
 
  private:
     ConditionGenerator condition_gen_;
@@ -492,6 +521,11 @@ class Runner : public node::NodeBase<Runner> {
         RunnerContext& ctx);  // NOLINT
     virtual std::shared_ptr<DataHandler> RunWithCache(
         RunnerContext& ctx);  // NOLINT
+    // called with the inputs of all the requests before they are run one by
+    // one, so the data of the whole batch can be prepared at once
+    virtual void PrepareBatch(
+        RunnerContext& ctx,  // NOLINT
+        const std::vector<std::shared_ptr<DataHandlerList>>& batch_inputs) {}
 
     static int64_t GetColumnInt64(const int8_t* buf, const RowView* view,
                                   int pos, type::Type type);
@@ -506,6 +540,11 @@ class Runner : public node::NodeBase<Runner> {
                              const bool is_instance,
                              size_t append_slices, Window* window);
     static Row GroupbyProject(const int8_t* fn, const Row& parameter, TableHandler* table);
+    // run the batch function of a row function, the output buffer of rows[i]
+    // is bufs[i]. return false if the function is not built or it fails, the
+    // rows should be run one by one then
+    static bool BatchProject(const int8_t* batch_fn, const std::vector<Row>& rows, const Row& parameter,
+                             std::vector<int8_t*>* bufs);
     static const Row RowLastJoinTable(size_t left_slices, const Row& left_row,
                                       size_t right_slices,
                                       std::shared_ptr<TableHandler> right_table,
@@ -677,6 +716,10 @@ class JoinGenerator {
 
     Row RowLastJoin(const Row& left_row, std::shared_ptr<DataHandler> right, const Row& parameter);
     Row RowLastJoinDropLeftSlices(const Row& left_row, std::shared_ptr<DataHandler> right, const Row& parameter);
+    // prefetch the right segments of the index keys of all the left rows
+    void PrefetchRightPartition(std::shared_ptr<DataHandlerList> left,
+                                std::shared_ptr<DataHandlerList> right,
+                                size_t size, const Row& parameter);
     ConditionGenerator condition_gen_;
     KeyGenerator left_key_gen_;
     PartitionGenerator right_group_gen_;
@@ -925,8 +968,12 @@ class WindowAggRunner : public Runner {
           instance_window_gen_(window_op),
           windows_union_gen_(),
           windows_join_gen_(),
-          window_project_gen_(fn_info) {}
+          window_project_gen_(fn_info),
+          parallelism_(1) {}
     ~WindowAggRunner() {}
+    // run the windows of the partition keys on `parallelism` threads, see
+    // RunWindowAggOnKeys
+    void SetParallelism(uint32_t parallelism) { parallelism_ = parallelism; }
     void AddWindowJoin(const Join& join, size_t left_slices, Runner* runner) {
         windows_join_gen_.AddWindowJoin(join, left_slices, runner);
     }
@@ -943,6 +990,12 @@ class WindowAggRunner : public Runner {
         std::vector<std::shared_ptr<PartitionHandler>> union_partitions,
         std::vector<std::shared_ptr<DataHandler>> joins, const std::string& key,
         std::shared_ptr<MemTableHandler> output_table);
+    std::shared_ptr<MemTableHandler> RunWindowAggOnKeys(
+        const Row& parameter,
+        std::shared_ptr<PartitionHandler> instance_partition,
+        const std::vector<std::shared_ptr<PartitionHandler>>& union_partitions,
+        const std::vector<std::shared_ptr<DataHandler>>& joins,
+        const std::vector<std::string>& keys);
 
     const bool instance_not_in_window_;
     const bool exclude_current_time_;
@@ -952,6 +1005,99 @@ class WindowAggRunner : public Runner {
     WindowUnionGenerator windows_union_gen_;
     WindowJoinGenerator windows_join_gen_;
     WindowProjectGenerator window_project_gen_;
+    uint32_t parallelism_;
+};
+
+// the recent windows of a request union keyed by the segment key. a window is
+// reused by the next request of the key with a later ts if no row is put at or
+// before the newest row of the window, see TableHandler::GetAppendVersion, so
+// only the rows put after it are read and the rows out of the window range are
+// evicted. a window keeps either its rows, or the incremental aggregate of
+// them for the request agg union, see WindowAggState. the windows are shared by
+// the concurrent requests and each one is refreshed under its own lock. the
+// least recently used keys are dropped once the windows keep more than
+// `max_rows` rows
+class RequestWindowCache {
+ public:
+    using AggStateFactory = std::function<std::unique_ptr<BaseWindowAggState>()>;
+    // add the value of a base row to the aggregate state
+    using AggStateAdd = std::function<void(BaseWindowAggState*, uint64_t ts, const Row& row)>;
+
+    explicit RequestWindowCache(uint64_t max_rows)
+        : max_rows_(max_rows), mu_(), rows_cnt_(0), lru_(), entries_() {}
+
+    // return null if the window can not be cached, e.g. the segment does not
+    // track the version, the window is not a pure rows range window or it
+    // keeps more than `max_rows` rows. the key of a window too large is not
+    // read again until its entry is dropped from the lru
+    std::shared_ptr<TableHandler> GetWindow(
+        const Row& request, const std::shared_ptr<TableHandler>& segment,
+        int64_t ts_gen, const WindowRange& window_range,
+        bool output_request_row, bool exclude_current_time);
+
+    // update `aggregator` with the aggregate of the rows of the segment in the
+    // window, which is kept by the state made by `new_state`. return false if
+    // the window can not be cached as GetWindow, the caller reads the
+    // pre-aggregate tables then
+    bool UpdateAggregator(const std::shared_ptr<TableHandler>& segment,
+                          int64_t ts_gen, const WindowRange& window_range,
+                          bool exclude_current_time,
+                          const AggStateFactory& new_state,
+                          const AggStateAdd& add_row,
+                          BaseAggregator* aggregator);
+
+ private:
+    struct State {
+        uint64_t version = 0;
+        int64_t ts_gen = 0;
+        bool filled = false;
+        // all the rows at or before it are read
+        uint64_t newest_ts = 0;
+        // the rows of the window in descending order of ts, which are copied
+        // so they outlive the storage
+        std::deque<std::pair<uint64_t, Row>> rows;
+        std::unique_ptr<BaseWindowAggState> agg;
+        // the window keeps more than `max_rows_` rows, so it is not cached
+        bool too_large = false;
+    };
+
+    struct Entry {
+        std::mutex mu;
+        State state;
+        // the rows of the entry counted in `rows_cnt_`, guarded by `mu_`
+        uint64_t cached_rows = 0;
+    };
+
+    // lock the entry of the segment key by `lock`, reset its state if it can
+    // not be reused by the request and pass the rows after its newest ts to
+    // `add` in ascending order of ts, the rows out of [start, end] or expired
+    // should be evicted by the caller then. return null if the window can not
+    // be cached
+    std::shared_ptr<Entry> Refresh(
+        const std::shared_ptr<TableHandler>& segment, int64_t ts_gen,
+        const WindowRange& window_range, bool exclude_current_time,
+        const std::function<void(State*, uint64_t, const Row&)>& add,
+        std::unique_lock<std::mutex>* lock, std::string* key,
+        uint64_t* start, uint64_t* expire_ts);
+    std::shared_ptr<Entry> GetEntry(const std::string& key);
+    // drop the rows of the entry locked by `lock` and keep it as a window too
+    // large, which counts as one row
+    void SetTooLarge(const std::string& key, const std::shared_ptr<Entry>& entry,
+                     std::unique_lock<std::mutex>* lock);
+    // account the rows kept by the entry and drop the lru entries if the
+    // windows keep too many rows
+    void UpdateRows(const std::string& key, const std::shared_ptr<Entry>& entry,
+                    uint64_t rows);
+
+    const uint64_t max_rows_;
+    std::mutex mu_;
+    uint64_t rows_cnt_;
+    // the keys in lru order, the most recently used one is at the front
+    std::list<std::string> lru_;
+    std::unordered_map<
+        std::string,
+        std::pair<std::shared_ptr<Entry>, std::list<std::string>::iterator>>
+        entries_;
 };
 
 class RequestUnionRunner : public Runner {
@@ -964,6 +1110,12 @@ class RequestUnionRunner : public Runner {
           exclude_current_time_(exclude_current_time),
           output_request_row_(output_request_row) {}
 
+    // keep the recent windows of at most `max_rows` rows, see
+    // RequestWindowCache
+    void EnableWindowCache(uint64_t max_rows) {
+        window_cache_ = std::make_unique<RequestWindowCache>(max_rows);
+    }
+
     std::shared_ptr<DataHandler> Run(
         RunnerContext& ctx,  // NOLINT
         const std::vector<std::shared_ptr<DataHandler>>& inputs)
@@ -980,6 +1132,7 @@ class RequestUnionRunner : public Runner {
     RangeGenerator range_gen_;
     bool exclude_current_time_;
     bool output_request_row_;
+    std::unique_ptr<RequestWindowCache> window_cache_;
 };
 
 class RequestAggUnionRunner : public Runner {
@@ -999,6 +1152,11 @@ class RequestAggUnionRunner : public Runner {
 }
 
     bool InitAggregator();
+    // keep the aggregates of the recent windows of at most `max_rows` rows,
+    // see RequestWindowCache
+    void EnableWindowCache(uint64_t max_rows) {
+        window_cache_ = std::make_unique<RequestWindowCache>(max_rows);
+    }
     std::shared_ptr<DataHandler> Run(RunnerContext& ctx,
                                      const std::vector<std::shared_ptr<DataHandler>>& inputs) override;
     std::shared_ptr<TableHandler> RequestUnionWindow(
@@ -1028,8 +1186,15 @@ class RequestAggUnionRunner : public Runner {
     const node::ExprNode* agg_col_ = nullptr;
     std::string agg_col_name_;
     type::Type agg_col_type_;
+    std::unique_ptr<RequestWindowCache> window_cache_;
 
     std::unique_ptr<BaseAggregator> CreateAggregator() const;
+    std::unique_ptr<BaseWindowAggState> CreateWindowAggState() const;
+    // add the value of a base row to the state, skip the null value
+    void AddWindowAggValue(BaseWindowAggState* state, uint64_t ts, const Row& row) const;
+    // return null if the window can not be cached
+    std::shared_ptr<TableHandler> CachedAggWindow(const Row& request, const std::shared_ptr<TableHandler>& segment,
+                                                  int64_t ts_gen) const;
     static inline const std::unordered_map<std::string, AggType> agg_type_map_ = {
         {"sum", kSum}, {"count", kCount}, {"avg", kAvg}, {"min", kMin}, {"max", kMax},
     };
@@ -1079,6 +1244,10 @@ class RequestLastJoinRunner : public Runner {
     std::shared_ptr<DataHandler> Run(
         RunnerContext& ctx,                                        // NOLINT
         const std::vector<std::shared_ptr<DataHandler>>& inputs);  // NOLINT
+    void PrepareBatch(
+        RunnerContext& ctx,  // NOLINT
+        const std::vector<std::shared_ptr<DataHandlerList>>& batch_inputs)
+        override;
     virtual void PrintRunnerInfo(std::ostream& output,
                                  const std::string& tab) const {
         output << tab << "[" << id_ << "]" << RunnerTypeName(type_);
@@ -1444,8 +1613,24 @@ class RunnerBuilder {
           cluster_job_(sql, db, common_column_indices),
           task_map_(),
           proxy_runner_map_(),
-          batch_common_node_set_(batch_common_node_set) {}
+          batch_common_node_set_(batch_common_node_set),
+          request_window_cache_rows_(0),
+          window_agg_parallelism_(1),
+          sort_parallelism_(1) {}
     virtual ~RunnerBuilder() {}
+    // keep the recent windows of the request unions and the request agg
+    // unions, see RequestWindowCache
+    void SetRequestWindowCacheRows(uint64_t rows) {
+        request_window_cache_rows_ = rows;
+    }
+    // the threads to run a window aggregation of the batch mode
+    void SetWindowAggParallelism(uint32_t parallelism) {
+        window_agg_parallelism_ = parallelism;
+    }
+    // the threads to sort a partition of the batch mode
+    void SetSortParallelism(uint32_t parallelism) {
+        sort_parallelism_ = parallelism;
+    }
     ClusterTask RegisterTask(PhysicalOpNode* node, ClusterTask task) {
         task_map_[node] = task;
         if (batch_common_node_set_.find(node->node_id()) !=
@@ -1507,6 +1692,9 @@ class RunnerBuilder {
     std::unordered_map<hybridse::vm::Runner*, ::hybridse::vm::Runner*>
         proxy_runner_map_;
     std::set<size_t> batch_common_node_set_;
+    uint64_t request_window_cache_rows_;
+    uint32_t window_agg_parallelism_;
+    uint32_t sort_parallelism_;
     ClusterTask MultipleInherit(const std::vector<const ClusterTask*>& children, Runner* runner,
                                                 const Key& index_key, const TaskBiasType bias);
     ClusterTask BinaryInherit(const ClusterTask& left, const ClusterTask& right,
@@ -14,8 +14,13 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <string>
+#include <thread>  // NOLINT
 #include <utility>
+#include <vector>
 #include "boost/algorithm/string.hpp"
 #include "case/sql_case.h"
 #include "gtest/gtest.h"
@@ -375,6 +380,148 @@ TEST_F(RunnerTest, KeyGeneratorTest) {
     ASSERT_EQ("5|55", group_runner->partition_gen_.GetKey(rows[4], empty_parameter));
 }
 
+// the order function of SortGeneratorPartitionTest, which takes the only
+// int64 column of a row as its order key
+static int32_t OrderByFirstColumn(const int64_t, const int8_t* row_ptr,
+                                  const int8_t*, const int8_t*, int8_t** out) {
+    codec::Schema schema;
+    auto column = schema.Add();
+    column->set_type(type::kInt64);
+    column->set_name("ts");
+    auto row = reinterpret_cast<const Row*>(row_ptr);
+    codec::RowView view(schema, row->buf(), row->size());
+    int64_t ts = 0;
+    view.GetInt64(0, &ts);
+    codec::RowBuilder builder(schema);
+    uint32_t size = builder.CalTotalLength(0);
+    auto buf = reinterpret_cast<int8_t*>(malloc(size));
+    builder.SetBuffer(buf, size);
+    builder.AppendInt64(ts);
+    *out = buf;
+    return 0;
+}
+
+TEST_F(RunnerTest, SortGeneratorPartitionTest) {
+    codec::Schema schema;
+    auto column = schema.Add();
+    column->set_type(type::kInt64);
+    column->set_name("ts");
+    auto partition = std::make_shared<MemPartitionHandler>(&schema);
+    std::vector<std::string> keys = {"key1", "key2", "key3"};
+    for (const auto& key : keys) {
+        for (int64_t ts : {3, 1, 2}) {
+            codec::RowBuilder builder(schema);
+            uint32_t size = builder.CalTotalLength(0);
+            auto buf = reinterpret_cast<int8_t*>(malloc(size));
+            builder.SetBuffer(buf, size);
+            builder.AppendInt64(ts);
+            Row row(base::RefCountedSlice::CreateManaged(buf, size));
+            partition->AddRow(key, static_cast<uint64_t>(ts), row);
+        }
+    }
+
+    node::NodeManager nm;
+    auto orders = nm.MakeOrderByNode(nm.MakeExprList(
+        nm.MakeOrderExpression(nm.MakeColumnRefNode("ts", "t1"), true)));
+    Sort sort(orders);
+    sort.mutable_fn_info()->AddOutputColumn(*column);
+    sort.mutable_fn_info()->SetFnPtr(
+        reinterpret_cast<const int8_t*>(&OrderByFirstColumn));
+    SortGenerator sort_gen(sort);
+    ASSERT_TRUE(sort_gen.order_gen().Valid());
+
+    // every segment of the partition is sorted, not only the first one
+    auto output = sort_gen.Sort(
+        std::static_pointer_cast<PartitionHandler>(partition));
+    ASSERT_TRUE(output != nullptr);
+    auto iter = output->GetWindowIterator();
+    std::vector<std::string> output_keys;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        output_keys.push_back(iter->GetKey().ToString());
+        std::vector<uint64_t> ts_list;
+        auto segment_iter = iter->GetValue();
+        for (segment_iter->SeekToFirst(); segment_iter->Valid();
+             segment_iter->Next()) {
+            ts_list.push_back(segment_iter->GetKey());
+        }
+        ASSERT_EQ(std::vector<uint64_t>({1, 2, 3}), ts_list);
+    }
+    std::sort(output_keys.begin(), output_keys.end());
+    ASSERT_EQ(keys, output_keys);
+}
+
+// the keys and the order keys of the segments of a partition
+static std::vector<std::pair<std::string, std::vector<uint64_t>>> DumpPartition(
+    const std::shared_ptr<DataHandler>& data) {
+    std::vector<std::pair<std::string, std::vector<uint64_t>>> segments;
+    auto partition = std::dynamic_pointer_cast<PartitionHandler>(data);
+    if (!partition) {
+        return segments;
+    }
+    auto iter = partition->GetWindowIterator();
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        std::vector<uint64_t> ts_list;
+        auto segment_iter = iter->GetValue();
+        for (segment_iter->SeekToFirst(); segment_iter->Valid();
+             segment_iter->Next()) {
+            ts_list.push_back(segment_iter->GetKey());
+        }
+        segments.emplace_back(iter->GetKey().ToString(), ts_list);
+    }
+    return segments;
+}
+
+TEST_F(RunnerTest, SortRunnerParallelTest) {
+    codec::Schema schema;
+    auto column = schema.Add();
+    column->set_type(type::kInt64);
+    column->set_name("ts");
+    SchemasContext schemas_ctx;
+    auto source = schemas_ctx.AddSource();
+    source->SetSourceDBAndTableName("", "t1");
+    source->SetSchema(&schema);
+
+    // large enough to be sorted by several threads, see MemPartitionHandler::Sort
+    auto partition = std::make_shared<MemPartitionHandler>(&schema);
+    std::vector<std::string> keys = {"key1", "key2", "key3", "key4"};
+    for (const auto& key : keys) {
+        for (int64_t i = 0; i < 20000; i++) {
+            int64_t ts = (i * 7919) % 20000;
+            codec::RowBuilder builder(schema);
+            uint32_t size = builder.CalTotalLength(0);
+            auto buf = reinterpret_cast<int8_t*>(malloc(size));
+            builder.SetBuffer(buf, size);
+            builder.AppendInt64(ts);
+            Row row(base::RefCountedSlice::CreateManaged(buf, size));
+            partition->AddRow(key, static_cast<uint64_t>(ts), row);
+        }
+    }
+
+    node::NodeManager nm;
+    auto orders = nm.MakeOrderByNode(nm.MakeExprList(
+        nm.MakeOrderExpression(nm.MakeColumnRefNode("ts", "t1"), true)));
+    Sort sort(orders);
+    sort.mutable_fn_info()->AddOutputColumn(*column);
+    sort.mutable_fn_info()->SetFnPtr(
+        reinterpret_cast<const int8_t*>(&OrderByFirstColumn));
+
+    ClusterJob cluster_job;
+    Row empty_parameter;
+    RunnerContext ctx(&cluster_job, empty_parameter, false);
+    std::vector<std::shared_ptr<DataHandler>> inputs = {partition};
+    SortRunner serial_runner(0, &schemas_ctx, 0, sort);
+    auto expect = DumpPartition(serial_runner.Run(ctx, inputs));
+    SortRunner parallel_runner(1, &schemas_ctx, 0, sort);
+    parallel_runner.sort_gen_.SetParallelism(4);
+    auto output = DumpPartition(parallel_runner.Run(ctx, inputs));
+
+    ASSERT_EQ(keys.size(), expect.size());
+    for (const auto& segment : expect) {
+        ASSERT_TRUE(std::is_sorted(segment.second.begin(), segment.second.end()));
+    }
+    ASSERT_EQ(expect, output);
+}
+
 TEST_F(RunnerTest, RunnerPrintDataTest) {
     hybridse::type::TableDef table_def;
     BuildTableDef(table_def);
@@ -522,6 +669,181 @@ TEST_F(RunnerTest, RunnerPrintDataMemTimeTableTest) {
         LOG(INFO) << oss.str();
     }
 }
+
+// a segment whose version is bumped by the test
+class VersionedSegment : public MemTimeTableHandler {
+ public:
+    bool GetAppendVersion(std::string* key, uint64_t* version,
+                          uint64_t* expire_ts) override {
+        *key = "key1";
+        *version = version_;
+        *expire_ts = 0;
+        return true;
+    }
+    uint64_t version_ = 0;
+};
+
+static std::vector<uint64_t> GetWindowKeys(
+    const std::shared_ptr<TableHandler>& window) {
+    std::vector<uint64_t> keys;
+    auto iter = window->GetIterator();
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        keys.push_back(iter->GetKey());
+    }
+    return keys;
+}
+
+TEST_F(RunnerTest, RequestWindowCacheTest) {
+    static const std::string value = "value";
+    Row row(value);
+    Row request(value);
+    auto segment = std::make_shared<VersionedSegment>();
+    for (uint64_t ts = 100; ts <= 1000; ts += 100) {
+        segment->AddRow(ts, row);
+    }
+    segment->Sort(false);
+    auto range = WindowRange::CreateRowsRangeWindow(-300, 0);
+    RequestWindowCache cache(100);
+    auto check = [&](int64_t ts) {
+        auto window = cache.GetWindow(request, segment, ts, range, true, false);
+        ASSERT_TRUE(window != nullptr);
+        auto expect = RequestUnionRunner::RequestUnionWindow(
+            request, {segment}, ts, range, true, false);
+        ASSERT_EQ(GetWindowKeys(expect), GetWindowKeys(window));
+    };
+    check(1000);
+    // the rows appended after the window
+    segment->AddRow(1100, row);
+    segment->AddRow(1200, row);
+    segment->Sort(false);
+    check(1100);
+    check(1200);
+    // a row put before the newest row bumps the version
+    segment->AddRow(1050, row);
+    segment->Sort(false);
+    segment->version_++;
+    check(1200);
+    // the window moves back
+    check(500);
+    check(1200);
+    // the window is larger than the cache, it is read by the caller
+    RequestWindowCache small_cache(1);
+    ASSERT_TRUE(small_cache.GetWindow(request, segment, 1200, range, true,
+                                      false) == nullptr);
+    ASSERT_TRUE(small_cache.GetWindow(request, segment, 1200, range, true,
+                                      false) == nullptr);
+    // only the rows range window is cached
+    ASSERT_TRUE(cache.GetWindow(request, segment, 1200,
+                                WindowRange::CreateRowsWindow(3), true,
+                                false) == nullptr);
+}
+
+TEST_F(RunnerTest, RequestWindowCacheSharedTest) {
+    static const std::string value = "value";
+    Row row(value);
+    Row request(value);
+    auto segment = std::make_shared<VersionedSegment>();
+    for (uint64_t ts = 100; ts <= 1000; ts += 100) {
+        segment->AddRow(ts, row);
+    }
+    segment->Sort(false);
+    auto range = WindowRange::CreateRowsRangeWindow(-300, 0);
+    auto expect = GetWindowKeys(RequestUnionRunner::RequestUnionWindow(
+        request, {segment}, 1000, range, true, false));
+    RequestWindowCache cache(100);
+    // the concurrent requests of the key share the window
+    std::vector<std::thread> threads;
+    std::atomic<int> failed(0);
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < 100; j++) {
+                auto window =
+                    cache.GetWindow(request, segment, 1000, range, true, false);
+                if (!window || GetWindowKeys(window) != expect) {
+                    failed++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(0, failed.load());
+}
+
+TEST_F(RunnerTest, RequestWindowCacheAggTest) {
+    static const std::string value = "value";
+    Row row(value);
+    auto segment = std::make_shared<VersionedSegment>();
+    for (uint64_t ts = 100; ts <= 1000; ts += 100) {
+        segment->AddRow(ts, row);
+    }
+    segment->Sort(false);
+    codec::Schema schema;
+    auto column = schema.Add();
+    column->set_type(type::kInt64);
+    column->set_name("val");
+    auto range = WindowRange::CreateRowsRangeWindow(-300, 0);
+    RequestWindowCache cache(100);
+    int new_states = 0;
+    auto new_state = [&]() {
+        new_states++;
+        return std::make_unique<WindowAggState<int64_t>>(WindowAggOp::kSum);
+    };
+    // the value of a row is its ts
+    auto add_row = [](BaseWindowAggState* state, uint64_t ts, const Row&) {
+        state->Add(ts, static_cast<int64_t>(ts));
+    };
+    auto check = [&](int64_t ts) {
+        SumAggregator<int64_t> aggregator(type::kInt64, schema);
+        ASSERT_TRUE(cache.UpdateAggregator(segment, ts, range, false,
+                                           new_state, add_row, &aggregator));
+        int64_t expect = 0;
+        for (auto key : GetWindowKeys(RequestUnionRunner::RequestUnionWindow(
+                 Row(), {segment}, ts, range, false, false))) {
+            expect += key;
+        }
+        ASSERT_EQ(expect, aggregator.val());
+    };
+    check(1000);
+    segment->AddRow(1100, row);
+    segment->AddRow(1200, row);
+    segment->Sort(false);
+    check(1100);
+    check(1200);
+    // the state is updated incrementally
+    ASSERT_EQ(1, new_states);
+    // a row put before the newest row bumps the version
+    segment->AddRow(1050, row);
+    segment->Sort(false);
+    segment->version_++;
+    check(1200);
+    ASSERT_EQ(2, new_states);
+    // only the rows range window is cached
+    SumAggregator<int64_t> aggregator(type::kInt64, schema);
+    ASSERT_FALSE(cache.UpdateAggregator(segment, 1200,
+                                        WindowRange::CreateRowsWindow(3), false,
+                                        new_state, add_row, &aggregator));
+    // the window is larger than the cache, so the caller reads the pre-agg
+    // tables. the rows are not read again by the next request
+    RequestWindowCache small_cache(2);
+    int read_rows = 0;
+    auto count_row = [&read_rows](BaseWindowAggState*, uint64_t, const Row&) {
+        read_rows++;
+    };
+    ASSERT_FALSE(small_cache.UpdateAggregator(segment, 1200, range, false,
+                                              new_state, count_row,
+                                              &aggregator));
+    ASSERT_FALSE(small_cache.UpdateAggregator(segment, 1200, range, false,
+                                              new_state, count_row,
+                                              &aggregator));
+    ASSERT_EQ(0, read_rows);
+    // a window in the limit is cached
+    RequestWindowCache fit_cache(2);
+    ASSERT_TRUE(fit_cache.UpdateAggregator(
+        segment, 1200, WindowRange::CreateRowsRangeWindow(-100, 0), false,
+        new_state, add_row, &aggregator));
+}
 }  // namespace vm
 }  // namespace hybridse
 
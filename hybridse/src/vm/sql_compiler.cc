@@ -308,6 +308,12 @@ bool SqlCompiler::BuildClusterJob(SqlContext& ctx, Status& status) {  // NOLINT
                                  ctx.is_cluster_optimized && is_request_mode,
                                  ctx.batch_request_info.common_column_indices,
                                  ctx.batch_request_info.common_node_set);
+    if (vm::kRequestMode == ctx.engine_mode) {
+        runner_builder.SetRequestWindowCacheRows(ctx.request_window_cache_rows);
+    } else if (vm::kBatchMode == ctx.engine_mode) {
+        runner_builder.SetWindowAggParallelism(ctx.window_agg_parallelism);
+        runner_builder.SetSortParallelism(ctx.sort_parallelism);
+    }
     ctx.cluster_job = runner_builder.BuildClusterJob(ctx.physical_plan, status);
     return status.isOK();
 }
@@ -402,13 +408,20 @@ bool SqlCompiler::ResolvePlanFnAddress(vm::PhysicalOpNode* node,
             if (!info_ptr->fn_name().empty()) {
                 DLOG(INFO) << "Start to resolve fn address "
                            << info_ptr->fn_name();
-                auto addr = jit->FindFunction(info_ptr->fn_name());
-                if (addr == nullptr) {
+                if (!jit->ResolveFunction(info_ptr->fn_name(),
+                                          info_ptr->fn_address())) {
                     LOG(WARNING) << "Fail to find jit function "
                                  << info_ptr->fn_name() << " for node\n"
                                  << *node;
                 }
-                const_cast<FnInfo*>(info_ptr)->SetFnPtr(addr);
+            }
+            if (!info_ptr->batch_fn_name().empty()) {
+                if (!jit->ResolveFunction(info_ptr->batch_fn_name(),
+                                          info_ptr->batch_fn_address())) {
+                    LOG(WARNING) << "Fail to find jit function "
+                                 << info_ptr->batch_fn_name() << " for node\n"
+                                 << *node;
+                }
             }
         }
     }
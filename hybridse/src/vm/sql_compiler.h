@@ -45,6 +45,12 @@ struct SqlContext {
     bool enable_expr_optimize = false;
     bool enable_batch_window_parallelization = true;
     bool enable_window_column_pruning = false;
+    // the rows of the windows kept by a request union, 0 if disabled
+    uint64_t request_window_cache_rows = 0;
+    // the threads to run a window aggregation of the batch mode
+    uint32_t window_agg_parallelism = 1;
+    // the threads to sort a partition of the batch mode
+    uint32_t sort_parallelism = 1;
 
     // the sql content
     std::string sql;
@@ -18,6 +18,7 @@
 #include <set>
 #include <stack>
 #include <unordered_map>
+#include "codegen/batch_fn_ir_builder.h"
 #include "codegen/context.h"
 #include "codegen/fn_ir_builder.h"
 #include "codegen/fn_let_ir_builder.h"
@@ -308,6 +309,8 @@ Status BatchModeTransformer::InitFnInfo(PhysicalOpNode* node,
                      "th native function \"", fn_info->fn_name(),
                      "\" failed at node:\n", node->GetTreeString());
     }
+    CHECK_STATUS(InstantiateBatchLLVMFunction(node), "Instantiate batch native function failed at node:\n",
+                 node->GetTreeString());
     return Status::OK();
 }
 
@@ -945,6 +948,38 @@ Status BatchModeTransformer::InstantiateLLVMFunction(const FnInfo& fn_info) {
                          *fn_info.fn_schema());
 }
 
+Status BatchModeTransformer::InstantiateBatchLLVMFunction(PhysicalOpNode* node) {
+    FnInfo* fn_info = nullptr;
+    switch (node->GetOpType()) {
+        case kPhysicalOpSimpleProject: {
+            fn_info = dynamic_cast<PhysicalSimpleProjectNode*>(node)->mutable_project()->mutable_fn_info();
+            break;
+        }
+        case kPhysicalOpProject: {
+            auto project_op = dynamic_cast<PhysicalProjectNode*>(node);
+            if (kTableProject == project_op->project_type_) {
+                fn_info = project_op->mutable_project()->mutable_fn_info();
+            }
+            break;
+        }
+        case kPhysicalOpFilter: {
+            fn_info = dynamic_cast<PhysicalFilterNode*>(node)->filter_.condition_.mutable_fn_info();
+            break;
+        }
+        default:
+            break;
+    }
+    if (nullptr == fn_info || fn_info->fn_name().empty()) {
+        return Status::OK();
+    }
+    const std::string batch_fn_name = fn_info->fn_name() + "_batch";
+    codegen::CodeGenContext codegen_ctx(module_, fn_info->schemas_ctx(), plan_ctx_.parameter_types(), node_manager_);
+    codegen::BatchFnIRBuilder builder(&codegen_ctx);
+    CHECK_STATUS(builder.Build(batch_fn_name, fn_info->fn_name()));
+    fn_info->SetBatchFn(batch_fn_name);
+    return Status::OK();
+}
+
 bool BatchModeTransformer::AddDefaultPasses() {
     AddPass(PhysicalPlanPassType::kPassColumnProjectsOptimized);
     AddPass(PhysicalPlanPassType::kPassFilterOptimized);
@@ -219,6 +219,12 @@ class BatchModeTransformer {
      */
     Status InstantiateLLVMFunction(const FnInfo& fn_info);
 
+    /**
+     * Instantiate the batch version of the table project or filter function
+     * of the node, which is called on a batch of rows by the batch runners.
+     */
+    virtual Status InstantiateBatchLLVMFunction(PhysicalOpNode* node);
+
     Status GenWindowJoinList(PhysicalWindowAggrerationNode* window_agg_op,
                              PhysicalOpNode* in);
     Status GenWindowUnionList(WindowUnionList* window_union_list,
@@ -293,6 +299,9 @@ class RequestModeTransformer : public BatchModeTransformer {
 
     Status TransformLoadDataOp(const node::LoadDataPlanNode* node, PhysicalOpNode** output) override;
 
+    // the request plans project and filter the rows one by one
+    Status InstantiateBatchLLVMFunction(PhysicalOpNode* node) override { return Status::OK(); }
+
  private:
     bool enable_batch_request_opt_;
     bool performance_sensitive_;
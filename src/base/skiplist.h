@@ -21,9 +21,15 @@
 #include <stdint.h>
 
 #include <atomic>
+#include <functional>
 #include <iostream>
+#include <new>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "base/random.h"
+#include "base/slab_allocator.h"
 
 namespace openmldb {
 namespace base {
@@ -40,18 +46,16 @@ struct DefaultComparator {
 };
 
 // Skiplist node , a thread safe structure
+// The next pointers are inline after the key and value, so the node must be
+// created by NewNode with the room of its height and released by DeleteNode
 template <class K, class V>
 class Node {
  public:
     // Set data reference and Node height
     Node(const K& key, V& value, uint8_t height)  // NOLINT
-        : height_(height), key_(key), value_(value) {
-        nexts_ = new std::atomic<Node<K, V>*>[height];
-    }
+        : height_(height), key_(key), value_(value) {}
 
-    Node(uint8_t height) : height_(height), key_(), value_() {  // NOLINT
-        nexts_ = new std::atomic<Node<K, V>*>[height];
-    }
+    Node(uint8_t height) : height_(height), key_(), value_() {}  // NOLINT
 
     // Set the next node with memory barrier
     void SetNext(uint8_t level, Node<K, V>* node) {
@@ -65,6 +69,13 @@ class Node {
         nexts_[level].store(node, std::memory_order_relaxed);
     }
 
+    // Set the next node with memory barrier if the next node is still expected
+    bool CasNext(uint8_t level, Node<K, V>* expected, Node<K, V>* node) {
+        assert(level < height_ && level >= 0);
+        return nexts_[level].compare_exchange_strong(expected, node, std::memory_order_release,
+                                                     std::memory_order_relaxed);
+    }
+
     uint8_t Height() { return height_; }
 
     Node<K, V>* GetNext(uint8_t level) {
@@ -81,33 +92,76 @@ class Node {
 
     const K& GetKey() const { return key_; }
 
-    ~Node() { delete[] nexts_; }
+    ~Node() {}
+
+    // the memory of node is allocated with its next pointers, use NewNode and DeleteNode
+    static void* operator new(size_t size) = delete;
+    static void operator delete(void* ptr) = delete;
 
  private:
     uint8_t const height_;
     K const key_;
     V value_;
-    std::atomic<Node<K, V>*>* nexts_;
+    // the first next pointer, the other height - 1 ones follow it
+    std::atomic<Node<K, V>*> nexts_[1];
 };
 
+// The byte size of node and its next pointers
+template <class K, class V>
+inline uint32_t GetNodeSize(uint8_t height) {
+    return sizeof(Node<K, V>) + (height - 1) * sizeof(std::atomic<Node<K, V>*>);
+}
+
+// Allocate the node from allocator if it is not null, otherwise from heap
+template <class K, class V, class... Args>
+inline Node<K, V>* NewNode(SlabAllocator* allocator, uint8_t height, Args&&... args) {
+    uint32_t size = GetNodeSize<K, V>(height);
+    void* chunk = allocator == NULL ? ::operator new(size) : allocator->Allocate(size);
+    auto* node = ::new (chunk) Node<K, V>(std::forward<Args>(args)..., height);
+    for (uint8_t i = 1; i < height; i++) {
+        // construct the next pointers out of nexts_[0]
+        ::new (reinterpret_cast<char*>(node) + sizeof(Node<K, V>) + (i - 1) * sizeof(std::atomic<Node<K, V>*>))
+            std::atomic<Node<K, V>*>(NULL);
+    }
+    return node;
+}
+
+// Delete the node which is created by NewNode with the same allocator
+template <class K, class V>
+inline void DeleteNode(Node<K, V>* node, SlabAllocator* allocator) {
+    if (node == NULL) {
+        return;
+    }
+    uint32_t size = GetNodeSize<K, V>(node->Height());
+    node->~Node<K, V>();
+    if (allocator == NULL) {
+        ::operator delete(node);
+    } else {
+        allocator->Free(node, size);
+    }
+}
+
 template <class K, class V, class Comparator>
 class Skiplist {
  public:
-    Skiplist(uint8_t max_height, uint8_t branch, const Comparator& compare)
+    // the nodes except head are allocated from allocator if it is not null,
+    // allocator must outlive the skiplist and the nodes split from it
+    Skiplist(uint8_t max_height, uint8_t branch, const Comparator& compare, SlabAllocator* allocator = NULL)
         : MaxHeight(max_height),
           Branch(branch),
           max_height_(0),
           compare_(compare),
           rand_(0xdeadbeef),
+          allocator_(allocator),
           head_(NULL),
           tail_(NULL) {
-        head_ = new Node<K, V>(MaxHeight);
+        head_ = ::openmldb::base::NewNode<K, V>(NULL, MaxHeight);
         for (uint8_t i = 0; i < head_->Height(); i++) {
             head_->SetNext(i, NULL);
         }
         max_height_.store(1, std::memory_order_relaxed);
     }
-    ~Skiplist() { delete head_; }
+    ~Skiplist() { DeleteNode(head_, NULL); }
 
     // Insert need external synchronized
     uint8_t Insert(const K& key, V& value) {  // NOLINT
@@ -131,6 +185,59 @@ class Skiplist {
         return height;
     }
 
+    // Insert with the other concurrent InsertConcurrently by CAS, but it still need
+    // external synchronized with Insert, Remove, Split and Clear.
+    // If unique is true and the key exists, nothing is inserted and the value of the
+    // existing key is returned by value. Return the height of new node, 0 if not inserted
+    uint8_t InsertConcurrently(const K& key, V& value, bool unique = false) {  // NOLINT
+        uint8_t height = RandomHeightConcurrently();
+        uint8_t max_height = GetMaxHeight();
+        while (height > max_height) {
+            if (max_height_.compare_exchange_weak(max_height, height, std::memory_order_relaxed)) {
+                max_height = height;
+                break;
+            }
+        }
+        Node<K, V>* pre[MaxHeight];
+        Node<K, V>* next[MaxHeight];
+        Node<K, V>* node = head_;
+        for (int level = max_height - 1; level >= 0; level--) {
+            FindSpliceForLevel(key, node, level, &pre[level], &next[level]);
+            node = pre[level];
+        }
+        if (unique && IsEqualNode(key, next[0])) {
+            value = next[0]->GetValue();
+            return 0;
+        }
+        Node<K, V>* new_node = NewNode(key, value, height);
+        for (uint8_t i = 0; i < height; i++) {
+            while (true) {
+                new_node->SetNextNoBarrier(i, next[i]);
+                if (pre[i]->CasNext(i, next[i], new_node)) {
+                    break;
+                }
+                // the splice is changed by other writer, nodes are never removed during
+                // concurrent insert so search it again from pre
+                FindSpliceForLevel(key, pre[i], i, &pre[i], &next[i]);
+                if (i == 0 && unique && IsEqualNode(key, next[0])) {
+                    // the node is not linked to any level yet
+                    value = next[0]->GetValue();
+                    DeleteNode(new_node, allocator_);
+                    return 0;
+                }
+            }
+            if (i == 0) {
+                // the tail is the last writer who sees its node has no next
+                Node<K, V>* last = tail_.load(std::memory_order_acquire);
+                while (new_node->GetNext(0) == NULL &&
+                       !tail_.compare_exchange_weak(last, new_node, std::memory_order_release,
+                                                    std::memory_order_acquire)) {
+                }
+            }
+        }
+        return height;
+    }
+
     bool IsEmpty() {
         if (head_->GetNextNoBarrier(0) == NULL) {
             return true;
@@ -286,7 +393,7 @@ class Skiplist {
             for (uint8_t i = 0; i < tmp->Height(); i++) {
                 tmp->SetNextNoBarrier(i, NULL);
             }
-            delete tmp;
+            DeleteNode(tmp, allocator_);
         }
         return cnt;
     }
@@ -362,10 +469,84 @@ class Skiplist {
     // delete the iterator after it's used
     Iterator* NewIterator() { return new Iterator(this); }
 
+    // Build the list from the keys in order of comparator. The last node of every level
+    // is cached, so the key after the tail is linked without search from head. The key
+    // before the tail falls back to Insert.
+    // Need external synchronized and no other writer during the life of appender
+    class Appender {
+     public:
+        explicit Appender(Skiplist<K, V, Comparator>* list) : list_(list), lasts_(list->MaxHeight, NULL) {
+            Reset();
+        }
+        ~Appender() {}
+
+        uint8_t Append(const K& key, V& value) {  // NOLINT
+            Node<K, V>* last = lasts_[0];
+            if (last != list_->head_ && list_->compare_(key, last->GetKey()) < 0) {
+                uint8_t height = list_->Insert(key, value);
+                Reset();
+                return height;
+            }
+            uint8_t height = list_->RandomHeight();
+            if (height > list_->GetMaxHeight()) {
+                list_->max_height_.store(height, std::memory_order_relaxed);
+            }
+            Node<K, V>* node = list_->NewNode(key, value, height);
+            for (uint8_t i = 0; i < height; i++) {
+                node->SetNextNoBarrier(i, NULL);
+                lasts_[i]->SetNext(i, node);
+                lasts_[i] = node;
+            }
+            list_->tail_.store(node, std::memory_order_release);
+            return height;
+        }
+
+     private:
+        void Reset() {
+            Node<K, V>* node = list_->head_;
+            for (int level = list_->MaxHeight - 1; level >= 0; level--) {
+                Node<K, V>* next = node->GetNextNoBarrier(level);
+                while (next != NULL) {
+                    node = next;
+                    next = node->GetNextNoBarrier(level);
+                }
+                lasts_[level] = node;
+            }
+        }
+
+        Skiplist<K, V, Comparator>* const list_;
+        std::vector<Node<K, V>*> lasts_;
+    };
+
  private:
     Node<K, V>* NewNode(const K& key, V& value, uint8_t height) {  // NOLINT
-        Node<K, V>* node = new Node<K, V>(key, value, height);
-        return node;
+        return ::openmldb::base::NewNode<K, V>(allocator_, height, key, value);
+    }
+
+    uint8_t RandomHeightConcurrently() {
+        static thread_local Random rand(std::hash<std::thread::id>()(std::this_thread::get_id()));
+        uint8_t height = 1;
+        while (height < MaxHeight && (rand.Next() % Branch) == 0) {
+            height++;
+        }
+        return height;
+    }
+
+    // Find the last node before key and its next node on the level from start
+    void FindSpliceForLevel(const K& key, Node<K, V>* start, uint8_t level, Node<K, V>** pre,
+                            Node<K, V>** next) {
+        Node<K, V>* node = start;
+        Node<K, V>* cur = node->GetNext(level);
+        while (IsAfterNode(key, cur)) {
+            node = cur;
+            cur = node->GetNext(level);
+        }
+        *pre = node;
+        *next = cur;
+    }
+
+    bool IsEqualNode(const K& key, const Node<K, V>* node) const {
+        return (node != NULL) && (compare_(key, node->GetKey()) == 0);
     }
 
     uint8_t RandomHeight() {
@@ -465,9 +646,11 @@ class Skiplist {
     std::atomic<uint8_t> max_height_;
     Comparator const compare_;
     Random rand_;
+    SlabAllocator* const allocator_;
     Node<K, V>* head_;
     std::atomic<Node<K, V>*> tail_;
     friend Iterator;
+    friend Appender;
 };
 
 }  // namespace base
@@ -0,0 +1,285 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "base/random.h"
+#include "base/skiplist.h"
+#include "benchmark/benchmark.h"
+
+namespace openmldb {
+namespace base {
+
+struct BmComparator {
+    int operator()(const uint64_t a, const uint64_t b) const {
+        if (a > b) {
+            return 1;
+        } else if (a == b) {
+            return 0;
+        }
+        return -1;
+    }
+};
+
+// The layout before the next pointers are inline, they are in a separate heap array
+class LegacyNode {
+ public:
+    LegacyNode(uint64_t key, uint64_t value, uint8_t height) : height_(height), key_(key), value_(value) {
+        nexts_ = new std::atomic<LegacyNode*>[height];
+        for (uint8_t i = 0; i < height; i++) {
+            nexts_[i].store(NULL, std::memory_order_relaxed);
+        }
+    }
+    ~LegacyNode() { delete[] nexts_; }
+
+    LegacyNode* GetNext(uint8_t level) { return nexts_[level].load(std::memory_order_acquire); }
+    void SetNext(uint8_t level, LegacyNode* node) { nexts_[level].store(node, std::memory_order_release); }
+    uint64_t GetKey() const { return key_; }
+
+ private:
+    uint8_t const height_;
+    uint64_t const key_;
+    uint64_t value_;
+    std::atomic<LegacyNode*>* nexts_;
+};
+
+// The same search and link of Skiplist on the legacy node
+class LegacySkiplist {
+ public:
+    LegacySkiplist(uint8_t max_height, uint8_t branch)
+        : max_height_(max_height), branch_(branch), height_(1), rand_(0xdeadbeef) {
+        head_ = new LegacyNode(0, 0, max_height);
+    }
+    ~LegacySkiplist() {
+        LegacyNode* node = head_;
+        while (node != NULL) {
+            LegacyNode* next = node->GetNext(0);
+            delete node;
+            node = next;
+        }
+    }
+
+    void Insert(uint64_t key, uint64_t value) {
+        uint8_t height = 1;
+        while (height < max_height_ && (rand_.Next() % branch_) == 0) {
+            height++;
+        }
+        LegacyNode* pre[max_height_];
+        LegacyNode* node = head_;
+        for (int level = height_ - 1; level >= 0; level--) {
+            LegacyNode* next = node->GetNext(level);
+            while (next != NULL && cmp_(key, next->GetKey()) > 0) {
+                node = next;
+                next = node->GetNext(level);
+            }
+            pre[level] = node;
+        }
+        for (uint8_t i = height_; i < height; i++) {
+            pre[i] = head_;
+        }
+        height_ = std::max(height_, height);
+        LegacyNode* new_node = new LegacyNode(key, value, height);
+        for (uint8_t i = 0; i < height; i++) {
+            new_node->SetNext(i, pre[i]->GetNext(i));
+            pre[i]->SetNext(i, new_node);
+        }
+    }
+
+    LegacyNode* Seek(uint64_t key) {
+        LegacyNode* node = head_;
+        for (int level = height_ - 1; level >= 0; level--) {
+            LegacyNode* next = node->GetNext(level);
+            while (next != NULL && cmp_(next->GetKey(), key) < 0) {
+                node = next;
+                next = node->GetNext(level);
+            }
+        }
+        return node->GetNext(0);
+    }
+
+    LegacyNode* First() { return head_->GetNext(0); }
+
+ private:
+    uint8_t const max_height_;
+    uint8_t const branch_;
+    uint8_t height_;
+    Random rand_;
+    BmComparator cmp_;
+    LegacyNode* head_;
+};
+
+typedef Skiplist<uint64_t, uint64_t, BmComparator> BmSkiplist;
+
+static std::vector<uint64_t> RandomKeys(uint64_t n) {
+    std::vector<uint64_t> keys;
+    keys.reserve(n);
+    Random rand(301);
+    for (uint64_t i = 0; i < n; i++) {
+        keys.push_back((static_cast<uint64_t>(rand.Next()) << 32) | rand.Next());
+    }
+    return keys;
+}
+
+static void BM_SkiplistPut(benchmark::State& state) {  // NOLINT
+    auto keys = RandomKeys(state.range(0));
+    BmComparator cmp;
+    for (auto _ : state) {
+        std::unique_ptr<BmSkiplist> list(new BmSkiplist(12, 4, cmp));
+        for (uint64_t key : keys) {
+            list->Insert(key, key);
+        }
+        state.PauseTiming();
+        list->Clear();
+        list.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+static void BM_LegacySkiplistPut(benchmark::State& state) {  // NOLINT
+    auto keys = RandomKeys(state.range(0));
+    for (auto _ : state) {
+        std::unique_ptr<LegacySkiplist> list(new LegacySkiplist(12, 4));
+        for (uint64_t key : keys) {
+            list->Insert(key, key);
+        }
+        state.PauseTiming();
+        list.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+static void BM_SkiplistAppendSorted(benchmark::State& state) {  // NOLINT
+    auto keys = RandomKeys(state.range(0));
+    std::sort(keys.begin(), keys.end());
+    BmComparator cmp;
+    for (auto _ : state) {
+        std::unique_ptr<BmSkiplist> list(new BmSkiplist(12, 4, cmp));
+        BmSkiplist::Appender appender(list.get());
+        for (uint64_t key : keys) {
+            appender.Append(key, key);
+        }
+        state.PauseTiming();
+        list->Clear();
+        list.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+static void BM_SkiplistInsertSorted(benchmark::State& state) {  // NOLINT
+    auto keys = RandomKeys(state.range(0));
+    std::sort(keys.begin(), keys.end());
+    BmComparator cmp;
+    for (auto _ : state) {
+        std::unique_ptr<BmSkiplist> list(new BmSkiplist(12, 4, cmp));
+        for (uint64_t key : keys) {
+            list->Insert(key, key);
+        }
+        state.PauseTiming();
+        list->Clear();
+        list.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+static void BM_SkiplistSeek(benchmark::State& state) {  // NOLINT
+    auto keys = RandomKeys(state.range(0));
+    BmComparator cmp;
+    BmSkiplist list(12, 4, cmp);
+    for (uint64_t key : keys) {
+        list.Insert(key, key);
+    }
+    std::unique_ptr<BmSkiplist::Iterator> it(list.NewIterator());
+    uint64_t idx = 0;
+    for (auto _ : state) {
+        it->Seek(keys[idx++ % keys.size()]);
+        benchmark::DoNotOptimize(it->GetValue());
+    }
+    state.SetItemsProcessed(state.iterations());
+    list.Clear();
+}
+
+static void BM_LegacySkiplistSeek(benchmark::State& state) {  // NOLINT
+    auto keys = RandomKeys(state.range(0));
+    LegacySkiplist list(12, 4);
+    for (uint64_t key : keys) {
+        list.Insert(key, key);
+    }
+    uint64_t idx = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(list.Seek(keys[idx++ % keys.size()]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_SkiplistScan(benchmark::State& state) {  // NOLINT
+    auto keys = RandomKeys(state.range(0));
+    BmComparator cmp;
+    BmSkiplist list(12, 4, cmp);
+    for (uint64_t key : keys) {
+        list.Insert(key, key);
+    }
+    std::unique_ptr<BmSkiplist::Iterator> it(list.NewIterator());
+    for (auto _ : state) {
+        uint64_t sum = 0;
+        it->SeekToFirst();
+        while (it->Valid()) {
+            sum += it->GetKey();
+            it->Next();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+    list.Clear();
+}
+
+static void BM_LegacySkiplistScan(benchmark::State& state) {  // NOLINT
+    auto keys = RandomKeys(state.range(0));
+    LegacySkiplist list(12, 4);
+    for (uint64_t key : keys) {
+        list.Insert(key, key);
+    }
+    for (auto _ : state) {
+        uint64_t sum = 0;
+        LegacyNode* node = list.First();
+        while (node != NULL) {
+            sum += node->GetKey();
+            node = node->GetNext(0);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+BENCHMARK(BM_SkiplistPut)->Arg(1000000)->Arg(10000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LegacySkiplistPut)->Arg(1000000)->Arg(10000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SkiplistAppendSorted)->Arg(1000000)->Arg(10000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SkiplistInsertSorted)->Arg(1000000)->Arg(10000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SkiplistSeek)->Arg(1000000)->Arg(10000000);
+BENCHMARK(BM_LegacySkiplistSeek)->Arg(1000000)->Arg(10000000);
+BENCHMARK(BM_SkiplistScan)->Arg(1000000)->Arg(10000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LegacySkiplistScan)->Arg(1000000)->Arg(10000000)->Unit(benchmark::kMillisecond);
+
+}  // namespace base
+}  // namespace openmldb
+
+BENCHMARK_MAIN();
@@ -17,6 +17,7 @@
 #include "base/skiplist.h"
 
 #include <string>
+#include <thread>  // NOLINT
 #include <vector>
 
 #include "base/slice.h"
@@ -77,14 +78,17 @@ struct StrComparator {
 TEST_F(NodeTest, SetNext) {
     uint32_t key = 1;
     uint32_t value = 2;
-    Node<uint32_t, uint32_t> node(key, value, 2);
+    auto* node = NewNode<uint32_t, uint32_t>(NULL, 2, key, value);
     uint32_t key2 = 3;
     uint32_t value2 = 3;
-    Node<uint32_t, uint32_t> node2(key2, value2, 2);
-    node.SetNext(1, &node2);
-    Node<uint32_t, uint32_t>* node_ptr = node.GetNext(1);
+    auto* node2 = NewNode<uint32_t, uint32_t>(NULL, 2, key2, value2);
+    ASSERT_TRUE(node->GetNext(1) == NULL);
+    node->SetNext(1, node2);
+    Node<uint32_t, uint32_t>* node_ptr = node->GetNext(1);
     ASSERT_EQ(3, (signed)node_ptr->GetValue());
     ASSERT_EQ(3, (signed)node_ptr->GetKey());
+    DeleteNode(node, NULL);
+    DeleteNode(node2, NULL);
 }
 
 TEST_F(NodeTest, NodeByteSize) {
@@ -92,6 +96,8 @@ TEST_F(NodeTest, NodeByteSize) {
     ASSERT_EQ(96u, sizeof(node0));
     ASSERT_EQ(32u, sizeof(Node<uint64_t, void*>));
     ASSERT_EQ(40u, sizeof(Node<Slice, void*>));
+    // the next pointers are inline
+    ASSERT_EQ(32u + 11 * 8, (GetNodeSize<uint64_t, void*>(12)));
 }
 
 TEST_F(NodeTest, SliceTest) {
@@ -111,7 +117,7 @@ TEST_F(NodeTest, AddToFirst) {
     Comparator cmp;
     for (auto height : vec) {
         Skiplist<uint32_t, uint32_t, Comparator> sl(height, 4, cmp);
-        ASSERT_EQ(24u, sizeof(sl));
+        ASSERT_EQ(32u, sizeof(sl));
         uint32_t key3 = 2;
         uint32_t value3 = 5;
         sl.Insert(key3, value3);
@@ -663,6 +669,96 @@ TEST_F(SkiplistTest, Duplicate) {
     ASSERT_FALSE(it->Valid());
 }
 
+TEST_F(SkiplistTest, Appender) {
+    DescComparator cmp;
+    for (auto height : vec) {
+        Skiplist<uint32_t, uint32_t, DescComparator> sl(height, 4, cmp);
+        uint32_t key = 100;
+        uint32_t value = 100;
+        sl.Insert(key, value);
+        Skiplist<uint32_t, uint32_t, DescComparator>::Appender appender(&sl);
+        for (uint32_t i = 99; i > 0; i--) {
+            appender.Append(i, i);
+        }
+        // out of order key falls back to insert
+        uint32_t key1 = 50;
+        uint32_t value1 = 1000;
+        appender.Append(key1, value1);
+        uint32_t key2 = 0;
+        uint32_t value2 = 0;
+        appender.Append(key2, value2);
+        ASSERT_EQ(102u, sl.GetSize());
+        ASSERT_EQ(0u, sl.GetLast()->GetKey());
+        Skiplist<uint32_t, uint32_t, DescComparator>::Iterator* it = sl.NewIterator();
+        it->Seek(50);
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(50u, it->GetKey());
+        ASSERT_EQ(1000u, it->GetValue());
+        it->Next();
+        ASSERT_EQ(50u, it->GetKey());
+        ASSERT_EQ(50u, it->GetValue());
+        it->SeekToFirst();
+        uint32_t last = 101;
+        while (it->Valid()) {
+            ASSERT_LE(it->GetKey(), last);
+            last = it->GetKey();
+            it->Next();
+        }
+        delete it;
+        ASSERT_EQ(102u, sl.Clear());
+    }
+}
+
+TEST_F(SkiplistTest, InsertConcurrently) {
+    Comparator cmp;
+    for (auto height : vec) {
+        Skiplist<uint32_t, uint32_t, Comparator> sl(height, 4, cmp);
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t < 4; t++) {
+            threads.emplace_back([&sl, t] {
+                for (uint32_t i = 0; i < 1000; i++) {
+                    uint32_t key = i * 4 + t;
+                    uint32_t value = key;
+                    ASSERT_GT(sl.InsertConcurrently(key, value), 0);
+                    // all the threads insert the same keys
+                    uint32_t dup_key = 10000 + i;
+                    uint32_t dup_value = t;
+                    sl.InsertConcurrently(dup_key, dup_value, true);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        ASSERT_EQ(5000u, sl.GetSize());
+        ASSERT_EQ(10999u, sl.GetLast()->GetKey());
+        Skiplist<uint32_t, uint32_t, Comparator>::Iterator* it = sl.NewIterator();
+        it->SeekToFirst();
+        for (uint32_t i = 0; i < 4000; i++) {
+            ASSERT_TRUE(it->Valid());
+            ASSERT_EQ(i, it->GetKey());
+            ASSERT_EQ(i, it->GetValue());
+            it->Next();
+        }
+        for (uint32_t i = 0; i < 1000; i++) {
+            ASSERT_TRUE(it->Valid());
+            ASSERT_EQ(10000 + i, it->GetKey());
+            ASSERT_LT(it->GetValue(), 4u);
+            it->Next();
+        }
+        ASSERT_FALSE(it->Valid());
+        it->Seek(2001);
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(2001u, it->GetKey());
+        delete it;
+        uint32_t key = 10001;
+        uint32_t value = 100;
+        ASSERT_EQ(0, sl.InsertConcurrently(key, value, true));
+        ASSERT_LT(value, 4u);
+        ASSERT_EQ(5000u, sl.Clear());
+    }
+}
+
 }  // namespace base
 }  // namespace openmldb
 
@@ -0,0 +1,163 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_BASE_SLAB_ALLOCATOR_H_
+#define SRC_BASE_SLAB_ALLOCATOR_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "base/spinlock.h"
+
+namespace openmldb {
+namespace base {
+
+// Size class allocator for small objects. Chunks are carved from big slabs and
+// the freed chunks are kept in the free list of their size class, so memory
+// released by gc is reused by the following puts without going back to malloc.
+// Slabs are returned to the system only when the allocator is destroyed.
+// Objects bigger than kMaxSlabObjectSize are allocated by malloc directly.
+class SlabAllocator {
+ public:
+    static constexpr uint32_t kSlabAlign = 8;
+    static constexpr uint32_t kMaxSlabObjectSize = 4096;
+    static constexpr uint32_t kDefaultSlabSize = 256 * 1024;
+
+    explicit SlabAllocator(uint32_t slab_size = kDefaultSlabSize)
+        : slab_size_(slab_size < kMaxSlabObjectSize ? kMaxSlabObjectSize : AlignSize(slab_size)),
+          cur_(nullptr),
+          left_(0),
+          free_lists_(kMaxSlabObjectSize / kSlabAlign + 1, nullptr),
+          slabs_(),
+          mu_(),
+          slab_byte_size_(0),
+          used_byte_size_(0),
+          large_byte_size_(0) {}
+
+    ~SlabAllocator() {
+        for (char* slab : slabs_) {
+            free(slab);
+        }
+        slabs_.clear();
+    }
+
+    char* Allocate(uint32_t size) {
+        uint32_t real_size = AlignSize(size);
+        if (real_size > kMaxSlabObjectSize) {
+            large_byte_size_.fetch_add(real_size, std::memory_order_relaxed);
+            return reinterpret_cast<char*>(malloc(real_size));
+        }
+        char* ptr = nullptr;
+        {
+            std::lock_guard<SpinMutex> lock(mu_);
+            FreeChunk* chunk = free_lists_[real_size / kSlabAlign];
+            if (chunk != nullptr) {
+                free_lists_[real_size / kSlabAlign] = chunk->next;
+                ptr = reinterpret_cast<char*>(chunk);
+            } else {
+                if (left_ < real_size) {
+                    NewSlab();
+                }
+                ptr = cur_;
+                cur_ += real_size;
+                left_ -= real_size;
+            }
+        }
+        used_byte_size_.fetch_add(real_size, std::memory_order_relaxed);
+        return ptr;
+    }
+
+    // size must be the same as the one used in Allocate
+    void Free(void* ptr, uint32_t size) {
+        if (ptr == nullptr) {
+            return;
+        }
+        uint32_t real_size = AlignSize(size);
+        if (real_size > kMaxSlabObjectSize) {
+            large_byte_size_.fetch_sub(real_size, std::memory_order_relaxed);
+            free(ptr);
+            return;
+        }
+        {
+            std::lock_guard<SpinMutex> lock(mu_);
+            PushFreeChunk(reinterpret_cast<char*>(ptr), real_size);
+        }
+        used_byte_size_.fetch_sub(real_size, std::memory_order_relaxed);
+    }
+
+    // the memory hold by this allocator, including the unused part of slabs
+    uint64_t GetByteSize() const {
+        return slab_byte_size_.load(std::memory_order_relaxed) + large_byte_size_.load(std::memory_order_relaxed);
+    }
+
+    // the memory of chunks in use
+    uint64_t GetUsedByteSize() const {
+        return used_byte_size_.load(std::memory_order_relaxed) + large_byte_size_.load(std::memory_order_relaxed);
+    }
+
+    uint64_t GetSlabCnt() const { return slab_byte_size_.load(std::memory_order_relaxed) / slab_size_; }
+
+    static inline uint32_t AlignSize(uint32_t size) {
+        uint32_t real_size = (size + kSlabAlign - 1) & ~(kSlabAlign - 1);
+        return real_size < kSlabAlign ? kSlabAlign : real_size;
+    }
+
+ private:
+    struct FreeChunk {
+        FreeChunk* next;
+    };
+
+    void PushFreeChunk(char* ptr, uint32_t real_size) {
+        FreeChunk* chunk = reinterpret_cast<FreeChunk*>(ptr);
+        chunk->next = free_lists_[real_size / kSlabAlign];
+        free_lists_[real_size / kSlabAlign] = chunk;
+    }
+
+    // need hold mu_
+    void NewSlab() {
+        // keep the tail of current slab for the smaller objects
+        if (left_ >= kSlabAlign) {
+            PushFreeChunk(cur_, left_ & ~(kSlabAlign - 1));
+        }
+        cur_ = reinterpret_cast<char*>(malloc(slab_size_));
+        left_ = slab_size_;
+        slabs_.push_back(cur_);
+        slab_byte_size_.fetch_add(slab_size_, std::memory_order_relaxed);
+    }
+
+    SlabAllocator(const SlabAllocator&) = delete;
+    SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+ private:
+    const uint32_t slab_size_;
+    char* cur_;
+    uint32_t left_;
+    std::vector<FreeChunk*> free_lists_;
+    std::vector<char*> slabs_;
+    SpinMutex mu_;
+    std::atomic<uint64_t> slab_byte_size_;
+    std::atomic<uint64_t> used_byte_size_;
+    std::atomic<uint64_t> large_byte_size_;
+};
+
+}  // namespace base
+}  // namespace openmldb
+
+#endif  // SRC_BASE_SLAB_ALLOCATOR_H_
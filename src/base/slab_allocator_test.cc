@@ -0,0 +1,147 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/slab_allocator.h"
+
+#include <string.h>
+
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "base/skiplist.h"
+#include "gtest/gtest.h"
+
+namespace openmldb {
+namespace base {
+
+class SlabAllocatorTest : public ::testing::Test {
+ public:
+    SlabAllocatorTest() {}
+    ~SlabAllocatorTest() {}
+};
+
+TEST_F(SlabAllocatorTest, AlignSize) {
+    ASSERT_EQ(8u, SlabAllocator::AlignSize(0));
+    ASSERT_EQ(8u, SlabAllocator::AlignSize(1));
+    ASSERT_EQ(8u, SlabAllocator::AlignSize(8));
+    ASSERT_EQ(16u, SlabAllocator::AlignSize(9));
+    ASSERT_EQ(4096u, SlabAllocator::AlignSize(4095));
+}
+
+TEST_F(SlabAllocatorTest, AllocateAndFree) {
+    SlabAllocator allocator(4096);
+    std::vector<char*> chunks;
+    for (int i = 0; i < 1000; i++) {
+        char* ptr = allocator.Allocate(20);
+        memset(ptr, i % 128, 20);
+        chunks.push_back(ptr);
+    }
+    ASSERT_EQ(24u * 1000, allocator.GetUsedByteSize());
+    uint64_t byte_size = allocator.GetByteSize();
+    ASSERT_GE(byte_size, 24u * 1000);
+    for (int i = 0; i < 1000; i++) {
+        ASSERT_EQ(i % 128, chunks[i][19]);
+        allocator.Free(chunks[i], 20);
+    }
+    ASSERT_EQ(0u, allocator.GetUsedByteSize());
+    // reuse the freed chunks
+    for (int i = 0; i < 1000; i++) {
+        chunks[i] = allocator.Allocate(17);
+    }
+    ASSERT_EQ(byte_size, allocator.GetByteSize());
+    for (int i = 0; i < 1000; i++) {
+        allocator.Free(chunks[i], 17);
+    }
+}
+
+TEST_F(SlabAllocatorTest, LargeObject) {
+    SlabAllocator allocator;
+    char* ptr = allocator.Allocate(10000);
+    memset(ptr, 1, 10000);
+    ASSERT_EQ(10000u, allocator.GetUsedByteSize());
+    ASSERT_EQ(0u, allocator.GetSlabCnt());
+    allocator.Free(ptr, 10000);
+    ASSERT_EQ(0u, allocator.GetUsedByteSize());
+}
+
+TEST_F(SlabAllocatorTest, MultiThread) {
+    SlabAllocator allocator;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&allocator, t] {
+            std::vector<char*> chunks;
+            for (int i = 0; i < 10000; i++) {
+                uint32_t size = 8 + (i + t) % 100;
+                char* ptr = allocator.Allocate(size);
+                memset(ptr, t, size);
+                chunks.push_back(ptr);
+            }
+            for (int i = 0; i < 10000; i++) {
+                allocator.Free(chunks[i], 8 + (i + t) % 100);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(0u, allocator.GetUsedByteSize());
+}
+
+struct Comparator {
+    int operator()(const uint32_t a, const uint32_t b) const {
+        if (a > b) {
+            return 1;
+        } else if (a == b) {
+            return 0;
+        }
+        return -1;
+    }
+};
+
+TEST_F(SlabAllocatorTest, Skiplist) {
+    SlabAllocator allocator;
+    Comparator cmp;
+    {
+        Skiplist<uint32_t, uint32_t, Comparator> sl(12, 4, cmp, &allocator);
+        for (uint32_t i = 0; i < 1000; i++) {
+            sl.Insert(i, i);
+        }
+        ASSERT_GT(allocator.GetUsedByteSize(), 1000 * sizeof(Node<uint32_t, uint32_t>));
+        Skiplist<uint32_t, uint32_t, Comparator>::Iterator* it = sl.NewIterator();
+        it->Seek(500);
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(500u, it->GetValue());
+        delete it;
+        // keep the keys less than 499
+        Node<uint32_t, uint32_t>* node = sl.Split(499);
+        while (node != NULL) {
+            Node<uint32_t, uint32_t>* tmp = node;
+            node = node->GetNextNoBarrier(0);
+            DeleteNode(tmp, &allocator);
+        }
+        ASSERT_EQ(499u, sl.GetSize());
+        sl.Clear();
+    }
+    ASSERT_EQ(0u, allocator.GetUsedByteSize());
+}
+
+}  // namespace base
+}  // namespace openmldb
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -30,6 +30,7 @@
 
 #pragma once
 #include <atomic>
+#include <cstdint>
 #include <thread>  // NOLINT
 
 namespace openmldb {
@@ -75,5 +76,60 @@ class SpinMutex {
     std::atomic<bool> locked_;
 };
 
+// SharedSpinMutex prefers the writers: a reader does not take the lock while a
+// writer holds or waits for it, so the writers are not starved by the readers
+// coming continuously. it is used with std::shared_lock and std::unique_lock.
+class SharedSpinMutex {
+ public:
+    SharedSpinMutex() : state_(0), writers_(0) {}
+
+    bool try_lock_shared() {
+        if (writers_.load(std::memory_order_relaxed) > 0) {
+            return false;
+        }
+        auto state = state_.load(std::memory_order_relaxed);
+        return state != kWriteLocked &&
+               state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void lock_shared() { Spin([this]() { return try_lock_shared(); }); }
+
+    void unlock_shared() { state_.fetch_sub(1, std::memory_order_release); }
+
+    bool try_lock() {
+        uint32_t state = 0;
+        return state_.compare_exchange_strong(state, kWriteLocked, std::memory_order_acquire,
+                                              std::memory_order_relaxed);
+    }
+
+    void lock() {
+        writers_.fetch_add(1, std::memory_order_relaxed);
+        Spin([this]() { return try_lock(); });
+        writers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void unlock() { state_.store(0, std::memory_order_release); }
+
+ private:
+    template <class F>
+    static void Spin(F try_lock) {
+        for (size_t tries = 0;; ++tries) {
+            if (try_lock()) {
+                break;
+            }
+            AsmVolatilePause();
+            if (tries > 100) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    static constexpr uint32_t kWriteLocked = UINT32_MAX;
+    // the count of the readers holding the lock, or kWriteLocked
+    std::atomic<uint32_t> state_;
+    // the count of the writers waiting for the lock
+    std::atomic<uint32_t> writers_;
+};
+
 }  // namespace base
 }  // namespace openmldb
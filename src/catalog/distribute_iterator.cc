@@ -15,15 +15,77 @@
  */
 
 #include "catalog/distribute_iterator.h"
+
+#include <algorithm>
+
 #include "gflags/gflags.h"
 
 DECLARE_uint32(traverse_cnt_limit);
+DECLARE_bool(enable_stream_scan);
+DECLARE_bool(enable_remote_prefetch);
+DECLARE_uint32(remote_fetch_max_cnt_limit);
+DECLARE_int32(request_timeout_ms);
 
 namespace openmldb {
 namespace catalog {
 
 constexpr uint32_t INVALID_PID = UINT32_MAX;
 
+// the limit of the page following a page of `limit` rows
+static uint32_t GrowPageLimit(uint32_t limit) {
+    uint32_t max_limit = std::max(FLAGS_remote_fetch_max_cnt_limit, FLAGS_traverse_cnt_limit);
+    return limit >= max_limit / 2 ? max_limit : limit * 2;
+}
+
+// a broken stream ends as if it was finished, the rest rows are read by the paged Scan or Traverse
+static bool IsStreamFailed(const std::shared_ptr<::openmldb::base::KvIterator>& it) {
+    auto stream_it = std::dynamic_pointer_cast<::openmldb::client::StreamKvIterator>(it);
+    return stream_it && stream_it->Failed();
+}
+
+static bool StartScan(const std::shared_ptr<openmldb::client::TabletClient>& client, uint32_t tid, uint32_t pid,
+        const std::string& pk, const std::string& idx_name, uint64_t st, uint32_t skip_record_num, uint32_t limit,
+        RemotePage<::openmldb::api::ScanResponse>* page) {
+    ::openmldb::api::ScanRequest request;
+    request.set_pk(pk);
+    request.set_st(st);
+    request.set_et(0);
+    request.set_tid(tid);
+    request.set_pid(pid);
+    if (!idx_name.empty()) {
+        request.set_idx_name(idx_name);
+    }
+    request.set_limit(limit);
+    request.set_skip_record_num(skip_record_num);
+    if (!client->AsyncScan(request, page->Start(FLAGS_request_timeout_ms))) {
+        page->Abort();
+        return false;
+    }
+    return true;
+}
+
+static bool StartTraverse(const std::shared_ptr<openmldb::client::TabletClient>& client, uint32_t tid, uint32_t pid,
+        const std::string& idx_name, const std::string& pk, uint64_t ts, uint32_t limit, bool skip_current_pk,
+        RemotePage<::openmldb::api::TraverseResponse>* page) {
+    ::openmldb::api::TraverseRequest request;
+    request.set_tid(tid);
+    request.set_pid(pid);
+    request.set_limit(limit);
+    if (!idx_name.empty()) {
+        request.set_idx_name(idx_name);
+    }
+    if (!pk.empty()) {
+        request.set_pk(pk);
+        request.set_ts(ts);
+    }
+    request.set_skip_current_pk(skip_current_pk);
+    if (!client->AsyncTraverse(request, page->Start(FLAGS_request_timeout_ms))) {
+        page->Abort();
+        return false;
+    }
+    return true;
+}
+
 FullTableIterator::FullTableIterator(uint32_t tid, std::shared_ptr<Tables> tables,
         const std::map<uint32_t, std::shared_ptr<::openmldb::client::TabletClient>>& tablet_clients)
     : tid_(tid), tables_(tables), tablet_clients_(tablet_clients), in_local_(true), cur_pid_(INVALID_PID),
@@ -127,9 +189,22 @@ bool FullTableIterator::NextFromRemote() {
         cur_pid_ = iter->first;
         uint32_t count = 0;
         if (kv_it_) {
-            if (!kv_it_->IsFinish()) {
-                kv_it_ = iter->second->Traverse(tid_, cur_pid_, "", last_pk_, last_ts_,
-                            FLAGS_traverse_cnt_limit, false, count);
+            if (!kv_it_->IsFinish() || IsStreamFailed(kv_it_)) {
+                auto stream_it = std::dynamic_pointer_cast<::openmldb::client::StreamKvIterator>(kv_it_);
+                if (stream_it) {
+                    last_pk_ = stream_it->GetLastPK();
+                    last_ts_ = stream_it->GetLastTS();
+                }
+                if (stream_it && !stream_it->Failed()) {
+                    kv_it_ = iter->second->TraverseStream(tid_, cur_pid_, "", last_pk_, last_ts_,
+                                                          FLAGS_remote_fetch_max_cnt_limit, false);
+                } else {
+                    kv_it_.reset();
+                }
+                if (!kv_it_) {
+                    kv_it_ = iter->second->Traverse(tid_, cur_pid_, "", last_pk_, last_ts_,
+                                FLAGS_traverse_cnt_limit, false, count);
+                }
                 DLOG(INFO) << "pid " << cur_pid_ << " last pk " << last_pk_ <<
                     " key " << last_ts_ << " count " << count;
             } else {
@@ -138,13 +213,27 @@ bool FullTableIterator::NextFromRemote() {
                 continue;
             }
         } else {
-            kv_it_ = iter->second->Traverse(tid_, cur_pid_, "", "", 0, FLAGS_traverse_cnt_limit, false, count);
-            DLOG(INFO) << "count " << count;
+            if (FLAGS_enable_stream_scan) {
+                // one stream pushes the rows of a big page in chunks instead of one response
+                kv_it_ = iter->second->TraverseStream(tid_, cur_pid_, "", "", 0, FLAGS_remote_fetch_max_cnt_limit,
+                                                      false);
+            }
+            if (!kv_it_) {
+                kv_it_ = iter->second->Traverse(tid_, cur_pid_, "", "", 0, FLAGS_traverse_cnt_limit, false, count);
+                DLOG(INFO) << "count " << count;
+            }
+        }
+        if (kv_it_ && !kv_it_->Valid() && IsStreamFailed(kv_it_)) {
+            // the stream is broken before its first row, so the traverse continues from where the stream started
+            continue;
         }
         if (kv_it_ && kv_it_->Valid()) {
-            last_pk_ = kv_it_->GetLastPK();
-            last_ts_ = kv_it_->GetLastTS();
-            response_vec_.emplace_back(kv_it_->GetResponse());
+            auto traverse_it = std::dynamic_pointer_cast<::openmldb::base::TraverseKvIterator>(kv_it_);
+            if (traverse_it) {
+                last_pk_ = traverse_it->GetLastPK();
+                last_ts_ = traverse_it->GetLastTS();
+                response_vec_.emplace_back(traverse_it->GetResponse());
+            }
             key_ = kv_it_->GetKey();
             break;
         }
@@ -162,9 +251,8 @@ const ::hybridse::codec::Row& FullTableIterator::GetValue() {
     } else {
         auto slice_row = kv_it_->GetValue();
         size_t sz = slice_row.size();
-        int8_t* copyed_row_data = new int8_t[sz];
-        memcpy(copyed_row_data, slice_row.data(), sz);
-        auto shared_slice = ::hybridse::base::RefCountedSlice::CreateManaged(copyed_row_data, sz);
+        auto shared_slice = ::hybridse::base::RefCountedSlice::Allocate(sz);
+        memcpy(shared_slice.buf(), slice_row.data(), sz);
         value_.Reset(shared_slice);
         return value_;
     }
@@ -175,12 +263,16 @@ DistributeWindowIterator::DistributeWindowIterator(uint32_t tid, uint32_t pid_nu
         const std::map<uint32_t, std::shared_ptr<::openmldb::client::TabletClient>>& tablet_clients)
     : tid_(tid), pid_num_(pid_num), tables_(tables), tablet_clients_(tablet_clients),
     index_(index), index_name_(index_name),
-    cur_pid_(0), it_(), kv_it_() {}
+    cur_pid_(0), it_(), kv_it_(), first_pages_(), next_page_(), next_page_pk_(), next_page_ts_(0),
+    page_limit_(FLAGS_traverse_cnt_limit) {}
 
 void DistributeWindowIterator::Reset() {
     it_.reset();
     kv_it_.reset();
     cur_pid_ = INVALID_PID;
+    first_pages_.clear();
+    next_page_.Cancel();
+    page_limit_ = FLAGS_traverse_cnt_limit;
 }
 
 // seek to the pos where key = `key` on success
@@ -205,10 +297,63 @@ void DistributeWindowIterator::Seek(const std::string& key) {
     cur_pid_ = stat.pid;
 }
 
-DistributeWindowIterator::ItStat DistributeWindowIterator::SeekToFirstRemote() const {
+DistributeWindowIterator::KV_IT DistributeWindowIterator::FirstPage(uint32_t pid,
+        const std::shared_ptr<openmldb::client::TabletClient>& client) {
+    page_limit_ = FLAGS_traverse_cnt_limit;
+    auto iter = first_pages_.find(pid);
+    if (iter != first_pages_.end()) {
+        auto response = iter->second->Wait();
+        first_pages_.erase(iter);
+        if (response) {
+            return std::make_shared<openmldb::base::TraverseKvIterator>(response);
+        }
+    }
+    uint32_t count = 0;
+    auto it = client->Traverse(tid_, pid, index_name_, "", 0, FLAGS_traverse_cnt_limit, false, count);
+    DLOG(INFO) << "pid " << pid << " count " << count;
+    return it;
+}
+
+DistributeWindowIterator::KV_IT DistributeWindowIterator::NextPage(
+        const std::shared_ptr<openmldb::client::TabletClient>& client, const std::string& pk, uint64_t ts) {
+    if (next_page_.InFlight()) {
+        if (next_page_pk_ == pk && next_page_ts_ == ts) {
+            auto response = next_page_.Wait();
+            if (response) {
+                DLOG(INFO) << "pid " << cur_pid_ << " last pk " << pk << " key " << ts << " prefetched";
+                return std::make_shared<openmldb::base::TraverseKvIterator>(response);
+            }
+        } else {
+            next_page_.Cancel();
+        }
+    }
+    uint32_t count = 0;
+    auto it = client->Traverse(tid_, cur_pid_, index_name_, pk, ts, page_limit_, true, count);
+    DLOG(INFO) << "pid " << cur_pid_ << " last pk " << pk << " key " << ts << " count " << count;
+    return it;
+}
+
+void DistributeWindowIterator::PrefetchNextPage() {
+    auto traverse_it = std::dynamic_pointer_cast<openmldb::base::TraverseKvIterator>(kv_it_);
+    if (!FLAGS_enable_remote_prefetch || !traverse_it || traverse_it->IsFinish()) {
+        return;
+    }
+    auto iter = tablet_clients_.find(cur_pid_);
+    if (iter == tablet_clients_.end()) {
+        return;
+    }
+    // the keys of a partition are iterated to the end usually, so the next page is fetched as soon as
+    // the current one arrives
+    page_limit_ = GrowPageLimit(page_limit_);
+    next_page_pk_ = traverse_it->GetLastPK();
+    next_page_ts_ = traverse_it->GetLastTS();
+    StartTraverse(iter->second, tid_, cur_pid_, index_name_, next_page_pk_, next_page_ts_, page_limit_, true,
+                  &next_page_);
+}
+
+DistributeWindowIterator::ItStat DistributeWindowIterator::SeekToFirstRemote() {
     for (const auto& kv : tablet_clients_) {
-        uint32_t count = 0;
-        auto it = kv.second->Traverse(tid_, kv.first, index_name_, "", 0, FLAGS_traverse_cnt_limit, false, count);
+        auto it = FirstPage(kv.first, kv.second);
         if (it && it->Valid()) {
             DLOG(INFO) << "first pos in remote: pid=" << kv.first;
             return {kv.first, nullptr, it};
@@ -223,6 +368,16 @@ void DistributeWindowIterator::SeekToFirst() {
     if (!tables_) {
         return;
     }
+    if (FLAGS_enable_remote_prefetch) {
+        // the first pages of all the remote partitions are fetched in parallel while the local ones are iterated
+        for (const auto& kv : tablet_clients_) {
+            auto page = std::make_unique<RemotePage<::openmldb::api::TraverseResponse>>();
+            if (StartTraverse(kv.second, tid_, kv.first, index_name_, "", 0, FLAGS_traverse_cnt_limit, false,
+                              page.get())) {
+                first_pages_.emplace(kv.first, std::move(page));
+            }
+        }
+    }
     for (const auto& kv : *tables_) {
         auto it = kv.second->NewWindowIterator(index_);
         if (it != nullptr) {
@@ -241,6 +396,7 @@ void DistributeWindowIterator::SeekToFirst() {
         response_vec_.push_back(stat.kv_it->GetResponse());
         kv_it_ = stat.kv_it;
         cur_pid_ = stat.pid;
+        PrefetchNextPage();
         return;
     }
     DLOG(INFO) << "empty window iterator";
@@ -313,24 +469,23 @@ void DistributeWindowIterator::Next() {
         if (iter == tablet_clients_.end()) {
             return;
         }
-        uint32_t count = 0;
-        kv_it_ = iter->second->Traverse(tid_, cur_pid_, "", cur_pk, last_ts, FLAGS_traverse_cnt_limit, true, count);
-        DLOG(INFO) << "pid " << cur_pid_ << " last pk " << cur_pk << " key " << last_ts << " count " << count;
+        kv_it_ = NextPage(iter->second, cur_pk, last_ts);
         if (kv_it_ && kv_it_->Valid()) {
             response_vec_.emplace_back(kv_it_->GetResponse());
+            PrefetchNextPage();
             return;
         }
+        next_page_.Cancel();
         do {
             iter++;
             if (iter == tablet_clients_.end()) {
                 return;
             }
             cur_pid_ = iter->first;
-            uint32_t count = 0;
-            kv_it_ = iter->second->Traverse(tid_, cur_pid_, "", "", 0, FLAGS_traverse_cnt_limit, false, count);
-            DLOG(INFO) << "count " << count;
+            kv_it_ = FirstPage(cur_pid_, iter->second);
             if (kv_it_ && kv_it_->Valid()) {
                 response_vec_.emplace_back(kv_it_->GetResponse());
+                PrefetchNextPage();
                 break;
             }
             kv_it_.reset();
@@ -341,6 +496,7 @@ void DistributeWindowIterator::Next() {
             response_vec_.push_back(stat.kv_it->GetResponse());
             kv_it_ = stat.kv_it;
             cur_pid_ = stat.pid;
+            PrefetchNextPage();
             return;
         }
     }
@@ -384,9 +540,8 @@ const ::hybridse::codec::Row& RemoteWindowIterator::GetValue() {
     size_t sz = slice_row.size();
     // for distributed environment, slice_row's data probably become invalid when the DistributeWindowIterator
     // iterator goes out of scope. so copy action occured here
-    int8_t* copyed_row_data = new int8_t[sz];
-    memcpy(copyed_row_data, slice_row.data(), sz);
-    auto shared_slice = ::hybridse::base::RefCountedSlice::CreateManaged(copyed_row_data, sz);
+    auto shared_slice = ::hybridse::base::RefCountedSlice::Allocate(sz);
+    memcpy(shared_slice.buf(), slice_row.data(), sz);
     row_.Reset(shared_slice);
     DLOG(INFO) << "get value  pk " << pk_ << " ts_key " << kv_it_->GetKey() << " ts " << ts_;
     return row_;
@@ -396,7 +551,8 @@ RemoteWindowIterator::RemoteWindowIterator(uint32_t tid, uint32_t pid, const std
         const std::shared_ptr<::openmldb::base::KvIterator>& kv_it,
         const std::shared_ptr<openmldb::client::TabletClient>& client)
     : tid_(tid), pid_(pid), index_name_(index_name), kv_it_(kv_it), tablet_client_(client),
-        is_traverse_data_(false), ts_(0), ts_cnt_(0) {
+        is_traverse_data_(false), ts_(0), ts_cnt_(0), page_rows_(0), page_pos_(0), prefetch_checked_(false),
+        page_limit_(FLAGS_traverse_cnt_limit), next_page_(), next_page_st_(0), next_page_skip_(0) {
     if (kv_it_ && kv_it_->Valid()) {
         pk_ = kv_it_->GetPK();
         ts_ = kv_it_->GetKey();
@@ -406,6 +562,7 @@ RemoteWindowIterator::RemoteWindowIterator(uint32_t tid, uint32_t pid, const std
         if (traverse_it) {
             is_traverse_data_ = true;
         }
+        ResetPage();
     }
 }
 
@@ -429,13 +586,115 @@ void RemoteWindowIterator::SetTs() {
     }
 }
 
+void RemoteWindowIterator::ResetPage() {
+    page_rows_ = 0;
+    page_pos_ = 0;
+    prefetch_checked_ = false;
+    if (!kv_it_) {
+        return;
+    }
+    auto response = kv_it_->GetResponse();
+    if (auto scan_response = std::dynamic_pointer_cast<::openmldb::api::ScanResponse>(response)) {
+        page_rows_ = scan_response->count();
+    } else if (auto traverse_response = std::dynamic_pointer_cast<::openmldb::api::TraverseResponse>(response)) {
+        page_rows_ = traverse_response->count();
+    }
+}
+
+void RemoteWindowIterator::MaybePrefetch() {
+    if (!FLAGS_enable_remote_prefetch || prefetch_checked_ || next_page_.InFlight() || !kv_it_ ||
+        kv_it_->IsFinish() || !kv_it_->Valid() || page_pos_ * 2 < page_rows_) {
+        return;
+    }
+    prefetch_checked_ = true;
+    // replay the rest of the page to get the position where the next page starts, see Next
+    std::shared_ptr<::openmldb::base::KvIterator> it;
+    if (is_traverse_data_) {
+        auto response = std::dynamic_pointer_cast<::openmldb::api::TraverseResponse>(kv_it_->GetResponse());
+        if (!response) {
+            return;
+        }
+        auto traverse_it = std::make_shared<::openmldb::base::TraverseKvIterator>(response);
+        traverse_it->Seek(pk_);
+        it = traverse_it;
+    } else {
+        auto response = std::dynamic_pointer_cast<::openmldb::api::ScanResponse>(kv_it_->GetResponse());
+        if (!response) {
+            return;
+        }
+        it = std::make_shared<::openmldb::base::ScanKvIterator>(pk_, response);
+    }
+    for (uint32_t i = 0; i < page_pos_ && it->Valid(); i++) {
+        it->Next();
+    }
+    uint64_t ts = ts_;
+    uint32_t ts_cnt = ts_cnt_;
+    for (it->Next(); it->Valid(); it->Next()) {
+        if (is_traverse_data_ && it->GetPK() != pk_) {
+            // the window ends in this page
+            return;
+        }
+        if (it->GetKey() == ts) {
+            ts_cnt++;
+        } else {
+            ts = it->GetKey();
+            ts_cnt = 1;
+        }
+    }
+    page_limit_ = GrowPageLimit(page_limit_);
+    if (StartScan(tablet_client_, tid_, pid_, pk_, index_name_, ts, ts_cnt, page_limit_, &next_page_)) {
+        next_page_st_ = ts;
+        next_page_skip_ = ts_cnt;
+        DLOG(INFO) << "prefetch key " << pk_ << " ts " << ts << " ts_cnt " << ts_cnt << " limit " << page_limit_;
+    }
+}
+
 void RemoteWindowIterator::ScanRemote(uint64_t key, uint32_t ts_cnt) {
     std::string msg;
+    // the window continues by the paged scan after a broken stream
+    bool use_stream = FLAGS_enable_stream_scan && !IsStreamFailed(kv_it_);
+    if (next_page_.InFlight()) {
+        if (next_page_st_ == key && next_page_skip_ == ts_cnt) {
+            auto response = next_page_.Wait();
+            if (response) {
+                kv_it_ = std::make_shared<::openmldb::base::ScanKvIterator>(pk_, response);
+                is_traverse_data_ = false;
+                DLOG(INFO) << "scan key " << pk_ << " ts " << key << " by prefetch. tid " << tid_ << " pid " << pid_
+                           << " ts_cnt " << ts_cnt;
+                response_vec_.emplace_back(response);
+                ResetPage();
+                if (kv_it_->Valid()) {
+                    SetTs();
+                }
+                return;
+            }
+        } else {
+            next_page_.Cancel();
+        }
+    }
+    if (use_stream) {
+        // the stream is bounded by the growing page limit, so a long window holds a tablet thread
+        // for one page at a time and the rows are not pushed beyond what the window reads
+        page_limit_ = GrowPageLimit(page_limit_);
+        kv_it_ = tablet_client_->ScanStream(tid_, pid_, pk_, index_name_, key, 0, page_limit_, ts_cnt, msg);
+        if (kv_it_ && (kv_it_->Valid() || !IsStreamFailed(kv_it_))) {
+            is_traverse_data_ = false;
+            DLOG(INFO) << "scan key " << pk_ << " ts " << key << " by stream. tid " << tid_ << " pid " << pid_
+                       << " ts_cnt " << ts_cnt;
+            ResetPage();
+            if (kv_it_->Valid()) {
+                SetTs();
+            }
+            return;
+        }
+    }
     kv_it_ = tablet_client_->Scan(tid_, pid_, pk_, index_name_, key, 0,
-                FLAGS_traverse_cnt_limit, ts_cnt, msg);
+                page_limit_, ts_cnt, msg);
     DLOG(INFO) << "scan key " << pk_ << " ts " << key << " from remote. tid "
         << tid_ << " pid " << pid_ << " ts_cnt " << ts_cnt;
+    ResetPage();
     if (kv_it_ && kv_it_->Valid()) {
+        is_traverse_data_ = false;
         response_vec_.emplace_back(kv_it_->GetResponse());
         SetTs();
     }
@@ -451,13 +710,15 @@ void RemoteWindowIterator::Seek(const uint64_t& key) {
             break;
         }
         kv_it_->Next();
+        page_pos_++;
     }
     if (kv_it_->Valid()) {
         ts_ = kv_it_->GetKey();
-    } else if (!kv_it_->IsFinish()) {
+    } else if (!kv_it_->IsFinish() || IsStreamFailed(kv_it_)) {
         ScanRemote(key, 0);
     }
     ts_cnt_ = 1;
+    MaybePrefetch();
 }
 
 void RemoteWindowIterator::Next() {
@@ -467,10 +728,12 @@ void RemoteWindowIterator::Next() {
             kv_it_.reset();
             return;
         }
+        page_pos_++;
         SetTs();
-    } else if (!kv_it_->IsFinish()) {
+    } else if (!kv_it_->IsFinish() || IsStreamFailed(kv_it_)) {
         ScanRemote(ts_, ts_cnt_);
     }
+    MaybePrefetch();
 }
 
 }  // namespace catalog
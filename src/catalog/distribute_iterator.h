@@ -25,6 +25,7 @@
 #include "base/hash.h"
 #include "base/kv_iterator.h"
 #include "client/tablet_client.h"
+#include "rpc/rpc_client.h"
 #include "storage/table.h"
 #include "vm/catalog.h"
 
@@ -33,6 +34,65 @@ namespace catalog {
 
 using Tables = std::map<uint32_t, std::shared_ptr<::openmldb::storage::Table>>;
 
+// a page of a remote partition fetched in background, so the rpc is in flight while the current page is consumed
+template <class Response>
+class RemotePage {
+ public:
+    RemotePage() : callback_(nullptr) {}
+    ~RemotePage() { Cancel(); }
+    RemotePage(const RemotePage&) = delete;
+    RemotePage& operator=(const RemotePage&) = delete;
+
+    // create the callback of a new rpc, the page in flight is cancelled
+    ::openmldb::RpcCallback<Response>* Start(int32_t timeout_ms) {
+        Cancel();
+        auto cntl = std::make_shared<brpc::Controller>();
+        cntl->set_timeout_ms(timeout_ms);
+        callback_ = new ::openmldb::RpcCallback<Response>(std::make_shared<Response>(), cntl);
+        // one ref is released when the rpc is done and the other one by the page
+        callback_->Ref();
+        return callback_;
+    }
+
+    // the rpc of the callback is not sent
+    void Abort() {
+        if (callback_ != nullptr) {
+            callback_->Run();
+            callback_->UnRef();
+            callback_ = nullptr;
+        }
+    }
+
+    bool InFlight() const { return callback_ != nullptr; }
+
+    // wait for the page, return null if the rpc fails
+    std::shared_ptr<Response> Wait() {
+        if (callback_ == nullptr) {
+            return {};
+        }
+        brpc::Join(callback_->GetController()->call_id());
+        std::shared_ptr<Response> response;
+        if (!callback_->GetController()->Failed() && callback_->GetResponse()->code() == 0) {
+            response = callback_->GetResponse();
+        }
+        callback_->UnRef();
+        callback_ = nullptr;
+        return response;
+    }
+
+    void Cancel() {
+        if (callback_ != nullptr) {
+            brpc::StartCancel(callback_->GetController()->call_id());
+            brpc::Join(callback_->GetController()->call_id());
+            callback_->UnRef();
+            callback_ = nullptr;
+        }
+    }
+
+ private:
+    ::openmldb::RpcCallback<Response>* callback_;
+};
+
 class FullTableIterator : public ::hybridse::codec::ConstIterator<uint64_t, ::hybridse::codec::Row> {
  public:
     FullTableIterator(uint32_t tid, std::shared_ptr<Tables> tables,
@@ -62,7 +122,8 @@ class FullTableIterator : public ::hybridse::codec::ConstIterator<uint64_t, ::hy
     bool in_local_;
     uint32_t cur_pid_;
     std::unique_ptr<::openmldb::storage::TableIterator> it_;
-    std::shared_ptr<::openmldb::base::TraverseKvIterator> kv_it_;
+    // a page of traverse or a stream of the partition
+    std::shared_ptr<::openmldb::base::KvIterator> kv_it_;
     uint64_t key_;
     uint64_t last_ts_;
     std::string last_pk_;
@@ -96,6 +157,9 @@ class RemoteWindowIterator : public ::hybridse::vm::RowIterator {
  private:
     void SetTs();
     void ScanRemote(uint64_t key, uint32_t ts_cnt);
+    void ResetPage();
+    // fetch the next page in background after half of the current page is consumed
+    void MaybePrefetch();
 
  private:
     uint32_t tid_;
@@ -109,6 +173,15 @@ class RemoteWindowIterator : public ::hybridse::vm::RowIterator {
     std::string pk_;
     mutable uint64_t ts_;
     uint32_t ts_cnt_;
+    // the rows of the current page and the position of `kv_it_` in it
+    uint32_t page_rows_;
+    uint32_t page_pos_;
+    bool prefetch_checked_;
+    // the limit of the next page, it grows as the window goes on
+    uint32_t page_limit_;
+    RemotePage<::openmldb::api::ScanResponse> next_page_;
+    uint64_t next_page_st_;
+    uint32_t next_page_skip_;
 };
 
 class DistributeWindowIterator : public ::hybridse::codec::WindowIterator {
@@ -143,7 +216,15 @@ class DistributeWindowIterator : public ::hybridse::codec::WindowIterator {
 
     ItStat SeekByKey(const std::string& key) const;
 
-    ItStat SeekToFirstRemote() const;
+    ItStat SeekToFirstRemote();
+
+    // the first page of the remote partition, it is fetched in parallel by SeekToFirst if prefetch is enabled
+    KV_IT FirstPage(uint32_t pid, const std::shared_ptr<openmldb::client::TabletClient>& client);
+
+    // the page following `pk` and `ts` of the current remote partition
+    KV_IT NextPage(const std::shared_ptr<openmldb::client::TabletClient>& client, const std::string& pk, uint64_t ts);
+
+    void PrefetchNextPage();
 
  private:
     const uint32_t tid_;
@@ -160,6 +241,13 @@ class DistributeWindowIterator : public ::hybridse::codec::WindowIterator {
     KV_IT kv_it_;
     // underlaying data pointed by `kv_it_`
     std::vector<std::shared_ptr<::google::protobuf::Message>> response_vec_;
+    // the first pages of the remote partitions not reached yet
+    std::map<uint32_t, std::unique_ptr<RemotePage<::openmldb::api::TraverseResponse>>> first_pages_;
+    // the next page of the current remote partition, it starts from `next_page_pk_` and `next_page_ts_`
+    RemotePage<::openmldb::api::TraverseResponse> next_page_;
+    std::string next_page_pk_;
+    uint64_t next_page_ts_;
+    uint32_t page_limit_;
 };
 
 }  // namespace catalog
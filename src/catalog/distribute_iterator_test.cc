@@ -16,11 +16,15 @@
 
 #include "catalog/distribute_iterator.h"
 
+#include <algorithm>
+#include <map>
 #include <string>
 #include <vector>
 #include <utility>
 
+#include "client/stream_kv_iterator.h"
 #include "client/tablet_client.h"
+#include "codec/row_codec.h"
 #include "codec/sdk_codec.h"
 #include "common/timer.h"
 #include "gtest/gtest.h"
@@ -32,6 +36,12 @@
 
 DECLARE_string(db_root_path);
 DECLARE_uint32(traverse_cnt_limit);
+DECLARE_uint32(remote_fetch_max_cnt_limit);
+DECLARE_bool(enable_stream_scan);
+DECLARE_uint32(stream_scan_chunk_size);
+DECLARE_bool(enable_remote_prefetch);
+DECLARE_uint32(stream_scan_window_size);
+DECLARE_int32(stream_scan_idle_timeout_ms);
 
 namespace openmldb {
 namespace catalog {
@@ -504,6 +514,439 @@ TEST_F(DistributeIteratorTest, MoreTsCnt) {
     FLAGS_traverse_cnt_limit = old_limit;
 }
 
+TEST_F(DistributeIteratorTest, ScanStream) {
+    uint32_t old_chunk_size = FLAGS_stream_scan_chunk_size;
+    // a chunk holds a few rows only, so a stream has many chunks
+    FLAGS_stream_scan_chunk_size = 64;
+    uint32_t tid = 3;
+    FLAGS_db_root_path = "/tmp/" + ::openmldb::test::GenRand();
+    std::vector<std::string> endpoints = {"127.0.0.1:9230"};
+    brpc::Server tablet1;
+    ASSERT_TRUE(::openmldb::test::StartTablet(endpoints[0], &tablet1));
+    auto client1 = std::make_shared<openmldb::client::TabletClient>(endpoints[0], endpoints[0]);
+    ASSERT_EQ(client1->Init(), 0);
+    auto meta = CreateTableMeta(tid, 0);
+    ASSERT_TRUE(client1->CreateTable(meta));
+    std::string key = "card0";
+    PutKey(key, meta, client1, 100);
+    std::string msg;
+    auto it = client1->ScanStream(tid, 0, key, "card", 0, 0, 0, 0, msg);
+    ASSERT_TRUE(it);
+    int count = 0;
+    uint64_t last_ts = UINT64_MAX;
+    while (it->Valid()) {
+        ASSERT_EQ(key, it->GetPK());
+        ASSERT_LT(it->GetKey(), last_ts);
+        last_ts = it->GetKey();
+        count++;
+        it->Next();
+    }
+    ASSERT_EQ(100, count);
+    ASSERT_TRUE(it->IsFinish());
+    ASSERT_FALSE(it->Failed());
+
+    // the stream stops at the limit and the rest rows are read by another stream
+    it = client1->ScanStream(tid, 0, key, "card", 0, 0, 30, 0, msg);
+    ASSERT_TRUE(it);
+    count = 0;
+    while (it->Valid()) {
+        last_ts = it->GetKey();
+        count++;
+        it->Next();
+    }
+    ASSERT_EQ(30, count);
+    ASSERT_FALSE(it->IsFinish());
+    ASSERT_FALSE(it->Failed());
+    it = client1->ScanStream(tid, 0, key, "card", last_ts, 0, 0, 1, msg);
+    ASSERT_TRUE(it);
+    count = 0;
+    while (it->Valid()) {
+        ASSERT_LT(it->GetKey(), last_ts);
+        count++;
+        it->Next();
+    }
+    ASSERT_EQ(70, count);
+    ASSERT_TRUE(it->IsFinish());
+
+    // a stream released before it is consumed
+    it = client1->ScanStream(tid, 0, key, "card", 0, 0, 0, 0, msg);
+    ASSERT_TRUE(it && it->Valid());
+    it.reset();
+    it = client1->ScanStream(tid, 0, "card_not_exist", "card", 0, 0, 0, 0, msg);
+    ASSERT_TRUE(it);
+    ASSERT_FALSE(it->Valid());
+    ASSERT_TRUE(it->IsFinish());
+    FLAGS_stream_scan_chunk_size = old_chunk_size;
+}
+
+TEST_F(DistributeIteratorTest, TraverseStream) {
+    uint32_t old_chunk_size = FLAGS_stream_scan_chunk_size;
+    FLAGS_stream_scan_chunk_size = 64;
+    uint32_t tid = 3;
+    FLAGS_db_root_path = "/tmp/" + ::openmldb::test::GenRand();
+    std::vector<std::string> endpoints = {"127.0.0.1:9230"};
+    brpc::Server tablet1;
+    ASSERT_TRUE(::openmldb::test::StartTablet(endpoints[0], &tablet1));
+    auto client1 = std::make_shared<openmldb::client::TabletClient>(endpoints[0], endpoints[0]);
+    ASSERT_EQ(client1->Init(), 0);
+    auto meta = CreateTableMeta(tid, 0);
+    ASSERT_TRUE(client1->CreateTable(meta));
+    PutData(meta, client1);
+    auto it = client1->TraverseStream(tid, 0, "", "", 0, 0, false);
+    ASSERT_TRUE(it);
+    std::map<std::string, int> key_cnt;
+    while (it->Valid()) {
+        key_cnt[it->GetPK()]++;
+        it->Next();
+    }
+    ASSERT_EQ(5u, key_cnt.size());
+    for (const auto& kv : key_cnt) {
+        ASSERT_EQ(10, kv.second);
+    }
+    ASSERT_TRUE(it->IsFinish());
+    ASSERT_FALSE(it->Failed());
+
+    it = client1->TraverseStream(tid, 0, "", "", 0, 23, false);
+    ASSERT_TRUE(it);
+    int count = 0;
+    std::string last_pk;
+    uint64_t last_ts = 0;
+    while (it->Valid()) {
+        last_pk = it->GetPK();
+        last_ts = it->GetKey();
+        count++;
+        it->Next();
+    }
+    ASSERT_EQ(23, count);
+    ASSERT_FALSE(it->IsFinish());
+    ASSERT_EQ(last_pk, it->GetLastPK());
+    ASSERT_EQ(last_ts, it->GetLastTS());
+
+    // the table iterator continues the bounded streams from the last position
+    uint32_t old_max_limit = FLAGS_remote_fetch_max_cnt_limit;
+    FLAGS_remote_fetch_max_cnt_limit = 7;
+    FLAGS_enable_stream_scan = true;
+    std::map<uint32_t, std::shared_ptr<openmldb::client::TabletClient>> tablet_clients = {{0, client1}};
+    FullTableIterator full_it(tid, {}, tablet_clients);
+    full_it.SeekToFirst();
+    count = 0;
+    while (full_it.Valid()) {
+        count++;
+        full_it.Next();
+    }
+    ASSERT_EQ(50, count);
+    FLAGS_enable_stream_scan = false;
+    FLAGS_remote_fetch_max_cnt_limit = old_max_limit;
+    FLAGS_stream_scan_chunk_size = old_chunk_size;
+}
+
+TEST_F(DistributeIteratorTest, RemoteIteratorByStream) {
+    uint32_t old_limit = FLAGS_traverse_cnt_limit;
+    uint32_t old_chunk_size = FLAGS_stream_scan_chunk_size;
+    FLAGS_traverse_cnt_limit = 7;
+    FLAGS_stream_scan_chunk_size = 256;
+    FLAGS_enable_stream_scan = true;
+    uint32_t tid = 3;
+    auto tables = std::make_shared<Tables>();
+    FLAGS_db_root_path = "/tmp/" + ::openmldb::test::GenRand();
+    std::vector<std::string> endpoints = {"127.0.0.1:9230"};
+    brpc::Server tablet1;
+    ASSERT_TRUE(::openmldb::test::StartTablet(endpoints[0], &tablet1));
+    auto client1 = std::make_shared<openmldb::client::TabletClient>(endpoints[0], endpoints[0]);
+    ASSERT_EQ(client1->Init(), 0);
+    std::vector<::openmldb::api::TableMeta> metas = {CreateTableMeta(tid, 0)};
+    ASSERT_TRUE(client1->CreateTable(metas[0]));
+    std::map<uint32_t, std::shared_ptr<openmldb::client::TabletClient>> tablet_clients = {{0, client1}};
+    codec::SDKCodec codec(metas[0]);
+    uint64_t now = ::baidu::common::timer::get_micros() / 1000;
+    std::string key = "card0";
+    // the rows of the same ts span several streams
+    for (int j = 0; j < 100; j++) {
+        std::vector<std::string> row = {key , "mcc", std::to_string(now)};
+        std::string value;
+        ASSERT_EQ(0, codec.EncodeRow(row, &value));
+        std::vector<std::pair<std::string, uint32_t>> dimensions = {{key, 0}};
+        client1->Put(tid, 0, 0, value, dimensions);
+    }
+    for (int j = 100; j < 2000; j++) {
+        std::vector<std::string> row = {key , "mcc", std::to_string(now - j)};
+        std::string value;
+        ASSERT_EQ(0, codec.EncodeRow(row, &value));
+        std::vector<std::pair<std::string, uint32_t>> dimensions = {{key, 0}};
+        client1->Put(tid, 0, 0, value, dimensions);
+    }
+    DistributeWindowIterator w_it(tid, 1, tables, 0, "card", tablet_clients);
+    w_it.Seek(key);
+    ASSERT_TRUE(w_it.Valid());
+    auto it = w_it.GetValue();
+    it->SeekToFirst();
+    int count = 0;
+    while (it->Valid()) {
+        count++;
+        it->Next();
+    }
+    ASSERT_EQ(count, 2000);
+
+    DistributeWindowIterator w_it2(tid, 1, tables, 0, "card", tablet_clients);
+    w_it2.Seek(key);
+    ASSERT_TRUE(w_it2.Valid());
+    it = w_it2.GetValue();
+    it->Seek(now - 1500);
+    ASSERT_TRUE(it->Valid());
+    count = 0;
+    while (it->Valid()) {
+        ASSERT_EQ(now - 1500 - count, it->GetKey());
+        count++;
+        it->Next();
+    }
+    ASSERT_EQ(count, 500);
+    FLAGS_enable_stream_scan = false;
+    FLAGS_stream_scan_chunk_size = old_chunk_size;
+    FLAGS_traverse_cnt_limit = old_limit;
+}
+
+TEST_F(DistributeIteratorTest, BrokenStream) {
+    uint32_t old_chunk_size = FLAGS_stream_scan_chunk_size;
+    uint32_t old_window_size = FLAGS_stream_scan_window_size;
+    int32_t old_idle_timeout = FLAGS_stream_scan_idle_timeout_ms;
+    uint32_t old_max_limit = FLAGS_remote_fetch_max_cnt_limit;
+    // the tablet closes a stream once its window of one byte is full, so the streams break after a chunk or two
+    FLAGS_stream_scan_chunk_size = 64;
+    FLAGS_stream_scan_window_size = 1;
+    FLAGS_stream_scan_idle_timeout_ms = 0;
+    FLAGS_remote_fetch_max_cnt_limit = 1000;
+    FLAGS_enable_stream_scan = true;
+    uint32_t tid = 3;
+    auto tables = std::make_shared<Tables>();
+    FLAGS_db_root_path = "/tmp/" + ::openmldb::test::GenRand();
+    std::vector<std::string> endpoints = {"127.0.0.1:9230"};
+    brpc::Server tablet1;
+    ASSERT_TRUE(::openmldb::test::StartTablet(endpoints[0], &tablet1));
+    auto client1 = std::make_shared<openmldb::client::TabletClient>(endpoints[0], endpoints[0]);
+    ASSERT_EQ(client1->Init(), 0);
+    auto meta = CreateTableMeta(tid, 0);
+    ASSERT_TRUE(client1->CreateTable(meta));
+    codec::SDKCodec codec(meta);
+    uint64_t now = ::baidu::common::timer::get_micros() / 1000;
+    std::string key = "card0";
+    for (int j = 0; j < 500; j++) {
+        std::vector<std::string> row = {key, "mcc", std::to_string(now - j)};
+        std::string value;
+        ASSERT_EQ(0, codec.EncodeRow(row, &value));
+        std::vector<std::pair<std::string, uint32_t>> dimensions = {{key, 0}};
+        client1->Put(tid, 0, 0, value, dimensions);
+    }
+    std::map<uint32_t, std::shared_ptr<openmldb::client::TabletClient>> tablet_clients = {{0, client1}};
+
+    // the table iterator continues a broken stream by traverse
+    FullTableIterator full_it(tid, {}, tablet_clients);
+    full_it.SeekToFirst();
+    int count = 0;
+    while (full_it.Valid()) {
+        count++;
+        full_it.Next();
+    }
+    ASSERT_EQ(500, count);
+
+    // the window continues a broken stream by scan after the last row read
+    DistributeWindowIterator w_it(tid, 1, tables, 0, "card", tablet_clients);
+    w_it.Seek(key);
+    ASSERT_TRUE(w_it.Valid());
+    auto it = w_it.GetValue();
+    it->SeekToFirst();
+    count = 0;
+    while (it->Valid()) {
+        ASSERT_EQ(now - count, it->GetKey());
+        count++;
+        it->Next();
+    }
+    ASSERT_EQ(500, count);
+
+    DistributeWindowIterator w_it2(tid, 1, tables, 0, "card", tablet_clients);
+    w_it2.Seek(key);
+    ASSERT_TRUE(w_it2.Valid());
+    it = w_it2.GetValue();
+    it->Seek(now - 300);
+    count = 0;
+    while (it->Valid()) {
+        ASSERT_EQ(now - 300 - count, it->GetKey());
+        count++;
+        it->Next();
+    }
+    ASSERT_EQ(200, count);
+    FLAGS_enable_stream_scan = false;
+    FLAGS_remote_fetch_max_cnt_limit = old_max_limit;
+    FLAGS_stream_scan_idle_timeout_ms = old_idle_timeout;
+    FLAGS_stream_scan_window_size = old_window_size;
+    FLAGS_stream_scan_chunk_size = old_chunk_size;
+}
+
+// the rows of every window in the order of the iteration, keyed by pk
+static void ReadWindows(DistributeWindowIterator* w_it, std::vector<uint32_t>* pids,
+        std::map<std::string, std::vector<uint64_t>>* windows) {
+    w_it->SeekToFirst();
+    while (w_it->Valid()) {
+        std::string key = w_it->GetKey().ToString();
+        ASSERT_TRUE(windows->find(key) == windows->end()) << "duplicate key " << key;
+        pids->push_back(static_cast<uint32_t>(::openmldb::base::hash64(key) % 2));
+        auto& rows = (*windows)[key];
+        auto it = w_it->GetValue();
+        it->SeekToFirst();
+        while (it->Valid()) {
+            rows.push_back(it->GetKey());
+            it->Next();
+        }
+        w_it->Next();
+    }
+}
+
+TEST_F(DistributeIteratorTest, RemotePrefetch) {
+    uint32_t old_limit = FLAGS_traverse_cnt_limit;
+    uint32_t old_max_limit = FLAGS_remote_fetch_max_cnt_limit;
+    bool old_prefetch = FLAGS_enable_remote_prefetch;
+    // every page has 10 rows, so the windows of 10 and 20 rows end on a page boundary
+    FLAGS_traverse_cnt_limit = 10;
+    FLAGS_remote_fetch_max_cnt_limit = 10;
+    uint32_t tid = 3;
+    auto tables = std::make_shared<Tables>();
+    FLAGS_db_root_path = "/tmp/" + ::openmldb::test::GenRand();
+    std::vector<std::string> endpoints = {"127.0.0.1:9230"};
+    brpc::Server tablet1;
+    ASSERT_TRUE(::openmldb::test::StartTablet(endpoints[0], &tablet1));
+    auto client1 = std::make_shared<openmldb::client::TabletClient>(endpoints[0], endpoints[0]);
+    ASSERT_EQ(client1->Init(), 0);
+    std::vector<::openmldb::api::TableMeta> metas = {CreateTableMeta(tid, 0), CreateTableMeta(tid, 1)};
+    ASSERT_TRUE(client1->CreateTable(metas[0]));
+    ASSERT_TRUE(client1->CreateTable(metas[1]));
+    std::map<uint32_t, std::shared_ptr<openmldb::client::TabletClient>> tablet_clients = {{0, client1},
+                                                                                          {1, client1}};
+    std::map<std::string, int> expect_cnt;
+    for (int i = 0; i < 12; i++) {
+        std::string key = "card" + std::to_string(i);
+        uint32_t pid = static_cast<uint32_t>(::openmldb::base::hash64(key) % 2);
+        int cnt = i % 3 == 0 ? 10 : (i % 3 == 1 ? 20 : 25);
+        PutKey(key, metas[pid], client1, cnt);
+        expect_cnt[key] = cnt;
+    }
+
+    std::map<std::string, std::vector<uint64_t>> windows[2];
+    for (int prefetch = 0; prefetch < 2; prefetch++) {
+        FLAGS_enable_remote_prefetch = prefetch == 1;
+        DistributeWindowIterator w_it(tid, 2, tables, 0, "card", tablet_clients);
+        std::vector<uint32_t> pids;
+        ASSERT_NO_FATAL_FAILURE(ReadWindows(&w_it, &pids, &windows[prefetch]));
+        // the partitions are iterated one by one
+        ASSERT_TRUE(std::is_sorted(pids.begin(), pids.end()));
+        ASSERT_EQ(expect_cnt.size(), windows[prefetch].size());
+        for (const auto& kv : windows[prefetch]) {
+            ASSERT_EQ(expect_cnt[kv.first], static_cast<int>(kv.second.size())) << kv.first;
+            for (size_t i = 1; i < kv.second.size(); i++) {
+                ASSERT_GT(kv.second[i - 1], kv.second[i]) << kv.first;
+            }
+        }
+    }
+    ASSERT_EQ(windows[0], windows[1]);
+
+    // the windows which are scanned by key
+    FLAGS_enable_remote_prefetch = true;
+    DistributeWindowIterator w_it(tid, 2, tables, 0, "card", tablet_clients);
+    for (const auto& kv : expect_cnt) {
+        w_it.Seek(kv.first);
+        ASSERT_TRUE(w_it.Valid());
+        ASSERT_EQ(kv.first, w_it.GetKey().ToString());
+        auto it = w_it.GetValue();
+        it->SeekToFirst();
+        std::vector<uint64_t> rows;
+        while (it->Valid()) {
+            rows.push_back(it->GetKey());
+            it->Next();
+        }
+        ASSERT_EQ(windows[0][kv.first], rows) << kv.first;
+    }
+    FLAGS_enable_remote_prefetch = old_prefetch;
+    FLAGS_remote_fetch_max_cnt_limit = old_max_limit;
+    FLAGS_traverse_cnt_limit = old_limit;
+}
+
+static butil::IOBuf EncodeScanChunk(const std::vector<uint64_t>& ts_vec, bool is_finish) {
+    boost::container::deque<std::pair<uint64_t, ::openmldb::base::Slice>> rows;
+    uint32_t total_size = 0;
+    for (auto ts : ts_vec) {
+        rows.emplace_back(ts, ::openmldb::base::Slice("value"));
+        total_size += 5;
+    }
+    ::openmldb::api::ScanResponse chunk;
+    ::openmldb::codec::EncodeRows(rows, total_size, chunk.mutable_pairs());
+    chunk.set_code(0);
+    chunk.set_count(rows.size());
+    chunk.set_is_finish(is_finish);
+    butil::IOBuf buf;
+    {
+        butil::IOBufAsZeroCopyOutputStream output(&buf);
+        chunk.SerializeToZeroCopyStream(&output);
+    }
+    return buf;
+}
+
+TEST_F(DistributeIteratorTest, StreamKvIterator) {
+    // the chunks are fed to the handler of the stream directly, the id is not of any stream
+    brpc::StreamId stream = brpc::INVALID_STREAM_ID - 1;
+    {
+        openmldb::client::StreamKvIterator it(false, "key1", 0);
+        auto* handler = it.GetStreamOptions().handler;
+        it.SetStream(stream);
+        butil::IOBuf chunks[3] = {EncodeScanChunk({9, 8}, false), EncodeScanChunk({}, false),
+                                  EncodeScanChunk({7}, true)};
+        butil::IOBuf* messages[3] = {&chunks[0], &chunks[1], &chunks[2]};
+        ASSERT_EQ(0, handler->on_received_messages(stream, messages, 3));
+        handler->on_closed(stream);
+        it.Next();
+        std::vector<uint64_t> ts_vec;
+        while (it.Valid()) {
+            ASSERT_EQ("key1", it.GetPK());
+            ASSERT_EQ("value", it.GetValue().ToString());
+            ts_vec.push_back(it.GetKey());
+            it.Next();
+        }
+        ASSERT_EQ(std::vector<uint64_t>({9, 8, 7}), ts_vec);
+        ASSERT_TRUE(it.IsFinish());
+        ASSERT_FALSE(it.Failed());
+    }
+    {
+        // the stream is closed before the last chunk
+        openmldb::client::StreamKvIterator it(false, "key1", 0);
+        auto* handler = it.GetStreamOptions().handler;
+        it.SetStream(stream);
+        butil::IOBuf chunk = EncodeScanChunk({9, 8}, false);
+        butil::IOBuf* messages[1] = {&chunk};
+        ASSERT_EQ(0, handler->on_received_messages(stream, messages, 1));
+        handler->on_closed(stream);
+        int count = 0;
+        for (it.Next(); it.Valid(); it.Next()) {
+            count++;
+        }
+        ASSERT_EQ(2, count);
+        ASSERT_TRUE(it.Failed());
+    }
+    {
+        // the stream stops at the limit
+        openmldb::client::StreamKvIterator it(false, "key1", 3);
+        auto* handler = it.GetStreamOptions().handler;
+        it.SetStream(stream);
+        butil::IOBuf chunks[2] = {EncodeScanChunk({9, 8}, false), EncodeScanChunk({7}, false)};
+        butil::IOBuf* messages[2] = {&chunks[0], &chunks[1]};
+        ASSERT_EQ(0, handler->on_received_messages(stream, messages, 2));
+        handler->on_closed(stream);
+        int count = 0;
+        for (it.Next(); it.Valid(); it.Next()) {
+            count++;
+        }
+        ASSERT_EQ(3, count);
+        ASSERT_FALSE(it.IsFinish());
+        ASSERT_FALSE(it.Failed());
+    }
+}
+
 }  // namespace catalog
 }  // namespace openmldb
 
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "catalog/read_key_recorder.h"
+
+#include <algorithm>
+
+#include "bthread/bthread.h"
+#include "storage/key_versions.h"
+
+namespace openmldb {
+namespace catalog {
+
+// a bthread may be moved to another worker while it waits for a remote read, so the recorder is kept in a bthread
+// local instead of a thread local
+static bthread_key_t GetRecorderKey() {
+    static bthread_key_t key = [] {
+        bthread_key_t k;
+        bthread_key_create(&k, nullptr);
+        return k;
+    }();
+    return key;
+}
+
+ReadKeyRecorder::ReadKeyRecorder() : prev_(Current()), full_scan_(false), slots_() {
+    bthread_setspecific(GetRecorderKey(), this);
+}
+
+ReadKeyRecorder::~ReadKeyRecorder() { bthread_setspecific(GetRecorderKey(), prev_); }
+
+ReadKeyRecorder* ReadKeyRecorder::Current() {
+    return static_cast<ReadKeyRecorder*>(bthread_getspecific(GetRecorderKey()));
+}
+
+void ReadKeyRecorder::Record(uint32_t tid, uint32_t idx, const std::string& key) {
+    if (!::openmldb::storage::KeyVersions::IsEnabled()) {
+        return;
+    }
+    auto recorder = Current();
+    if (recorder == nullptr) {
+        return;
+    }
+    uint32_t slot = ::openmldb::storage::KeyVersions::GetSlot(tid, idx, key);
+    recorder->slots_.emplace_back(slot, ::openmldb::storage::KeyVersions::GetVersion(slot));
+}
+
+void ReadKeyRecorder::RecordFullScan() {
+    auto recorder = Current();
+    if (recorder != nullptr) {
+        recorder->full_scan_ = true;
+    }
+}
+
+std::vector<std::pair<uint32_t, uint64_t>> ReadKeyRecorder::TakeReadSlots() {
+    // a key read twice keeps the version of the first read, which is the older one
+    std::stable_sort(slots_.begin(), slots_.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    slots_.erase(std::unique(slots_.begin(), slots_.end(),
+                             [](const auto& a, const auto& b) { return a.first == b.first; }),
+                 slots_.end());
+    return std::move(slots_);
+}
+
+}  // namespace catalog
+}  // namespace openmldb
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_CATALOG_READ_KEY_RECORDER_H_
+#define SRC_CATALOG_READ_KEY_RECORDER_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace openmldb {
+namespace catalog {
+
+// the slots and the versions of the keys read by a request, see storage::KeyVersions. the recorder collects the
+// reads of the catalog in the bthread which creates it until it is destroyed, so the result of the request can be
+// cached until one of the keys is updated
+class ReadKeyRecorder {
+ public:
+    ReadKeyRecorder();
+    ~ReadKeyRecorder();
+
+    ReadKeyRecorder(const ReadKeyRecorder&) = delete;
+    ReadKeyRecorder& operator=(const ReadKeyRecorder&) = delete;
+
+    // called by the catalog before the rows of the key are read
+    static void Record(uint32_t tid, uint32_t idx, const std::string& key);
+
+    // the request reads a whole table, which is not tracked by the versions of the keys
+    static void RecordFullScan();
+
+    bool IsCacheable() const { return !full_scan_; }
+
+    // the slot and the version of the keys, which are deduplicated
+    std::vector<std::pair<uint32_t, uint64_t>> TakeReadSlots();
+
+ private:
+    static ReadKeyRecorder* Current();
+
+    ReadKeyRecorder* prev_;
+    bool full_scan_;
+    std::vector<std::pair<uint32_t, uint64_t>> slots_;
+};
+
+}  // namespace catalog
+}  // namespace openmldb
+#endif  // SRC_CATALOG_READ_KEY_RECORDER_H_
@@ -23,12 +23,18 @@
 #include <utility>
 
 #include "catalog/distribute_iterator.h"
+#include "catalog/read_key_recorder.h"
 #include "codec/list_iterator_codec.h"
 #include "glog/logging.h"
 #include "schema/index_util.h"
 #include "schema/schema_adapter.h"
+#include "storage/key_versions.h"
+#include "vm/mem_catalog.h"
 
 DECLARE_bool(enable_localtablet);
+DECLARE_bool(enable_multi_get);
+DECLARE_uint32(traverse_cnt_limit);
+DECLARE_int32(request_timeout_ms);
 namespace openmldb {
 namespace catalog {
 
@@ -158,6 +164,7 @@ const ::hybridse::codec::Row TabletTableHandler::Get(int32_t pos) {
 }
 
 ::hybridse::codec::RowIterator* TabletTableHandler::GetRawIterator() {
+    ReadKeyRecorder::RecordFullScan();
     auto tables = std::atomic_load_explicit(&tables_, std::memory_order_acquire);
     std::map<uint32_t, std::shared_ptr<openmldb::client::TabletClient>> tablet_clients;
     for (uint32_t pid = 0; pid < partition_num_; pid++) {
@@ -277,6 +284,162 @@ std::shared_ptr<::hybridse::vm::Tablet> TabletTableHandler::GetTablet(const std:
     return tablets_accessor;
 }
 
+bool TabletTableHandler::GetLocalIndex(const std::string& index_name, const std::string& pk, uint32_t* idx,
+                                       uint64_t* expire_ts) {
+    auto iter = index_hint_.find(index_name);
+    if (iter == index_hint_.end()) {
+        return false;
+    }
+    uint32_t pid_num = table_st_.GetPartitionNum();
+    uint32_t pid = 0;
+    if (pid_num > 0) {
+        pid = (uint32_t)(::openmldb::base::hash64(pk) % pid_num);
+    }
+    auto tables = std::atomic_load_explicit(&tables_, std::memory_order_relaxed);
+    auto table_iter = tables->find(pid);
+    if (table_iter == tables->end() || table_iter->second->GetStorageMode() != ::openmldb::common::kMemory) {
+        return false;
+    }
+    auto index = table_iter->second->GetIndex(iter->second.index);
+    if (!index || index->GetTTLType() != ::openmldb::storage::TTLType::kAbsoluteTime) {
+        return false;
+    }
+    *idx = iter->second.index;
+    *expire_ts = table_iter->second->GetExpireTime(*index->GetTTL());
+    return true;
+}
+
+void TabletTableHandler::MultiGet(const std::string& index_name, const std::vector<std::string>& keys,
+                                  std::map<std::string, std::shared_ptr<::hybridse::vm::TableHandler>>* segments) {
+    uint32_t pid_num = table_st_.GetPartitionNum();
+    auto tables = std::atomic_load_explicit(&tables_, std::memory_order_acquire);
+    std::map<uint32_t, std::set<std::string>> pid_keys;
+    for (const auto& key : keys) {
+        uint32_t pid = 0;
+        if (pid_num > 0) {
+            pid = (uint32_t)(::openmldb::base::hash64(key) % pid_num);
+        }
+        // the local keys are seeked directly
+        if (tables && tables->find(pid) != tables->end()) {
+            continue;
+        }
+        pid_keys[pid].insert(key);
+    }
+    using Callback = openmldb::RpcCallback<openmldb::api::MultiGetResponse>;
+    std::vector<std::pair<Callback*, const std::set<std::string>*>> calls;
+    for (const auto& kv : pid_keys) {
+        auto accessor = table_client_manager_->GetTablet(kv.first);
+        if (!accessor) {
+            continue;
+        }
+        ::openmldb::api::MultiGetRequest request;
+        request.set_tid(GetTid());
+        request.set_pid(kv.first);
+        for (const auto& key : kv.second) {
+            auto* multi_get_key = request.add_keys();
+            multi_get_key->set_idx_name(index_name);
+            multi_get_key->set_pk(key);
+            multi_get_key->set_st(0);
+            multi_get_key->set_et(0);
+            multi_get_key->set_limit(FLAGS_traverse_cnt_limit);
+        }
+        auto cntl = std::make_shared<brpc::Controller>();
+        cntl->set_timeout_ms(FLAGS_request_timeout_ms);
+        auto callback = new Callback(std::make_shared<openmldb::api::MultiGetResponse>(), cntl);
+        callback->Ref();
+        if (!accessor->GetClient()->AsyncMultiGet(request, callback)) {
+            callback->Run();
+            callback->UnRef();
+            continue;
+        }
+        calls.emplace_back(callback, &kv.second);
+    }
+    for (auto& call : calls) {
+        Callback* callback = call.first;
+        auto& cntl = callback->GetController();
+        auto& response = callback->GetResponse();
+        brpc::Join(cntl->call_id());
+        if (cntl->Failed() || response->code() != 0 ||
+            response->results_size() != static_cast<int>(call.second->size())) {
+            LOG(WARNING) << "fail to multi get table " << GetName() << ". " << cntl->ErrorText() << response->msg();
+            callback->UnRef();
+            continue;
+        }
+        butil::IOBuf& buf = cntl->response_attachment();
+        int idx = 0;
+        for (const auto& key : *call.second) {
+            const auto& result = response->results(idx++);
+            if (result.code() != 0 || !result.is_finish()) {
+                buf.pop_front(result.byte_size());
+                continue;
+            }
+            auto scan_response = std::make_shared<openmldb::api::ScanResponse>();
+            buf.cutn(scan_response->mutable_pairs(), result.byte_size());
+            auto segment = std::make_shared<::hybridse::vm::MemTimeTableHandler>(GetName(), GetDatabase(), &schema_);
+            segment->SetOrderType(::hybridse::vm::kDescOrder);
+            for (openmldb::base::ScanKvIterator it(key, scan_response); it.Valid(); it.Next()) {
+                auto value = it.GetValue();
+                auto slice = ::hybridse::base::RefCountedSlice::Allocate(value.size());
+                memcpy(slice.buf(), value.data(), value.size());
+                segment->AddRow(it.GetKey(), ::hybridse::codec::Row(slice));
+            }
+            (*segments)[key] = segment;
+        }
+        callback->UnRef();
+    }
+}
+
+std::shared_ptr<::hybridse::vm::TableHandler> TabletPartitionHandler::GetSegment(const std::string& key) {
+    if (::openmldb::storage::KeyVersions::IsEnabled()) {
+        auto table = std::dynamic_pointer_cast<TabletTableHandler>(table_handler_);
+        auto iter = table_handler_->GetIndex().find(index_name_);
+        if (table && iter != table_handler_->GetIndex().end()) {
+            ReadKeyRecorder::Record(table->GetTid(), iter->second.index, key);
+        }
+    }
+    auto iter = segments_.find(key);
+    if (iter != segments_.end()) {
+        return iter->second;
+    }
+    return std::make_shared<TabletSegmentHandler>(shared_from_this(), key);
+}
+
+bool TabletPartitionHandler::GetLocalIndex(const std::string& key, uint32_t* tid, uint32_t* idx,
+                                           uint64_t* expire_ts) {
+    auto table = std::dynamic_pointer_cast<TabletTableHandler>(table_handler_);
+    if (!table || !table->GetLocalIndex(index_name_, key, idx, expire_ts)) {
+        return false;
+    }
+    *tid = table->GetTid();
+    return true;
+}
+
+bool TabletSegmentHandler::GetAppendVersion(std::string* key, uint64_t* version, uint64_t* expire_ts) {
+    if (!::openmldb::storage::KeyVersions::IsEnabled()) {
+        return false;
+    }
+    auto partition = std::dynamic_pointer_cast<TabletPartitionHandler>(partition_handler_);
+    uint32_t tid = 0;
+    uint32_t idx = 0;
+    if (!partition || !partition->GetLocalIndex(key_, &tid, &idx, expire_ts)) {
+        return false;
+    }
+    *key = key_;
+    *version = ::openmldb::storage::KeyVersions::GetAppendVersion(
+        ::openmldb::storage::KeyVersions::GetSlot(tid, idx, key_));
+    return true;
+}
+
+void TabletPartitionHandler::Prefetch(const std::vector<std::string>& keys) {
+    if (!FLAGS_enable_multi_get) {
+        return;
+    }
+    auto table = std::dynamic_pointer_cast<TabletTableHandler>(table_handler_);
+    if (table) {
+        table->MultiGet(index_name_, keys, &segments_);
+    }
+}
+
 TabletCatalog::TabletCatalog()
     : mu_(),
       tables_(),
@@ -112,6 +112,9 @@ class TabletSegmentHandler : public ::hybridse::vm::TableHandler {
     }
     const std::string GetHandlerTypeName() override { return "TabletSegmentHandler"; }
 
+    // the version is tracked if the key is on a local memory table, see storage::KeyVersions
+    bool GetAppendVersion(std::string *key, uint64_t *version, uint64_t *expire_ts) override;
+
  private:
     std::shared_ptr<::hybridse::vm::PartitionHandler> partition_handler_;
     std::string key_;
@@ -154,14 +157,20 @@ class TabletPartitionHandler : public ::hybridse::vm::PartitionHandler,
         return cnt;
     }
 
-    std::shared_ptr<::hybridse::vm::TableHandler> GetSegment(const std::string &key) override {
-        return std::make_shared<TabletSegmentHandler>(shared_from_this(), key);
-    }
+    std::shared_ptr<::hybridse::vm::TableHandler> GetSegment(const std::string &key) override;
     const std::string GetHandlerTypeName() override { return "TabletPartitionHandler"; }
 
+    // fetch the segments of the keys on the remote partitions by one MultiGet per partition
+    void Prefetch(const std::vector<std::string> &keys) override;
+
+    // see TabletTableHandler::GetLocalIndex
+    bool GetLocalIndex(const std::string &key, uint32_t *tid, uint32_t *idx, uint64_t *expire_ts);
+
  private:
     std::shared_ptr<::hybridse::vm::TableHandler> table_handler_;
     std::string index_name_;
+    // the segments fetched by Prefetch
+    std::map<std::string, std::shared_ptr<::hybridse::vm::TableHandler>> segments_;
 };
 
 class TabletTableHandler : public ::hybridse::vm::TableHandler,
@@ -209,6 +218,15 @@ class TabletTableHandler : public ::hybridse::vm::TableHandler,
 
     inline int32_t GetTid() { return table_st_.GetTid(); }
 
+    // get all the rows of the keys on the remote partitions, the rpcs of the partitions are sent in parallel.
+    // a key is not set in `segments` if its rows are more than a page or the rpc fails
+    void MultiGet(const std::string &index_name, const std::vector<std::string> &keys,
+                  std::map<std::string, std::shared_ptr<::hybridse::vm::TableHandler>> *segments);
+
+    // get the index id if the key is on a local memory table and the ttl of the index is absolute, `expire_ts` is
+    // the ts at or before which the rows are expired
+    bool GetLocalIndex(const std::string &index_name, const std::string &pk, uint32_t *idx, uint64_t *expire_ts);
+
     void AddTable(std::shared_ptr<::openmldb::storage::Table> table);
 
     bool HasLocalTable();
@@ -0,0 +1,193 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "client/stream_kv_iterator.h"
+
+#include <mutex>  // NOLINT
+
+#include "glog/logging.h"
+#include "proto/tablet.pb.h"
+
+namespace openmldb {
+namespace client {
+
+StreamChunkReceiver::StreamChunkReceiver()
+    : mu_(),
+      cv_(),
+      chunks_(),
+      closed_(false),
+      abandoned_(false),
+      self_() {}
+
+int StreamChunkReceiver::on_received_messages(brpc::StreamId id, butil::IOBuf* const messages[], size_t size) {
+    std::lock_guard<bthread::Mutex> lock(mu_);
+    if (abandoned_) {
+        return 0;
+    }
+    for (size_t i = 0; i < size; i++) {
+        chunks_.emplace_back();
+        chunks_.back().swap(*messages[i]);
+    }
+    cv_.notify_all();
+    return 0;
+}
+
+void StreamChunkReceiver::on_closed(brpc::StreamId id) {
+    std::shared_ptr<StreamChunkReceiver> self;
+    {
+        std::lock_guard<bthread::Mutex> lock(mu_);
+        closed_ = true;
+        self.swap(self_);
+        cv_.notify_all();
+    }
+}
+
+bool StreamChunkReceiver::Pop(butil::IOBuf* chunk) {
+    std::unique_lock<bthread::Mutex> lock(mu_);
+    while (chunks_.empty() && !closed_) {
+        cv_.wait(lock);
+    }
+    if (chunks_.empty()) {
+        return false;
+    }
+    chunk->swap(chunks_.front());
+    chunks_.pop_front();
+    return true;
+}
+
+void StreamChunkReceiver::Abandon() {
+    std::lock_guard<bthread::Mutex> lock(mu_);
+    abandoned_ = true;
+    chunks_.clear();
+}
+
+void StreamChunkReceiver::KeepAliveUntilClosed(const std::shared_ptr<StreamChunkReceiver>& self) {
+    std::lock_guard<bthread::Mutex> lock(mu_);
+    if (!closed_) {
+        self_ = self;
+    }
+}
+
+StreamKvIterator::StreamKvIterator(bool is_traverse, const std::string& pk, uint32_t limit)
+    : KvIterator(std::shared_ptr<::google::protobuf::Message>()),
+      is_traverse_(is_traverse),
+      limit_(limit),
+      receiver_(std::make_shared<StreamChunkReceiver>()),
+      stream_(brpc::INVALID_STREAM_ID),
+      chunk_it_(),
+      last_chunk_received_(false),
+      failed_(false),
+      received_cnt_(0),
+      last_pk_(),
+      last_ts_(0) {
+    pk_ = pk;
+    // it is reset if the stream stops at the limit
+    is_finish_ = true;
+}
+
+StreamKvIterator::~StreamKvIterator() {
+    receiver_->Abandon();
+    if (stream_ != brpc::INVALID_STREAM_ID) {
+        brpc::StreamClose(stream_);
+    }
+}
+
+brpc::StreamOptions StreamKvIterator::GetStreamOptions() const {
+    brpc::StreamOptions options;
+    options.handler = receiver_.get();
+    return options;
+}
+
+void StreamKvIterator::SetStream(brpc::StreamId stream) {
+    stream_ = stream;
+    receiver_->KeepAliveUntilClosed(receiver_);
+}
+
+void StreamKvIterator::SetCurrent() {
+    time_ = chunk_it_->GetKey();
+    if (is_traverse_) {
+        pk_ = chunk_it_->GetPK();
+    }
+    auto value = chunk_it_->GetValue();
+    tmp_.reset(value.data(), value.size());
+}
+
+void StreamKvIterator::Next() {
+    if (chunk_it_) {
+        chunk_it_->Next();
+        if (chunk_it_->Valid()) {
+            SetCurrent();
+            return;
+        }
+    }
+    while (NextChunk()) {
+        if (chunk_it_->Valid()) {
+            SetCurrent();
+            return;
+        }
+    }
+}
+
+bool StreamKvIterator::NextChunk() {
+    chunk_it_.reset();
+    if (last_chunk_received_ || failed_ || stream_ == brpc::INVALID_STREAM_ID) {
+        return false;
+    }
+    butil::IOBuf buf;
+    if (!receiver_->Pop(&buf)) {
+        LOG(WARNING) << "stream " << stream_ << " is closed before the last chunk";
+        failed_ = true;
+        return false;
+    }
+    butil::IOBufAsZeroCopyInputStream input(buf);
+    bool chunk_finish = false;
+    uint32_t chunk_cnt = 0;
+    if (is_traverse_) {
+        auto response = std::make_shared<::openmldb::api::TraverseResponse>();
+        if (!response->ParseFromZeroCopyStream(&input) || response->code() != 0) {
+            LOG(WARNING) << "fail to traverse by stream " << stream_ << ". msg " << response->msg();
+            failed_ = true;
+            return false;
+        }
+        chunk_finish = response->is_finish();
+        chunk_cnt = response->count();
+        last_pk_ = response->pk();
+        last_ts_ = response->ts();
+        chunk_it_ = std::make_shared<::openmldb::base::TraverseKvIterator>(response);
+    } else {
+        auto response = std::make_shared<::openmldb::api::ScanResponse>();
+        if (!response->ParseFromZeroCopyStream(&input) || response->code() != 0) {
+            LOG(WARNING) << "fail to scan by stream " << stream_ << ". msg " << response->msg();
+            failed_ = true;
+            return false;
+        }
+        chunk_finish = response->is_finish();
+        chunk_cnt = response->count();
+        chunk_it_ = std::make_shared<::openmldb::base::ScanKvIterator>(pk_, response);
+    }
+    received_cnt_ += chunk_cnt;
+    if (chunk_finish) {
+        last_chunk_received_ = true;
+    } else if (limit_ > 0 && received_cnt_ >= limit_) {
+        // the tablet stops at the limit, the rest rows are read by another scan
+        last_chunk_received_ = true;
+        is_finish_ = false;
+    }
+    return true;
+}
+
+}  // namespace client
+}  // namespace openmldb
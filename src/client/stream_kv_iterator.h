@@ -0,0 +1,118 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_CLIENT_STREAM_KV_ITERATOR_H_
+#define SRC_CLIENT_STREAM_KV_ITERATOR_H_
+
+#include <deque>
+#include <memory>
+#include <string>
+
+#include "base/kv_iterator.h"
+#include "brpc/stream.h"
+#include "bthread/condition_variable.h"
+#include "bthread/mutex.h"
+#include "butil/iobuf.h"
+
+namespace openmldb {
+namespace client {
+
+// receive the chunks of a streaming scan or traverse. the chunks are queued without blocking the brpc callback,
+// the pending ones are bounded by the limit of the stream
+class StreamChunkReceiver : public brpc::StreamInputHandler {
+ public:
+    StreamChunkReceiver();
+
+    int on_received_messages(brpc::StreamId id, butil::IOBuf* const messages[], size_t size) override;
+
+    void on_idle_timeout(brpc::StreamId id) override {}
+
+    void on_closed(brpc::StreamId id) override;
+
+    // wait for the next chunk, return false if the stream is closed and all the chunks are consumed
+    bool Pop(butil::IOBuf* chunk);
+
+    // the iterator is released and the chunks will not be consumed any more
+    void Abandon();
+
+    // the receiver must live until the stream is closed
+    void KeepAliveUntilClosed(const std::shared_ptr<StreamChunkReceiver>& self);
+
+ private:
+    bthread::Mutex mu_;
+    bthread::ConditionVariable cv_;
+    std::deque<butil::IOBuf> chunks_;
+    bool closed_;
+    bool abandoned_;
+    std::shared_ptr<StreamChunkReceiver> self_;
+};
+
+// iterate the rows of a streaming scan or traverse chunk by chunk, see TabletImpl::ScanStream.
+// the value is valid until Next is called. IsFinish is false if the stream stops at the limit and
+// there may be more rows after GetLastPK and GetLastTS, as a page of Scan or Traverse
+class StreamKvIterator : public ::openmldb::base::KvIterator {
+ public:
+    // pk is the key of a scan and empty for a traverse, limit is the max rows of the stream
+    StreamKvIterator(bool is_traverse, const std::string& pk, uint32_t limit);
+
+    ~StreamKvIterator() override;
+
+    // the options to create the stream of the rpc, the iterator reads the chunks by its handler
+    brpc::StreamOptions GetStreamOptions() const;
+
+    // set the stream created, it is closed when the iterator is released
+    void SetStream(brpc::StreamId stream);
+
+    // the first call moves to the first row after the rpc is successful
+    void Next() override;
+
+    bool Valid() override { return chunk_it_ && chunk_it_->Valid(); }
+
+    // the stream is broken or the tablet failed to scan, so the rows are not complete. IsFinish is still true, the
+    // caller continues by the paged Scan or Traverse after the last row it read
+    bool Failed() const { return failed_; }
+
+    // the position a traverse starts from, it is the last position until the first chunk is received
+    void SetStartPosition(const std::string& pk, uint64_t ts) {
+        last_pk_ = pk;
+        last_ts_ = ts;
+    }
+
+    // the position of the last row pushed, a traverse continues from it
+    const std::string& GetLastPK() const { return last_pk_; }
+
+    uint64_t GetLastTS() const { return last_ts_; }
+
+ private:
+    bool NextChunk();
+    void SetCurrent();
+
+ private:
+    const bool is_traverse_;
+    const uint32_t limit_;
+    std::shared_ptr<StreamChunkReceiver> receiver_;
+    brpc::StreamId stream_;
+    std::shared_ptr<::openmldb::base::KvIterator> chunk_it_;
+    bool last_chunk_received_;
+    bool failed_;
+    uint32_t received_cnt_;
+    std::string last_pk_;
+    uint64_t last_ts_;
+};
+
+}  // namespace client
+}  // namespace openmldb
+#endif  // SRC_CLIENT_STREAM_KV_ITERATOR_H_
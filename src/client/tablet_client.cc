@@ -22,6 +22,7 @@
 
 #include "base/glog_wapper.h"
 #include "brpc/channel.h"
+#include "brpc/stream.h"
 #include "codec/codec.h"
 #include "codec/sql_rpc_row_codec.h"
 #include "common/timer.h"
@@ -261,6 +262,18 @@ bool TabletClient::Put(uint32_t tid, uint32_t pid, uint64_t time, const std::str
     return false;
 }
 
+bool TabletClient::PutBatch(const ::openmldb::api::PutBatchRequest& request,
+                            ::openmldb::api::PutBatchResponse* response) {
+    bool ok = client_.SendRequest(&::openmldb::api::TabletServer_Stub::PutBatch, &request, response,
+                                  FLAGS_request_timeout_ms, 1);
+    if (ok && response->code() == 0) {
+        return true;
+    }
+    LOG(WARNING) << "fail to send put batch request for " << response->msg() << " and error code "
+                 << response->code();
+    return false;
+}
+
 bool TabletClient::Put(uint32_t tid, uint32_t pid, const std::string& pk, uint64_t time, const std::string& value) {
     ::openmldb::api::PutRequest request;
     auto dim = request.add_dimensions();
@@ -609,6 +622,43 @@ std::shared_ptr<openmldb::base::ScanKvIterator> TabletClient::Scan(uint32_t tid,
     return Scan(tid, pid, pk, idx_name, stime, etime, limit, 0, msg);
 }
 
+std::shared_ptr<StreamKvIterator> TabletClient::ScanStream(uint32_t tid, uint32_t pid, const std::string& pk,
+                                                           const std::string& idx_name, uint64_t stime,
+                                                           uint64_t etime, uint32_t limit,
+                                                           uint32_t skip_record_num, std::string& msg) {
+    ::openmldb::api::ScanRequest request;
+    request.set_pk(pk);
+    request.set_st(stime);
+    request.set_et(etime);
+    request.set_tid(tid);
+    request.set_pid(pid);
+    if (!idx_name.empty()) {
+        request.set_idx_name(idx_name);
+    }
+    request.set_limit(limit);
+    request.set_skip_record_num(skip_record_num);
+    auto it = std::make_shared<StreamKvIterator>(false, pk, limit);
+    brpc::Controller cntl;
+    cntl.set_timeout_ms(FLAGS_request_timeout_ms);
+    brpc::StreamId stream;
+    brpc::StreamOptions stream_options = it->GetStreamOptions();
+    if (brpc::StreamCreate(&stream, cntl, &stream_options) != 0) {
+        PDLOG(WARNING, "fail to create stream. tid %u pid %u", tid, pid);
+        return {};
+    }
+    it->SetStream(stream);
+    ::openmldb::api::ScanResponse response;
+    bool ok = client_.SendRequest(&::openmldb::api::TabletServer_Stub::ScanStream, &cntl, &request, &response);
+    if (response.has_msg()) {
+        msg = response.msg();
+    }
+    if (!ok || response.code() != 0) {
+        return {};
+    }
+    it->Next();
+    return it;
+}
+
 bool TabletClient::GetTableSchema(uint32_t tid, uint32_t pid, ::openmldb::api::TableMeta& table_meta) {
     ::openmldb::api::GetTableSchemaRequest request;
     request.set_tid(tid);
@@ -908,6 +958,50 @@ std::shared_ptr<openmldb::base::TraverseKvIterator> TabletClient::Traverse(uint3
     return std::make_shared<openmldb::base::TraverseKvIterator>(response);
 }
 
+bool TabletClient::AsyncTraverse(const ::openmldb::api::TraverseRequest& request,
+                                 openmldb::RpcCallback<openmldb::api::TraverseResponse>* callback) {
+    if (callback == nullptr) {
+        return false;
+    }
+    return client_.SendRequest(&::openmldb::api::TabletServer_Stub::Traverse, callback->GetController().get(),
+                               &request, callback->GetResponse().get(), callback);
+}
+
+std::shared_ptr<StreamKvIterator> TabletClient::TraverseStream(uint32_t tid, uint32_t pid,
+                                                               const std::string& idx_name, const std::string& pk,
+                                                               uint64_t ts, uint32_t limit, bool skip_current_pk) {
+    ::openmldb::api::TraverseRequest request;
+    request.set_tid(tid);
+    request.set_pid(pid);
+    request.set_limit(limit);
+    if (!idx_name.empty()) {
+        request.set_idx_name(idx_name);
+    }
+    if (!pk.empty()) {
+        request.set_pk(pk);
+        request.set_ts(ts);
+    }
+    request.set_skip_current_pk(skip_current_pk);
+    auto it = std::make_shared<StreamKvIterator>(true, "", limit);
+    it->SetStartPosition(pk, ts);
+    brpc::Controller cntl;
+    cntl.set_timeout_ms(FLAGS_request_timeout_ms);
+    brpc::StreamId stream;
+    brpc::StreamOptions stream_options = it->GetStreamOptions();
+    if (brpc::StreamCreate(&stream, cntl, &stream_options) != 0) {
+        PDLOG(WARNING, "fail to create stream. tid %u pid %u", tid, pid);
+        return {};
+    }
+    it->SetStream(stream);
+    ::openmldb::api::TraverseResponse response;
+    bool ok = client_.SendRequest(&::openmldb::api::TabletServer_Stub::TraverseStream, &cntl, &request, &response);
+    if (!ok || response.code() != 0) {
+        return {};
+    }
+    it->Next();
+    return it;
+}
+
 bool TabletClient::SetMode(bool mode) {
     ::openmldb::api::SetModeRequest request;
     ::openmldb::api::GeneralResponse response;
@@ -1162,6 +1256,15 @@ bool TabletClient::AsyncScan(const ::openmldb::api::ScanRequest& request,
                                callback->GetResponse().get(), callback);
 }
 
+bool TabletClient::AsyncMultiGet(const ::openmldb::api::MultiGetRequest& request,
+                                 openmldb::RpcCallback<openmldb::api::MultiGetResponse>* callback) {
+    if (callback == nullptr) {
+        return false;
+    }
+    return client_.SendRequest(&::openmldb::api::TabletServer_Stub::MultiGet, callback->GetController().get(),
+                               &request, callback->GetResponse().get(), callback);
+}
+
 bool TabletClient::Scan(const ::openmldb::api::ScanRequest& request, brpc::Controller* cntl,
                         ::openmldb::api::ScanResponse* response) {
     bool ok = client_.SendRequest(&::openmldb::api::TabletServer_Stub::Scan, cntl, &request, response);
@@ -28,6 +28,7 @@
 #include "base/status.h"
 #include "brpc/channel.h"
 #include "client/client.h"
+#include "client/stream_kv_iterator.h"
 #include "codec/schema_codec.h"
 #include "proto/tablet.pb.h"
 #include "rpc/rpc_client.h"
@@ -83,6 +84,8 @@ class TabletClient : public Client {
     bool Put(uint32_t tid, uint32_t pid, uint64_t time, const std::string& value,
              const std::vector<std::pair<std::string, uint32_t>>& dimensions);
 
+    bool PutBatch(const ::openmldb::api::PutBatchRequest& request, ::openmldb::api::PutBatchResponse* response);
+
     bool Get(uint32_t tid, uint32_t pid, const std::string& pk, uint64_t time, std::string& value,  // NOLINT
              uint64_t& ts,                                                                          // NOLINT
              std::string& msg);                        ;                                             // NOLINT
@@ -118,6 +121,16 @@ class TabletClient : public Client {
     bool AsyncScan(const ::openmldb::api::ScanRequest& request,
                    openmldb::RpcCallback<openmldb::api::ScanResponse>* callback);
 
+    // the rows of all the keys are in the response attachment of the controller, see MultiGetResult
+    bool AsyncMultiGet(const ::openmldb::api::MultiGetRequest& request,
+                       openmldb::RpcCallback<openmldb::api::MultiGetResponse>* callback);
+
+    // scan at most limit rows by a stream, the tablet pushes them in chunks
+    std::shared_ptr<StreamKvIterator> ScanStream(uint32_t tid, uint32_t pid, const std::string& pk,
+                                                 const std::string& idx_name, uint64_t stime, uint64_t etime,
+                                                 uint32_t limit, uint32_t skip_record_num,
+                                                 std::string& msg);  // NOLINT
+
     bool GetTableSchema(uint32_t tid, uint32_t pid,
                         ::openmldb::api::TableMeta& table_meta);  // NOLINT
 
@@ -198,6 +211,13 @@ class TabletClient : public Client {
             const std::string& idx_name, const std::string& pk, uint64_t ts,
             uint32_t limit, bool skip_current_pk, uint32_t& count);  // NOLINT
 
+    bool AsyncTraverse(const ::openmldb::api::TraverseRequest& request,
+                       openmldb::RpcCallback<openmldb::api::TraverseResponse>* callback);
+
+    std::shared_ptr<StreamKvIterator> TraverseStream(uint32_t tid, uint32_t pid, const std::string& idx_name,
+                                                     const std::string& pk, uint64_t ts, uint32_t limit,
+                                                     bool skip_current_pk);
+
     bool SetMode(bool mode);
 
     bool DeleteIndex(uint32_t tid, uint32_t pid, const std::string& idx_name, std::string* msg);
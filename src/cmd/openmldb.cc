@@ -256,6 +256,7 @@ void StartTablet() {
         exit(1);
     }
     server.MaxConcurrencyOf(tablet, "Put") = FLAGS_put_concurrency_limit;
+    server.MaxConcurrencyOf(tablet, "PutBatch") = FLAGS_put_concurrency_limit;
     server.MaxConcurrencyOf(tablet, "Get") = FLAGS_get_concurrency_limit;
     if (real_endpoint.empty()) {
         real_endpoint = FLAGS_endpoint;
@@ -53,12 +53,12 @@ bool DecodeRpcRow(const butil::IOBuf& buf, size_t offset, size_t size, size_t sl
                 row->Append(hybridse::base::RefCountedSlice());
             }
         } else {
-            int8_t* slice_buf = reinterpret_cast<int8_t*>(malloc(slice_size));
-            buf.copy_to(slice_buf, slice_size, cur_offset);
+            auto slice = hybridse::base::RefCountedSlice::Allocate(slice_size);
+            buf.copy_to(slice.buf(), slice_size, cur_offset);
             if (i == 0) {
-                *row = hybridse::codec::Row(hybridse::base::RefCountedSlice::CreateManaged(slice_buf, slice_size));
+                *row = hybridse::codec::Row(slice);
             } else {
-                row->Append(hybridse::base::RefCountedSlice::CreateManaged(slice_buf, slice_size));
+                row->Append(slice);
             }
         }
         cur_offset = next_offset;
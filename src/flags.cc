@@ -60,11 +60,40 @@ DEFINE_bool(use_name, false, "enable or disable use server name");
 DEFINE_string(data_dir, "./data", "the path of data dir");
 DEFINE_bool(enable_distsql, false, "enable or disable distribute sql");
 DEFINE_bool(enable_localtablet, true, "enable or disable local tablet opt when distribute sql circumstance");
+DEFINE_bool(enable_multi_get, true, "fetch the join keys of a batch request on a remote partition in one rpc");
+DEFINE_bool(enable_deploy_result_cache, false,
+            "cache the output rows of the deployments by the request rows until the keys read are updated");
+DEFINE_uint32(deploy_result_cache_capacity, 100000, "the max number of the output rows in the deploy result cache");
+DEFINE_uint32(deploy_result_cache_ttl_ms, 1000,
+              "the max age of a cached deploy result, which bounds the staleness of the rows on the other tablets");
+DEFINE_uint64(request_window_cache_rows, 0,
+              "the max number of the rows of the recent windows kept by a deployment, so the next request of a key "
+              "reads the rows put after its window only. 0 disables it");
+DEFINE_uint32(batch_window_agg_parallelism, 1,
+              "the number of the threads to run a window aggregation of a batch query, which split the partition keys");
+DEFINE_uint32(batch_sort_parallelism, 1,
+              "the number of the threads to sort a partition of a batch query, which split its segments");
+DEFINE_bool(enable_jit_object_cache, false,
+            "persist the compiled object code of sql under db_root_path, so a restarted tablet loads it instead of "
+            "compiling the deployments again");
+DEFINE_uint32(jit_object_cache_max_mb, 1024,
+              "the max total size of the persisted object code, the least recently used objects are removed beyond "
+              "it. 0 means no limit");
+DEFINE_bool(enable_tiered_jit, false,
+            "compile sql without optimization first and recompile the hot ones with aggressive optimization in "
+            "background");
+DEFINE_uint64(tiered_jit_threshold, 1000, "the number of calls to a jit function which triggers the recompiling");
 DEFINE_string(bucket_size, "1d", "the default bucket size in pre-aggr table");
 
 // scan configuration
 DEFINE_uint32(scan_max_bytes_size, 2 * 1024 * 1024, "config the max size of scan bytes size");
 DEFINE_uint32(scan_reserve_size, 1024, "config the size of vec reserve");
+DEFINE_bool(enable_stream_scan, false, "read the pages of the remote windows and tables by streaming scans in chunks");
+DEFINE_int32(stream_scan_pool_size, 8, "the thread num which pushes the rows of the streaming scans");
+DEFINE_uint32(stream_scan_chunk_size, 512 * 1024, "config the max bytes of the rows in a chunk of a streaming scan");
+DEFINE_uint32(stream_scan_window_size, 4 * 1024 * 1024,
+              "config the max bytes of a streaming scan sent but not acknowledged by the client");
+DEFINE_int32(stream_scan_idle_timeout_ms, 10000, "close a streaming scan if the client does not acknowledge it");
 DEFINE_uint32(preview_limit_max_num, 1000, "config the max num of preview limit");
 DEFINE_uint32(preview_default_limit, 100, "config the default limit of preview");
 // binlog configuration
@@ -78,6 +107,27 @@ DEFINE_int32(binlog_sync_to_disk_interval, 20000, "config the interval of sync b
 DEFINE_int32(binlog_delete_interval, 60000, "config the interval of delete binlog");
 DEFINE_int32(binlog_match_logoffset_interval, 1000, "config the interval of match log offset ");
 DEFINE_int32(binlog_name_length, 8, "binlog name length");
+DEFINE_bool(binlog_group_commit, false,
+            "if true, an append returns after its binlog entry is synced to disk, and the entries of the concurrent "
+            "appends are written and synced in groups");
+DEFINE_uint32(binlog_group_commit_max_batch, 256, "the max number of binlog entries written and synced in a group");
+DEFINE_uint32(binlog_group_commit_max_delay_us, 0,
+              "the max time in microseconds the first append of a group waits for more entries to join it");
+DEFINE_uint32(binlog_sync_pipeline_depth, 1,
+              "the max number of in-flight append entries requests to a follower. 1 sends a request after the "
+              "previous one is acknowledged. the followers should be upgraded before it is set greater than 1");
+DEFINE_int32(binlog_sync_max_batch_size, 1024,
+             "the max number of entries of a request if the pipeline is enabled. the batch size grows from "
+             "binlog_sync_batch_size up to it while the requests are faster than binlog_sync_target_latency_ms");
+DEFINE_uint32(binlog_sync_max_batch_bytes, 4 * 1024 * 1024,
+              "the max bytes of the entries of a request if the pipeline is enabled");
+DEFINE_uint32(binlog_sync_target_latency_ms, 20, "the target latency of a request if the pipeline is enabled");
+DEFINE_bool(binlog_sync_raw_entries, false,
+            "if true and the pipeline is enabled, send the binlog records to followers without parsing and "
+            "serializing them again");
+DEFINE_uint32(binlog_sync_reorder_wait_ms, 1000,
+              "the max time in milliseconds a follower holds a pipelined append entries request which arrives "
+              "before the previous one");
 DEFINE_uint32(check_binlog_sync_progress_delta, 100000, "config the delta of check binlog sync progress");
 DEFINE_uint32(go_back_max_try_cnt, 10, "config max try time of go back");
 
@@ -97,6 +147,9 @@ DEFINE_int32(request_sleep_time, 1000, "the sleep time when request error");
 
 DEFINE_uint32(max_traverse_cnt, 50000, "max traverse iter loop cnt");
 DEFINE_uint32(traverse_cnt_limit, 1000, "limit traverse cnt");
+DEFINE_bool(enable_remote_prefetch, true, "fetch the next page of a remote window or partition in background");
+DEFINE_uint32(remote_fetch_max_cnt_limit, 16000,
+              "the max rows of a page fetched from a remote partition, the pages grow from traverse_cnt_limit to it");
 DEFINE_string(ssd_root_path, "", "the root ssd path of db");
 DEFINE_string(hdd_root_path, "", "the root hdd path of db");
 
@@ -118,6 +171,10 @@ DEFINE_uint32(make_snapshot_offline_interval, 60 * 60 * 24,
               "makesnapshot from ns. unit is second");
 DEFINE_string(snapshot_compression, "off", "Type of snapshot compression, can be off, snappy, zlib");
 DEFINE_int32(snapshot_pool_size, 1, "the size of tablet thread pool for making snapshot");
+DEFINE_uint32(make_snapshot_thread_num, 4, "the number of threads to parse and filter records in making snapshot");
+DEFINE_uint32(snapshot_part_num, 1,
+              "the number of files a snapshot of memory table is split into, the parts are written and loaded in "
+              "parallel");
 
 DEFINE_uint32(load_index_max_wait_time, 120 * 60 * 1000, "config the max wait time of load index");
 
@@ -130,9 +187,15 @@ DEFINE_uint32(recycle_ttl, 0, "ttl of recycle in minute");
 DEFINE_uint32(latest_ttl_max, 1000, "the max ttl of latest");
 DEFINE_uint32(absolute_ttl_max, 60 * 24 * 365 * 30, "the max ttl of absolute time");
 DEFINE_uint32(skiplist_max_height, 12, "the max height of skiplist");
+DEFINE_uint32(skiplist_branch, 4,
+              "the branch factor of skiplist in memory table, a node is promoted to the upper level "
+              "with the probability of 1/branch");
 DEFINE_uint32(key_entry_max_height, 8, "the max height of key entry");
+DEFINE_bool(enable_concurrent_put, true,
+            "insert into the skiplists of memory table by CAS so the puts to one segment run in parallel");
 DEFINE_uint32(latest_default_skiplist_height, 1, "the default height of skiplist for latest table");
 DEFINE_uint32(absolute_default_skiplist_height, 4, "the default height of skiplist for absolute table");
+DEFINE_bool(enable_segment_slab, false, "allocate pk, skiplist node and row of memory table from slabs of segment");
 DEFINE_bool(enable_show_tp, false, "enable show tp");
 DEFINE_uint32(max_col_display_length, 256, "config the max length of column display");
 
@@ -145,11 +208,19 @@ DEFINE_uint32(block_cache_mb, 4096,
 DEFINE_uint32(write_buffer_mb, 128, "Memtable size");
 DEFINE_uint32(block_cache_shardbits, 8, "Divide block cache into 2^8 shards to avoid cache contention");
 DEFINE_bool(verify_compression, false, "For debug");
+DEFINE_uint32(disk_bloom_bits_per_key, 10,
+              "Bits per key of the prefix bloom filter on the pk of disk tables, 0 disables the filter");
+DEFINE_bool(disk_partition_filters, true, "Partition the index and filter blocks of disk tables");
+DEFINE_bool(disk_pin_l0_filter_and_index, true, "Pin the filter and index blocks of L0 files of disk tables in cache");
+DEFINE_bool(disk_gc_by_compaction, false,
+            "Expire the data of disk tables only in compaction and skip the scan of the latest ttl in gc");
 
 // load table resouce control
 DEFINE_uint32(load_table_batch, 30, "set laod table batch size");
 DEFINE_uint32(load_table_thread_num, 3, "set load tabale thread pool size");
 DEFINE_uint32(load_table_queue_size, 1000, "set load tabale queue size");
+DEFINE_bool(recover_snapshot_with_mmap, false,
+            "mmap the uncompressed snapshot files and parse the records in place by several threads in recovery");
 
 // multiple data center
 DEFINE_uint32(get_replica_status_interval, 10000, "config the interval to sync replica cluster status time");
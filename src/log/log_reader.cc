@@ -430,6 +430,115 @@ unsigned int Reader::ReadPhysicalRecord(Slice* result, uint64_t& offset) {
     return type;
 }
 
+BlockRangeReader::BlockRangeReader(const char* data, uint64_t size, uint64_t begin, uint64_t end, bool checksum)
+    : data_(data), size_(size), end_(end), checksum_(checksum), pos_(begin) {}
+
+Status BlockRangeReader::ReadRecord(Slice* record, std::string* scratch) {
+    scratch->clear();
+    record->clear();
+    bool in_fragmented_record = false;
+    Slice fragment;
+    while (true) {
+        // the trailer of a block is too small for a header and filled with zero
+        if (kBlockSize - pos_ % kBlockSize < kHeaderSize) {
+            SkipToNextBlock();
+        }
+        if (!in_fragmented_record && pos_ >= end_) {
+            return Status::Eof();
+        }
+        uint64_t physical_record_offset = pos_;
+        const unsigned int record_type = ReadPhysicalRecord(&fragment);
+        switch (record_type) {
+            case kFullType:
+            case kFirstType:
+                if (physical_record_offset >= end_) {
+                    // the record belongs to the next range
+                    return Status::Eof();
+                }
+                if (in_fragmented_record && !scratch->empty()) {
+                    DEBUGLOG("partial record without end");
+                }
+                if (record_type == kFullType) {
+                    scratch->clear();
+                    *record = fragment;
+                    return Status::OK();
+                }
+                scratch->assign(fragment.data(), fragment.size());
+                in_fragmented_record = true;
+                break;
+
+            case kMiddleType:
+            case kLastType:
+                if (!in_fragmented_record) {
+                    // the tail of a record which starts in the previous range
+                    break;
+                }
+                scratch->append(fragment.data(), fragment.size());
+                if (record_type == kLastType) {
+                    *record = Slice(*scratch);
+                    return Status::OK();
+                }
+                break;
+
+            case kEof:
+                scratch->clear();
+                return Status::Eof();
+
+            case kBadRecord:
+                scratch->clear();
+                return Status::InvalidRecord(Slice("kBadRecord"));
+
+            default: {
+                char buf[40];
+                snprintf(buf, sizeof(buf), "unknown record type %u", record_type);
+                DEBUGLOG("%s", buf);
+                scratch->clear();
+                SkipToNextBlock();
+                return Status::InvalidRecord(Slice(buf, strlen(buf)));
+            }
+        }
+    }
+}
+
+unsigned int BlockRangeReader::ReadPhysicalRecord(Slice* result) {
+    if (pos_ + kHeaderSize > size_) {
+        return kEof;
+    }
+    const char* header = data_ + pos_;
+    const uint32_t a = static_cast<uint32_t>(header[4]) & 0xff;
+    const uint32_t b = static_cast<uint32_t>(header[5]) & 0xff;
+    const unsigned int type = header[6];
+    const uint32_t length = a | (b << 8);
+    if (pos_ % kBlockSize + kHeaderSize + length > kBlockSize || pos_ + kHeaderSize + length > size_) {
+        // the same as Reader, a truncated tail ends the log
+        DEBUGLOG("end of file at %lu, data length %u", pos_, length);
+        pos_ = size_;
+        return kEof;
+    }
+    if (checksum_) {
+        uint32_t expected_crc = Unmask(DecodeFixed32(header));
+        uint32_t actual_crc = Value(header + 6, 1 + length);
+        if (actual_crc != expected_crc) {
+            // the length may be corrupted, so drop the rest of the block
+            SkipToNextBlock();
+            PDLOG(WARNING, "bad record with crc");
+            return kBadRecord;
+        }
+    }
+    if (type == kEofType && length == 0) {
+        pos_ = size_;
+        return kEof;
+    }
+    if (type == kZeroType && length == 0) {
+        SkipToNextBlock();
+        PDLOG(WARNING, "bad record with zero type");
+        return kBadRecord;
+    }
+    pos_ += kHeaderSize + length;
+    *result = Slice(header + kHeaderSize, length);
+    return type;
+}
+
 LogReader::LogReader(LogParts* logs, const std::string& log_path, bool compressed) : log_path_(log_path) {
     sf_ = NULL;
     reader_ = NULL;
@@ -446,6 +555,15 @@ LogReader::~LogReader() {
 
 void LogReader::SetOffset(uint64_t start_offset) { start_offset_ = start_offset; }
 
+void LogReader::Reset(uint64_t start_offset) {
+    delete reader_;
+    reader_ = NULL;
+    delete sf_;
+    sf_ = NULL;
+    log_part_index_ = -1;
+    start_offset_ = start_offset;
+}
+
 void LogReader::GoBackToLastBlock() {
     if (sf_ == NULL || reader_ == NULL) {
         return;
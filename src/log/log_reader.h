@@ -147,6 +147,35 @@ class Reader {
     void operator=(const Reader&);
 };
 
+// Reads the records of an uncompressed log held in memory, e.g. a mmapped
+// file. Only the records whose first fragment starts in [begin, end) are
+// returned, so a log can be split at block boundaries and read by several
+// readers in parallel. A record in one fragment is returned in place.
+class BlockRangeReader {
+ public:
+    // begin and end must be multiples of kBlockSize
+    BlockRangeReader(const char* data, uint64_t size, uint64_t begin, uint64_t end, bool checksum);
+
+    // "*record" is valid until the next call or the next mutation to
+    // "*scratch" if the record is fragmented
+    Status ReadRecord(Slice* record, std::string* scratch);
+
+    BlockRangeReader(const BlockRangeReader&) = delete;
+    BlockRangeReader& operator=(const BlockRangeReader&) = delete;
+
+ private:
+    enum { kEof = kMaxRecordType + 1, kBadRecord = kMaxRecordType + 2 };
+
+    unsigned int ReadPhysicalRecord(Slice* result);
+    void SkipToNextBlock() { pos_ += kBlockSize - pos_ % kBlockSize; }
+
+    const char* const data_;
+    uint64_t const size_;
+    uint64_t const end_;
+    bool const checksum_;
+    uint64_t pos_;
+};
+
 typedef ::openmldb::base::Skiplist<uint32_t, uint64_t, ::openmldb::base::DefaultComparator> LogParts;
 
 class LogReader {
@@ -162,6 +191,9 @@ class LogReader {
     int GetEndLogIndex();
     uint64_t GetLastRecordEndOffset();
     void SetOffset(uint64_t start_offset);
+    // close the current log part, the next read starts from the log part
+    // which contains start_offset
+    void Reset(uint64_t start_offset);
     LogReader(const LogReader&) = delete;
     LogReader& operator=(const LogReader&) = delete;
 
@@ -388,6 +388,62 @@ TEST_F(LogWRTest, TestGoBack) {
     ASSERT_EQ("hello", value3.ToString());
 }
 
+TEST_F(LogWRTest, TestBlockRangeRead) {
+    if (compressed_) {
+        // only the uncompressed log is read in place
+        return;
+    }
+    std::string log_dir = "/tmp/" + GenRand() + "/";
+    ::openmldb::base::MkdirRecur(log_dir);
+    std::string fname = "test.log";
+    std::string full_path = log_dir + "/" + fname;
+    FILE* fd_w = fopen(full_path.c_str(), "ab+");
+    ASSERT_TRUE(fd_w != NULL);
+    WritableFile* wf = NewWritableFile(fname, fd_w);
+    Writer writer(FLAGS_snapshot_compression, wf);
+    std::vector<std::string> records;
+    for (int i = 0; i < 500; i++) {
+        // some records span several blocks and some fill the block trailer
+        uint32_t size = i % 50 == 0 ? 3 * kBlockSize : rand() % 600 + 1;  // NOLINT
+        records.push_back(std::string(size, static_cast<char>('a' + i % 26)) + std::to_string(i));
+        ASSERT_TRUE(writer.AddRecord(records.back()).ok());
+    }
+    ASSERT_TRUE(writer.EndLog().ok());
+    ASSERT_TRUE(wf->Flush().ok());
+    std::string data;
+    {
+        FILE* fd_r = fopen(full_path.c_str(), "rb");
+        ASSERT_TRUE(fd_r != NULL);
+        char buf[kBlockSize];
+        size_t n = 0;
+        while ((n = fread(buf, 1, sizeof(buf), fd_r)) > 0) {
+            data.append(buf, n);
+        }
+        fclose(fd_r);
+    }
+    uint64_t block_num = (data.size() + kBlockSize - 1) / kBlockSize;
+    for (uint64_t range_num : {1, 2, 3, 7, 64}) {
+        uint64_t blocks_per_range = (block_num + range_num - 1) / range_num;
+        std::vector<std::string> result;
+        for (uint64_t i = 0; i < range_num; i++) {
+            BlockRangeReader reader(data.data(), data.size(), i * blocks_per_range * kBlockSize,
+                                    (i + 1) * blocks_per_range * kBlockSize, true);
+            std::string scratch;
+            Slice value;
+            while (true) {
+                Status status = reader.ReadRecord(&value, &scratch);
+                if (status.IsEof()) {
+                    break;
+                }
+                ASSERT_TRUE(status.ok());
+                result.push_back(value.ToString());
+            }
+        }
+        ASSERT_EQ(records, result);
+    }
+    delete wf;
+}
+
 TEST_F(LogWRTest, TestInit) {
     std::string log_dir = "/tmp/" + GenRand() + "/";
     ::openmldb::base::MkdirRecur(log_dir);
@@ -45,7 +45,8 @@ Writer::Writer(const std::string& compress_type, WritableFile* dest)
       compress_type_(GetCompressType(compress_type)),
       header_size_(compress_type_ != kNoCompress ? kHeaderSizeForCompress : kHeaderSize),
       buffer_(nullptr),
-      compress_buf_(nullptr) {
+      compress_buf_(nullptr),
+      delay_flush_(false) {
     InitTypeCrc(type_crc_);
     if (compress_type_ != kNoCompress) {
         block_size_ = kCompressBlockSize;
@@ -64,7 +65,8 @@ Writer::Writer(const std::string& compress_type, WritableFile* dest, uint64_t de
       compress_type_(GetCompressType(compress_type)),
       header_size_(compress_type_ != kNoCompress ? kHeaderSizeForCompress : kHeaderSize),
       buffer_(nullptr),
-      compress_buf_(nullptr) {
+      compress_buf_(nullptr),
+      delay_flush_(false) {
     InitTypeCrc(type_crc_);
     if (compress_type_ != kNoCompress) {
         block_size_ = kCompressBlockSize;
@@ -180,6 +182,26 @@ Status Writer::AddRecord(const Slice& slice) {
     return s;
 }
 
+Status Writer::AddRecords(const std::vector<Slice>& slices) {
+    Status s;
+    // records of one batch are flushed together instead of once per record
+    delay_flush_ = true;
+    for (const auto& slice : slices) {
+        s = AddRecord(slice);
+        if (!s.ok()) {
+            break;
+        }
+    }
+    delay_flush_ = false;
+    if (s.ok()) {
+        s = dest_->Flush();
+        if (!s.ok()) {
+            PDLOG(WARNING, "write error. %s", s.ToString().c_str());
+        }
+    }
+    return s;
+}
+
 Status Writer::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n) {
     if (compress_type_ == kNoCompress) {
         assert(n <= 0xffff);  // Must fit in two bytes
@@ -211,7 +233,7 @@ Status Writer::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n) {
         Status s = dest_->Append(Slice(buf, header_size_));
         if (s.ok()) {
             s = dest_->Append(Slice(ptr, n));
-            if (s.ok()) {
+            if (s.ok() && !delay_flush_) {
                 s = dest_->Flush();
             }
         }
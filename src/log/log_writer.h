@@ -24,6 +24,7 @@
 #include <stdint.h>
 
 #include <string>
+#include <vector>
 
 #include "base/slice.h"
 #include "log/status.h"
@@ -50,6 +51,8 @@ class Writer {
     ~Writer();
 
     Status AddRecord(const Slice& slice);
+    // Append several records and flush them to the file once
+    Status AddRecords(const std::vector<Slice>& slices);
     Status EndLog();
 
     inline CompressType GetCompressType() { return compress_type_; }
@@ -76,6 +79,8 @@ class Writer {
     char* buffer_;
     // buffer for compressed block
     char* compress_buf_;
+    // skip the flush of every physical record while writing a batch
+    bool delay_flush_;
     Status CompressRecord();
     Status AppendInternal(WritableFile* wf, int leftover);
 
@@ -98,6 +103,8 @@ struct WriteHandle {
 
     Status Write(const ::openmldb::base::Slice& slice) { return lw_->AddRecord(slice); }
 
+    Status Write(const std::vector<::openmldb::base::Slice>& slices) { return lw_->AddRecords(slices); }
+
     Status Sync() { return wf_->Sync(); }
 
     Status EndLog() { return lw_->EndLog(); }
@@ -10700,6 +10700,10 @@ void NameServerImpl::SyncDeployStats() {
                            statistics::ParseDurationFromStr(r.time(), statistics::TimeUnit::MICRO_SECOND), r.count(),
                            statistics::ParseDurationFromStr(r.total(), statistics::TimeUnit::MICRO_SECOND));
         }
+        for (auto& c : res.cache_stats()) {
+            LOG(INFO) << "deploy result cache of " << c.deploy_name() << " on " << client.first << ": hit " << c.hit()
+                      << ", miss " << c.miss();
+        }
     }
 
     // Step three: Query old deploy response time from table
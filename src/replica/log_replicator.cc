@@ -30,11 +30,15 @@
 #include "base/file_util.h"
 #include "base/glog_wapper.h"  // NOLINT
 #include "base/strings.h"
+#include "common/timer.h"
 #include "log/log_format.h"
 #include "storage/segment.h"
 
 DECLARE_int32(binlog_single_file_max_size);
 DECLARE_int32(binlog_name_length);
+DECLARE_bool(binlog_group_commit);
+DECLARE_uint32(binlog_group_commit_max_batch);
+DECLARE_uint32(binlog_group_commit_max_delay_us);
 DECLARE_string(zk_cluster);
 
 namespace openmldb {
@@ -59,7 +63,12 @@ LogReplicator::LogReplicator(uint32_t tid, uint32_t pid, const std::string& path
       term_(0),
       mu_(),
       cv_(),
-      wmu_() {
+      wmu_(),
+      commit_mu_(),
+      commit_cv_(),
+      commit_queue_(),
+      apply_mu_(),
+      apply_cv_() {
     binlog_index_ = 0;
     snapshot_log_part_index_.store(-1, std::memory_order_relaxed);
     snapshot_last_offset_.store(0, std::memory_order_relaxed);
@@ -281,7 +290,7 @@ void LogReplicator::DeleteBinlog(bool* deleted) {
             }
             PDLOG(INFO, "delete binlog[%s] success", full_path.c_str());
         }
-        delete tmp_node;
+        ::openmldb::base::DeleteNode(tmp_node, NULL);
     }
 }
 
@@ -316,6 +325,21 @@ bool LogReplicator::ApplyEntry(const LogEntry& entry) {
     return true;
 }
 
+bool LogReplicator::LockForApply(uint64_t pre_log_index, uint32_t timeout_ms, ApplyLock* lock) {
+    std::unique_lock<bthread::Mutex> apply_lock(apply_mu_);
+    int64_t deadline_us = ::baidu::common::timer::get_micros() + static_cast<int64_t>(timeout_ms) * 1000;
+    while (GetOffset() < pre_log_index) {
+        int64_t wait_us = deadline_us - ::baidu::common::timer::get_micros();
+        if (wait_us <= 0) {
+            return false;
+        }
+        apply_cv_.wait_for(apply_lock, wait_us);
+    }
+    lock->lock_ = std::move(apply_lock);
+    lock->cv_ = &apply_cv_;
+    return true;
+}
+
 int LogReplicator::AddReplicateNode(const std::map<std::string, std::string>& real_ep_map) {
     return AddReplicateNode(real_ep_map, UINT32_MAX);
 }
@@ -398,18 +422,77 @@ int LogReplicator::DelReplicateNode(const std::string& endpoint) {
     return 0;
 }
 
-void LogReplicator::GetReplicateInfo(std::map<std::string, uint64_t>& info_map) {
-    std::lock_guard<bthread::Mutex> lock(mu_);
-    if (role_ != kLeaderNode) {
-        DEBUGLOG("cur table is not leader");
-        return;
+void LogReplicator::GetReplicateInfo(std::map<std::string, ReplicateInfo>& info_map) {
+    // the positions of the nodes, the lag bytes are counted out of mu_ since they stat the binlog files
+    struct NodePosition {
+        std::string endpoint;
+        uint64_t offset;
+        int log_part_index;
+        uint64_t log_part_offset;
+    };
+    std::vector<NodePosition> positions;
+    uint64_t log_offset = 0;
+    {
+        std::lock_guard<bthread::Mutex> lock(mu_);
+        if (role_ != kLeaderNode) {
+            DEBUGLOG("cur table is not leader");
+            return;
+        }
+        if (nodes_.empty()) {
+            return;
+        }
+        log_offset = log_offset_.load(std::memory_order_relaxed);
+        positions.reserve(nodes_.size());
+        for (const auto& node : nodes_) {
+            NodePosition position;
+            position.endpoint = node->GetEndPoint();
+            position.offset = node->GetLastSyncOffset();
+            position.log_part_index = -1;
+            position.log_part_offset = 0;
+            node->GetSyncPosition(&position.log_part_index, &position.log_part_offset);
+            positions.push_back(position);
+        }
     }
-    if (nodes_.empty()) {
-        return;
+    for (const auto& position : positions) {
+        ReplicateInfo info;
+        info.offset = position.offset;
+        if (log_offset > info.offset) {
+            info.lag_entries = log_offset - info.offset;
+            info.lag_bytes = GetLagBytes(info.offset, position.log_part_index, position.log_part_offset);
+        }
+        info_map.insert(std::make_pair(position.endpoint, info));
+    }
+}
+
+uint64_t LogReplicator::GetLagBytes(uint64_t offset, int log_part_index, uint64_t log_part_offset) {
+    if (log_part_index < 0) {
+        // the node has not acknowledged any entry since the leader started, count from the log part of its offset
+        LogParts::Iterator* it = logs_->NewIterator();
+        it->SeekToFirst();
+        while (it->Valid()) {
+            if (it->GetValue() <= offset) {
+                log_part_index = static_cast<int>(it->GetKey());
+                break;
+            }
+            it->Next();
+        }
+        delete it;
+        if (log_part_index < 0) {
+            return 0;
+        }
+        log_part_offset = 0;
     }
-    for (const auto& node : nodes_) {
-        info_map.insert(std::make_pair(node->GetEndPoint(), node->GetLastSyncOffset()));
+    uint64_t bytes = 0;
+    uint32_t binlog_index = binlog_index_.load(std::memory_order_relaxed);
+    for (uint32_t index = static_cast<uint32_t>(log_part_index); index < binlog_index; index++) {
+        std::string full_path =
+            log_path_ + "/" + ::openmldb::base::FormatToString(index, FLAGS_binlog_name_length) + ".log";
+        uint64_t size = 0;
+        if (::openmldb::base::GetFileSize(full_path, size)) {
+            bytes += size;
+        }
     }
+    return bytes > log_part_offset ? bytes - log_part_offset : 0;
 }
 
 bool LogReplicator::DelAllReplicateNode() {
@@ -434,6 +517,11 @@ bool LogReplicator::DelAllReplicateNode() {
 }
 
 bool LogReplicator::AppendEntry(LogEntry& entry) {
+    if (FLAGS_binlog_group_commit) {
+        GroupCommitRequest request;
+        request.entries.push_back(&entry);
+        return GroupCommit(&request);
+    }
     std::lock_guard<std::mutex> lock(wmu_);
     if (wh_ == NULL || wh_->GetSize() / (1024 * 1024) > (uint32_t)FLAGS_binlog_single_file_max_size) {
         bool ok = RollWLogFile();
@@ -459,6 +547,127 @@ bool LogReplicator::AppendEntry(LogEntry& entry) {
     return true;
 }
 
+bool LogReplicator::AppendEntryBatch(std::vector<LogEntry>* entries) {
+    if (entries == nullptr || entries->empty()) {
+        return true;
+    }
+    if (FLAGS_binlog_group_commit) {
+        GroupCommitRequest request;
+        for (auto& entry : *entries) {
+            request.entries.push_back(&entry);
+        }
+        return GroupCommit(&request);
+    }
+    std::lock_guard<std::mutex> lock(wmu_);
+    if (wh_ == NULL || wh_->GetSize() / (1024 * 1024) > (uint32_t)FLAGS_binlog_single_file_max_size) {
+        bool ok = RollWLogFile();
+        if (!ok) {
+            return false;
+        }
+    }
+    uint64_t cur_offset = log_offset_.load(std::memory_order_relaxed);
+    std::vector<std::string> buffers(entries->size());
+    std::vector<::openmldb::base::Slice> slices;
+    slices.reserve(entries->size());
+    for (size_t i = 0; i < entries->size(); i++) {
+        LogEntry& entry = (*entries)[i];
+        entry.set_log_index(cur_offset + i + 1);
+        entry.SerializeToString(&buffers[i]);
+        slices.emplace_back(buffers[i]);
+    }
+    ::openmldb::log::Status status = wh_->Write(slices);
+    if (!status.ok()) {
+        PDLOG(WARNING, "fail to write replication log in dir %s for %s", path_.c_str(), status.ToString().c_str());
+        return false;
+    }
+    log_offset_.fetch_add(entries->size(), std::memory_order_relaxed);
+    if (local_endpoints_.empty()) {
+        follower_offset_.store(cur_offset + entries->size(), std::memory_order_relaxed);
+    }
+    return true;
+}
+
+bool LogReplicator::GroupCommit(GroupCommitRequest* request) {
+    std::unique_lock<bthread::Mutex> lock(commit_mu_);
+    commit_queue_.push_back(request);
+    if (commit_queue_.size() >= FLAGS_binlog_group_commit_max_batch) {
+        // wake up the first append if it waits for more entries
+        commit_cv_.notify_all();
+    }
+    while (!request->done && request != commit_queue_.front()) {
+        commit_cv_.wait(lock);
+    }
+    if (request->done) {
+        return request->ok;
+    }
+    // this append is the first one of the queue, it writes and syncs a group for the others
+    if (FLAGS_binlog_group_commit_max_delay_us > 0 && commit_queue_.size() < FLAGS_binlog_group_commit_max_batch) {
+        commit_cv_.wait_for(lock, FLAGS_binlog_group_commit_max_delay_us);
+    }
+    std::vector<GroupCommitRequest*> group;
+    uint64_t entry_cnt = 0;
+    for (auto iter = commit_queue_.begin(); iter != commit_queue_.end(); iter++) {
+        if (!group.empty() && entry_cnt + (*iter)->entries.size() > FLAGS_binlog_group_commit_max_batch) {
+            break;
+        }
+        group.push_back(*iter);
+        entry_cnt += (*iter)->entries.size();
+    }
+    // the group stays at the front of the queue while writing, so the later appends wait for it
+    lock.unlock();
+    bool ok = WriteGroup(group);
+    lock.lock();
+    for (auto req : group) {
+        req->ok = ok;
+        req->done = true;
+        commit_queue_.pop_front();
+    }
+    commit_cv_.notify_all();
+    return ok;
+}
+
+bool LogReplicator::WriteGroup(const std::vector<GroupCommitRequest*>& group) {
+    std::lock_guard<std::mutex> lock(wmu_);
+    if (wh_ == NULL || wh_->GetSize() / (1024 * 1024) > (uint32_t)FLAGS_binlog_single_file_max_size) {
+        bool ok = RollWLogFile();
+        if (!ok) {
+            return false;
+        }
+    }
+    uint64_t cur_offset = log_offset_.load(std::memory_order_relaxed);
+    uint64_t entry_cnt = 0;
+    for (auto request : group) {
+        entry_cnt += request->entries.size();
+    }
+    std::vector<std::string> buffers(entry_cnt);
+    std::vector<::openmldb::base::Slice> slices;
+    slices.reserve(entry_cnt);
+    size_t pos = 0;
+    for (auto request : group) {
+        for (auto entry : request->entries) {
+            entry->set_log_index(cur_offset + pos + 1);
+            entry->SerializeToString(&buffers[pos]);
+            slices.emplace_back(buffers[pos]);
+            pos++;
+        }
+    }
+    ::openmldb::log::Status status = wh_->Write(slices);
+    if (!status.ok()) {
+        PDLOG(WARNING, "fail to write replication log in dir %s for %s", path_.c_str(), status.ToString().c_str());
+        return false;
+    }
+    log_offset_.fetch_add(entry_cnt, std::memory_order_relaxed);
+    if (local_endpoints_.empty()) {
+        follower_offset_.store(cur_offset + entry_cnt, std::memory_order_relaxed);
+    }
+    status = wh_->Sync();
+    if (!status.ok()) {
+        PDLOG(WARNING, "fail to sync replication log in dir %s for %s", path_.c_str(), status.ToString().c_str());
+        return false;
+    }
+    return true;
+}
+
 bool LogReplicator::RollWLogFile() {
     if (wh_ != NULL) {
         wh_->EndLog();
@@ -19,6 +19,7 @@
 
 #include <atomic>
 #include <condition_variable>  // NOLINT
+#include <deque>
 #include <map>
 #include <memory>
 #include <mutex>  // NOLINT
@@ -48,6 +49,32 @@ using ::openmldb::storage::Table;
 
 enum ReplicatorRole { kLeaderNode = 1, kFollowerNode };
 
+struct ReplicateInfo {
+    uint64_t offset = 0;
+    // the entries and the binlog bytes the node is behind the leader
+    uint64_t lag_entries = 0;
+    uint64_t lag_bytes = 0;
+};
+
+// the apply lock of a follower, see LogReplicator::LockForApply. the waiting requests are woken when it is
+// released
+class ApplyLock {
+ public:
+    ApplyLock() : lock_(), cv_(nullptr) {}
+    ~ApplyLock() { Unlock(); }
+    void Unlock() {
+        if (lock_.owns_lock()) {
+            lock_.unlock();
+            cv_->notify_all();
+        }
+    }
+
+ private:
+    friend class LogReplicator;
+    std::unique_lock<bthread::Mutex> lock_;
+    bthread::ConditionVariable* cv_;
+};
+
 class LogReplicator {
  public:
     LogReplicator(uint32_t tid, uint32_t pid, const std::string& path,
@@ -63,9 +90,17 @@ class LogReplicator {
     // the slave node receives master log entries
     bool ApplyEntry(const ::openmldb::api::LogEntry& entry);
 
-    // the master node append entry
+    // the slave node handles the pipelined append entries requests on different bthreads, so a request may arrive
+    // before the previous one. it waits up to timeout_ms for the binlog to reach pre_log_index, then holds `lock`
+    // so the requests are applied one by one in order. it returns false on timeout
+    bool LockForApply(uint64_t pre_log_index, uint32_t timeout_ms, ApplyLock* lock);
+
+    // the master node append entry, it returns after the entry is synced to disk if binlog_group_commit is on
     bool AppendEntry(::openmldb::api::LogEntry& entry);  // NOLINT
 
+    // the master node append a group of entries with continuous log index
+    bool AppendEntryBatch(std::vector<::openmldb::api::LogEntry>* entries);
+
     //  data to slave nodes
     void Notify();
     // recover logs meta
@@ -82,7 +117,7 @@ class LogReplicator {
 
     int DelReplicateNode(const std::string& endpoint);
 
-    void GetReplicateInfo(std::map<std::string, uint64_t>& info_map);  // NOLINT
+    void GetReplicateInfo(std::map<std::string, ReplicateInfo>& info_map);  // NOLINT
 
     void MatchLogOffset();
 
@@ -111,8 +146,25 @@ class LogReplicator {
     const std::string& GetLogPath() {return log_path_;}
 
  private:
+    // the entries of an append waiting to be written and synced by the first append of its group
+    struct GroupCommitRequest {
+        std::vector<::openmldb::api::LogEntry*> entries;
+        bool done = false;
+        bool ok = false;
+    };
+
     bool OpenSeqFile(const std::string& path, SequentialFile** sf);
 
+    // the binlog bytes after the position of a node. the position is unknown if log_part_index is negative,
+    // then the bytes are counted from the start of the log part which contains offset. it stats the binlog files,
+    // so it should not be called under mu_
+    uint64_t GetLagBytes(uint64_t offset, int log_part_index, uint64_t log_part_offset);
+
+    bool GroupCommit(GroupCommitRequest* request);
+
+    // write the entries of a group with one write and sync them with one fdatasync
+    bool WriteGroup(const std::vector<GroupCommitRequest*>& group);
+
  private:
     // the replicator root data path
     uint32_t tid_;
@@ -139,6 +191,15 @@ class LogReplicator {
     std::atomic<uint64_t> snapshot_last_offset_;
 
     std::mutex wmu_;
+
+    // the appends waiting for group commit, the ones at the front are being written
+    bthread::Mutex commit_mu_;
+    bthread::ConditionVariable commit_cv_;
+    std::deque<GroupCommitRequest*> commit_queue_;
+
+    // held by the follower while applying a request, see LockForApply
+    bthread::Mutex apply_mu_;
+    bthread::ConditionVariable apply_cv_;
 };
 
 }  // namespace replica
@@ -16,7 +16,9 @@
 
 #include "replica/log_replicator.h"
 
+#include <brpc/callback.h>
 #include <brpc/server.h>
+#include <gflags/gflags.h>
 #include <gtest/gtest.h>
 #include <sched.h>
 #include <stdio.h>
@@ -24,7 +26,10 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
 #include <utility>
+#include <vector>
 
 #include "base/glog_wapper.h"
 #include "base/status.h"
@@ -46,6 +51,14 @@ using ::openmldb::storage::Table;
 using ::openmldb::storage::TableIterator;
 using ::openmldb::storage::Ticket;
 
+DECLARE_bool(binlog_group_commit);
+DECLARE_uint32(binlog_group_commit_max_batch);
+DECLARE_uint32(binlog_group_commit_max_delay_us);
+DECLARE_int32(binlog_sync_batch_size);
+DECLARE_uint32(binlog_sync_pipeline_depth);
+DECLARE_bool(binlog_sync_raw_entries);
+DECLARE_uint32(binlog_sync_reorder_wait_ms);
+
 namespace openmldb {
 namespace replica {
 
@@ -82,12 +95,24 @@ class MockTabletImpl : public ::openmldb::api::TabletServer {
 
     void AppendEntries(RpcController* controller, const ::openmldb::api::AppendEntriesRequest* request,
                        ::openmldb::api::AppendEntriesResponse* response, Closure* done) {
+        ApplyLock apply_lock;
+        if (!replicator_.LockForApply(request->pre_log_index(), FLAGS_binlog_sync_reorder_wait_ms, &apply_lock)) {
+            response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
+            response->set_log_offset(replicator_.GetOffset());
+            done->Run();
+            return;
+        }
         uint64_t last_log_offset = replicator_.GetOffset();
-        for (int32_t i = 0; i < request->entries_size(); i++) {
-            if (request->entries(i).log_index() <= last_log_offset) {
+        int32_t entry_cnt = request->entries_size() > 0 ? request->entries_size() : request->raw_entries_size();
+        ::openmldb::api::LogEntry raw_entry;
+        for (int32_t i = 0; i < entry_cnt; i++) {
+            if (request->entries_size() == 0) {
+                raw_entry.ParseFromString(request->raw_entries(i));
+            }
+            const auto& entry = request->entries_size() > 0 ? request->entries(i) : raw_entry;
+            if (entry.log_index() <= last_log_offset) {
                 continue;
             }
-            const auto& entry = request->entries(i);
             if (!replicator_.ApplyEntry(entry)) {
                 response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
                 response->set_msg("fail to append entries to replicator");
@@ -96,10 +121,13 @@ class MockTabletImpl : public ::openmldb::api::TabletServer {
             table_->Put(entry);
         }
         response->set_log_offset(replicator_.GetOffset());
+        apply_lock.Unlock();
         done->Run();
         replicator_.Notify();
     }
 
+    uint64_t GetOffset() { return replicator_.GetOffset(); }
+
     void SetMode(bool follower) { follower_.store(follower); }
 
     bool GetMode() { return follower_.load(std::memory_order_relaxed); }
@@ -147,6 +175,100 @@ TEST_F(LogReplicatorTest, BenchMark) {
     ASSERT_TRUE(ok);
 }
 
+TEST_F(LogReplicatorTest, GroupCommit) {
+    FLAGS_binlog_group_commit = true;
+    FLAGS_binlog_group_commit_max_batch = 16;
+    FLAGS_binlog_group_commit_max_delay_us = 100;
+    std::map<std::string, std::string> map;
+    std::string folder = "/tmp/" + GenRand() + "/";
+    LogReplicator replicator(1, 1, folder, map, kLeaderNode);
+    ASSERT_TRUE(replicator.Init());
+    uint32_t thread_num = 8;
+    uint32_t append_num = 200;
+    std::atomic<uint32_t> failed_cnt(0);
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < thread_num; i++) {
+        threads.emplace_back([&replicator, &failed_cnt, append_num, i] {
+            for (uint32_t j = 0; j < append_num; j++) {
+                if (j % 10 == 0) {
+                    std::vector<::openmldb::api::LogEntry> entries(3);
+                    for (auto& entry : entries) {
+                        entry.set_pk("key" + std::to_string(i));
+                        entry.set_value("value");
+                        entry.set_ts(j);
+                    }
+                    if (!replicator.AppendEntryBatch(&entries)) {
+                        failed_cnt++;
+                    }
+                    continue;
+                }
+                ::openmldb::api::LogEntry entry;
+                entry.set_pk("key" + std::to_string(i));
+                entry.set_value("value");
+                entry.set_ts(j);
+                if (!replicator.AppendEntry(entry)) {
+                    failed_cnt++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    FLAGS_binlog_group_commit = false;
+    ASSERT_EQ(0u, failed_cnt.load());
+    uint64_t total = thread_num * (append_num + append_num / 10 * 2);
+    ASSERT_EQ(total, replicator.GetOffset());
+    // the entries are written with continuous log index
+    ::openmldb::log::LogReader log_reader(replicator.GetLogPart(), replicator.GetLogPath(), false);
+    log_reader.SetOffset(0);
+    uint64_t expect_index = 1;
+    std::string buffer;
+    ::openmldb::base::Slice record;
+    while (log_reader.ReadNextRecord(&record, &buffer).ok()) {
+        ::openmldb::api::LogEntry entry;
+        ASSERT_TRUE(entry.ParseFromString(record.ToString()));
+        ASSERT_EQ(expect_index, entry.log_index());
+        expect_index++;
+    }
+    ASSERT_EQ(total + 1, expect_index);
+}
+
+TEST_F(LogReplicatorTest, LogReaderReset) {
+    std::map<std::string, std::string> map;
+    std::string folder = "/tmp/" + GenRand() + "/";
+    LogReplicator replicator(1, 1, folder, map, kLeaderNode);
+    ASSERT_TRUE(replicator.Init());
+    for (int i = 0; i < 100; i++) {
+        ::openmldb::api::LogEntry entry;
+        entry.set_pk("key");
+        entry.set_value("value");
+        entry.set_ts(i);
+        ASSERT_TRUE(replicator.AppendEntry(entry));
+    }
+    replicator.SyncToDisk();
+    ::openmldb::log::LogReader log_reader(replicator.GetLogPart(), replicator.GetLogPath(), false);
+    log_reader.SetOffset(0);
+    std::string buffer;
+    ::openmldb::base::Slice record;
+    for (uint64_t expect_index = 1; expect_index <= 60; expect_index++) {
+        ASSERT_TRUE(log_reader.ReadNextRecord(&record, &buffer).ok());
+        ::openmldb::api::LogEntry entry;
+        ASSERT_TRUE(entry.ParseFromString(record.ToString()));
+        ASSERT_EQ(expect_index, entry.log_index());
+    }
+    // read again from the log part which contains the offset
+    log_reader.Reset(30);
+    uint64_t last_index = 0;
+    while (log_reader.ReadNextRecord(&record, &buffer).ok()) {
+        ::openmldb::api::LogEntry entry;
+        ASSERT_TRUE(entry.ParseFromString(record.ToString()));
+        ASSERT_EQ(last_index + 1, entry.log_index());
+        last_index = entry.log_index();
+    }
+    ASSERT_EQ(100u, last_index);
+}
+
 TEST_F(LogReplicatorTest, LeaderAndFollowerMulti) {
     brpc::ServerOptions options;
     brpc::Server server0;
@@ -300,6 +422,113 @@ TEST_F(LogReplicatorTest, LeaderAndFollowerMulti) {
     }
 }
 
+TEST_F(LogReplicatorTest, LeaderAndFollowerPipeline) {
+    FLAGS_binlog_sync_batch_size = 8;
+    FLAGS_binlog_sync_pipeline_depth = 4;
+    FLAGS_binlog_sync_raw_entries = true;
+    brpc::ServerOptions options;
+    brpc::Server server;
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx", 0));
+    std::shared_ptr<MemTable> table =
+        std::make_shared<MemTable>("test", 1, 1, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    {
+        std::string follower_addr = "127.0.0.1:17537";
+        std::string folder = "/tmp/" + GenRand() + "/";
+        MockTabletImpl* follower = new MockTabletImpl(kFollowerNode, folder, g_endpoints, table);
+        ASSERT_TRUE(follower->Init());
+        ASSERT_EQ(0, server.AddService(follower, brpc::SERVER_OWNS_SERVICE));
+        ASSERT_EQ(0, server.Start(follower_addr.c_str(), &options));
+    }
+    std::string folder = "/tmp/" + GenRand() + "/";
+    LogReplicator leader(1, 1, folder, g_endpoints, kLeaderNode);
+    ASSERT_TRUE(leader.Init());
+    uint32_t record_num = 500;
+    for (uint32_t i = 0; i < record_num; i++) {
+        ::openmldb::api::LogEntry entry;
+        std::string key = "key" + std::to_string(i % 10);
+        ::openmldb::test::AddDimension(0, key, &entry);
+        entry.set_value(::openmldb::test::EncodeKV(key, "value" + std::to_string(i)));
+        entry.set_ts(i + 1);
+        ASSERT_TRUE(leader.AppendEntry(entry));
+    }
+    std::map<std::string, std::string> map;
+    map.insert(std::make_pair("127.0.0.1:17537", ""));
+    ASSERT_EQ(0, leader.AddReplicateNode(map));
+    leader.Notify();
+    sleep(3);
+    std::map<std::string, ReplicateInfo> info_map;
+    leader.GetReplicateInfo(info_map);
+    leader.DelAllReplicateNode();
+    FLAGS_binlog_sync_batch_size = 32;
+    FLAGS_binlog_sync_pipeline_depth = 1;
+    FLAGS_binlog_sync_raw_entries = false;
+    ASSERT_EQ(record_num, table->GetRecordCnt());
+    ASSERT_EQ(1u, info_map.size());
+    ASSERT_EQ(record_num, info_map["127.0.0.1:17537"].offset);
+    ASSERT_EQ(0u, info_map["127.0.0.1:17537"].lag_entries);
+    ASSERT_EQ(0u, info_map["127.0.0.1:17537"].lag_bytes);
+}
+
+TEST_F(LogReplicatorTest, FollowerApplyOutOfOrder) {
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx", 0));
+    std::shared_ptr<MemTable> table =
+        std::make_shared<MemTable>("test", 1, 1, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    std::string folder = "/tmp/" + GenRand() + "/";
+    MockTabletImpl follower(kFollowerNode, folder, g_endpoints, table);
+    ASSERT_TRUE(follower.Init());
+    // 4 pipelined requests of 10 entries
+    uint32_t request_num = 4;
+    std::vector<::openmldb::api::AppendEntriesRequest> requests(request_num);
+    std::vector<::openmldb::api::AppendEntriesResponse> responses(request_num);
+    for (uint32_t i = 0; i < request_num; i++) {
+        requests[i].set_tid(1);
+        requests[i].set_pid(1);
+        requests[i].set_pre_log_index(i * 10);
+        for (uint32_t j = 1; j <= 10; j++) {
+            ::openmldb::api::LogEntry entry;
+            std::string key = "key" + std::to_string(j);
+            ::openmldb::test::AddDimension(0, key, &entry);
+            entry.set_value(::openmldb::test::EncodeKV(key, "value"));
+            entry.set_ts(i * 10 + j);
+            entry.set_log_index(i * 10 + j);
+            requests[i].add_raw_entries(entry.SerializeAsString());
+        }
+    }
+    // the requests arrive in the reverse order, the later ones wait for the earlier ones
+    std::vector<std::thread> threads;
+    for (uint32_t i = request_num; i > 0; i--) {
+        threads.emplace_back([&follower, &requests, &responses, i]() {
+            follower.AppendEntries(nullptr, &requests[i - 1], &responses[i - 1], brpc::DoNothing());
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (uint32_t i = 0; i < request_num; i++) {
+        ASSERT_EQ(::openmldb::base::ReturnCode::kOk, responses[i].code());
+        ASSERT_GE(responses[i].log_offset(), (i + 1) * 10);
+    }
+    ASSERT_EQ(request_num * 10, follower.GetOffset());
+    ASSERT_EQ(request_num * 10, table->GetRecordCnt());
+
+    // a request whose previous one never arrives is rejected once the wait times out
+    uint32_t wait_ms = FLAGS_binlog_sync_reorder_wait_ms;
+    FLAGS_binlog_sync_reorder_wait_ms = 10;
+    ::openmldb::api::AppendEntriesRequest request;
+    request.CopyFrom(requests[0]);
+    request.set_pre_log_index(request_num * 10 + 10);
+    ::openmldb::api::AppendEntriesResponse response;
+    follower.AppendEntries(nullptr, &request, &response, brpc::DoNothing());
+    FLAGS_binlog_sync_reorder_wait_ms = wait_ms;
+    ASSERT_EQ(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator, response.code());
+    ASSERT_EQ(request_num * 10, response.log_offset());
+}
+
 TEST_F(LogReplicatorTest, LeaderAndFollower) {
     brpc::ServerOptions options;
     brpc::Server server0;
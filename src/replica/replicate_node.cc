@@ -16,14 +16,23 @@
 
 #include "replica/replicate_node.h"
 
+#include <brpc/callback.h>
 #include <gflags/gflags.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
 
 #include <algorithm>
 
 #include "base/glog_wapper.h"  // NOLINT
 #include "base/strings.h"
+#include "common/timer.h"
 
 DECLARE_int32(binlog_sync_batch_size);
+DECLARE_int32(binlog_sync_max_batch_size);
+DECLARE_uint32(binlog_sync_max_batch_bytes);
+DECLARE_uint32(binlog_sync_pipeline_depth);
+DECLARE_uint32(binlog_sync_target_latency_ms);
+DECLARE_bool(binlog_sync_raw_entries);
 DECLARE_int32(binlog_sync_wait_time);
 DECLARE_int32(binlog_coffee_time);
 DECLARE_int32(binlog_match_logoffset_interval);
@@ -46,6 +55,26 @@ static void* RunSyncTask(void* args) {
     return NULL;
 }
 
+// read the log index of a serialized LogEntry without parsing the other fields
+static bool ParseLogIndex(const ::openmldb::base::Slice& record, uint64_t* log_index) {
+    using ::google::protobuf::internal::WireFormatLite;
+    ::google::protobuf::io::CodedInputStream input(reinterpret_cast<const uint8_t*>(record.data()),
+                                                   static_cast<int>(record.size()));
+    while (true) {
+        uint32_t tag = input.ReadTag();
+        if (tag == 0) {
+            return false;
+        }
+        if (WireFormatLite::GetTagFieldNumber(tag) == ::openmldb::api::LogEntry::kLogIndexFieldNumber &&
+            WireFormatLite::GetTagWireType(tag) == WireFormatLite::WIRETYPE_VARINT) {
+            return input.ReadVarint64(log_index);
+        }
+        if (!WireFormatLite::SkipField(&input, tag)) {
+            return false;
+        }
+    }
+}
+
 ReplicateNode::ReplicateNode(const std::string& point, LogParts* logs, const std::string& log_path, uint32_t tid,
                              uint32_t pid, std::atomic<uint64_t>* term, std::atomic<uint64_t>* leader_log_offset,
                              bthread::Mutex* mu, bthread::ConditionVariable* cv, bool rep_follower,
@@ -66,7 +95,12 @@ ReplicateNode::ReplicateNode(const std::string& point, LogParts* logs, const std
       cv_(cv),
       go_back_cnt_(0),
       rep_node_(rep_follower),
-      follower_offset_(follower_offset) {
+      follower_offset_(follower_offset),
+      inflight_(),
+      send_offset_(0),
+      batch_size_(FLAGS_binlog_sync_batch_size),
+      sync_log_part_index_(-1),
+      sync_log_part_offset_(0) {
     if (!real_point.empty()) {
         rpc_client_ = openmldb::RpcClient<::openmldb::api::TabletServer_Stub>(real_point);
     }
@@ -124,20 +158,25 @@ void ReplicateNode::SyncData() {
                           "replicate log to endpoint %s for table #tid %u #pid "
                           "%u exist",
                           endpoint_.c_str(), tid_, pid_);
+                    ClearInflight();
                     return;
                 }
             }
         }
+        uint64_t log_offset = rep_node_.load(std::memory_order_relaxed)
+                                  ? follower_offset_->load(std::memory_order_relaxed)
+                                  : leader_log_offset_->load(std::memory_order_relaxed);
         int ret;
-        if (rep_node_.load(std::memory_order_relaxed)) {
-            ret = SyncData(follower_offset_->load(std::memory_order_relaxed));
+        if (FLAGS_binlog_sync_pipeline_depth > 1) {
+            ret = SyncDataPipelined(log_offset);
         } else {
-            ret = SyncData(leader_log_offset_->load(std::memory_order_relaxed));
+            ret = SyncData(log_offset);
         }
         if (ret == 1) {
             coffee_time = FLAGS_binlog_coffee_time;
         }
     }
+    ClearInflight();
     PDLOG(INFO, "replicate log to endpoint %s for table #tid %u #pid %u exist", endpoint_.c_str(), tid_, pid_);
 }
 
@@ -151,6 +190,27 @@ uint64_t ReplicateNode::GetLastSyncOffset() { return last_sync_offset_; }
 
 void ReplicateNode::SetLastSyncOffset(uint64_t offset) { last_sync_offset_ = offset; }
 
+void ReplicateNode::GetSyncPosition(int* log_part_index, uint64_t* log_part_offset) {
+    *log_part_index = sync_log_part_index_.load(std::memory_order_relaxed);
+    *log_part_offset = sync_log_part_offset_.load(std::memory_order_relaxed);
+}
+
+void ReplicateNode::SetSyncPosition(int log_part_index, uint64_t log_part_offset) {
+    sync_log_part_offset_.store(log_part_offset, std::memory_order_relaxed);
+    sync_log_part_index_.store(log_part_index, std::memory_order_relaxed);
+}
+
+void ReplicateNode::GoBackLogReader() {
+    if (go_back_cnt_ > FLAGS_go_back_max_try_cnt) {
+        log_reader_.GoBackToStart();
+        go_back_cnt_ = 0;
+        PDLOG(WARNING, "go back to start. tid %u pid %u endpoint %s", tid_, pid_, endpoint_.c_str());
+    } else {
+        log_reader_.GoBackToLastBlock();
+        go_back_cnt_++;
+    }
+}
+
 int ReplicateNode::MatchLogOffsetFromNode() {
     ::openmldb::api::AppendEntriesRequest request;
     request.set_tid(tid_);
@@ -232,14 +292,7 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
                     PDLOG(WARNING, "log missing expect offset %lu but %ld. tid %u pid %u", sync_log_offset + 1,
                           entry->log_index(), tid_, pid_);
                     request.mutable_entries()->RemoveLast();
-                    if (go_back_cnt_ > FLAGS_go_back_max_try_cnt) {
-                        log_reader_.GoBackToStart();
-                        go_back_cnt_ = 0;
-                        PDLOG(WARNING, "go back to start. tid %u pid %u endpoint %s", tid_, pid_, endpoint_.c_str());
-                    } else {
-                        log_reader_.GoBackToLastBlock();
-                        go_back_cnt_++;
-                    }
+                    GoBackLogReader();
                     need_wait = true;
                     break;
                 }
@@ -251,14 +304,7 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
             } else if (status.IsInvalidRecord()) {
                 DEBUGLOG("fail to get record. %s. tid %u pid %u", status.ToString().c_str(), tid_, pid_);
                 need_wait = true;
-                if (go_back_cnt_ > FLAGS_go_back_max_try_cnt) {
-                    log_reader_.GoBackToStart();
-                    go_back_cnt_ = 0;
-                    PDLOG(WARNING, "go back to start. tid %u pid %u endpoint %s", tid_, pid_, endpoint_.c_str());
-                } else {
-                    log_reader_.GoBackToLastBlock();
-                    go_back_cnt_++;
-                }
+                GoBackLogReader();
                 break;
             } else {
                 PDLOG(WARNING, "fail to get record: %s. tid %u pid %u", status.ToString().c_str(), tid_, pid_);
@@ -282,6 +328,7 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
             if (request_from_cache) {
                 cache_.clear();
             }
+            SetSyncPosition(log_reader_.GetLogIndex(), log_reader_.GetLastRecordEndOffset());
         } else {
             if (!request_from_cache) {
                 cache_.push_back(request);
@@ -296,6 +343,158 @@ int ReplicateNode::SyncData(uint64_t log_offset) {
     return 0;
 }
 
+int ReplicateNode::ReadEntries(uint64_t log_offset, InflightRequest* inflight) {
+    ::openmldb::api::AppendEntriesRequest& request = inflight->request;
+    request.set_tid(tid_);
+    request.set_pid(pid_);
+    request.set_pre_log_index(send_offset_);
+    if (!FLAGS_zk_cluster.empty()) {
+        request.set_term(term_->load(std::memory_order_relaxed));
+    }
+    uint64_t sync_log_offset = send_offset_;
+    uint64_t max_cnt = std::min(log_offset - send_offset_, static_cast<uint64_t>(batch_size_));
+    uint64_t bytes = 0;
+    int ret = 0;
+    std::string buffer;
+    while (inflight->entry_cnt < max_cnt && bytes < FLAGS_binlog_sync_max_batch_bytes) {
+        ::openmldb::base::Slice record;
+        ::openmldb::log::Status status = log_reader_.ReadNextRecord(&record, &buffer);
+        if (status.ok()) {
+            uint64_t log_index = 0;
+            ::openmldb::api::LogEntry* entry = NULL;
+            bool ok = false;
+            if (FLAGS_binlog_sync_raw_entries) {
+                ok = ParseLogIndex(record, &log_index);
+            } else {
+                entry = request.add_entries();
+                ok = entry->ParseFromArray(record.data(), record.size());
+                log_index = entry->log_index();
+            }
+            if (!ok) {
+                PDLOG(WARNING, "bad protobuf format %s size %lu. tid %u pid %u",
+                      ::openmldb::base::DebugString(record.ToString()).c_str(), record.size(), tid_, pid_);
+                if (entry != NULL) {
+                    request.mutable_entries()->RemoveLast();
+                }
+                break;
+            }
+            if (log_index <= sync_log_offset) {
+                DEBUGLOG("skip duplicate log offset %lu", log_index);
+                if (entry != NULL) {
+                    request.mutable_entries()->RemoveLast();
+                }
+                continue;
+            }
+            // the log index should incr by 1
+            if (sync_log_offset + 1 != log_index) {
+                PDLOG(WARNING, "log missing expect offset %lu but %lu. tid %u pid %u", sync_log_offset + 1, log_index,
+                      tid_, pid_);
+                if (entry != NULL) {
+                    request.mutable_entries()->RemoveLast();
+                }
+                GoBackLogReader();
+                ret = 1;
+                break;
+            }
+            if (entry == NULL) {
+                request.add_raw_entries(record.data(), record.size());
+            }
+            sync_log_offset = log_index;
+            inflight->entry_cnt++;
+            bytes += record.size();
+            go_back_cnt_ = 0;
+        } else if (status.IsWaitRecord()) {
+            DEBUGLOG("got a coffee time for[%s]", endpoint_.c_str());
+            ret = 1;
+            break;
+        } else if (status.IsInvalidRecord()) {
+            DEBUGLOG("fail to get record. %s. tid %u pid %u", status.ToString().c_str(), tid_, pid_);
+            GoBackLogReader();
+            ret = 1;
+            break;
+        } else {
+            PDLOG(WARNING, "fail to get record: %s. tid %u pid %u", status.ToString().c_str(), tid_, pid_);
+            ret = 1;
+            break;
+        }
+    }
+    inflight->last_log_index = sync_log_offset;
+    inflight->full = inflight->entry_cnt >= batch_size_;
+    if (inflight->entry_cnt > 0) {
+        inflight->log_part_index = log_reader_.GetLogIndex();
+        inflight->log_part_offset = log_reader_.GetLastRecordEndOffset();
+    }
+    return ret;
+}
+
+int ReplicateNode::SyncDataPipelined(uint64_t log_offset) {
+    if (inflight_.empty()) {
+        send_offset_ = last_sync_offset_;
+    }
+    int ret = 0;
+    while (ret == 0 && inflight_.size() < FLAGS_binlog_sync_pipeline_depth && send_offset_ < log_offset) {
+        std::unique_ptr<InflightRequest> inflight(new InflightRequest());
+        ret = ReadEntries(log_offset, inflight.get());
+        if (inflight->entry_cnt == 0) {
+            break;
+        }
+        inflight->cntl.set_timeout_ms(FLAGS_request_timeout_ms);
+        inflight->cntl.set_max_retry(FLAGS_request_max_retry);
+        inflight->send_time = ::baidu::common::timer::get_micros();
+        if (!rpc_client_.SendRequest(&::openmldb::api::TabletServer_Stub::AppendEntries, &inflight->cntl,
+                                     &inflight->request, &inflight->response, brpc::DoNothing())) {
+            ClearInflight();
+            send_offset_ = last_sync_offset_;
+            log_reader_.Reset(last_sync_offset_);
+            return 1;
+        }
+        DEBUGLOG("send %u entries to node %s, last index %lu", inflight->entry_cnt, endpoint_.c_str(),
+                 inflight->last_log_index);
+        send_offset_ = inflight->last_log_index;
+        inflight_.push_back(std::move(inflight));
+    }
+    if (inflight_.empty()) {
+        return ret;
+    }
+    InflightRequest* head = inflight_.front().get();
+    brpc::Join(head->cntl.call_id());
+    // an old node ignores the raw entries, so check that the node has applied the entries
+    if (head->cntl.Failed() || head->response.code() != 0 ||
+        head->response.log_offset() < head->last_log_index) {
+        PDLOG(WARNING, "fail to sync log to node %s, resend from offset %lu. error %s code %d. tid %u pid %u",
+              endpoint_.c_str(), last_sync_offset_, head->cntl.ErrorText().c_str(), head->response.code(), tid_,
+              pid_);
+        ClearInflight();
+        send_offset_ = last_sync_offset_;
+        log_reader_.Reset(last_sync_offset_);
+        batch_size_ = FLAGS_binlog_sync_batch_size;
+        return 1;
+    }
+    uint64_t latency_ms = (::baidu::common::timer::get_micros() - head->send_time) / 1000;
+    if (latency_ms > FLAGS_binlog_sync_target_latency_ms) {
+        batch_size_ = std::max(batch_size_ / 2, static_cast<uint32_t>(FLAGS_binlog_sync_batch_size));
+    } else if (head->full && latency_ms * 2 < FLAGS_binlog_sync_target_latency_ms) {
+        batch_size_ = std::max(std::min(batch_size_ * 2, static_cast<uint32_t>(FLAGS_binlog_sync_max_batch_size)),
+                               static_cast<uint32_t>(FLAGS_binlog_sync_batch_size));
+    }
+    DEBUGLOG("sync log to node[%s] to offset %lu", endpoint_.c_str(), head->last_log_index);
+    last_sync_offset_ = head->last_log_index;
+    if (!rep_node_.load(std::memory_order_relaxed) &&
+        (last_sync_offset_ > follower_offset_->load(std::memory_order_relaxed))) {
+        follower_offset_->store(last_sync_offset_, std::memory_order_relaxed);
+    }
+    SetSyncPosition(head->log_part_index, head->log_part_offset);
+    inflight_.pop_front();
+    return ret;
+}
+
+void ReplicateNode::ClearInflight() {
+    for (const auto& inflight : inflight_) {
+        brpc::Join(inflight->cntl.call_id());
+    }
+    inflight_.clear();
+}
+
 void ReplicateNode::Stop() {
     is_running_.store(false, std::memory_order_relaxed);
     if (worker_ == 0) {
@@ -18,10 +18,13 @@
 #define SRC_REPLICA_REPLICATE_NODE_H_
 
 #include <atomic>
+#include <deque>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "base/skiplist.h"
+#include "brpc/controller.h"
 #include "bthread/bthread.h"
 #include "bthread/condition_variable.h"
 #include "log/log_reader.h"
@@ -63,6 +66,9 @@ class ReplicateNode {
 
     int GetLogIndex();
 
+    // the position in the binlog after the last entry acknowledged by the node
+    void GetSyncPosition(int* log_part_index, uint64_t* log_part_offset);
+
     void Stop();
 
     ReplicateNode(const ReplicateNode&) = delete;
@@ -70,8 +76,35 @@ class ReplicateNode {
     ReplicateNode& operator=(const ReplicateNode&) = delete;
 
  private:
+    // an append entries request sent to the node and not acknowledged yet
+    struct InflightRequest {
+        brpc::Controller cntl;
+        ::openmldb::api::AppendEntriesRequest request;
+        ::openmldb::api::AppendEntriesResponse response;
+        uint64_t last_log_index = 0;
+        uint32_t entry_cnt = 0;
+        // the request is limited by the batch size, not by the available entries
+        bool full = false;
+        int log_part_index = -1;
+        uint64_t log_part_offset = 0;
+        uint64_t send_time = 0;
+    };
+
     int MatchLogOffsetFromNode();
 
+    // keep up to binlog_sync_pipeline_depth requests in flight and wait for the oldest one
+    int SyncDataPipelined(uint64_t log_offset);
+
+    // read the entries after send_offset_ into the request, return 1 if the reader has to wait
+    int ReadEntries(uint64_t log_offset, InflightRequest* inflight);
+
+    // wait for the in-flight requests and drop them
+    void ClearInflight();
+
+    void GoBackLogReader();
+
+    void SetSyncPosition(int log_part_index, uint64_t log_part_offset);
+
  private:
     LogReader log_reader_;
     std::vector<::openmldb::api::AppendEntriesRequest> cache_;
@@ -90,6 +123,11 @@ class ReplicateNode {
     uint32_t go_back_cnt_;
     std::atomic<bool> rep_node_;
     std::atomic<uint64_t>* follower_offset_;  // max local cluster follower offset
+    std::deque<std::unique_ptr<InflightRequest>> inflight_;
+    uint64_t send_offset_;  // the last log index sent to the node
+    uint32_t batch_size_;
+    std::atomic<int> sync_log_part_index_;
+    std::atomic<uint64_t> sync_log_part_offset_;
 };
 
 }  // namespace replica
@@ -1266,6 +1266,62 @@ bool SQLClusterRouter::PutRow(uint32_t tid, const std::shared_ptr<SQLInsertRow>&
     return true;
 }
 
+bool SQLClusterRouter::PutRows(uint32_t tid, const std::vector<std::shared_ptr<SQLInsertRow>>& rows,
+                               const std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>>& tablets,
+                               ::hybridse::sdk::Status* status) {
+    if (status == nullptr) {
+        return false;
+    }
+    uint64_t cur_ts = ::baidu::common::timer::get_micros() / 1000;
+    std::map<uint32_t, ::openmldb::api::PutBatchRequest> requests;
+    for (const auto& row : rows) {
+        if (!row) {
+            continue;
+        }
+        for (const auto& kv : row->GetDimensions()) {
+            auto& request = requests[kv.first];
+            auto put_row = request.add_rows();
+            put_row->set_time(cur_ts);
+            put_row->set_value(row->GetRow());
+            for (const auto& dim : kv.second) {
+                auto dimension = put_row->add_dimensions();
+                dimension->set_key(dim.first);
+                dimension->set_idx(dim.second);
+            }
+        }
+    }
+    for (auto& kv : requests) {
+        uint32_t pid = kv.first;
+        std::shared_ptr<::openmldb::client::TabletClient> client;
+        if (pid < tablets.size() && tablets[pid]) {
+            client = tablets[pid]->GetClient();
+        }
+        if (!client) {
+            status->msg = "fail to get tablet client. pid " + std::to_string(pid);
+            LOG(WARNING) << status->msg;
+            return false;
+        }
+        kv.second.set_tid(tid);
+        kv.second.set_pid(pid);
+        DLOG(INFO) << "put " << kv.second.rows_size() << " rows to endpoint " << client->GetEndpoint();
+        ::openmldb::api::PutBatchResponse response;
+        if (!client->PutBatch(kv.second, &response)) {
+            int failed_cnt = 0;
+            for (auto code : response.row_code()) {
+                if (code != 0) {
+                    failed_cnt++;
+                }
+            }
+            status->msg = "fail to make a put batch request to table. tid " + std::to_string(tid) + " pid " +
+                          std::to_string(pid) + ", failed/total: " + std::to_string(failed_cnt) + "/" +
+                          std::to_string(kv.second.rows_size());
+            LOG(WARNING) << status->msg;
+            return false;
+        }
+    }
+    return true;
+}
+
 bool SQLClusterRouter::ExecuteInsert(const std::string& db, const std::string& sql, std::shared_ptr<SQLInsertRows> rows,
                                      hybridse::sdk::Status* status) {
     if (!rows || !status) {
@@ -1281,13 +1337,12 @@ bool SQLClusterRouter::ExecuteInsert(const std::string& db, const std::string& s
             status->msg = "fail to get table " + table_info->name() + " tablet";
             return false;
         }
+        std::vector<std::shared_ptr<SQLInsertRow>> row_vec;
+        row_vec.reserve(rows->GetCnt());
         for (uint32_t i = 0; i < rows->GetCnt(); ++i) {
-            std::shared_ptr<SQLInsertRow> row = rows->GetRow(i);
-            if (!PutRow(table_info->tid(), row, tablets, status)) {
-                return false;
-            }
+            row_vec.push_back(rows->GetRow(i));
         }
-        return true;
+        return PutRows(table_info->tid(), row_vec, tablets, status);
     } else {
         status->msg = "please use getInsertRow with " + sql + " first";
         return false;
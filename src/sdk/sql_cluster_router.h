@@ -303,6 +303,11 @@ class SQLClusterRouter : public SQLRouter {
                 const std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>>& tablets,
                 ::hybridse::sdk::Status* status);
 
+    // put rows grouped by partition, one PutBatch rpc for each partition
+    bool PutRows(uint32_t tid, const std::vector<std::shared_ptr<SQLInsertRow>>& rows,
+                 const std::vector<std::shared_ptr<::openmldb::catalog::TabletAccessor>>& tablets,
+                 ::hybridse::sdk::Status* status);
+
     bool IsConstQuery(::hybridse::vm::PhysicalOpNode* node);
     std::shared_ptr<SQLCache> GetCache(const std::string& db, const std::string& sql,
                                        const hybridse::vm::EngineMode engine_mode);
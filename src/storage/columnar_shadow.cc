@@ -0,0 +1,220 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/columnar_shadow.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "storage/schema.h"
+
+namespace openmldb {
+namespace storage {
+
+// the byte size of a value in the encoded row, 0 for the string types
+static uint32_t GetFixedSize(::openmldb::type::DataType type) {
+    switch (type) {
+        case ::openmldb::type::kBool:
+            return 1;
+        case ::openmldb::type::kSmallInt:
+            return 2;
+        case ::openmldb::type::kInt:
+        case ::openmldb::type::kFloat:
+        case ::openmldb::type::kDate:
+            return 4;
+        case ::openmldb::type::kBigInt:
+        case ::openmldb::type::kDouble:
+        case ::openmldb::type::kTimestamp:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+std::shared_ptr<ColumnarShadowSpec> ColumnarShadowSpec::Create(const codec::Schema& schema, uint8_t schema_version,
+                                                               const std::vector<uint32_t>& col_idxs) {
+    // the same layout as codec::RowView
+    std::vector<uint32_t> offsets;
+    uint32_t offset = codec::HEADER_LENGTH + (schema.size() >> 3) + ((schema.size() & 0x07) ? 1 : 0);
+    for (const auto& column : schema) {
+        offsets.push_back(offset);
+        offset += GetFixedSize(column.data_type());
+    }
+    auto spec = std::make_shared<ColumnarShadowSpec>();
+    spec->schema_version = schema_version;
+    for (uint32_t col_idx : col_idxs) {
+        if (col_idx >= (uint32_t)schema.size() || !ColumnDef::CheckColumnarType(schema.Get(col_idx).data_type())) {
+            return nullptr;
+        }
+        spec->columns.push_back({col_idx, offsets[col_idx], GetFixedSize(schema.Get(col_idx).data_type())});
+    }
+    return spec;
+}
+
+ColumnarShadow::ColumnarShadow(const std::shared_ptr<ColumnarShadowSpec>& spec)
+    : mu_(),
+      spec_(spec),
+      valid_(true),
+      version_(0),
+      begin_(0),
+      ts_(),
+      values_(spec->columns.size()),
+      nulls_(spec->columns.size()) {}
+
+bool ColumnarShadow::CheckRow(const int8_t* row, uint32_t size) const {
+    if (size < codec::HEADER_LENGTH || codec::RowView::GetSchemaVersion(row) != spec_->schema_version) {
+        return false;
+    }
+    for (const auto& column : spec_->columns) {
+        if (column.offset + column.size > size) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ColumnarShadow::Insert(uint64_t ts, const int8_t* row, uint32_t size) {
+    if (!CheckRow(row, size)) {
+        valid_ = false;
+        begin_ = 0;
+        std::vector<uint64_t>().swap(ts_);
+        for (uint32_t i = 0; i < spec_->columns.size(); i++) {
+            std::vector<int8_t>().swap(values_[i]);
+            std::vector<int8_t>().swap(nulls_[i]);
+        }
+        return;
+    }
+    // the new rows come in ts order mostly, the others are inserted after the rows with the same ts
+    uint64_t pos = ts_.size();
+    if (pos > begin_ && ts < ts_.back()) {
+        pos = std::upper_bound(ts_.begin() + begin_, ts_.end(), ts) - ts_.begin();
+    }
+    ts_.insert(ts_.begin() + pos, ts);
+    for (uint32_t i = 0; i < spec_->columns.size(); i++) {
+        const ShadowColumn& column = spec_->columns[i];
+        const int8_t* value = row + column.offset;
+        values_[i].insert(values_[i].begin() + pos * column.size, value, value + column.size);
+        int8_t is_null = (row[codec::HEADER_LENGTH + (column.col_idx >> 3)] >> (column.col_idx & 0x07)) & 1;
+        nulls_[i].insert(nulls_[i].begin() + pos, is_null);
+    }
+}
+
+void ColumnarShadow::DropOldest(uint64_t cnt) {
+    if (cnt == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mu_);
+    if (valid_) {
+        begin_ = std::min(begin_ + cnt, static_cast<uint64_t>(ts_.size()));
+        if (begin_ * 2 >= ts_.size()) {
+            Compact();
+        }
+    }
+    version_.fetch_add(1, std::memory_order_release);
+}
+
+void ColumnarShadow::Compact() {
+    ts_.erase(ts_.begin(), ts_.begin() + begin_);
+    for (uint32_t i = 0; i < spec_->columns.size(); i++) {
+        values_[i].erase(values_[i].begin(), values_[i].begin() + begin_ * spec_->columns[i].size);
+        nulls_[i].erase(nulls_[i].begin(), nulls_[i].begin() + begin_);
+    }
+    begin_ = 0;
+}
+
+void ColumnarShadow::Clear() {
+    std::lock_guard<std::mutex> lock(mu_);
+    begin_ = ts_.size();
+    Compact();
+    version_.fetch_add(1, std::memory_order_release);
+}
+
+bool ColumnarShadow::IsValid() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return valid_;
+}
+
+uint64_t ColumnarShadow::GetCount() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return ts_.size() - begin_;
+}
+
+bool ColumnarShadow::PrepareArrays(std::vector<::hybridse::codec::ColumnarArray>* arrays) const {
+    if (arrays->empty()) {
+        arrays->resize(spec_->columns.size());
+        for (uint32_t i = 0; i < spec_->columns.size(); i++) {
+            auto& array = arrays->at(i);
+            array.col_idx = spec_->columns[i].col_idx;
+            array.offset = spec_->columns[i].offset;
+            array.value_size = spec_->columns[i].size;
+        }
+        return true;
+    }
+    if (arrays->size() != spec_->columns.size()) {
+        return false;
+    }
+    for (uint32_t i = 0; i < spec_->columns.size(); i++) {
+        if (arrays->at(i).col_idx != spec_->columns[i].col_idx) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ColumnarShadow::Append(uint64_t version, uint64_t ts, uint64_t cnt,
+                            std::vector<::hybridse::codec::ColumnarArray>* arrays) {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (!valid_ || version != version_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    uint64_t end = std::upper_bound(ts_.begin() + begin_, ts_.end(), ts) - ts_.begin();
+    if (end < begin_ + cnt || !PrepareArrays(arrays)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < spec_->columns.size(); i++) {
+        auto& array = arrays->at(i);
+        uint32_t size = spec_->columns[i].size;
+        uint64_t old_cnt = array.nulls.size();
+        array.values.resize((old_cnt + cnt) * size);
+        array.nulls.resize(old_cnt + cnt);
+        int8_t* values = array.values.data() + old_cnt * size;
+        const int8_t* shadow_values = values_[i].data();
+        for (uint64_t pos = end; pos > end - cnt; pos--) {
+            memcpy(values, shadow_values + (pos - 1) * size, size);
+            values += size;
+        }
+        std::reverse_copy(nulls_[i].begin() + (end - cnt), nulls_[i].begin() + end, array.nulls.begin() + old_cnt);
+    }
+    return true;
+}
+
+bool ColumnarShadow::Append(const int8_t* row, uint32_t size,
+                            std::vector<::hybridse::codec::ColumnarArray>* arrays) const {
+    if (row == nullptr || !CheckRow(row, size) || !PrepareArrays(arrays)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < spec_->columns.size(); i++) {
+        const ShadowColumn& column = spec_->columns[i];
+        auto& array = arrays->at(i);
+        array.values.insert(array.values.end(), row + column.offset, row + column.offset + column.size);
+        array.nulls.push_back((row[codec::HEADER_LENGTH + (column.col_idx >> 3)] >> (column.col_idx & 0x07)) & 1);
+    }
+    return true;
+}
+
+}  // namespace storage
+}  // namespace openmldb
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_STORAGE_COLUMNAR_SHADOW_H_
+#define SRC_STORAGE_COLUMNAR_SHADOW_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "codec/codec.h"
+#include "codec/list_iterator_codec.h"
+
+namespace openmldb {
+namespace storage {
+
+// a fixed width column kept by the shadow
+struct ShadowColumn {
+    uint32_t col_idx;
+    uint32_t offset;
+    uint32_t size;
+};
+
+// the columns kept for the rows of one index, they are decoded with the layout
+// of one schema version
+struct ColumnarShadowSpec {
+    uint8_t schema_version;
+    std::vector<ShadowColumn> columns;
+
+    // return nullptr if any column is not a fixed width number or timestamp
+    static std::shared_ptr<ColumnarShadowSpec> Create(const codec::Schema& schema, uint8_t schema_version,
+                                                      const std::vector<uint32_t>& col_idxs);
+};
+
+// ColumnarShadow keeps the selected columns of the rows of one key entry in
+// contiguous arrays ordered by ts asc. The rows with the same ts are kept in
+// the order of insertion, so the arrays read backwards are in the order of
+// the time entries. A row which can not be decoded with the spec invalidates
+// the shadow and the readers fall back to the encoded rows.
+class ColumnarShadow {
+ public:
+    explicit ColumnarShadow(const std::shared_ptr<ColumnarShadowSpec>& spec);
+    ~ColumnarShadow() {}
+
+    // run `insert` to put the row into the time entries and keep its columns
+    // as one step, so the readers never see the two out of sync
+    template <class F>
+    uint8_t Put(uint64_t ts, const char* data, uint32_t size, F insert) {
+        std::lock_guard<std::mutex> lock(mu_);
+        uint8_t height = insert();
+        if (valid_) {
+            Insert(ts, reinterpret_cast<const int8_t*>(data), size);
+        }
+        version_.fetch_add(1, std::memory_order_release);
+        return height;
+    }
+
+    // drop the `cnt` oldest rows which have been split from the time entries
+    void DropOldest(uint64_t cnt);
+
+    void Clear();
+
+    // the version changes with every put and gc
+    uint64_t GetVersion() const { return version_.load(std::memory_order_acquire); }
+
+    bool IsValid();
+
+    uint64_t GetCount();
+
+    // append the columns of the `cnt` rows from the newest one with ts not
+    // greater than `ts`, in ts desc order. return false if the shadow has
+    // been changed since `version`
+    bool Append(uint64_t version, uint64_t ts, uint64_t cnt, std::vector<::hybridse::codec::ColumnarArray>* arrays);
+
+    // append the columns of a row which is not in the shadow
+    bool Append(const int8_t* row, uint32_t size, std::vector<::hybridse::codec::ColumnarArray>* arrays) const;
+
+ private:
+    void Insert(uint64_t ts, const int8_t* row, uint32_t size);
+    bool CheckRow(const int8_t* row, uint32_t size) const;
+    bool PrepareArrays(std::vector<::hybridse::codec::ColumnarArray>* arrays) const;
+    void Compact();
+
+ private:
+    std::mutex mu_;
+    std::shared_ptr<ColumnarShadowSpec> spec_;
+    bool valid_;
+    std::atomic<uint64_t> version_;
+    // the position of the oldest kept row, the dropped rows are compacted lazily
+    uint64_t begin_;
+    std::vector<uint64_t> ts_;
+    std::vector<std::vector<int8_t>> values_;
+    std::vector<std::vector<int8_t>> nulls_;
+};
+
+}  // namespace storage
+}  // namespace openmldb
+#endif  // SRC_STORAGE_COLUMNAR_SHADOW_H_
@@ -20,6 +20,7 @@
 #include "base/glog_wapper.h"  // NOLINT
 #include "base/hash.h"
 #include "config.h"  // NOLINT
+#include "storage/key_versions.h"
 
 DECLARE_bool(disable_wal);
 DECLARE_uint32(max_traverse_cnt);
@@ -29,14 +30,48 @@ DECLARE_uint32(block_cache_mb);
 DECLARE_uint32(write_buffer_mb);
 DECLARE_uint32(block_cache_shardbits);
 DECLARE_bool(verify_compression);
+DECLARE_uint32(disk_bloom_bits_per_key);
+DECLARE_bool(disk_partition_filters);
+DECLARE_bool(disk_pin_l0_filter_and_index);
+DECLARE_bool(disk_gc_by_compaction);
 
 namespace openmldb {
 namespace storage {
 
 static rocksdb::Options ssd_option_template;
 static rocksdb::Options hdd_option_template;
+static rocksdb::BlockBasedTableOptions table_option_template;
 static bool options_template_initialized = false;
 
+DiskTableFilterOptions DiskTableFilterOptions::FromFlags() {
+    DiskTableFilterOptions options;
+    options.bloom_bits_per_key = FLAGS_disk_bloom_bits_per_key;
+    options.partition_filters = FLAGS_disk_partition_filters;
+    options.pin_l0_filter_and_index = FLAGS_disk_pin_l0_filter_and_index;
+    return options;
+}
+
+// the keys are pk + ts and the prefix extractor cuts the ts, so the bloom filter is built on the pk. a lookup of a
+// missing pk skips the data blocks of every sst instead of reading one block per level
+static rocksdb::TableFactory* NewTableFactory(const DiskTableFilterOptions& filter_options) {
+    rocksdb::BlockBasedTableOptions table_options = table_option_template;
+    if (filter_options.bloom_bits_per_key > 0) {
+        table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(filter_options.bloom_bits_per_key, false));
+        table_options.cache_index_and_filter_blocks = true;
+        table_options.pin_l0_filter_and_index_blocks_in_cache = filter_options.pin_l0_filter_and_index;
+        if (filter_options.partition_filters) {
+            // only the top level index of the partitions is pinned, so the filters of a large table do not evict
+            // the data blocks from the block cache
+            table_options.index_type = rocksdb::BlockBasedTableOptions::IndexType::kTwoLevelIndexSearch;
+            table_options.partition_filters = true;
+            table_options.metadata_block_size = 4096;
+            table_options.cache_index_and_filter_blocks_with_high_priority = true;
+            table_options.pin_top_level_index_and_filter = true;
+        }
+    }
+    return rocksdb::NewBlockBasedTableFactory(table_options);
+}
+
 DiskTable::DiskTable(const std::string& name, uint32_t id, uint32_t pid, const std::map<std::string, uint32_t>& mapping,
                      uint64_t ttl, ::openmldb::type::TTLType ttl_type, ::openmldb::common::StorageMode storage_mode,
                      const std::string& table_path)
@@ -44,7 +79,8 @@ DiskTable::DiskTable(const std::string& name, uint32_t id, uint32_t pid, const s
             ::openmldb::type::CompressType::kNoCompress),
       write_opts_(),
       offset_(0),
-      table_path_(table_path) {
+      table_path_(table_path),
+      filter_options_(DiskTableFilterOptions::FromFlags()) {
     if (!options_template_initialized) {
         initOptionTemplate();
     }
@@ -58,7 +94,8 @@ DiskTable::DiskTable(const ::openmldb::api::TableMeta& table_meta, const std::st
             ::openmldb::type::CompressType::kNoCompress),
       write_opts_(),
       offset_(0),
-      table_path_(table_path) {
+      table_path_(table_path),
+      filter_options_(DiskTableFilterOptions::FromFlags()) {
     if (!options_template_initialized) {
         initOptionTemplate();
     }
@@ -98,11 +135,8 @@ void DiskTable::initOptionTemplate() {
         ssd_option_template.max_bytes_for_level_base >> 4;  // number of L1 files = 16
 
     rocksdb::BlockBasedTableOptions table_options;
-    // table_options.cache_index_and_filter_blocks = true;
-    // table_options.pin_l0_filter_and_index_blocks_in_cache = true;
     table_options.block_cache = cache;
-    // table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(10,
-    // false));
+    // the filter policy is set per table in NewTableFactory
     table_options.whole_key_filtering = false;
     table_options.block_size = 256 << 10;
     table_options.use_delta_encoding = false;
@@ -142,6 +176,7 @@ void DiskTable::initOptionTemplate() {
     hdd_option_template.target_file_size_base = 256 << 20;
     hdd_option_template.max_bytes_for_level_base = 1024 << 20;
     hdd_option_template.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
+    table_option_template = table_options;
 
     options_template_initialized = true;
 }
@@ -162,12 +197,15 @@ bool DiskTable::InitColumnFamilyDescriptor() {
         }
         cfo.comparator = &cmp_;
         cfo.prefix_extractor.reset(new KeyTsPrefixTransform());
+        cfo.table_factory.reset(NewTableFactory(filter_options_));
+        if (filter_options_.bloom_bits_per_key > 0) {
+            // the lookups of last join and window are often on missing keys, which need the filters of the last level
+            cfo.optimize_filters_for_hits = false;
+        }
         const auto& indexs = inner_index->GetIndex();
         auto index_def = indexs.front();
-        if (index_def->GetTTLType() == ::openmldb::storage::TTLType::kAbsoluteTime ||
-            index_def->GetTTLType() == ::openmldb::storage::TTLType::kAbsOrLat) {
-            cfo.compaction_filter_factory = std::make_shared<AbsoluteTTLFilterFactory>(inner_index);
-        }
+        // the ttl may be changed after the table is opened, so the filter is set for all the ttl types
+        cfo.compaction_filter_factory = std::make_shared<TTLCompactionFilterFactory>(inner_index);
         cf_ds_.push_back(rocksdb::ColumnFamilyDescriptor(index_def->GetName(), cfo));
         DEBUGLOG("add cf_name %s. tid %u pid %u", index_def->GetName().c_str(), id_, pid_);
     }
@@ -258,6 +296,9 @@ bool DiskTable::Put(uint64_t time, const std::string& value, const Dimensions& d
     }
     s = db_->Write(write_opts_, &batch);
     if (s.ok()) {
+        for (const auto& dimension : dimensions) {
+            KeyVersions::Bump(id_, dimension.idx(), dimension.key());
+        }
         offset_.fetch_add(1, std::memory_order_relaxed);
         return true;
     } else {
@@ -291,6 +332,7 @@ bool DiskTable::Delete(const std::string& pk, uint32_t idx) {
     }
     rocksdb::Status s = db_->Write(write_opts_, &batch);
     if (s.ok()) {
+        KeyVersions::Bump(id_, idx, pk);
         offset_.fetch_add(1, std::memory_order_relaxed);
         return true;
     } else {
@@ -316,10 +358,44 @@ bool DiskTable::Get(uint32_t idx, const std::string& pk, uint64_t ts, std::strin
 bool DiskTable::Get(const std::string& pk, uint64_t ts, std::string& value) { return Get(0, pk, ts, value); }
 
 void DiskTable::SchedGc() {
-    GcHead();
+    if (!FLAGS_disk_gc_by_compaction) {
+        GcHead();
+    }
     UpdateTTL();
 }
 
+bool DiskTable::CompactRange(uint32_t idx, const std::string& start_pk, const std::string& end_pk) {
+    std::shared_ptr<IndexDef> index_def = table_index_.GetIndex(idx);
+    if (!index_def) {
+        PDLOG(WARNING, "index %u not found. tid %u pid %u", idx, id_, pid_);
+        return false;
+    }
+    uint32_t inner_pos = index_def->GetInnerPos();
+    auto inner_index = table_index_.GetInnerIndex(inner_pos);
+    std::string begin_key;
+    std::string end_key;
+    if (!start_pk.empty()) {
+        begin_key = CombineKeyTs(start_pk, UINT64_MAX);
+    }
+    if (!end_pk.empty()) {
+        if (inner_index && inner_index->GetIndex().size() > 1) {
+            // the ts position follows the pk in the key, so the last ts position covers all the ts columns
+            end_key = CombineKeyTs(end_pk, 0, UINT32_MAX);
+        } else {
+            end_key = CombineKeyTs(end_pk, 0);
+        }
+    }
+    rocksdb::Slice begin(begin_key);
+    rocksdb::Slice end(end_key);
+    rocksdb::Status s = db_->CompactRange(rocksdb::CompactRangeOptions(), cf_hs_[inner_pos + 1],
+                                          start_pk.empty() ? nullptr : &begin, end_pk.empty() ? nullptr : &end);
+    if (!s.ok()) {
+        PDLOG(WARNING, "compact range failed. tid %u pid %u idx %u msg %s", id_, pid_, idx, s.ToString().c_str());
+        return false;
+    }
+    return true;
+}
+
 void DiskTable::GcHead() {
     uint64_t start_time = ::baidu::common::timer::get_micros() / 1000;
     auto inner_indexs = table_index_.GetAllInnerIndex();
@@ -328,7 +404,7 @@ void DiskTable::GcHead() {
         rocksdb::ReadOptions ro = rocksdb::ReadOptions();
         const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
         ro.snapshot = snapshot;
-        // ro.prefix_same_as_start = true;
+        ro.total_order_seek = true;
         ro.pin_data = true;
         rocksdb::Iterator* it = db_->NewIterator(ro, cf_hs_[idx + 1]);
         it->SeekToFirst();
@@ -512,7 +588,7 @@ TraverseIterator* DiskTable::NewTraverseIterator(uint32_t index) {
     rocksdb::ReadOptions ro = rocksdb::ReadOptions();
     const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
     ro.snapshot = snapshot;
-    // ro.prefix_same_as_start = true;
+    ro.total_order_seek = true;
     ro.pin_data = true;
     rocksdb::Iterator* it = db_->NewIterator(ro, cf_hs_[inner_pos + 1]);
     if (inner_index && inner_index->GetIndex().size() > 1) {
@@ -846,7 +922,7 @@ void DiskTableTraverseIterator::NextPK() {
     rocksdb::ReadOptions ro = rocksdb::ReadOptions();
     const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
     ro.snapshot = snapshot;
-    // ro.prefix_same_as_start = true;
+    ro.total_order_seek = true;
     ro.pin_data = true;
     rocksdb::Iterator* it = db_->NewIterator(ro, cf_hs_[inner_pos + 1]);
     if (inner_index && inner_index->GetIndex().size() > 1) {
@@ -959,7 +1035,7 @@ std::unique_ptr<::hybridse::vm::RowIterator> DiskTableKeyIterator::GetValue() {
     rocksdb::ReadOptions ro = rocksdb::ReadOptions();
     const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
     ro.snapshot = snapshot;
-    // ro.prefix_same_as_start = true;
+    ro.prefix_same_as_start = true;
     ro.pin_data = true;
     rocksdb::Iterator* it = db_->NewIterator(ro, column_handle_);
     std::unique_ptr<DiskTableRowIterator> wit(new DiskTableRowIterator(db_, it, snapshot, ttl_type_, expire_time_,
@@ -971,7 +1047,7 @@ std::unique_ptr<::hybridse::vm::RowIterator> DiskTableKeyIterator::GetValue() {
     rocksdb::ReadOptions ro = rocksdb::ReadOptions();
     const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
     ro.snapshot = snapshot;
-    // ro.prefix_same_as_start = true;
+    ro.prefix_same_as_start = true;
     ro.pin_data = true;
     rocksdb::Iterator* it = db_->NewIterator(ro, column_handle_);
     return new DiskTableRowIterator(db_, it, snapshot, ttl_type_, expire_time_, expire_cnt_, pk_, ts_, has_ts_idx_,
@@ -1127,7 +1203,7 @@ int DiskTable::GetCount(uint32_t index, const std::string& pk, uint64_t& count)
     rocksdb::ReadOptions ro = rocksdb::ReadOptions();
     const rocksdb::Snapshot* snapshot = db_->GetSnapshot();
     ro.snapshot = snapshot;
-    // ro.prefix_same_as_start = true;
+    ro.prefix_same_as_start = true;
     ro.pin_data = true;
     rocksdb::Iterator* it = db_->NewIterator(ro, cf_hs_[inner_pos + 1]);
 
@@ -143,19 +143,25 @@ class KeyTsPrefixTransform : public rocksdb::SliceTransform {
     bool SameResultWhenAppended(const rocksdb::Slice& prefix) const override { return InDomain(prefix); }
 };
 
-class AbsoluteTTLCompactionFilter : public rocksdb::CompactionFilter {
+// Expire the entries of all the ttl types while compaction walks the keys. The keys of a pk come in the
+// order of KeyTSComparator, ts descending, so the rank of an entry is the count of the pk seen before it. The
+// entries of a pk may be split into several compactions and the newer ones may be in other levels, so the rank
+// in a compaction is not more than the real one and an entry is never dropped before it expires.
+// A filter is created for each (sub)compaction and called from one thread
+class TTLCompactionFilter : public rocksdb::CompactionFilter {
  public:
-    explicit AbsoluteTTLCompactionFilter(std::shared_ptr<InnerIndexSt> inner_index) : inner_index_(inner_index) {}
-    virtual ~AbsoluteTTLCompactionFilter() {}
+    explicit TTLCompactionFilter(std::shared_ptr<InnerIndexSt> inner_index)
+        : inner_index_(inner_index), cur_time_(::baidu::common::timer::get_micros() / 1000), last_prefix_(), rank_(0) {}
+    virtual ~TTLCompactionFilter() {}
 
-    const char* Name() const override { return "AbsoluteTTLCompactionFilter"; }
+    const char* Name() const override { return "TTLCompactionFilter"; }
 
     bool Filter(int /*level*/, const rocksdb::Slice& key, const rocksdb::Slice& /*existing_value*/,
                 std::string* /*new_value*/, bool* /*value_changed*/) const override {
         if (key.size() < TS_LEN) {
             return false;
         }
-        uint64_t real_ttl = 0;
+        std::shared_ptr<TTLSt> ttl;
         const auto& indexs = inner_index_->GetIndex();
         if (indexs.size() > 1) {
             if (key.size() < TS_LEN + TS_POS_LEN) {
@@ -163,49 +169,58 @@ class AbsoluteTTLCompactionFilter : public rocksdb::CompactionFilter {
             }
             uint32_t ts_idx = *((uint32_t*)(key.data() + key.size() - TS_LEN -  // NOLINT
                                           TS_POS_LEN));
-            bool has_found = false;
-            for (const auto index : indexs) {
+            for (const auto& index : indexs) {
                 auto ts_col = index->GetTsColumn();
                 if (!ts_col) {
                     return false;
                 }
                 if (ts_col->GetId() == ts_idx) {
-                    real_ttl = index->GetTTL()->abs_ttl;
-                    has_found = true;
+                    ttl = index->GetTTL();
                     break;
                 }
             }
-            if (!has_found) {
+            if (!ttl) {
                 return false;
             }
         } else {
-            real_ttl = indexs.front()->GetTTL()->abs_ttl;
+            ttl = indexs.front()->GetTTL();
         }
-        if (real_ttl < 1) {
+        // the prefix is the pk and the ts position, so the ranks of the ts columns are counted separately
+        rocksdb::Slice prefix(key.data(), key.size() - TS_LEN);
+        if (prefix.compare(rocksdb::Slice(last_prefix_)) != 0) {
+            last_prefix_.assign(prefix.data(), prefix.size());
+            rank_ = 0;
+        }
+        rank_++;
+        if (!ttl->NeedGc()) {
             return false;
         }
+        uint64_t expire_time = 0;
+        if (ttl->abs_ttl > 0 && ttl->ttl_type != TTLType::kLatestTime) {
+            expire_time = cur_time_ - ttl->abs_ttl;
+        }
         uint64_t ts = 0;
         memcpy(static_cast<void*>(&ts), key.data() + key.size() - TS_LEN, TS_LEN);
         memrev64ifbe(static_cast<void*>(&ts));
-        uint64_t cur_time = ::baidu::common::timer::get_micros() / 1000;
-        if (ts < cur_time - real_ttl) {
-            return true;
-        }
-        return false;
+        return TTLSt(expire_time, ttl->lat_ttl, ttl->ttl_type).IsExpired(ts, rank_);
     }
 
  private:
     std::shared_ptr<InnerIndexSt> inner_index_;
+    const uint64_t cur_time_;
+    mutable std::string last_prefix_;
+    mutable uint64_t rank_;
 };
 
-class AbsoluteTTLFilterFactory : public rocksdb::CompactionFilterFactory {
+class TTLCompactionFilterFactory : public rocksdb::CompactionFilterFactory {
  public:
-    explicit AbsoluteTTLFilterFactory(const std::shared_ptr<InnerIndexSt>& inner_index) : inner_index_(inner_index) {}
+    explicit TTLCompactionFilterFactory(const std::shared_ptr<InnerIndexSt>& inner_index)
+        : inner_index_(inner_index) {}
     std::unique_ptr<rocksdb::CompactionFilter> CreateCompactionFilter(
         const rocksdb::CompactionFilter::Context& context) override {
-        return std::unique_ptr<rocksdb::CompactionFilter>(new AbsoluteTTLCompactionFilter(inner_index_));
+        return std::unique_ptr<rocksdb::CompactionFilter>(new TTLCompactionFilter(inner_index_));
     }
-    const char* Name() const override { return "AbsoluteTTLFilterFactory"; }
+    const char* Name() const override { return "TTLCompactionFilterFactory"; }
 
  private:
     std::shared_ptr<InnerIndexSt> inner_index_;
@@ -347,6 +362,18 @@ class DiskTableKeyIterator : public ::hybridse::vm::WindowIterator {
     rocksdb::ColumnFamilyHandle* column_handle_;
 };
 
+// the sst filter and index configuration of a disk table
+struct DiskTableFilterOptions {
+    // bits per key of the prefix bloom filter on the pk, 0 disables the filter
+    uint32_t bloom_bits_per_key = 10;
+    // split the index and filter blocks into partitions loaded on demand
+    bool partition_filters = true;
+    // pin the filter and index blocks of L0 files in the block cache
+    bool pin_l0_filter_and_index = true;
+
+    static DiskTableFilterOptions FromFlags();
+};
+
 class DiskTable : public Table {
  public:
     DiskTable(const std::string& name, uint32_t id, uint32_t pid, const std::map<std::string, uint32_t>& mapping,
@@ -365,6 +392,9 @@ class DiskTable : public Table {
 
     static void initOptionTemplate();
 
+    // must be called before Init, the options from flags are used by default
+    void SetFilterOptions(const DiskTableFilterOptions& filter_options) { filter_options_ = filter_options; }
+
     bool Put(const std::string& pk, uint64_t time, const char* data, uint32_t size) override;
 
     bool Put(uint64_t time, const std::string& value, const Dimensions& dimensions) override;
@@ -414,6 +444,10 @@ class DiskTable : public Table {
         }
     }
 
+    // compact the entries of the pks in [start_pk, end_pk] of an index, so the compaction filter expires them
+    // without rewriting the whole column family. an empty start_pk or end_pk leaves the range open on that side
+    bool CompactRange(uint32_t idx, const std::string& start_pk, const std::string& end_pk);
+
     int CreateCheckPoint(const std::string& checkpoint_dir);
 
     bool DeleteIndex(const std::string& idx_name) override;
@@ -434,6 +468,7 @@ class DiskTable : public Table {
     KeyTSComparator cmp_;
     std::atomic<uint64_t> offset_;
     std::string table_path_;
+    DiskTableFilterOptions filter_options_;
 };
 
 }  // namespace storage
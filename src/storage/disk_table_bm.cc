@@ -0,0 +1,118 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unistd.h>
+
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "base/file_util.h"
+#include "benchmark/benchmark.h"
+#include "gflags/gflags.h"
+#include "storage/disk_table.h"
+#include "storage/ticket.h"
+
+namespace openmldb {
+namespace storage {
+
+static const uint32_t kPkCnt = 100000;
+static const uint32_t kTsCntPerPk = 10;
+static const uint64_t kBaseTs = 1000000;
+
+// a table with kPkCnt pks of kTsCntPerPk rows, compacted so every read goes to the sst files
+static std::unique_ptr<DiskTable> CreateTable(const std::string& table_path, bool enable_filter) {
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::unique_ptr<DiskTable> table(new DiskTable("bm_table", 1, 1, mapping, 0,
+                                                   ::openmldb::type::TTLType::kAbsoluteTime,
+                                                   ::openmldb::common::StorageMode::kHDD, table_path));
+    DiskTableFilterOptions filter_options = DiskTableFilterOptions::FromFlags();
+    filter_options.bloom_bits_per_key = enable_filter ? 10 : 0;
+    table->SetFilterOptions(filter_options);
+    if (!table->Init()) {
+        return nullptr;
+    }
+    std::string value(128, 'a');
+    for (uint32_t i = 0; i < kPkCnt; i++) {
+        std::string pk = "pk" + std::to_string(i);
+        for (uint32_t k = 0; k < kTsCntPerPk; k++) {
+            table->Put(pk, kBaseTs + k, value.c_str(), value.size());
+        }
+    }
+    table->CompactDB();
+    return table;
+}
+
+// range(0) enables the prefix bloom filter and range(1) reads the existing pks or the missing ones
+static void RunDiskTableRead(benchmark::State& state, bool window_scan) {  // NOLINT
+    bool enable_filter = state.range(0) != 0;
+    bool hit = state.range(1) != 0;
+    std::string table_path = "/tmp/disk_table_bm_" + std::to_string(::getpid());
+    auto table = CreateTable(table_path, enable_filter);
+    if (!table) {
+        state.SkipWithError("fail to init disk table");
+        ::openmldb::base::RemoveDirRecursive(table_path);
+        return;
+    }
+    std::mt19937 rand(42);
+    std::uniform_int_distribution<uint32_t> dist(0, kPkCnt - 1);
+    uint64_t rows = 0;
+    for (auto _ : state) {
+        std::string pk = (hit ? "pk" : "missing") + std::to_string(dist(rand));
+        if (window_scan) {
+            Ticket ticket;
+            std::unique_ptr<TableIterator> it(table->NewIterator(0, pk, ticket));
+            for (it->SeekToFirst(); it->Valid(); it->Next()) {
+                benchmark::DoNotOptimize(it->GetValue());
+                rows++;
+            }
+        } else {
+            std::string value;
+            if (table->Get(0, pk, kBaseTs, value)) {
+                rows++;
+            }
+        }
+    }
+    state.counters["rows"] = benchmark::Counter(rows, benchmark::Counter::kAvgIterations);
+    table.reset();
+    ::openmldb::base::RemoveDirRecursive(table_path);
+}
+
+static void BM_DiskTableGet(benchmark::State& state) {  // NOLINT
+    RunDiskTableRead(state, false);
+}
+
+static void BM_DiskTableWindowScan(benchmark::State& state) {  // NOLINT
+    RunDiskTableRead(state, true);
+}
+
+static void ReadArgs(benchmark::internal::Benchmark* b) {
+    for (int enable_filter : {0, 1}) {
+        for (int hit : {0, 1}) {
+            b->Args({enable_filter, hit});
+        }
+    }
+}
+
+BENCHMARK(BM_DiskTableGet)->Apply(ReadArgs)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_DiskTableWindowScan)->Apply(ReadArgs)->Unit(benchmark::kMicrosecond);
+
+}  // namespace storage
+}  // namespace openmldb
+
+BENCHMARK_MAIN();
@@ -16,8 +16,12 @@
 
 #include "storage/disk_table.h"
 #include <gflags/gflags.h>
+#include <algorithm>
 #include <iostream>
+#include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 #include "base/file_util.h"
 #include "base/glog_wapper.h"  // NOLINT
 #include "codec/schema_codec.h"
@@ -1125,6 +1129,90 @@ TEST_F(DiskTableTest, GcHead) {
     RemoveData(table_path);
 }
 
+TEST_F(DiskTableTest, CompactFilterLatestTime) {
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::string table_path = FLAGS_hdd_root_path + "/14_1";
+    DiskTable* table = new DiskTable("t1", 14, 1, mapping, 3, ::openmldb::type::TTLType::kLatestTime,
+                                     ::openmldb::common::StorageMode::kHDD, table_path);
+    ASSERT_TRUE(table->Init());
+    for (int idx = 0; idx < 100; idx++) {
+        std::string key = "test" + std::to_string(idx);
+        uint64_t ts = 9537;
+        for (int k = 0; k < 5; k++) {
+            ASSERT_TRUE(table->Put(key, ts + k, "value", 5));
+        }
+    }
+    // only the pks from test10 to test19 are compacted
+    ASSERT_TRUE(table->CompactRange(0, "test10", "test19"));
+    for (int idx = 0; idx < 100; idx++) {
+        std::string key = "test" + std::to_string(idx);
+        bool compacted = idx >= 10 && idx < 20;
+        uint64_t ts = 9537;
+        for (int k = 0; k < 5; k++) {
+            std::string value;
+            if (compacted && k < 2) {
+                ASSERT_FALSE(table->Get(key, ts + k, value));
+            } else {
+                ASSERT_TRUE(table->Get(key, ts + k, value));
+                ASSERT_EQ("value", value);
+            }
+        }
+    }
+    table->CompactDB();
+    for (int idx = 0; idx < 100; idx++) {
+        std::string key = "test" + std::to_string(idx);
+        uint64_t ts = 9537;
+        for (int k = 0; k < 5; k++) {
+            std::string value;
+            ASSERT_EQ(k >= 2, table->Get(key, ts + k, value));
+        }
+    }
+    delete table;
+    RemoveData(table_path);
+}
+
+TEST_F(DiskTableTest, CompactFilterAbsAndLat) {
+    ::openmldb::api::TableMeta table_meta;
+    table_meta.set_tid(16);
+    table_meta.set_pid(1);
+    table_meta.set_storage_mode(::openmldb::common::kHDD);
+    table_meta.set_format_version(1);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "card", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "ts1", ::openmldb::type::kBigInt);
+    SchemaCodec::SetIndex(table_meta.add_column_key(), "card", "card", "ts1", ::openmldb::type::kAbsAndLat, 10, 2);
+    std::string table_path = FLAGS_hdd_root_path + "/16_1";
+    DiskTable* table = new DiskTable(table_meta, table_path);
+    ASSERT_TRUE(table->Init());
+    codec::SDKCodec codec(table_meta);
+
+    uint64_t cur_time = ::baidu::common::timer::get_micros() / 1000;
+    uint64_t expired_time = cur_time - 20 * 60 * 1000;
+    // all but the first are out of the absolute ttl and only the last three are out of the latest ttl
+    std::vector<uint64_t> ts_list = {cur_time - 2, expired_time, expired_time - 1, expired_time - 3, expired_time - 4};
+    for (int idx = 0; idx < 10; idx++) {
+        Dimensions dims;
+        ::openmldb::api::Dimension* dim = dims.Add();
+        dim->set_key("card" + std::to_string(idx));
+        dim->set_idx(0);
+        for (auto ts : ts_list) {
+            std::string value;
+            ASSERT_EQ(0, codec.EncodeRow({"card" + std::to_string(idx), std::to_string(ts)}, &value));
+            ASSERT_TRUE(table->Put(ts, value, dims));
+        }
+    }
+    table->CompactDB();
+    for (int idx = 0; idx < 10; idx++) {
+        std::string key = "card" + std::to_string(idx);
+        for (size_t i = 0; i < ts_list.size(); i++) {
+            std::string value;
+            ASSERT_EQ(i < 2, table->Get(0, key, ts_list[i], value));
+        }
+    }
+    delete table;
+    RemoveData(table_path);
+}
+
 TEST_F(DiskTableTest, CheckPoint) {
     std::map<std::string, uint32_t> mapping;
     mapping.insert(std::make_pair("idx0", 0));
@@ -1198,6 +1286,93 @@ TEST_F(DiskTableTest, CheckPoint) {
     RemoveData(table_path);
 }
 
+// the rows read by pk, by traverse and by window from `table`, in the order they are read
+static std::vector<std::string> ReadAll(DiskTable* table, const std::vector<std::string>& pks) {
+    std::vector<std::string> rows;
+    for (const auto& pk : pks) {
+        std::string value;
+        bool found = table->Get(0, pk, 9539, value);
+        rows.push_back("get " + pk + " " + (found ? value : "<none>"));
+        uint64_t count = 0;
+        int ret = table->GetCount(0, pk, count);
+        rows.push_back("count " + pk + " " + std::to_string(ret) + " " + std::to_string(count));
+        Ticket ticket;
+        std::unique_ptr<TableIterator> it(table->NewIterator(0, pk, ticket));
+        for (it->SeekToFirst(); it->Valid(); it->Next()) {
+            rows.push_back("scan " + it->GetPK() + " " + std::to_string(it->GetKey()) + " " +
+                           it->GetValue().ToString());
+        }
+        for (it->Seek(9538); it->Valid(); it->Next()) {
+            rows.push_back("seek " + it->GetPK() + " " + std::to_string(it->GetKey()));
+        }
+    }
+    std::unique_ptr<TableIterator> traverse_it(table->NewTraverseIterator(0));
+    for (traverse_it->SeekToFirst(); traverse_it->Valid(); traverse_it->Next()) {
+        rows.push_back("traverse " + traverse_it->GetPK() + " " + std::to_string(traverse_it->GetKey()));
+    }
+    std::unique_ptr<::hybridse::vm::WindowIterator> window_it(table->NewWindowIterator(0));
+    for (window_it->SeekToFirst(); window_it->Valid(); window_it->Next()) {
+        std::string key = window_it->GetKey().ToString();
+        auto row_it = window_it->GetValue();
+        for (row_it->SeekToFirst(); row_it->Valid(); row_it->Next()) {
+            rows.push_back("window " + key + " " + std::to_string(row_it->GetKey()));
+        }
+    }
+    return rows;
+}
+
+// the prefix bloom filter skips the missing pks only, every read agrees with the table without filter
+TEST_F(DiskTableTest, PrefixBloomFilter) {
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::vector<std::string> pks;
+    for (int idx = 0; idx < 200; idx++) {
+        pks.push_back("test" + std::to_string(idx));
+    }
+    // the prefixes and extensions of the existing pks
+    pks.push_back("test");
+    pks.push_back("tes");
+    pks.push_back("test1000");
+
+    std::vector<std::vector<std::string>> results;
+    uint32_t bloom_bits[] = {0, 10, 10};
+    bool partition_filters[] = {false, false, true};
+    for (int i = 0; i < 3; i++) {
+        std::string table_path = FLAGS_hdd_root_path + "/" + std::to_string(17 + i) + "_1";
+        DiskTable* table = new DiskTable("t1", 17 + i, 1, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime,
+                                         ::openmldb::common::StorageMode::kHDD, table_path);
+        DiskTableFilterOptions filter_options;
+        filter_options.bloom_bits_per_key = bloom_bits[i];
+        filter_options.partition_filters = partition_filters[i];
+        table->SetFilterOptions(filter_options);
+        ASSERT_TRUE(table->Init());
+        // the odd pks are missing, so test1 is missing while test10 and test100 exist
+        for (int idx = 0; idx < 200; idx += 2) {
+            std::string key = "test" + std::to_string(idx);
+            for (int k = 0; k < 5; k++) {
+                ASSERT_TRUE(table->Put(key, 9537 + k, "value" + std::to_string(k), 6));
+            }
+        }
+        // the reads cover the sst files and the memtable
+        table->CompactDB();
+        for (int idx = 0; idx < 200; idx += 4) {
+            std::string key = "test" + std::to_string(idx);
+            ASSERT_TRUE(table->Put(key, 9545, "valuem", 6));
+        }
+        results.push_back(ReadAll(table, pks));
+        delete table;
+        RemoveData(table_path);
+    }
+    ASSERT_FALSE(results[0].empty());
+    ASSERT_EQ(results[0], results[1]);
+    ASSERT_EQ(results[0], results[2]);
+    // 100 pks of 5 rows and 50 of them with one more in the memtable
+    ASSERT_EQ(550, std::count_if(results[0].begin(), results[0].end(),
+                                 [](const std::string& row) { return row.rfind("traverse ", 0) == 0; }));
+    ASSERT_EQ(550, std::count_if(results[0].begin(), results[0].end(),
+                                 [](const std::string& row) { return row.rfind("window ", 0) == 0; }));
+}
+
 }  // namespace storage
 }  // namespace openmldb
 
@@ -0,0 +1,46 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/key_versions.h"
+
+#include "base/hash.h"
+
+namespace openmldb {
+namespace storage {
+
+// differs from the seed of the segments, so the keys of a segment are spread over the slots
+static const uint32_t KEY_VERSION_SEED = 0x9747b28c;
+
+std::atomic<bool> KeyVersions::enabled_(false);
+std::atomic<uint64_t> KeyVersions::versions_[KeyVersions::kSlotCnt] = {};
+std::atomic<uint64_t> KeyVersions::append_versions_[KeyVersions::kSlotCnt] = {};
+std::atomic<uint64_t> KeyVersions::newest_ts_[KeyVersions::kSlotCnt] = {};
+
+uint32_t KeyVersions::GetSlot(uint32_t tid, uint32_t idx, const ::openmldb::base::Slice& key) {
+    uint32_t seed = KEY_VERSION_SEED ^ (tid * 131 + idx);
+    return ::openmldb::base::hash(key.data(), key.size(), seed) & (kSlotCnt - 1);
+}
+
+bool KeyVersions::RaiseNewestTs(uint32_t slot, uint64_t ts) {
+    uint64_t newest = newest_ts_[slot].load(std::memory_order_acquire);
+    while (newest < ts && !newest_ts_[slot].compare_exchange_weak(newest, ts, std::memory_order_acq_rel)) {
+    }
+    // a row at or before the newest ts may be inserted among the rows read before
+    return ts > newest;
+}
+
+}  // namespace storage
+}  // namespace openmldb
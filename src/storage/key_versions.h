@@ -0,0 +1,91 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_STORAGE_KEY_VERSIONS_H_
+#define SRC_STORAGE_KEY_VERSIONS_H_
+
+#include <atomic>
+
+#include "base/slice.h"
+
+namespace openmldb {
+namespace storage {
+
+// the versions of the keys of the indexes, bumped after a row of the key is put, bulk loaded or dropped by gc, or the
+// key is deleted. a reader gets the version of a key before reading its rows, so a result computed from the rows is
+// stale once the version changes. the keys of all the tables are hashed into a fixed number of slots, a collision
+// only makes a false invalidation. the versions are not maintained until Enable is called.
+//
+// the append version of a key is not bumped by the rows newer than all the rows put into its slot, so a reader
+// which has read the rows up to ts t only needs to read the rows after t if the append version is not changed.
+// the newest ts of the slot is raised before the row is put, so a concurrent put of an older row is seen as out of
+// order even if it is visible first, and the versions are bumped after the row is put
+class KeyVersions {
+ public:
+    // a put of a row into the slot, see PrepareTs
+    struct TsPut {
+        uint32_t slot;
+        bool in_order;
+    };
+
+    static void Enable() { enabled_.store(true, std::memory_order_relaxed); }
+
+    static bool IsEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    static uint32_t GetSlot(uint32_t tid, uint32_t idx, const ::openmldb::base::Slice& key);
+
+    static uint64_t GetVersion(uint32_t slot) { return versions_[slot].load(std::memory_order_acquire); }
+
+    static uint64_t GetAppendVersion(uint32_t slot) {
+        return append_versions_[slot].load(std::memory_order_acquire);
+    }
+
+    // the rows of the key are changed in place, e.g. the key is deleted
+    static void Bump(uint32_t tid, uint32_t idx, const ::openmldb::base::Slice& key) {
+        if (IsEnabled()) {
+            uint32_t slot = GetSlot(tid, idx, key);
+            append_versions_[slot].fetch_add(1, std::memory_order_release);
+            versions_[slot].fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    // a row of `ts` is to be put into the key, call it before the row is put and BumpPut after
+    static TsPut PrepareTs(uint32_t tid, uint32_t idx, const ::openmldb::base::Slice& key, uint64_t ts) {
+        uint32_t slot = GetSlot(tid, idx, key);
+        return {slot, RaiseNewestTs(slot, ts)};
+    }
+
+    static void BumpPut(const TsPut& put) {
+        if (!put.in_order) {
+            append_versions_[put.slot].fetch_add(1, std::memory_order_release);
+        }
+        versions_[put.slot].fetch_add(1, std::memory_order_release);
+    }
+
+ private:
+    // return false if a row at or after `ts` may be put into the slot before
+    static bool RaiseNewestTs(uint32_t slot, uint64_t ts);
+
+    static constexpr uint32_t kSlotCnt = 1 << 18;
+    static std::atomic<bool> enabled_;
+    static std::atomic<uint64_t> versions_[kSlotCnt];
+    static std::atomic<uint64_t> append_versions_[kSlotCnt];
+    static std::atomic<uint64_t> newest_ts_[kSlotCnt];
+};
+
+}  // namespace storage
+}  // namespace openmldb
+#endif  // SRC_STORAGE_KEY_VERSIONS_H_
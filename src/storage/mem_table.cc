@@ -24,6 +24,7 @@
 #include "base/slice.h"
 #include "common/timer.h"
 #include "gflags/gflags.h"
+#include "storage/key_versions.h"
 #include "storage/record.h"
 
 DECLARE_uint32(skiplist_max_height);
@@ -68,15 +69,6 @@ MemTable::~MemTable() {
         return;
     }
     Release();
-    for (uint32_t i = 0; i < segments_.size(); i++) {
-        if (segments_[i] != NULL) {
-            for (uint32_t j = 0; j < seg_cnt_; j++) {
-                delete segments_[i][j];
-            }
-            delete[] segments_[i];
-        }
-    }
-    segments_.clear();
     PDLOG(INFO, "drop memtable. tid %u pid %u", id_, pid_);
 }
 
@@ -116,6 +108,14 @@ bool MemTable::Init() {
                 PDLOG(INFO, "init %u, %u segment. height %u tid %u pid %u", i, j, cur_key_entry_max_height, id_, pid_);
             }
         }
+        InitColumnarShadow(inner_indexs->at(i), seg_arr);
+        std::vector<uint32_t> index_ids;
+        for (const auto& index_def : inner_indexs->at(i)->GetIndex()) {
+            index_ids.push_back(index_def->GetId());
+        }
+        for (uint32_t j = 0; j < seg_cnt_; j++) {
+            seg_arr[j]->TrackKeyVersions(id_, index_ids);
+        }
         segments_[i] = seg_arr;
         key_entry_max_height_ = cur_key_entry_max_height;
     }
@@ -123,6 +123,40 @@ bool MemTable::Init() {
     return true;
 }
 
+void MemTable::InitColumnarShadow(const std::shared_ptr<InnerIndexSt>& inner_index, Segment** seg_arr) {
+    for (const auto& index_def : inner_index->GetIndex()) {
+        const auto& columnar_columns = index_def->GetColumnarColumns();
+        if (columnar_columns.empty() || !index_def->GetTsColumn()) {
+            continue;
+        }
+        if (compress_type_ == ::openmldb::type::kSnappy) {
+            PDLOG(WARNING, "columnar shadow is unsupported with compression. index %s tid %u pid %u",
+                  index_def->GetName().c_str(), id_, pid_);
+            continue;
+        }
+        // the rows of the other versions make the shadow of their keys invalid
+        auto versions = GetAllVersionSchema();
+        if (versions.empty()) {
+            continue;
+        }
+        std::vector<uint32_t> col_idxs;
+        for (const auto& col : columnar_columns) {
+            col_idxs.push_back(col.GetId());
+        }
+        auto spec = ColumnarShadowSpec::Create(*(versions.rbegin()->second), versions.rbegin()->first, col_idxs);
+        if (!spec) {
+            PDLOG(WARNING, "create columnar shadow spec failed. index %s tid %u pid %u", index_def->GetName().c_str(),
+                  id_, pid_);
+            continue;
+        }
+        for (uint32_t j = 0; j < seg_cnt_; j++) {
+            seg_arr[j]->EnableColumnarShadow(index_def->GetTsColumn()->GetId(), spec);
+        }
+        PDLOG(INFO, "keep %u columnar columns for index %s. tid %u pid %u", col_idxs.size(),
+              index_def->GetName().c_str(), id_, pid_);
+    }
+}
+
 void MemTable::SetCompressType(::openmldb::type::CompressType compress_type) { compress_type_ = compress_type; }
 
 ::openmldb::type::CompressType MemTable::GetCompressType() { return compress_type_; }
@@ -135,7 +169,13 @@ bool MemTable::Put(const std::string& pk, uint64_t time, const char* data, uint3
     }
     Segment* segment = segments_[0][index];
     Slice spk(pk);
-    segment->Put(spk, time, data, size);
+    if (KeyVersions::IsEnabled()) {
+        auto ts_put = KeyVersions::PrepareTs(id_, 0, spk, time);
+        segment->Put(spk, time, data, size);
+        KeyVersions::BumpPut(ts_put);
+    } else {
+        segment->Put(spk, time, data, size);
+    }
     record_cnt_.fetch_add(1, std::memory_order_relaxed);
     record_byte_size_.fetch_add(GetRecordSize(size));
     return true;
@@ -194,7 +234,7 @@ bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& di
     if (ts_map.empty()) {
         return false;
     }
-    auto* block = new DataBlock(real_ref_cnt, value.c_str(), value.length());
+    std::vector<std::pair<Segment*, Slice>> put_segments;
     for (const auto& kv : inner_index_key_map) {
         auto inner_index = table_index_.GetInnerIndex(kv.first);
         bool need_put = false;
@@ -210,15 +250,44 @@ bool MemTable::Put(uint64_t time, const std::string& value, const Dimensions& di
             if (seg_cnt_ > 1) {
                 seg_idx = ::openmldb::base::hash(kv.second.data(), kv.second.size(), SEED) % seg_cnt_;
             }
-            Segment* segment = segments_[kv.first][seg_idx];
-            segment->Put(::openmldb::base::Slice(kv.second), ts_map, block);
+            put_segments.emplace_back(segments_[kv.first][seg_idx], kv.second);
+        }
+    }
+    // the block is allocated from the first segment and freed by the segment which drops it at last
+    auto* block = DataBlock::New(put_segments.empty() ? NULL : put_segments.front().first->GetAllocator(),
+                                 real_ref_cnt, value.c_str(), value.length());
+    std::vector<KeyVersions::TsPut> ts_puts;
+    if (KeyVersions::IsEnabled()) {
+        for (const auto& kv : inner_index_key_map) {
+            for (const auto& index_def : table_index_.GetInnerIndex(kv.first)->GetIndex()) {
+                auto ts_col = index_def->GetTsColumn();
+                auto ts_iter = ts_col ? ts_map.find(ts_col->GetId()) : ts_map.end();
+                if (ts_iter != ts_map.end()) {
+                    ts_puts.push_back(KeyVersions::PrepareTs(id_, index_def->GetId(), kv.second, ts_iter->second));
+                } else {
+                    ts_puts.push_back({KeyVersions::GetSlot(id_, index_def->GetId(), kv.second), false});
+                }
+            }
         }
     }
+    for (const auto& kv : put_segments) {
+        kv.first->Put(kv.second, ts_map, block);
+    }
+    for (const auto& ts_put : ts_puts) {
+        KeyVersions::BumpPut(ts_put);
+    }
     record_cnt_.fetch_add(1, std::memory_order_relaxed);
     record_byte_size_.fetch_add(GetRecordSize(value.length()));
     return true;
 }
 
+uint32_t MemTable::GetSegIdx(const std::string& key) const {
+    if (seg_cnt_ > 1) {
+        return ::openmldb::base::hash(key.c_str(), key.length(), SEED) % seg_cnt_;
+    }
+    return 0;
+}
+
 bool MemTable::Delete(const std::string& pk, uint32_t idx) {
     std::shared_ptr<IndexDef> index_def = GetIndex(idx);
     if (!index_def || !index_def->IsReady()) {
@@ -231,7 +300,9 @@ bool MemTable::Delete(const std::string& pk, uint32_t idx) {
     }
     uint32_t real_idx = index_def->GetInnerPos();
     Segment* segment = segments_[real_idx][seg_idx];
-    return segment->Delete(spk);
+    bool ok = segment->Delete(spk);
+    KeyVersions::Bump(id_, idx, pk);
+    return ok;
 }
 
 uint64_t MemTable::Release() {
@@ -249,6 +320,16 @@ uint64_t MemTable::Release() {
             }
         }
     }
+    // a data block is shared by the segments of all indexes and goes back to the slab
+    // it came from, so delete the segments with their slabs only after all are released
+    for (uint32_t i = 0; i < segments_.size(); i++) {
+        if (segments_[i] != NULL) {
+            for (uint32_t j = 0; j < seg_cnt_; j++) {
+                delete segments_[i][j];
+            }
+            delete[] segments_[i];
+        }
+    }
     segment_released_ = true;
     segments_.clear();
     return total_cnt;
@@ -484,6 +565,24 @@ uint64_t MemTable::GetRecordIdxByteSize() {
     return record_idx_byte_size;
 }
 
+void MemTable::GetSlabByteSize(uint64_t* byte_size, uint64_t* used_byte_size) {
+    *byte_size = 0;
+    *used_byte_size = 0;
+    if (segments_.empty()) {
+        return;
+    }
+    auto inner_indexs = table_index_.GetAllInnerIndex();
+    for (size_t i = 0; i < inner_indexs->size(); i++) {
+        if (segments_[i] == NULL) {
+            continue;
+        }
+        for (uint32_t j = 0; j < seg_cnt_; j++) {
+            *byte_size += segments_[i][j]->GetSlabByteSize();
+            *used_byte_size += segments_[i][j]->GetSlabUsedByteSize();
+        }
+    }
+}
+
 uint64_t MemTable::GetRecordIdxCnt() {
     uint64_t record_idx_cnt = 0;
     auto inner_indexs = table_index_.GetAllInnerIndex();
@@ -600,6 +699,9 @@ bool MemTable::AddIndex(const ::openmldb::common::ColumnKey& column_key) {
             PDLOG(WARNING, "add index failed. tid %u pid %u", id_, pid_);
             return false;
         }
+        for (uint32_t j = 0; j < seg_cnt_; j++) {
+            seg_arr[j]->TrackKeyVersions(id_, {index_def->GetId()});
+        }
         segments_[inner_id] = seg_arr;
         if (!column_key.ts_name().empty()) {
             auto ts_iter = schema.find(column_key.ts_name());
@@ -739,6 +841,7 @@ bool MemTable::GetBulkLoadInfo(::openmldb::api::BulkLoadInfoResponse* response)
 bool MemTable::BulkLoad(const std::vector<DataBlock*>& data_blocks,
                         const ::google::protobuf::RepeatedPtrField<::openmldb::api::BulkLoadIndex>& indexes) {
     // data_block[i] is the block which id == i
+    std::vector<std::pair<uint64_t, DataBlock*>> rows;
     for (int i = 0; i < indexes.size(); ++i) {
         const auto& inner_index = indexes.Get(i);
         auto real_idx = inner_index.inner_index_id();
@@ -752,6 +855,7 @@ bool MemTable::BulkLoad(const std::vector<DataBlock*>& data_blocks,
                 for (int key_entry_idx = 0; key_entry_idx < key_entries.key_entry_size(); ++key_entry_idx) {
                     const auto& key_entry = key_entries.key_entry(key_entry_idx);
                     auto key_entry_id = key_entry.key_entry_id();
+                    rows.clear();
                     for (int time_idx = 0; time_idx < key_entry.time_entry_size(); ++time_idx) {
                         const auto& time_entry = key_entry.time_entry(time_idx);
                         auto* block =
@@ -765,9 +869,12 @@ bool MemTable::BulkLoad(const std::vector<DataBlock*>& data_blocks,
                         VLOG(1) << "do segment(" << real_idx << "-" << seg_idx << ") put, key" << pk.ToString()
                                 << ", time " << time_entry.time() << ", key_entry_id " << key_entry_id << ", block id "
                                 << time_entry.block_id();
-                        block->dim_cnt_down++;
-                        segment->BulkLoadPut(key_entry_id, pk, time_entry.time(), block);
+                        rows.emplace_back(time_entry.time(), block);
+                    }
+                    for (auto& row : rows) {
+                        row.second->dim_cnt_down++;
                     }
+                    segment->BulkLoadPut(key_entry_id, pk, rows);
                 }
             }
         }
@@ -837,18 +944,17 @@ bool MemTableKeyIterator::Valid() {
 void MemTableKeyIterator::Next() { NextPK(); }
 
 ::hybridse::vm::RowIterator* MemTableKeyIterator::GetRawValue() {
-    TimeEntries::Iterator* it = NULL;
+    KeyEntry* entry = NULL;
     if (segments_[seg_idx_]->GetTsCnt() > 1) {
-        KeyEntry* entry = ((KeyEntry**)pk_it_->GetValue())[ts_idx_];  // NOLINT
-        it = entry->entries.NewIterator();
-        ticket_.Push(entry);
+        entry = ((KeyEntry**)pk_it_->GetValue())[ts_idx_];  // NOLINT
     } else {
-        it = ((KeyEntry*)pk_it_->GetValue())  // NOLINT
-                 ->entries.NewIterator();
-        ticket_.Push((KeyEntry*)pk_it_->GetValue());  // NOLINT
+        entry = (KeyEntry*)pk_it_->GetValue();  // NOLINT
     }
+    ticket_.Push(entry);
+    uint64_t shadow_version = entry->shadow_ == NULL ? 0 : entry->shadow_->GetVersion();
+    TimeEntries::Iterator* it = entry->entries.NewIterator();
     it->SeekToFirst();
-    return new MemTableWindowIterator(it, ttl_type_, expire_time_, expire_cnt_);
+    return new MemTableWindowIterator(it, ttl_type_, expire_time_, expire_cnt_, entry->shadow_, shadow_version);
 }
 
 std::unique_ptr<::hybridse::vm::RowIterator> MemTableKeyIterator::GetValue() {
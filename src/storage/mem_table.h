@@ -38,11 +38,18 @@ namespace storage {
 
 typedef google::protobuf::RepeatedPtrField<::openmldb::api::Dimension> Dimensions;
 
-class MemTableWindowIterator : public ::hybridse::vm::RowIterator {
+class MemTableWindowIterator : public ::hybridse::codec::ColumnarRowIterator {
  public:
     MemTableWindowIterator(TimeEntries::Iterator* it, ::openmldb::storage::TTLType ttl_type, uint64_t expire_time,
                            uint64_t expire_cnt)
-        : it_(it), record_idx_(1), expire_value_(expire_time, expire_cnt, ttl_type), row_() {}
+        : it_(it), record_idx_(1), expire_value_(expire_time, expire_cnt, ttl_type), row_(), shadow_(NULL),
+          shadow_version_(0) {}
+
+    // the version of shadow should be got before `it` is created
+    MemTableWindowIterator(TimeEntries::Iterator* it, ::openmldb::storage::TTLType ttl_type, uint64_t expire_time,
+                           uint64_t expire_cnt, ColumnarShadow* shadow, uint64_t shadow_version)
+        : it_(it), record_idx_(1), expire_value_(expire_time, expire_cnt, ttl_type), row_(), shadow_(shadow),
+          shadow_version_(shadow_version) {}
 
     ~MemTableWindowIterator() { delete it_; }
 
@@ -73,11 +80,22 @@ class MemTableWindowIterator : public ::hybridse::vm::RowIterator {
     }
     bool IsSeekable() const override { return true; }
 
+    bool AppendColumnar(uint64_t key, uint64_t cnt, std::vector<::hybridse::codec::ColumnarArray>* arrays) override {
+        return shadow_ != NULL && shadow_->Append(shadow_version_, key, cnt, arrays);
+    }
+
+    bool AppendColumnar(const ::hybridse::codec::Row& row,
+                        std::vector<::hybridse::codec::ColumnarArray>* arrays) override {
+        return shadow_ != NULL && shadow_->Append(row.buf(), row.size(), arrays);
+    }
+
  private:
     TimeEntries::Iterator* it_;
     uint32_t record_idx_;
     TTLSt expire_value_;
     ::hybridse::codec::Row row_;
+    ColumnarShadow* shadow_;
+    uint64_t shadow_version_;
 };
 
 class MemTableKeyIterator : public ::hybridse::vm::WindowIterator {
@@ -195,10 +213,16 @@ class MemTable : public Table {
 
     uint64_t GetRecordByteSize() const override { return record_byte_size_.load(std::memory_order_relaxed); }
 
+    // the memory hold by the slabs of all segments and the part in use, both are 0 if slab is disabled
+    void GetSlabByteSize(uint64_t* byte_size, uint64_t* used_byte_size);
+
     uint64_t GetRecordCnt() const override { return record_cnt_.load(std::memory_order_relaxed); }
 
     inline uint32_t GetSegCnt() const { return seg_cnt_; }
 
+    // the index of the segment which the key is put into
+    uint32_t GetSegIdx(const std::string& key) const;
+
     inline void SetExpire(bool is_expire) { enable_gc_.store(is_expire, std::memory_order_relaxed); }
 
     uint64_t GetExpireTime(const TTLSt& ttl_st) override;
@@ -222,6 +246,9 @@ class MemTable : public Table {
 
     bool CheckLatest(uint32_t index_id, const std::string& key, uint64_t ts);
 
+    // keep the columnar columns of the indexes of inner_index in the segments
+    void InitColumnarShadow(const std::shared_ptr<InnerIndexSt>& inner_index, Segment** seg_arr);
+
  private:
     uint32_t seg_cnt_;
     std::vector<Segment**> segments_;
@@ -20,9 +20,17 @@
 #ifdef DISALLOW_COPY_AND_ASSIGN
 #undef DISALLOW_COPY_AND_ASSIGN
 #endif
+#include <fcntl.h>
 #include <snappy.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <mutex>  // NOLINT
 #include <set>
 #include <utility>
 
@@ -38,9 +46,11 @@
 #include "common/thread_pool.h"
 #include "common/timer.h"
 #include "gflags/gflags.h"
+#include "log/log_format.h"
 #include "log/log_reader.h"
 #include "log/sequential_file.h"
 #include "proto/tablet.pb.h"
+#include "storage/mem_table.h"
 
 using google::protobuf::RepeatedPtrField;
 using ::openmldb::codec::SchemaCodec;
@@ -51,7 +61,10 @@ DECLARE_uint32(make_snapshot_max_deleted_keys);
 DECLARE_uint32(load_table_batch);
 DECLARE_uint32(load_table_thread_num);
 DECLARE_uint32(load_table_queue_size);
+DECLARE_bool(recover_snapshot_with_mmap);
 DECLARE_string(snapshot_compression);
+DECLARE_uint32(make_snapshot_thread_num);
+DECLARE_uint32(snapshot_part_num);
 
 namespace openmldb {
 namespace storage {
@@ -59,6 +72,146 @@ namespace storage {
 const std::string SNAPSHOT_SUBFIX = ".sdb";  // NOLINT
 const uint32_t KEY_NUM_DISPLAY = 1000000;    // NOLINT
 const std::string MANIFEST = "MANIFEST";     // NOLINT
+const uint32_t MAKE_SNAPSHOT_BATCH_SIZE = 1024;
+
+static bool IsCompressedFile(const std::string& path) {
+    return path.find(openmldb::log::ZLIB_COMPRESS_SUFFIX) != std::string::npos ||
+           path.find(openmldb::log::SNAPPY_COMPRESS_SUFFIX) != std::string::npos;
+}
+
+// reads the records of all the files of a snapshot one file after another
+class SnapshotReader {
+ public:
+    SnapshotReader(const std::string& snapshot_path, const std::vector<std::string>& files)
+        : snapshot_path_(snapshot_path), files_(files) {}
+
+    ~SnapshotReader() {
+        for (auto& file : opened_) {
+            delete file.second;
+            // will close the fd
+            delete file.first;
+        }
+    }
+
+    bool Open() {
+        for (const auto& name : files_) {
+            std::string full_path = snapshot_path_ + name;
+            FILE* fd = fopen(full_path.c_str(), "rb");
+            if (fd == NULL) {
+                PDLOG(WARNING, "fail to open path %s for error %s", full_path.c_str(), strerror(errno));
+                return false;
+            }
+            ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(full_path, fd);
+            opened_.emplace_back(seq_file,
+                                 new ::openmldb::log::Reader(seq_file, NULL, false, 0, IsCompressedFile(full_path)));
+        }
+        return true;
+    }
+
+    // return eof after the last record of the last file
+    ::openmldb::log::Status ReadRecord(::openmldb::base::Slice* record, std::string* buffer) {
+        while (cur_ < opened_.size()) {
+            ::openmldb::log::Status status = opened_[cur_].second->ReadRecord(record, buffer);
+            if (!status.IsEof()) {
+                return status;
+            }
+            cur_++;
+        }
+        return ::openmldb::log::Status::Eof();
+    }
+
+ private:
+    std::string snapshot_path_;
+    std::vector<std::string> files_;
+    std::vector<std::pair<::openmldb::log::SequentialFile*, ::openmldb::log::Reader*>> opened_;
+    size_t cur_ = 0;
+};
+
+// the state of a record after it is parsed and filtered in making snapshot
+struct SnapshotRecordInfo {
+    enum Kind { kParseFailed, kDeleteOp, kDeletedKey, kExpired, kKeep };
+    Kind kind = kParseFailed;
+    uint64_t log_index = 0;
+    bool has_term = false;
+    uint64_t term = 0;
+    // the record without the dimensions of deleted keys and indexes
+    bool rewritten = false;
+    std::string rewritten_record;
+};
+
+// records are read, filtered in parallel and written in batches
+struct SnapshotBatch {
+    bool from_binlog = false;
+    std::vector<std::string> records;
+    std::vector<SnapshotRecordInfo> infos;
+    // the records to write, they point into records and infos
+    std::vector<::openmldb::base::Slice> kept;
+    bool filtered = false;
+};
+
+// hands the batches from the reader to the writer in the order they are read,
+// and limits the batches in flight
+class SnapshotPipeline {
+ public:
+    explicit SnapshotPipeline(uint32_t max_pending) : max_pending_(max_pending) {}
+
+    // return false if the pipeline is stopped
+    bool Push(const std::shared_ptr<SnapshotBatch>& batch) {
+        std::unique_lock<std::mutex> lock(mu_);
+        cv_.wait(lock, [this] { return stop_ || batches_.size() < max_pending_; });
+        if (stop_) {
+            return false;
+        }
+        batches_.push_back(batch);
+        return true;
+    }
+
+    void SetFiltered(const std::shared_ptr<SnapshotBatch>& batch) {
+        std::lock_guard<std::mutex> lock(mu_);
+        batch->filtered = true;
+        cv_.notify_all();
+    }
+
+    // return nullptr if all the batches read are consumed
+    std::shared_ptr<SnapshotBatch> Pop() {
+        std::unique_lock<std::mutex> lock(mu_);
+        cv_.wait(lock, [this] { return batches_.empty() ? read_done_ : batches_.front()->filtered; });
+        if (batches_.empty()) {
+            return nullptr;
+        }
+        auto batch = batches_.front();
+        batches_.pop_front();
+        cv_.notify_all();
+        return batch;
+    }
+
+    void FinishRead(bool ok) {
+        std::lock_guard<std::mutex> lock(mu_);
+        read_done_ = true;
+        read_ok_ = ok;
+        cv_.notify_all();
+    }
+
+    void Stop() {
+        std::lock_guard<std::mutex> lock(mu_);
+        stop_ = true;
+        cv_.notify_all();
+    }
+
+    bool ReadOk() {
+        std::lock_guard<std::mutex> lock(mu_);
+        return read_ok_;
+    }
+
+ private:
+    uint32_t max_pending_;
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::deque<std::shared_ptr<SnapshotBatch>> batches_;
+    bool read_done_ = false;
+    bool read_ok_ = true;
+    bool stop_ = false;
+};
 
 MemTableSnapshot::MemTableSnapshot(uint32_t tid, uint32_t pid, LogParts* log_part, const std::string& db_root_path)
     : Snapshot(tid, pid), log_part_(log_part), db_root_path_(db_root_path) {}
@@ -85,94 +238,221 @@ bool MemTableSnapshot::Recover(std::shared_ptr<Table> table, uint64_t& latest_of
         return false;
     }
     if (ret == 0) {
-        RecoverFromSnapshot(manifest.name(), manifest.count(), table);
+        RecoverFromSnapshot(GetSnapshotFiles(manifest), manifest.count(), table);
         latest_offset = manifest.offset();
         offset_ = latest_offset;
     }
     return true;
 }
 
-void MemTableSnapshot::RecoverFromSnapshot(const std::string& snapshot_name, uint64_t expect_cnt,
+void MemTableSnapshot::RecoverFromSnapshot(const std::vector<std::string>& snapshot_files, uint64_t expect_cnt,
                                            std::shared_ptr<Table> table) {
-    std::string full_path = snapshot_path_ + "/" + snapshot_name;
     std::atomic<uint64_t> g_succ_cnt(0);
     std::atomic<uint64_t> g_failed_cnt(0);
-    RecoverSingleSnapshot(full_path, table, &g_succ_cnt, &g_failed_cnt);
+    if (snapshot_files.size() == 1) {
+        RecoverSingleSnapshot(snapshot_path_ + "/" + snapshot_files[0], table, &g_succ_cnt, &g_failed_cnt);
+    } else {
+        // the parts of a snapshot are loaded at the same time
+        ::openmldb::base::TaskPool part_pool(snapshot_files.size(), snapshot_files.size());
+        for (const auto& name : snapshot_files) {
+            std::string full_path = snapshot_path_ + "/" + name;
+            part_pool.AddTask([this, full_path, table, &g_succ_cnt, &g_failed_cnt] {
+                RecoverSingleSnapshot(full_path, table, &g_succ_cnt, &g_failed_cnt);
+            });
+        }
+        part_pool.Stop();
+    }
     PDLOG(INFO, "[Recover] progress done stat: success count %lu, failed count %lu",
           g_succ_cnt.load(std::memory_order_relaxed), g_failed_cnt.load(std::memory_order_relaxed));
     if (g_succ_cnt.load(std::memory_order_relaxed) != expect_cnt) {
-        PDLOG(WARNING, "snapshot %s , expect cnt %lu but succ_cnt %lu", snapshot_name.c_str(), expect_cnt,
+        PDLOG(WARNING, "snapshot %s , expect cnt %lu but succ_cnt %lu", snapshot_files[0].c_str(), expect_cnt,
               g_succ_cnt.load(std::memory_order_relaxed));
     }
 }
 
 void MemTableSnapshot::RecoverSingleSnapshot(const std::string& path, std::shared_ptr<Table> table,
                                              std::atomic<uint64_t>* g_succ_cnt, std::atomic<uint64_t>* g_failed_cnt) {
-    ::openmldb::base::TaskPool load_pool_(FLAGS_load_table_thread_num, FLAGS_load_table_batch);
+    if (table == NULL) {
+        PDLOG(WARNING, "table input is NULL");
+        return;
+    }
     std::atomic<uint64_t> succ_cnt, failed_cnt;
     succ_cnt = failed_cnt = 0;
+    uint64_t start_time = ::baidu::common::timer::get_micros();
+    bool loaded = false;
+    if (FLAGS_recover_snapshot_with_mmap && !IsCompressed(path)) {
+        loaded = LoadSnapshotWithMmap(path, table, &succ_cnt, &failed_cnt);
+    }
+    if (!loaded && !LoadSnapshotWithReader(path, table, &succ_cnt, &failed_cnt)) {
+        return;
+    }
+    uint64_t consumed = ::baidu::common::timer::get_micros() - start_time;
+    PDLOG(INFO,
+          "read path %s for table tid %u pid %u completed, "
+          "succ_cnt %lu, failed_cnt %lu, consumed %lums, %lu rows/s",
+          path.c_str(), tid_, pid_, succ_cnt.load(std::memory_order_relaxed),
+          failed_cnt.load(std::memory_order_relaxed), consumed / 1000,
+          succ_cnt.load(std::memory_order_relaxed) * 1000000 / std::max(consumed, static_cast<uint64_t>(1)));
+    if (g_succ_cnt) {
+        g_succ_cnt->fetch_add(succ_cnt, std::memory_order_relaxed);
+    }
+    if (g_failed_cnt) {
+        g_failed_cnt->fetch_add(failed_cnt, std::memory_order_relaxed);
+    }
+}
 
-    do {
-        if (table == NULL) {
-            PDLOG(WARNING, "table input is NULL");
+bool MemTableSnapshot::LoadSnapshotWithReader(const std::string& path, std::shared_ptr<Table> table,
+                                              std::atomic<uint64_t>* succ_cnt, std::atomic<uint64_t>* failed_cnt) {
+    FILE* fd = fopen(path.c_str(), "rb");
+    if (fd == NULL) {
+        PDLOG(WARNING, "fail to open path %s for error %s", path.c_str(), strerror(errno));
+        return false;
+    }
+    ::openmldb::base::TaskPool load_pool_(FLAGS_load_table_thread_num, FLAGS_load_table_batch);
+    bool compressed = IsCompressed(path);
+    ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(path, fd);
+    ::openmldb::log::Reader reader(seq_file, NULL, false, 0, compressed);
+    std::string buffer;
+    std::vector<std::string*> recordPtr;
+    recordPtr.reserve(FLAGS_load_table_batch);
+    while (true) {
+        buffer.clear();
+        ::openmldb::base::Slice record;
+        ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
+        if (status.IsWaitRecord() || status.IsEof()) {
             break;
         }
-        FILE* fd = fopen(path.c_str(), "rb");
-        if (fd == NULL) {
-            PDLOG(WARNING, "fail to open path %s for error %s", path.c_str(), strerror(errno));
-            break;
+        if (!status.ok()) {
+            PDLOG(WARNING, "fail to read record for tid %u, pid %u with error %s", tid_, pid_,
+                  status.ToString().c_str());
+            failed_cnt->fetch_add(1, std::memory_order_relaxed);
+            continue;
         }
-        bool compressed = IsCompressed(path);
-        ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(path, fd);
-        ::openmldb::log::Reader reader(seq_file, NULL, false, 0, compressed);
-        std::string buffer;
-        // second
-        uint64_t consumed = ::baidu::common::timer::now_time();
-        std::vector<std::string*> recordPtr;
-        recordPtr.reserve(FLAGS_load_table_batch);
-
-        while (true) {
-            buffer.clear();
-            ::openmldb::base::Slice record;
-            ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
-            if (status.IsWaitRecord() || status.IsEof()) {
-                consumed = ::baidu::common::timer::now_time() - consumed;
-                PDLOG(INFO,
-                      "read path %s for table tid %u pid %u completed, "
-                      "succ_cnt %lu, failed_cnt %lu, consumed %us",
-                      path.c_str(), tid_, pid_, succ_cnt.load(std::memory_order_relaxed),
-                      failed_cnt.load(std::memory_order_relaxed), consumed);
-                break;
-            }
+        std::string* sp = new std::string(record.data(), record.size());
+        recordPtr.push_back(sp);
+        if (recordPtr.size() >= FLAGS_load_table_batch) {
+            load_pool_.AddTask(boost::bind(&MemTableSnapshot::Put, this, path, table, recordPtr, succ_cnt, failed_cnt));
+            recordPtr.clear();
+        }
+    }
+    if (recordPtr.size() > 0) {
+        load_pool_.AddTask(boost::bind(&MemTableSnapshot::Put, this, path, table, recordPtr, succ_cnt, failed_cnt));
+    }
+    load_pool_.Stop();
+    // will close the fd atomic
+    delete seq_file;
+    return true;
+}
 
-            if (!status.ok()) {
-                PDLOG(WARNING, "fail to read record for tid %u, pid %u with error %s", tid_, pid_,
-                      status.ToString().c_str());
-                failed_cnt.fetch_add(1, std::memory_order_relaxed);
-                continue;
+bool MemTableSnapshot::LoadSnapshotWithMmap(const std::string& path, std::shared_ptr<Table> table,
+                                            std::atomic<uint64_t>* succ_cnt, std::atomic<uint64_t>* failed_cnt) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        PDLOG(WARNING, "fail to open path %s for error %s", path.c_str(), strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        PDLOG(WARNING, "fail to stat path %s for error %s", path.c_str(), strerror(errno));
+        close(fd);
+        return false;
+    }
+    uint64_t size = st.st_size;
+    if (size == 0) {
+        close(fd);
+        return true;
+    }
+    void* addr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        PDLOG(WARNING, "fail to mmap path %s for error %s", path.c_str(), strerror(errno));
+        return false;
+    }
+    madvise(addr, size, MADV_SEQUENTIAL);
+    const char* data = reinterpret_cast<const char*>(addr);
+    // the rows are sharded to the loaders by the segment of their first dimension, so the segments of the first
+    // index are each fed by one loader. the segments of the other indexes take rows from several loaders and rely on
+    // the segment locks like the normal put path
+    auto mem_table = std::dynamic_pointer_cast<MemTable>(table);
+    uint32_t loader_num = std::max(FLAGS_load_table_thread_num, 1u);
+    if (mem_table) {
+        loader_num = std::min(loader_num, std::max(mem_table->GetSegCnt(), 1u));
+    }
+    std::vector<std::shared_ptr<::openmldb::base::TaskPool>> loaders;
+    for (uint32_t i = 0; i < loader_num; i++) {
+        loaders.push_back(std::make_shared<::openmldb::base::TaskPool>(1, FLAGS_load_table_queue_size));
+    }
+    // the file is split at block boundaries and each reader parses the records starting in its range
+    uint64_t block_num = (size + ::openmldb::log::kBlockSize - 1) / ::openmldb::log::kBlockSize;
+    uint64_t reader_num = std::min(static_cast<uint64_t>(std::max(FLAGS_load_table_thread_num, 1u)), block_num);
+    uint64_t blocks_per_reader = (block_num + reader_num - 1) / reader_num;
+    uint32_t chunk_size = std::max(FLAGS_load_table_batch, 1u) * loader_num;
+    auto read_range = [&](uint64_t begin, uint64_t end) {
+        ::openmldb::log::BlockRangeReader reader(data, size, begin, end, false);
+        std::string scratch;
+        bool eof = false;
+        while (!eof) {
+            std::vector<std::shared_ptr<std::vector<::openmldb::api::LogEntry>>> shards(loader_num);
+            ::openmldb::api::LogEntry entry;
+            for (uint32_t cnt = 0; cnt < chunk_size; cnt++) {
+                ::openmldb::base::Slice record;
+                ::openmldb::log::Status status = reader.ReadRecord(&record, &scratch);
+                if (status.IsEof()) {
+                    eof = true;
+                    break;
+                }
+                if (!status.ok()) {
+                    PDLOG(WARNING, "fail to read record for tid %u, pid %u with error %s", tid_, pid_,
+                          status.ToString().c_str());
+                    failed_cnt->fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                if (!entry.ParseFromArray(record.data(), record.size())) {
+                    failed_cnt->fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                uint32_t shard = 0;
+                if (mem_table && entry.dimensions_size() > 0) {
+                    shard = mem_table->GetSegIdx(entry.dimensions(0).key()) % loader_num;
+                }
+                if (!shards[shard]) {
+                    shards[shard] = std::make_shared<std::vector<::openmldb::api::LogEntry>>();
+                    shards[shard]->reserve(FLAGS_load_table_batch);
+                }
+                shards[shard]->push_back(std::move(entry));
             }
-            std::string* sp = new std::string(record.data(), record.size());
-            recordPtr.push_back(sp);
-            if (recordPtr.size() >= FLAGS_load_table_batch) {
-                load_pool_.AddTask(
-                    boost::bind(&MemTableSnapshot::Put, this, path, table, recordPtr, &succ_cnt, &failed_cnt));
-                recordPtr.clear();
+            for (uint32_t i = 0; i < loader_num; i++) {
+                if (!shards[i]) {
+                    continue;
+                }
+                auto entries = shards[i];
+                loaders[i]->AddTask([this, &path, &table, entries, succ_cnt, failed_cnt] {
+                    for (const auto& entry : *entries) {
+                        auto scount = succ_cnt->fetch_add(1, std::memory_order_relaxed);
+                        if (scount % 100000 == 0) {
+                            PDLOG(INFO, "load snapshot %s with succ_cnt %lu, failed_cnt %lu", path.c_str(), scount,
+                                  failed_cnt->load(std::memory_order_relaxed));
+                        }
+                        table->Put(entry);
+                    }
+                });
             }
         }
-        if (recordPtr.size() > 0) {
-            load_pool_.AddTask(
-                boost::bind(&MemTableSnapshot::Put, this, path, table, recordPtr, &succ_cnt, &failed_cnt));
-        }
-        // will close the fd atomic
-        delete seq_file;
-        if (g_succ_cnt) {
-            g_succ_cnt->fetch_add(succ_cnt, std::memory_order_relaxed);
-        }
-        if (g_failed_cnt) {
-            g_failed_cnt->fetch_add(failed_cnt, std::memory_order_relaxed);
+    };
+    {
+        ::openmldb::base::TaskPool read_pool(reader_num, reader_num);
+        for (uint64_t i = 0; i < reader_num; i++) {
+            uint64_t begin = i * blocks_per_reader * ::openmldb::log::kBlockSize;
+            uint64_t end = std::min(block_num, (i + 1) * blocks_per_reader) * ::openmldb::log::kBlockSize;
+            read_pool.AddTask([&read_range, begin, end] { read_range(begin, end); });
         }
-    } while (false);
-    load_pool_.Stop();
+        read_pool.Stop();
+    }
+    for (auto& loader : loaders) {
+        loader->Stop();
+    }
+    munmap(addr, size);
+    return true;
 }
 
 void MemTableSnapshot::Put(std::string& path, std::shared_ptr<Table>& table, std::vector<std::string*> recordPtr,
@@ -195,84 +475,6 @@ void MemTableSnapshot::Put(std::string& path, std::shared_ptr<Table>& table, std
     }
 }
 
-int MemTableSnapshot::TTLSnapshot(std::shared_ptr<Table> table, const ::openmldb::api::Manifest& manifest,
-                                  WriteHandle* wh, uint64_t& count, uint64_t& expired_key_num,
-                                  uint64_t& deleted_key_num) {
-    std::string full_path = snapshot_path_ + manifest.name();
-    FILE* fd = fopen(full_path.c_str(), "rb");
-    if (fd == NULL) {
-        PDLOG(WARNING, "fail to open path %s for error %s", full_path.c_str(), strerror(errno));
-        return -1;
-    }
-    bool compressed = IsCompressed(full_path);
-    ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(manifest.name(), fd);
-    ::openmldb::log::Reader reader(seq_file, NULL, false, 0, compressed);
-
-    std::string buffer;
-    std::string tmp_buf;
-    ::openmldb::api::LogEntry entry;
-    bool has_error = false;
-    std::set<uint32_t> deleted_index;
-    for (const auto& it : table->GetAllIndex()) {
-        if (it->GetStatus() != ::openmldb::storage::IndexStatus::kReady) {
-            deleted_index.insert(it->GetId());
-        }
-    }
-    while (true) {
-        ::openmldb::base::Slice record;
-        ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
-        if (status.IsEof()) {
-            break;
-        }
-        if (!status.ok()) {
-            PDLOG(WARNING, "fail to read record for tid %u, pid %u with error %s", tid_, pid_,
-                  status.ToString().c_str());
-            has_error = true;
-            break;
-        }
-        if (!entry.ParseFromString(record.ToString())) {
-            PDLOG(WARNING, "fail parse record for tid %u, pid %u with value %s", tid_, pid_,
-                  ::openmldb::base::DebugString(record.ToString()).c_str());
-            has_error = true;
-            break;
-        }
-        int ret = RemoveDeletedKey(entry, deleted_index, &tmp_buf);
-        if (ret == 1) {
-            deleted_key_num++;
-            continue;
-        } else if (ret == 2) {
-            record.reset(tmp_buf.data(), tmp_buf.size());
-        }
-        if (table->IsExpire(entry)) {
-            expired_key_num++;
-            continue;
-        }
-        status = wh->Write(record);
-        if (!status.ok()) {
-            PDLOG(WARNING, "fail to write snapshot. status[%s]", status.ToString().c_str());
-            has_error = true;
-            break;
-        }
-        if ((count + expired_key_num + deleted_key_num) % KEY_NUM_DISPLAY == 0) {
-            PDLOG(INFO, "tackled key num[%lu] total[%lu]", count + expired_key_num, manifest.count());
-        }
-        count++;
-    }
-    delete seq_file;
-    if (expired_key_num + count + deleted_key_num != manifest.count()) {
-        PDLOG(WARNING,
-              "key num not match! total key num[%lu] load key num[%lu] ttl key "
-              "num[%lu]",
-              manifest.count(), count, expired_key_num);
-        has_error = true;
-    }
-    if (has_error) {
-        return -1;
-    }
-    PDLOG(INFO, "load snapshot success. load key num[%lu] ttl key num[%lu]", count, expired_key_num);
-    return 0;
-}
-
 uint64_t MemTableSnapshot::CollectDeletedKey(uint64_t end_offset) {
     deleted_keys_.clear();
     ::openmldb::log::LogReader log_reader(log_part_, log_path_, false);
@@ -341,6 +543,130 @@ uint64_t MemTableSnapshot::CollectDeletedKey(uint64_t end_offset) {
     return cur_offset;
 }
 
+bool MemTableSnapshot::ReadSnapshotRecords(const std::vector<std::string>& old_files,
+                                           const std::function<bool(const std::shared_ptr<SnapshotBatch>&)>& submit) {
+    auto batch = std::make_shared<SnapshotBatch>();
+    if (!old_files.empty()) {
+        SnapshotReader reader(snapshot_path_, old_files);
+        if (!reader.Open()) {
+            return false;
+        }
+        std::string buffer;
+        while (true) {
+            ::openmldb::base::Slice record;
+            ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
+            if (status.IsEof()) {
+                break;
+            }
+            if (!status.ok()) {
+                PDLOG(WARNING, "fail to read record for tid %u, pid %u with error %s", tid_, pid_,
+                      status.ToString().c_str());
+                return false;
+            }
+            batch->records.emplace_back(record.data(), record.size());
+            if (batch->records.size() >= MAKE_SNAPSHOT_BATCH_SIZE) {
+                if (!submit(batch)) {
+                    return true;
+                }
+                batch = std::make_shared<SnapshotBatch>();
+            }
+        }
+        if (!batch->records.empty()) {
+            if (!submit(batch)) {
+                return true;
+            }
+            batch = std::make_shared<SnapshotBatch>();
+        }
+    }
+    batch->from_binlog = true;
+    ::openmldb::log::LogReader log_reader(log_part_, log_path_, false);
+    log_reader.SetOffset(offset_);
+    std::string buffer;
+    while (true) {
+        buffer.clear();
+        ::openmldb::base::Slice record;
+        ::openmldb::log::Status status = log_reader.ReadNextRecord(&record, &buffer);
+        if (status.ok()) {
+            batch->records.emplace_back(record.data(), record.size());
+            if (batch->records.size() >= MAKE_SNAPSHOT_BATCH_SIZE) {
+                if (!submit(batch)) {
+                    return true;
+                }
+                batch = std::make_shared<SnapshotBatch>();
+                batch->from_binlog = true;
+            }
+        } else if (status.IsEof()) {
+            continue;
+        } else if (status.IsWaitRecord()) {
+            int end_log_index = log_reader.GetEndLogIndex();
+            int cur_log_index = log_reader.GetLogIndex();
+            // judge end_log_index greater than cur_log_index
+            if (end_log_index >= 0 && end_log_index > cur_log_index) {
+                log_reader.RollRLogFile();
+                PDLOG(WARNING, "read new binlog file. tid[%u] pid[%u] cur_log_index[%d] end_log_index[%d]", tid_,
+                      pid_, cur_log_index, end_log_index);
+                continue;
+            }
+            DEBUGLOG("has read all record!");
+            break;
+        } else {
+            PDLOG(WARNING, "fail to get record. status is %s", status.ToString().c_str());
+            return false;
+        }
+    }
+    if (!batch->records.empty()) {
+        submit(batch);
+    }
+    return true;
+}
+
+void MemTableSnapshot::FilterSnapshotBatch(const std::shared_ptr<Table>& table,
+                                           const std::set<uint32_t>& snapshot_deleted_index,
+                                           const std::set<uint32_t>& binlog_deleted_index, SnapshotBatch* batch) {
+    const std::set<uint32_t>& deleted_index = batch->from_binlog ? binlog_deleted_index : snapshot_deleted_index;
+    batch->infos.resize(batch->records.size());
+    ::openmldb::api::LogEntry entry;
+    for (size_t i = 0; i < batch->records.size(); i++) {
+        SnapshotRecordInfo& info = batch->infos[i];
+        if (!entry.ParseFromString(batch->records[i])) {
+            info.kind = SnapshotRecordInfo::kParseFailed;
+            continue;
+        }
+        info.log_index = entry.log_index();
+        info.has_term = entry.has_term();
+        info.term = entry.term();
+        if (batch->from_binlog && entry.has_method_type() &&
+            entry.method_type() == ::openmldb::api::MethodType::kDelete) {
+            info.kind = SnapshotRecordInfo::kDeleteOp;
+            continue;
+        }
+        int ret = RemoveDeletedKey(entry, deleted_index, &info.rewritten_record);
+        if (ret == 1) {
+            info.kind = SnapshotRecordInfo::kDeletedKey;
+            continue;
+        }
+        info.rewritten = ret == 2;
+        if (table->IsExpire(entry)) {
+            info.kind = SnapshotRecordInfo::kExpired;
+            continue;
+        }
+        info.kind = SnapshotRecordInfo::kKeep;
+    }
+}
+
+void MemTableSnapshot::DeleteOldSnapshot(const ::openmldb::api::Manifest& old_manifest,
+                                         const std::vector<std::string>& new_files) {
+    if (!old_manifest.has_name()) {
+        return;
+    }
+    for (const auto& name : GetSnapshotFiles(old_manifest)) {
+        if (std::find(new_files.begin(), new_files.end(), name) == new_files.end()) {
+            DEBUGLOG("old snapshot[%s] has deleted", name.c_str());
+            unlink((snapshot_path_ + name).c_str());
+        }
+    }
+}
+
 int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_offset, uint64_t end_offset,
                                    uint64_t term) {
     if (making_snapshot_.load(std::memory_order_acquire)) {
@@ -352,36 +678,52 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
         return -1;
     }
     making_snapshot_.store(true, std::memory_order_release);
-    std::string now_time = ::openmldb::base::GetNowTime();
-    std::string snapshot_name = now_time.substr(0, now_time.length() - 2) + ".sdb";
-    if (FLAGS_snapshot_compression != "off") {
-        snapshot_name.append(".");
-        snapshot_name.append(FLAGS_snapshot_compression);
+    // a large snapshot is split into parts which are written and loaded in parallel
+    uint32_t part_num = std::max(FLAGS_snapshot_part_num, 1u);
+    std::vector<std::string> snapshot_names;
+    if (part_num == 1) {
+        snapshot_names.push_back(GenSnapshotName());
+    } else {
+        std::string now_time = ::openmldb::base::GetNowTime();
+        std::string compression_suffix = FLAGS_snapshot_compression != "off" ? "." + FLAGS_snapshot_compression : "";
+        for (uint32_t i = 0; i < part_num; i++) {
+            snapshot_names.push_back(now_time.substr(0, now_time.length() - 2) + "_" + std::to_string(i) + ".sdb" +
+                                     compression_suffix);
+        }
     }
-    std::string snapshot_name_tmp = snapshot_name + ".tmp";
-    std::string full_path = snapshot_path_ + snapshot_name;
-    std::string tmp_file_path = snapshot_path_ + snapshot_name_tmp;
-    FILE* fd = fopen(tmp_file_path.c_str(), "ab+");
-    if (fd == NULL) {
-        PDLOG(WARNING, "fail to create file %s", tmp_file_path.c_str());
+    std::vector<WriteHandle*> whs;
+    bool has_error = false;
+    for (const auto& snapshot_name : snapshot_names) {
+        std::string snapshot_name_tmp = snapshot_name + ".tmp";
+        std::string tmp_file_path = snapshot_path_ + snapshot_name_tmp;
+        FILE* fd = fopen(tmp_file_path.c_str(), "ab+");
+        if (fd == NULL) {
+            PDLOG(WARNING, "fail to create file %s", tmp_file_path.c_str());
+            has_error = true;
+            break;
+        }
+        whs.push_back(new WriteHandle(FLAGS_snapshot_compression, snapshot_name_tmp, fd));
+    }
+    if (has_error) {
+        for (size_t i = 0; i < whs.size(); i++) {
+            delete whs[i];
+            unlink((snapshot_path_ + snapshot_names[i] + ".tmp").c_str());
+        }
         making_snapshot_.store(false, std::memory_order_release);
         return -1;
     }
     uint64_t collected_offset = CollectDeletedKey(end_offset);
     uint64_t start_time = ::baidu::common::timer::now_time();
-    WriteHandle* wh = new WriteHandle(FLAGS_snapshot_compression, snapshot_name_tmp, fd);
     ::openmldb::api::Manifest manifest;
-    bool has_error = false;
     uint64_t write_count = 0;
     uint64_t expired_key_num = 0;
     uint64_t deleted_key_num = 0;
     uint64_t last_term = term;
+    std::vector<std::string> old_files;
     int result = GetLocalManifest(snapshot_path_ + MANIFEST, manifest);
     if (result == 0) {
         // filter old snapshot
-        if (TTLSnapshot(table, manifest, wh, write_count, expired_key_num, deleted_key_num) < 0) {
-            has_error = true;
-        }
+        old_files = GetSnapshotFiles(manifest);
         last_term = manifest.term();
         DEBUGLOG("old manifest term is %lu", last_term);
     } else if (result < 0) {
@@ -389,123 +731,187 @@ int MemTableSnapshot::MakeSnapshot(std::shared_ptr<Table> table, uint64_t& out_o
         has_error = true;
     }
 
-    // get deleted index
-    std::set<uint32_t> deleted_index;
+    // the records of old snapshot skip the indexes not ready, and the ones of binlog skip the deleted indexes
+    std::set<uint32_t> snapshot_deleted_index;
+    std::set<uint32_t> binlog_deleted_index;
     for (const auto& it : table->GetAllIndex()) {
-        if (it->GetStatus() == ::openmldb::storage::IndexStatus::kDeleted) {
-            deleted_index.insert(it->GetId());
+        if (it->GetStatus() != ::openmldb::storage::IndexStatus::kReady) {
+            snapshot_deleted_index.insert(it->GetId());
         }
+        if (it->GetStatus() == ::openmldb::storage::IndexStatus::kDeleted) {
+            binlog_deleted_index.insert(it->GetId());
+        }
+    }
+    // the reader reads old snapshot and binlog in order, the records are parsed and filtered by the filter
+    // pool, then this thread takes the batches in order to track the offset and term, and each part is
+    // compressed and written by its own thread
+    uint32_t thread_num = std::max(FLAGS_make_snapshot_thread_num, 1u);
+    uint32_t max_pending = thread_num * 2 + part_num;
+    SnapshotPipeline pipeline(max_pending);
+    ::openmldb::base::TaskPool read_pool(1, 1);
+    ::openmldb::base::TaskPool filter_pool(thread_num, max_pending + 1);
+    std::vector<std::shared_ptr<::openmldb::base::TaskPool>> write_pools;
+    for (uint32_t i = 0; i < part_num; i++) {
+        write_pools.push_back(std::make_shared<::openmldb::base::TaskPool>(1, max_pending + 1));
+    }
+    std::atomic<bool> write_error(false);
+    if (!has_error) {
+        read_pool.AddTask([this, &old_files, &pipeline, &filter_pool, &table, &snapshot_deleted_index,
+                           &binlog_deleted_index] {
+            bool ok = ReadSnapshotRecords(old_files, [&](const std::shared_ptr<SnapshotBatch>& batch) {
+                if (!pipeline.Push(batch)) {
+                    return false;
+                }
+                filter_pool.AddTask([this, &pipeline, &table, &snapshot_deleted_index, &binlog_deleted_index, batch] {
+                    FilterSnapshotBatch(table, snapshot_deleted_index, binlog_deleted_index, batch.get());
+                    pipeline.SetFiltered(batch);
+                });
+                return true;
+            });
+            pipeline.FinishRead(ok);
+        });
     }
-    ::openmldb::log::LogReader log_reader(log_part_, log_path_, false);
-    log_reader.SetOffset(offset_);
     uint64_t cur_offset = offset_;
-    std::string buffer;
-    std::string tmp_buf;
-    while (!has_error && cur_offset < collected_offset) {
-        buffer.clear();
-        ::openmldb::base::Slice record;
-        ::openmldb::log::Status status = log_reader.ReadNextRecord(&record, &buffer);
-        if (status.ok()) {
-            ::openmldb::api::LogEntry entry;
-            if (!entry.ParseFromString(record.ToString())) {
+    uint64_t snapshot_key_num = 0;
+    uint64_t written_batch_num = 0;
+    bool read_binlog_done = false;
+    while (!has_error && !read_binlog_done) {
+        std::shared_ptr<SnapshotBatch> batch = pipeline.Pop();
+        if (!batch) {
+            break;
+        }
+        for (size_t i = 0; i < batch->records.size(); i++) {
+            const SnapshotRecordInfo& info = batch->infos[i];
+            // the binlog records past collected_offset are read ahead by the reader, but they are not part of
+            // the snapshot, so they are not checked
+            if (batch->from_binlog && cur_offset >= collected_offset) {
+                read_binlog_done = true;
+                break;
+            }
+            if (info.kind == SnapshotRecordInfo::kParseFailed) {
                 PDLOG(WARNING, "fail to parse LogEntry. record[%s] size[%ld]",
-                      ::openmldb::base::DebugString(record.ToString()).c_str(), record.ToString().size());
+                      ::openmldb::base::DebugString(batch->records[i]).c_str(), batch->records[i].size());
                 has_error = true;
                 break;
             }
-            if (entry.log_index() <= cur_offset) {
-                continue;
-            }
-            if (cur_offset + 1 != entry.log_index()) {
-                PDLOG(WARNING, "log missing expect offset %lu but %ld", cur_offset + 1, entry.log_index());
-                continue;
-            }
-            cur_offset = entry.log_index();
-            if (entry.has_method_type() && entry.method_type() == ::openmldb::api::MethodType::kDelete) {
-                continue;
-            }
-            if (entry.has_term()) {
-                last_term = entry.term();
+            if (!batch->from_binlog) {
+                snapshot_key_num++;
+            } else {
+                if (info.log_index <= cur_offset) {
+                    continue;
+                }
+                if (cur_offset + 1 != info.log_index) {
+                    PDLOG(WARNING, "log missing expect offset %lu but %ld", cur_offset + 1, info.log_index);
+                    continue;
+                }
+                cur_offset = info.log_index;
+                if (info.kind == SnapshotRecordInfo::kDeleteOp) {
+                    continue;
+                }
+                if (info.has_term) {
+                    last_term = info.term;
+                }
             }
-            int ret = RemoveDeletedKey(entry, deleted_index, &tmp_buf);
-            if (ret == 1) {
+            if (info.kind == SnapshotRecordInfo::kDeletedKey) {
                 deleted_key_num++;
                 continue;
-            } else if (ret == 2) {
-                record.reset(tmp_buf.data(), tmp_buf.size());
-            }
-            if (table->IsExpire(entry)) {
+            } else if (info.kind == SnapshotRecordInfo::kExpired) {
                 expired_key_num++;
                 continue;
             }
-            ::openmldb::log::Status status = wh->Write(record);
-            if (!status.ok()) {
-                PDLOG(WARNING, "fail to write snapshot. path[%s] status[%s]", tmp_file_path.c_str(),
-                      status.ToString().c_str());
-                has_error = true;
-                break;
+            if (info.rewritten) {
+                batch->kept.emplace_back(info.rewritten_record);
+            } else {
+                batch->kept.emplace_back(batch->records[i]);
             }
             write_count++;
             if ((write_count + expired_key_num + deleted_key_num) % KEY_NUM_DISPLAY == 0) {
                 PDLOG(INFO, "has write key num[%lu] expired key num[%lu]", write_count, expired_key_num);
             }
-        } else if (status.IsEof()) {
-            continue;
-        } else if (status.IsWaitRecord()) {
-            int end_log_index = log_reader.GetEndLogIndex();
-            int cur_log_index = log_reader.GetLogIndex();
-            // judge end_log_index greater than cur_log_index
-            if (end_log_index >= 0 && end_log_index > cur_log_index) {
-                log_reader.RollRLogFile();
-                PDLOG(WARNING,
-                      "read new binlog file. tid[%u] pid[%u] cur_log_index[%d] "
-                      "end_log_index[%d] cur_offset[%lu]",
-                      tid_, pid_, cur_log_index, end_log_index, cur_offset);
-                continue;
-            }
-            DEBUGLOG("has read all record!");
-            break;
-        } else {
-            PDLOG(WARNING, "fail to get record. status is %s", status.ToString().c_str());
+        }
+        if (!has_error && !batch->kept.empty()) {
+            WriteHandle* wh = whs[written_batch_num % part_num];
+            write_pools[written_batch_num % part_num]->AddTask([wh, batch, &write_error] {
+                if (write_error.load(std::memory_order_relaxed)) {
+                    return;
+                }
+                ::openmldb::log::Status status = wh->Write(batch->kept);
+                if (!status.ok()) {
+                    PDLOG(WARNING, "fail to write snapshot. status[%s]", status.ToString().c_str());
+                    write_error.store(true, std::memory_order_relaxed);
+                }
+            });
+            written_batch_num++;
+        }
+    }
+    pipeline.Stop();
+    read_pool.Stop();
+    filter_pool.Stop();
+    for (auto& pool : write_pools) {
+        pool->Stop();
+    }
+    // a read error after collected_offset is reached does not fail the snapshot either
+    if ((!read_binlog_done && !pipeline.ReadOk()) || write_error.load(std::memory_order_relaxed)) {
+        has_error = true;
+    }
+    if (!has_error && result == 0) {
+        if (snapshot_key_num != manifest.count()) {
+            PDLOG(WARNING, "key num not match! total key num[%lu] load key num[%lu]", manifest.count(),
+                  snapshot_key_num);
             has_error = true;
-            break;
+        } else {
+            PDLOG(INFO, "load snapshot success. load key num[%lu]", snapshot_key_num);
         }
     }
-    if (wh != NULL) {
+    for (auto wh : whs) {
         wh->EndLog();
         delete wh;
-        wh = NULL;
     }
+    whs.clear();
     int ret = 0;
-    if (has_error) {
-        unlink(tmp_file_path.c_str());
-        ret = -1;
-    } else {
-        if (rename(tmp_file_path.c_str(), full_path.c_str()) == 0) {
-            if (GenManifest(snapshot_name, write_count, cur_offset, last_term) == 0) {
-                // delete old snapshot
-                if (manifest.has_name() && manifest.name() != snapshot_name) {
-                    DEBUGLOG("old snapshot[%s] has deleted", manifest.name().c_str());
-                    unlink((snapshot_path_ + manifest.name()).c_str());
+    if (!has_error) {
+        for (size_t i = 0; i < snapshot_names.size(); i++) {
+            std::string tmp_file_path = snapshot_path_ + snapshot_names[i] + ".tmp";
+            if (rename(tmp_file_path.c_str(), (snapshot_path_ + snapshot_names[i]).c_str()) != 0) {
+                PDLOG(WARNING, "rename[%s] failed", snapshot_names[i].c_str());
+                for (size_t j = 0; j < i; j++) {
+                    unlink((snapshot_path_ + snapshot_names[j]).c_str());
                 }
+                has_error = true;
+                ret = -1;
+                break;
+            }
+        }
+        if (!has_error) {
+            std::vector<std::string> parts;
+            if (snapshot_names.size() > 1) {
+                parts = snapshot_names;
+            }
+            if (GenManifest(snapshot_names[0], write_count, cur_offset, last_term, parts) == 0) {
+                DeleteOldSnapshot(manifest, snapshot_names);
                 uint64_t consumed = ::baidu::common::timer::now_time() - start_time;
                 PDLOG(INFO,
                       "make snapshot[%s] success. update offset from %lu to %lu."
                       "use %lu second. write key %lu expired key %lu deleted key "
-                      "%lu",
-                      snapshot_name.c_str(), offset_, cur_offset, consumed, write_count, expired_key_num,
-                      deleted_key_num);
+                      "%lu part num %u",
+                      snapshot_names[0].c_str(), offset_, cur_offset, consumed, write_count, expired_key_num,
+                      deleted_key_num, part_num);
                 offset_ = cur_offset;
                 out_offset = cur_offset;
             } else {
-                PDLOG(WARNING, "GenManifest failed. delete snapshot file[%s]", full_path.c_str());
-                unlink(full_path.c_str());
+                PDLOG(WARNING, "GenManifest failed. delete snapshot file[%s]", snapshot_names[0].c_str());
+                for (const auto& snapshot_name : snapshot_names) {
+                    unlink((snapshot_path_ + snapshot_name).c_str());
+                }
                 ret = -1;
             }
-        } else {
-            PDLOG(WARNING, "rename[%s] failed", snapshot_name.c_str());
-            unlink(tmp_file_path.c_str());
-            ret = -1;
+        }
+    } else {
+        ret = -1;
+    }
+    if (has_error) {
+        for (const auto& snapshot_name : snapshot_names) {
+            unlink((snapshot_path_ + snapshot_name + ".tmp").c_str());
         }
     }
     deleted_keys_.clear();
@@ -669,15 +1075,10 @@ base::Status MemTableSnapshot::ExtractIndexFromSnapshot(std::shared_ptr<Table> t
         }
         index_vec.push_back(index_def);
     }
-    std::string full_path = snapshot_path_ + manifest.name();
-    FILE* fd = fopen(full_path.c_str(), "rb");
-    if (fd == NULL) {
-        PDLOG(WARNING, "fail to open path %s for error %s", full_path.c_str(), strerror(errno));
+    SnapshotReader reader(snapshot_path_, GetSnapshotFiles(manifest));
+    if (!reader.Open()) {
         return base::Status(base::ReturnCode::kError, "fail to open file");
     }
-    ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(manifest.name(), fd);
-    bool compressed = IsCompressed(full_path);
-    ::openmldb::log::Reader reader(seq_file, NULL, false, 0, compressed);
     std::string buffer;
     ::openmldb::api::LogEntry entry;
     bool has_error = false;
@@ -769,7 +1170,6 @@ base::Status MemTableSnapshot::ExtractIndexFromSnapshot(std::shared_ptr<Table> t
         }
         (*count)++;
     }
-    delete seq_file;
     if (*expired_key_num + write_count + *deleted_key_num != manifest.count()) {
         PDLOG(WARNING, "key num not match! total key[%lu] load key[%lu] ttl key[%lu] delete key [%lu], tid %u pid %u",
                 manifest.count(), *count, *expired_key_num, *deleted_key_num, tid, pid);
@@ -789,15 +1189,10 @@ int MemTableSnapshot::ExtractIndexFromSnapshot(std::shared_ptr<Table> table, con
                                                uint64_t& expired_key_num, uint64_t& deleted_key_num) {
     uint32_t tid = table->GetId();
     uint32_t pid = table->GetPid();
-    std::string full_path = snapshot_path_ + manifest.name();
-    FILE* fd = fopen(full_path.c_str(), "rb");
-    if (fd == NULL) {
-        PDLOG(WARNING, "fail to open path %s for error %s", full_path.c_str(), strerror(errno));
+    SnapshotReader reader(snapshot_path_, GetSnapshotFiles(manifest));
+    if (!reader.Open()) {
         return -1;
     }
-    ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(manifest.name(), fd);
-    bool compressed = IsCompressed(full_path);
-    ::openmldb::log::Reader reader(seq_file, NULL, false, 0, compressed);
     std::string buffer;
     ::openmldb::api::LogEntry entry;
     bool has_error = false;
@@ -927,7 +1322,6 @@ int MemTableSnapshot::ExtractIndexFromSnapshot(std::shared_ptr<Table> table, con
         }
         count++;
     }
-    delete seq_file;
     if (expired_key_num + count + deleted_key_num + schame_size_less_count + other_error_count != manifest.count()) {
         LOG(WARNING) << "key num not match ! total key num[" << manifest.count() << "] load key num[" << count
                      << "] ttl key num[" << expired_key_num << "] schema size less num[" << schame_size_less_count
@@ -1159,11 +1553,7 @@ int MemTableSnapshot::ExtractIndexData(std::shared_ptr<Table> table,
     } else {
         if (rename(tmp_file_path.c_str(), full_path.c_str()) == 0) {
             if (GenManifest(snapshot_name, write_count, cur_offset, last_term) == 0) {
-                // delete old snapshot
-                if (manifest.has_name() && manifest.name() != snapshot_name) {
-                    DEBUGLOG("old snapshot[%s] has deleted", manifest.name().c_str());
-                    unlink((snapshot_path_ + manifest.name()).c_str());
-                }
+                DeleteOldSnapshot(manifest, {snapshot_name});
                 uint64_t consumed = ::baidu::common::timer::now_time() - start_time;
                 PDLOG(INFO,
                       "make snapshot[%s] success. update offset from %lu to %lu."
@@ -1425,11 +1815,7 @@ int MemTableSnapshot::ExtractIndexData(std::shared_ptr<Table> table, const ::ope
     } else {
         if (rename(tmp_file_path.c_str(), full_path.c_str()) == 0) {
             if (GenManifest(snapshot_name, write_count, cur_offset, last_term) == 0) {
-                // delete old snapshot
-                if (manifest.has_name() && manifest.name() != snapshot_name) {
-                    DEBUGLOG("old snapshot[%s] has deleted", manifest.name().c_str());
-                    unlink((snapshot_path_ + manifest.name()).c_str());
-                }
+                DeleteOldSnapshot(manifest, {snapshot_name});
                 uint64_t consumed = ::baidu::common::timer::now_time() - start_time;
                 PDLOG(INFO,
                       "make snapshot[%s] success. update offset from %lu to %lu."
@@ -1544,17 +1930,12 @@ bool MemTableSnapshot::DumpSnapshotIndexData(std::shared_ptr<Table> table,
         return false;
     }
     *snapshot_offset = manifest.offset();
-    std::string path = snapshot_path_ + "/" + manifest.name();
     uint64_t succ_cnt = 0;
     uint64_t failed_cnt = 0;
-    FILE* fd = fopen(path.c_str(), "rb");
-    if (fd == NULL) {
-        PDLOG(WARNING, "fail to open path %s for error %s", path.c_str(), strerror(errno));
+    SnapshotReader reader(snapshot_path_, GetSnapshotFiles(manifest));
+    if (!reader.Open()) {
         return false;
     }
-    ::openmldb::log::SequentialFile* seq_file = ::openmldb::log::NewSeqFile(path, fd);
-    bool compressed = IsCompressed(path);
-    ::openmldb::log::Reader reader(seq_file, NULL, false, 0, compressed);
     ::openmldb::api::LogEntry entry;
     std::string buffer;
     std::string entry_buff;
@@ -1565,9 +1946,9 @@ bool MemTableSnapshot::DumpSnapshotIndexData(std::shared_ptr<Table> table,
         ::openmldb::log::Status status = reader.ReadRecord(&record, &buffer);
         if (status.IsWaitRecord() || status.IsEof()) {
             PDLOG(INFO,
-                  "read path %s for table tid %u pid %u completed, succ_cnt "
+                  "read snapshot %s for table tid %u pid %u completed, succ_cnt "
                   "%lu, failed_cnt %lu",
-                  path.c_str(), tid_, pid_, succ_cnt, failed_cnt);
+                  manifest.name().c_str(), tid_, pid_, succ_cnt, failed_cnt);
             break;
         }
         if (!status.ok()) {
@@ -1592,7 +1973,6 @@ bool MemTableSnapshot::DumpSnapshotIndexData(std::shared_ptr<Table> table,
         ::openmldb::base::Slice new_record(entry_str);
         status = whs[index_pid]->Write(new_record);
         if (!status.ok()) {
-            delete seq_file;
             PDLOG(WARNING,
                   "fail to dump index entrylog in snapshot to pid[%u]. tid "
                   "%u pid %u",
@@ -1601,7 +1981,6 @@ bool MemTableSnapshot::DumpSnapshotIndexData(std::shared_ptr<Table> table,
         }
         succ_cnt++;
     }
-    delete seq_file;
     return true;
 }
 
@@ -1787,13 +2166,7 @@ int MemTableSnapshot::DecodeData(std::shared_ptr<Table> table, const openmldb::a
     return 0;
 }
 
-bool MemTableSnapshot::IsCompressed(const std::string& path) {
-    if (path.find(openmldb::log::ZLIB_COMPRESS_SUFFIX) != std::string::npos ||
-        path.find(openmldb::log::SNAPPY_COMPRESS_SUFFIX) != std::string::npos) {
-        return true;
-    }
-    return false;
-}
+bool MemTableSnapshot::IsCompressed(const std::string& path) { return IsCompressedFile(path); }
 
 }  // namespace storage
 }  // namespace openmldb
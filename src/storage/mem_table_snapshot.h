@@ -17,6 +17,7 @@
 #pragma once
 
 #include <atomic>
+#include <functional>
 #include <map>
 #include <memory>
 #include <set>
@@ -39,6 +40,8 @@ using ::openmldb::log::WriteHandle;
 
 typedef ::openmldb::base::Skiplist<uint32_t, uint64_t, ::openmldb::base::DefaultComparator> LogParts;
 
+struct SnapshotBatch;
+
 // table snapshot
 class MemTableSnapshot : public Snapshot {
  public:
@@ -50,17 +53,14 @@ class MemTableSnapshot : public Snapshot {
 
     bool Recover(std::shared_ptr<Table> table, uint64_t& latest_offset) override;
 
-    void RecoverFromSnapshot(const std::string& snapshot_name, uint64_t expect_cnt, std::shared_ptr<Table> table);
+    void RecoverFromSnapshot(const std::vector<std::string>& snapshot_files, uint64_t expect_cnt,
+                             std::shared_ptr<Table> table);
 
     int MakeSnapshot(std::shared_ptr<Table> table,
                      uint64_t& out_offset,  // NOLINT
                      uint64_t end_offset,
                      uint64_t term = 0) override;
 
-    int TTLSnapshot(std::shared_ptr<Table> table, const ::openmldb::api::Manifest& manifest, WriteHandle* wh,
-                    uint64_t& count, uint64_t& expired_key_num,  // NOLINT
-                    uint64_t& deleted_key_num);                  // NOLINT
-
     void Put(std::string& path, std::shared_ptr<Table>& table,  // NOLINT
              std::vector<std::string*> recordPtr, std::atomic<uint64_t>* succ_cnt, std::atomic<uint64_t>* failed_cnt);
 
@@ -120,8 +120,28 @@ class MemTableSnapshot : public Snapshot {
     void RecoverSingleSnapshot(const std::string& path, std::shared_ptr<Table> table, std::atomic<uint64_t>* g_succ_cnt,
                                std::atomic<uint64_t>* g_failed_cnt);
 
+    // read the records by one thread and parse and put them in batches by the load pool
+    bool LoadSnapshotWithReader(const std::string& path, std::shared_ptr<Table> table,
+                                std::atomic<uint64_t>* succ_cnt, std::atomic<uint64_t>* failed_cnt);
+
+    // mmap an uncompressed snapshot file and parse the records in place by several readers, the entries are
+    // sharded to the loaders by the segment of their first dimension. return false if the file can not be mapped
+    bool LoadSnapshotWithMmap(const std::string& path, std::shared_ptr<Table> table,
+                              std::atomic<uint64_t>* succ_cnt, std::atomic<uint64_t>* failed_cnt);
+
     uint64_t CollectDeletedKey(uint64_t end_offset);
 
+    // read the records of old snapshot and then binlog in batches, stop if submit returns false
+    bool ReadSnapshotRecords(const std::vector<std::string>& old_files,
+                             const std::function<bool(const std::shared_ptr<SnapshotBatch>&)>& submit);
+
+    // parse the records and mark the ones of deleted keys and expired
+    void FilterSnapshotBatch(const std::shared_ptr<Table>& table, const std::set<uint32_t>& snapshot_deleted_index,
+                             const std::set<uint32_t>& binlog_deleted_index, SnapshotBatch* batch);
+
+    // delete the files of old snapshot which are not reused by the new one
+    void DeleteOldSnapshot(const ::openmldb::api::Manifest& old_manifest, const std::vector<std::string>& new_files);
+
     int DecodeData(std::shared_ptr<Table> table, const openmldb::api::LogEntry& entry, uint32_t maxIdx,
                    std::vector<std::string>& row);  // NOLINT
 
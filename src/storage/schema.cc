@@ -65,6 +65,9 @@ void TableColumn::AddColumn(std::shared_ptr<ColumnDef> column_def) {
     if (ts_column_) {
         column_key.set_ts_name(ts_column_->GetName());
     }
+    for (const auto& col : columnar_columns_) {
+        column_key.add_columnar_col_name(col.GetName());
+    }
     auto index_ttl = GetTTL();
     auto ttl = column_key.mutable_ttl();
     ttl->set_ttl_type(index_ttl->GetProtoTTLType());
@@ -211,6 +214,18 @@ int TableIndex::ParseFromMeta(const ::openmldb::api::TableMeta& table_meta) {
             if (column_key.has_ttl()) {
                 index->SetTTL(::openmldb::storage::TTLSt(column_key.ttl()));
             }
+            if (column_key.columnar_col_name_size() > 0) {
+                std::vector<ColumnDef> columnar_vec;
+                for (const auto& cur_col_name : column_key.columnar_col_name()) {
+                    auto iter = col_map.find(cur_col_name);
+                    if (iter == col_map.end() || !ColumnDef::CheckColumnarType(iter->second->GetType())) {
+                        LOG(WARNING) << "col " << cur_col_name << " can not be kept in columnar, tid " << tid;
+                        return -1;
+                    }
+                    columnar_vec.push_back(*(iter->second));
+                }
+                index->SetColumnarColumns(columnar_vec);
+            }
             if (AddIndex(index) < 0) {
                 DLOG(WARNING) << "add index failed";
                 return -1;
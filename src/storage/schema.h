@@ -163,6 +163,21 @@ class ColumnDef {
         return false;
     }
 
+    // the fixed width types which can be kept in a columnar shadow
+    static bool CheckColumnarType(::openmldb::type::DataType type) {
+        switch (type) {
+            case ::openmldb::type::kSmallInt:
+            case ::openmldb::type::kInt:
+            case ::openmldb::type::kBigInt:
+            case ::openmldb::type::kFloat:
+            case ::openmldb::type::kDouble:
+            case ::openmldb::type::kTimestamp:
+                return true;
+            default:
+                return false;
+        }
+    }
+
     inline bool IsAutoGenTs() const { return id_ == DEFUALT_TS_COL_ID; }
 
  private:
@@ -207,6 +222,8 @@ class IndexDef {
     inline void SetInnerPos(int32_t inner_pos) { inner_pos_ = inner_pos; }
     inline uint32_t GetInnerPos() const { return inner_pos_; }
     ::openmldb::common::ColumnKey GenColumnKey();
+    void SetColumnarColumns(const std::vector<ColumnDef>& columns) { columnar_columns_ = columns; }
+    inline const std::vector<ColumnDef>& GetColumnarColumns() const { return columnar_columns_; }
 
  private:
     std::string name_;
@@ -217,6 +234,7 @@ class IndexDef {
     std::vector<ColumnDef> columns_;
     std::shared_ptr<TTLSt> ttl_st_;
     std::shared_ptr<ColumnDef> ts_column_;
+    std::vector<ColumnDef> columnar_columns_;
 };
 
 class InnerIndexSt {
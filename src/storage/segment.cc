@@ -21,56 +21,94 @@
 #include "base/glog_wapper.h"
 #include "base/strings.h"
 #include "common/timer.h"
+#include "storage/key_versions.h"
 #include "storage/record.h"
 
 DECLARE_int32(gc_safe_offset);
 DECLARE_uint32(skiplist_max_height);
 DECLARE_uint32(gc_deleted_pk_version_delta);
+DECLARE_bool(enable_segment_slab);
+DECLARE_uint32(skiplist_branch);
+DECLARE_bool(enable_concurrent_put);
 
 namespace openmldb {
 namespace storage {
 
 static const SliceComparator scmp;
+
+// drop the rows split from the time entries from the columnar shadow too, need hold the exclusive lock of mu_
+static void DropShadowRows(KeyEntry* entry, ::openmldb::base::Node<uint64_t, DataBlock*>* node) {
+    if (entry->shadow_ == NULL || node == NULL) {
+        return;
+    }
+    uint64_t cnt = 0;
+    for (; node != NULL; node = node->GetNextNoBarrier(0)) {
+        cnt++;
+    }
+    entry->shadow_->DropOldest(cnt);
+}
+
+// branch 1 makes every node reach the max height
+static inline uint8_t GetSkiplistBranch() { return FLAGS_skiplist_branch < 2 ? 2 : (uint8_t)FLAGS_skiplist_branch; }
+
 Segment::Segment()
     : entries_(NULL),
-      mu_(),
+      mu_(FLAGS_enable_concurrent_put),
       idx_cnt_(0),
       idx_byte_size_(0),
       pk_cnt_(0),
       ts_cnt_(1),
       gc_version_(0),
-      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000) {
-    entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, 4, scmp);
+      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000),
+      skiplist_branch_(GetSkiplistBranch()),
+      concurrent_put_(FLAGS_enable_concurrent_put),
+      allocator_(NULL) {
+    if (FLAGS_enable_segment_slab) {
+        allocator_ = new ::openmldb::base::SlabAllocator();
+    }
+    entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, skiplist_branch_, scmp, allocator_);
     key_entry_max_height_ = (uint8_t)FLAGS_skiplist_max_height;
-    entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
+    entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp, allocator_);
 }
 
 Segment::Segment(uint8_t height)
     : entries_(NULL),
-      mu_(),
+      mu_(FLAGS_enable_concurrent_put),
       idx_cnt_(0),
       idx_byte_size_(0),
       pk_cnt_(0),
       key_entry_max_height_(height),
       ts_cnt_(1),
       gc_version_(0),
-      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000) {
-    entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, 4, scmp);
-    entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
+      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000),
+      skiplist_branch_(GetSkiplistBranch()),
+      concurrent_put_(FLAGS_enable_concurrent_put),
+      allocator_(NULL) {
+    if (FLAGS_enable_segment_slab) {
+        allocator_ = new ::openmldb::base::SlabAllocator();
+    }
+    entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, skiplist_branch_, scmp, allocator_);
+    entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp, allocator_);
 }
 
 Segment::Segment(uint8_t height, const std::vector<uint32_t>& ts_idx_vec)
     : entries_(NULL),
-      mu_(),
+      mu_(FLAGS_enable_concurrent_put),
       idx_cnt_(0),
       idx_byte_size_(0),
       pk_cnt_(0),
       key_entry_max_height_(height),
       ts_cnt_(ts_idx_vec.size()),
       gc_version_(0),
-      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000) {
-    entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, 4, scmp);
-    entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp);
+      ttl_offset_(FLAGS_gc_safe_offset * 60 * 1000),
+      skiplist_branch_(GetSkiplistBranch()),
+      concurrent_put_(FLAGS_enable_concurrent_put),
+      allocator_(NULL) {
+    if (FLAGS_enable_segment_slab) {
+        allocator_ = new ::openmldb::base::SlabAllocator();
+    }
+    entries_ = new KeyEntries((uint8_t)FLAGS_skiplist_max_height, skiplist_branch_, scmp, allocator_);
+    entry_free_list_ = new KeyEntryNodeList(4, 4, tcmp, allocator_);
     for (uint32_t i = 0; i < ts_idx_vec.size(); i++) {
         ts_idx_map_[ts_idx_vec[i]] = i;
         idx_cnt_vec_.push_back(std::make_shared<std::atomic<uint64_t>>(0));
@@ -80,6 +118,22 @@ Segment::Segment(uint8_t height, const std::vector<uint32_t>& ts_idx_vec)
 Segment::~Segment() {
     delete entries_;
     delete entry_free_list_;
+    // the nodes not freed by Release are returned with the slabs
+    delete allocator_;
+}
+
+Slice Segment::NewKey(const Slice& key) {
+    char* pk = allocator_ == NULL ? new char[key.size()] : allocator_->Allocate(key.size());
+    memcpy(pk, key.data(), key.size());
+    return Slice(pk, key.size());
+}
+
+void Segment::FreeKey(const Slice& key) {
+    if (allocator_ == NULL) {
+        delete[] key.data();
+    } else {
+        allocator_->Free(const_cast<char*>(key.data()), key.size());
+    }
 }
 
 uint64_t Segment::Release() {
@@ -87,7 +141,7 @@ uint64_t Segment::Release() {
     KeyEntries::Iterator* it = entries_->NewIterator();
     it->SeekToFirst();
     while (it->Valid()) {
-        delete[] it->GetKey().data();
+        FreeKey(it->GetKey());
         if (it->GetValue() != NULL) {
             if (ts_cnt_ > 1) {
                 KeyEntry** entry_arr = (KeyEntry**)it->GetValue();  // NOLINT
@@ -111,7 +165,7 @@ uint64_t Segment::Release() {
     f_it->SeekToFirst();
     while (f_it->Valid()) {
         ::openmldb::base::Node<Slice, void*>* node = f_it->GetValue();
-        delete[] node->GetKey().data();
+        FreeKey(node->GetKey());
         if (ts_cnt_ > 1) {
             KeyEntry** entry_arr = (KeyEntry**)node->GetValue();  // NOLINT
             for (uint32_t i = 0; i < ts_cnt_; i++) {
@@ -124,7 +178,7 @@ uint64_t Segment::Release() {
             entry->Release();
             delete entry;
         }
-        delete node;
+        ::openmldb::base::DeleteNode(node, allocator_);
         f_it->Next();
     }
     delete f_it;
@@ -140,7 +194,7 @@ void Segment::ReleaseAndCount(uint64_t& gc_idx_cnt, uint64_t& gc_record_cnt, uin
         Slice key = it->GetKey();
         ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
         {
-            std::lock_guard<std::mutex> lock(mu_);
+            std::lock_guard<SegmentMutex> lock(mu_);
             entry_node = entries_->Remove(key);
         }
         if (entry_node != NULL) {
@@ -159,7 +213,7 @@ void Segment::Put(const Slice& key, uint64_t time, const char* data, uint32_t si
     if (ts_cnt_ > 1) {
         return;
     }
-    auto* db = new DataBlock(1, data, size);
+    auto* db = DataBlock::New(allocator_, 1, data, size);
     Put(key, time, db);
 }
 
@@ -167,26 +221,122 @@ void Segment::Put(const Slice& key, uint64_t time, DataBlock* row) {
     if (ts_cnt_ > 1) {
         return;
     }
-    std::lock_guard<std::mutex> lock(mu_);
+    if (concurrent_put_) {
+        std::shared_lock<SegmentMutex> lock(mu_);
+        uint32_t byte_size = 0;
+        KeyEntry* entry = (KeyEntry*)GetOrInsertEntryConcurrently(key, &byte_size);  // NOLINT
+        uint8_t height = InsertToEntry(entry, time, row, true);
+        entry->count_.fetch_add(1, std::memory_order_relaxed);
+        idx_cnt_.fetch_add(1, std::memory_order_relaxed);
+        byte_size += GetRecordTsIdxSize(height);
+        idx_byte_size_.fetch_add(byte_size, std::memory_order_relaxed);
+        return;
+    }
+    std::lock_guard<SegmentMutex> lock(mu_);
     PutUnlock(key, time, row);
 }
 
+void* Segment::GetOrInsertEntryConcurrently(const Slice& key, uint32_t* byte_size) {
+    void* entry = NULL;
+    if (entries_->Get(key, entry) == 0 && entry != NULL) {
+        return entry;
+    }
+    Slice skey = NewKey(key);
+    if (ts_cnt_ > 1) {
+        KeyEntry** entry_arr = new KeyEntry*[ts_cnt_];
+        for (uint32_t i = 0; i < ts_cnt_; i++) {
+            entry_arr[i] = NewKeyEntry(i);
+        }
+        entry = (void*)entry_arr;  // NOLINT
+    } else {
+        entry = (void*)NewKeyEntry(0);  // NOLINT
+    }
+    void* exist_entry = entry;
+    uint8_t height = entries_->InsertConcurrently(skey, exist_entry, true);
+    if (height == 0) {
+        // the key is inserted by the other writer, drop the empty entry
+        FreeKey(skey);
+        if (ts_cnt_ > 1) {
+            KeyEntry** entry_arr = (KeyEntry**)entry;  // NOLINT
+            for (uint32_t i = 0; i < ts_cnt_; i++) {
+                delete entry_arr[i];
+            }
+            delete[] entry_arr;
+        } else {
+            delete (KeyEntry*)entry;  // NOLINT
+        }
+        return exist_entry;
+    }
+    if (ts_cnt_ > 1) {
+        *byte_size += GetRecordPkMultiIdxSize(height, key.size(), key_entry_max_height_, ts_cnt_);
+    } else {
+        *byte_size += GetRecordPkIdxSize(height, key.size(), key_entry_max_height_);
+    }
+    pk_cnt_.fetch_add(1, std::memory_order_relaxed);
+    return entry;
+}
+
+KeyEntry* Segment::NewKeyEntry(uint32_t pos) {
+    auto* entry = new KeyEntry(key_entry_max_height_, skiplist_branch_, allocator_);
+    if (pos < shadow_specs_.size() && shadow_specs_[pos]) {
+        entry->shadow_ = new ColumnarShadow(shadow_specs_[pos]);
+    }
+    return entry;
+}
+
+uint8_t Segment::InsertToEntry(KeyEntry* entry, uint64_t time, DataBlock* row, bool concurrent) {
+    if (entry->shadow_ == NULL) {
+        return concurrent ? entry->entries.InsertConcurrently(time, row) : entry->entries.Insert(time, row);
+    }
+    return entry->shadow_->Put(time, row->data, row->size, [entry, time, row, concurrent]() mutable {
+        return concurrent ? entry->entries.InsertConcurrently(time, row) : entry->entries.Insert(time, row);
+    });
+}
+
+void Segment::ResetShadow(KeyEntry* entry) {
+    std::vector<std::pair<uint64_t, DataBlock*>> rows;
+    std::unique_ptr<TimeEntries::Iterator> it(entry->entries.NewIterator());
+    for (it->SeekToFirst(); it->Valid(); it->Next()) {
+        rows.emplace_back(it->GetKey(), it->GetValue());
+    }
+    entry->shadow_->Clear();
+    // put from the oldest one, so the rows with the same time keep the order of time entries
+    for (auto row = rows.rbegin(); row != rows.rend(); ++row) {
+        entry->shadow_->Put(row->first, row->second->data, row->second->size, []() { return (uint8_t)0; });
+    }
+}
+
+bool Segment::EnableColumnarShadow(uint32_t ts_idx, const std::shared_ptr<ColumnarShadowSpec>& spec) {
+    uint32_t pos = 0;
+    if (!ts_idx_map_.empty() && GetTsIdx(ts_idx, pos) < 0) {
+        return false;
+    }
+    std::lock_guard<SegmentMutex> lock(mu_);
+    if (pk_cnt_.load(std::memory_order_relaxed) > 0) {
+        PDLOG(WARNING, "can not enable columnar shadow after put");
+        return false;
+    }
+    if (shadow_specs_.size() < ts_cnt_) {
+        shadow_specs_.resize(ts_cnt_);
+    }
+    shadow_specs_[pos] = spec;
+    return true;
+}
+
 void Segment::PutUnlock(const Slice& key, uint64_t time, DataBlock* row) {
     void* entry = nullptr;
     uint32_t byte_size = 0;
     int ret = entries_->Get(key, entry);
     if (ret < 0 || entry == NULL) {
-        char* pk = new char[key.size()];
-        memcpy(pk, key.data(), key.size());
         // need to delete memory when free node
-        Slice skey(pk, key.size());
-        entry = (void*)new KeyEntry(key_entry_max_height_);  // NOLINT
+        Slice skey = NewKey(key);
+        entry = (void*)NewKeyEntry(0);  // NOLINT
         uint8_t height = entries_->Insert(skey, entry);
         byte_size += GetRecordPkIdxSize(height, key.size(), key_entry_max_height_);
         pk_cnt_.fetch_add(1, std::memory_order_relaxed);
     }
     idx_cnt_.fetch_add(1, std::memory_order_relaxed);
-    uint8_t height = ((KeyEntry*)entry)->entries.Insert(time, row);  // NOLINT
+    uint8_t height = InsertToEntry((KeyEntry*)entry, time, row, false);  // NOLINT
     ((KeyEntry*)entry)                                               // NOLINT
         ->count_.fetch_add(1, std::memory_order_relaxed);
     byte_size += GetRecordTsIdxSize(height);
@@ -196,32 +346,84 @@ void Segment::PutUnlock(const Slice& key, uint64_t time, DataBlock* row) {
 void Segment::BulkLoadPut(unsigned int key_entry_id, const Slice& key, uint64_t time, DataBlock* row) {
     void* key_entry_or_list = nullptr;
     uint32_t byte_size = 0;
-    std::lock_guard<std::mutex> lock(mu_);  // TODO(hw): need lock?
+    std::lock_guard<SegmentMutex> lock(mu_);  // TODO(hw): need lock?
     int ret = entries_->Get(key, key_entry_or_list);
     if (ts_cnt_ == 1) {
         PutUnlock(key, time, row);
     } else {
         if (ret < 0 || key_entry_or_list == nullptr) {
-            char* pk = new char[key.size()];
-            memcpy(pk, key.data(), key.size());
-            Slice skey(pk, key.size());
+            Slice skey = NewKey(key);
             auto** entry_arr_tmp = new KeyEntry*[ts_cnt_];
             for (uint32_t i = 0; i < ts_cnt_; i++) {
-                entry_arr_tmp[i] = new KeyEntry(key_entry_max_height_);
+                entry_arr_tmp[i] = NewKeyEntry(i);
             }
-            auto entry_arr = (void*)entry_arr_tmp;  // NOLINT
-            uint8_t height = entries_->Insert(skey, entry_arr);
+            key_entry_or_list = (void*)entry_arr_tmp;  // NOLINT
+            uint8_t height = entries_->Insert(skey, key_entry_or_list);
             byte_size += GetRecordPkMultiIdxSize(height, key.size(), key_entry_max_height_, ts_cnt_);
             pk_cnt_.fetch_add(1, std::memory_order_relaxed);
         }
-        uint8_t height = ((KeyEntry**)key_entry_or_list)[key_entry_id]->entries.Insert(  // NOLINT
-            time, row);
+        uint8_t height = InsertToEntry(((KeyEntry**)key_entry_or_list)[key_entry_id], time, row, false);  // NOLINT
         ((KeyEntry**)key_entry_or_list)[key_entry_id]->count_.fetch_add(  // NOLINT
             1, std::memory_order_relaxed);
         byte_size += GetRecordTsIdxSize(height);
         idx_byte_size_.fetch_add(byte_size, std::memory_order_relaxed);
         idx_cnt_vec_[key_entry_id]->fetch_add(1, std::memory_order_relaxed);
     }
+    BumpKeyVersions(key);
+}
+
+void Segment::BulkLoadPut(unsigned int key_entry_id, const Slice& key,
+                          const std::vector<std::pair<uint64_t, DataBlock*>>& rows) {
+    if (rows.empty()) {
+        return;
+    }
+    void* key_entry_or_list = nullptr;
+    uint32_t byte_size = 0;
+    std::lock_guard<SegmentMutex> lock(mu_);
+    int ret = entries_->Get(key, key_entry_or_list);
+    if (ret < 0 || key_entry_or_list == nullptr) {
+        Slice skey = NewKey(key);
+        if (ts_cnt_ == 1) {
+            key_entry_or_list = (void*)NewKeyEntry(0);  // NOLINT
+            uint8_t height = entries_->Insert(skey, key_entry_or_list);
+            byte_size += GetRecordPkIdxSize(height, key.size(), key_entry_max_height_);
+        } else {
+            auto** entry_arr_tmp = new KeyEntry*[ts_cnt_];
+            for (uint32_t i = 0; i < ts_cnt_; i++) {
+                entry_arr_tmp[i] = NewKeyEntry(i);
+            }
+            key_entry_or_list = (void*)entry_arr_tmp;  // NOLINT
+            uint8_t height = entries_->Insert(skey, key_entry_or_list);
+            byte_size += GetRecordPkMultiIdxSize(height, key.size(), key_entry_max_height_, ts_cnt_);
+        }
+        pk_cnt_.fetch_add(1, std::memory_order_relaxed);
+    }
+    KeyEntry* entry = ts_cnt_ == 1 ? (KeyEntry*)key_entry_or_list                 // NOLINT
+                                   : ((KeyEntry**)key_entry_or_list)[key_entry_id];  // NOLINT
+    // the rows are in order of time entries usually, append them to the tail without search
+    TimeEntries::Appender appender(&entry->entries);
+    for (const auto& row : rows) {
+        DataBlock* block = row.second;
+        byte_size += GetRecordTsIdxSize(appender.Append(row.first, block));
+    }
+    if (entry->shadow_ != NULL) {
+        ResetShadow(entry);
+    }
+    entry->count_.fetch_add(rows.size(), std::memory_order_relaxed);
+    idx_byte_size_.fetch_add(byte_size, std::memory_order_relaxed);
+    if (ts_cnt_ == 1) {
+        idx_cnt_.fetch_add(rows.size(), std::memory_order_relaxed);
+    } else {
+        idx_cnt_vec_[key_entry_id]->fetch_add(rows.size(), std::memory_order_relaxed);
+    }
+    // the rows are not appended in order of the puts
+    BumpKeyVersions(key);
+}
+
+void Segment::BumpKeyVersions(const Slice& key) {
+    for (uint32_t idx : version_index_ids_) {
+        KeyVersions::Bump(version_tid_, idx, key);
+    }
 }
 
 void Segment::Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, DataBlock* row) {
@@ -237,22 +439,28 @@ void Segment::Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, D
         return;
     }
     void* entry_arr = NULL;
-    std::lock_guard<std::mutex> lock(mu_);
+    std::shared_lock<SegmentMutex> shared_lock(mu_, std::defer_lock);
+    std::unique_lock<SegmentMutex> unique_lock(mu_, std::defer_lock);
+    if (concurrent_put_) {
+        shared_lock.lock();
+    } else {
+        unique_lock.lock();
+    }
     for (const auto& kv : ts_map) {
         uint32_t byte_size = 0;
         auto pos = ts_idx_map_.find(kv.first);
         if (pos == ts_idx_map_.end()) {
             continue;
         }
-        if (entry_arr == NULL) {
+        if (entry_arr == NULL && concurrent_put_) {
+            entry_arr = GetOrInsertEntryConcurrently(key, &byte_size);
+        } else if (entry_arr == NULL) {
             int ret = entries_->Get(key, entry_arr);
             if (ret < 0 || entry_arr == NULL) {
-                char* pk = new char[key.size()];
-                memcpy(pk, key.data(), key.size());
-                Slice skey(pk, key.size());
+                Slice skey = NewKey(key);
                 KeyEntry** entry_arr_tmp = new KeyEntry*[ts_cnt_];
                 for (uint32_t i = 0; i < ts_cnt_; i++) {
-                    entry_arr_tmp[i] = new KeyEntry(key_entry_max_height_);
+                    entry_arr_tmp[i] = NewKeyEntry(i);
                 }
                 entry_arr = (void*)entry_arr_tmp;  // NOLINT
                 uint8_t height = entries_->Insert(skey, entry_arr);
@@ -260,10 +468,9 @@ void Segment::Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, D
                 pk_cnt_.fetch_add(1, std::memory_order_relaxed);
             }
         }
-        uint8_t height = ((KeyEntry**)entry_arr)[pos->second]->entries.Insert(  // NOLINT
-            kv.second, row);
-        ((KeyEntry**)entry_arr)[pos->second]->count_.fetch_add(  // NOLINT
-            1, std::memory_order_relaxed);
+        KeyEntry* entry = ((KeyEntry**)entry_arr)[pos->second];  // NOLINT
+        uint8_t height = InsertToEntry(entry, kv.second, row, concurrent_put_);
+        entry->count_.fetch_add(1, std::memory_order_relaxed);
         byte_size += GetRecordTsIdxSize(height);
         idx_byte_size_.fetch_add(byte_size, std::memory_order_relaxed);
         idx_cnt_vec_[pos->second]->fetch_add(1, std::memory_order_relaxed);
@@ -304,7 +511,7 @@ bool Segment::Get(const Slice& key, uint32_t idx, const uint64_t time, DataBlock
 bool Segment::Delete(const Slice& key) {
     ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
     {
-        std::lock_guard<std::mutex> lock(mu_);
+        std::lock_guard<SegmentMutex> lock(mu_);
         entry_node = entries_->Remove(key);
         if (entry_node == NULL) {
             return false;
@@ -330,10 +537,10 @@ void Segment::FreeList(::openmldb::base::Node<uint64_t, DataBlock*>* node, uint6
         } else {
             DEBUGLOG("delele data block for key %lu", tmp->GetKey());
             gc_record_byte_size += GetRecordSize(tmp->GetValue()->size);
-            delete tmp->GetValue();
+            DataBlock::Delete(tmp->GetValue());
             gc_record_cnt++;
         }
-        delete tmp;
+        ::openmldb::base::DeleteNode(tmp, allocator_);
     }
 }
 
@@ -343,7 +550,7 @@ void Segment::FreeEntry(::openmldb::base::Node<Slice, void*>* entry_node, uint64
         return;
     }
     // free pk memory
-    delete[] entry_node->GetKey().data();
+    FreeKey(entry_node->GetKey());
     if (ts_cnt_ > 1) {
         KeyEntry** entry_arr = (KeyEntry**)entry_node->GetValue();  // NOLINT
         for (uint32_t i = 0; i < ts_cnt_; i++) {
@@ -393,10 +600,10 @@ void Segment::GcEntryFreeList(uint64_t version, uint64_t& gc_idx_cnt, uint64_t&
     while (node != NULL) {
         ::openmldb::base::Node<Slice, void*>* entry_node = node->GetValue();
         FreeEntry(entry_node, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
-        delete entry_node;
+        ::openmldb::base::DeleteNode(entry_node, allocator_);
         ::openmldb::base::Node<uint64_t, ::openmldb::base::Node<Slice, void*>*>* tmp = node;
         node = node->GetNextNoBarrier(0);
-        delete tmp;
+        ::openmldb::base::DeleteNode(tmp, allocator_);
         pk_cnt_.fetch_sub(1, std::memory_order_relaxed);
     }
 }
@@ -487,11 +694,15 @@ void Segment::Gc4Head(uint64_t keep_cnt, uint64_t& gc_idx_cnt, uint64_t& gc_reco
         KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
         ::openmldb::base::Node<uint64_t, DataBlock*>* node = NULL;
         {
-            std::lock_guard<std::mutex> lock(mu_);
+            std::lock_guard<SegmentMutex> lock(mu_);
             if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                 node = entry->entries.SplitByPos(keep_cnt);
+                DropShadowRows(entry, node);
             }
         }
+        if (node != NULL) {
+            BumpKeyVersions(it->GetKey());
+        }
         uint64_t entry_gc_idx_cnt = 0;
         FreeList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
         entry->count_.fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
@@ -533,7 +744,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                         continue_flag = true;
                     } else {
                         node = NULL;
-                        std::lock_guard<std::mutex> lock(mu_);
+                        std::lock_guard<SegmentMutex> lock(mu_);
                         SplitList(entry, kv.second.abs_ttl, &node);
                         if (entry->entries.IsEmpty()) {
                             empty_cnt++;
@@ -542,9 +753,10 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                     break;
                 }
                 case ::openmldb::storage::TTLType::kLatestTime: {
-                    std::lock_guard<std::mutex> lock(mu_);
+                    std::lock_guard<SegmentMutex> lock(mu_);
                     if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                         node = entry->entries.SplitByPos(kv.second.lat_ttl);
+                        DropShadowRows(entry, node);
                     }
                     break;
                 }
@@ -554,9 +766,10 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                         continue_flag = true;
                     } else {
                         node = NULL;
-                        std::lock_guard<std::mutex> lock(mu_);
+                        std::lock_guard<SegmentMutex> lock(mu_);
                         if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                             node = entry->entries.SplitByKeyAndPos(kv.second.abs_ttl, kv.second.lat_ttl);
+                            DropShadowRows(entry, node);
                         }
                     }
                     break;
@@ -567,7 +780,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                         continue_flag = true;
                     } else {
                         node = NULL;
-                        std::lock_guard<std::mutex> lock(mu_);
+                        std::lock_guard<SegmentMutex> lock(mu_);
                         if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                             if (kv.second.abs_ttl == 0) {
                                 node = entry->entries.SplitByPos(kv.second.lat_ttl);
@@ -576,6 +789,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
                             } else {
                                 node = entry->entries.SplitByKeyOrPos(kv.second.abs_ttl, kv.second.lat_ttl);
                             }
+                            DropShadowRows(entry, node);
                         }
                         if (entry->entries.IsEmpty()) {
                             empty_cnt++;
@@ -589,6 +803,9 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
             if (continue_flag) {
                 continue;
             }
+            if (node != NULL) {
+                BumpKeyVersions(key);
+            }
             uint64_t entry_gc_idx_cnt = 0;
             FreeList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
             entry->count_.fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
@@ -599,7 +816,7 @@ void Segment::GcAllType(const std::map<uint32_t, TTLSt>& ttl_st_map, uint64_t& g
             bool is_empty = true;
             ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
             {
-                std::lock_guard<std::mutex> lock(mu_);
+                std::lock_guard<SegmentMutex> lock(mu_);
                 for (uint32_t i = 0; i < ts_cnt_; i++) {
                     if (!entry_arr[i]->entries.IsEmpty()) {
                         is_empty = false;
@@ -625,6 +842,7 @@ void Segment::SplitList(KeyEntry* entry, uint64_t ts, ::openmldb::base::Node<uin
     // skip entry that ocupied by reader
     if (entry->refs_.load(std::memory_order_acquire) <= 0) {
         *node = entry->entries.Split(ts);
+        DropShadowRows(entry, *node);
     }
 }
 
@@ -652,12 +870,15 @@ void Segment::Gc4TTL(const uint64_t time, uint64_t& gc_idx_cnt, uint64_t& gc_rec
         node = NULL;
         ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
         {
-            std::lock_guard<std::mutex> lock(mu_);
+            std::lock_guard<SegmentMutex> lock(mu_);
             SplitList(entry, time, &node);
             if (entry->entries.IsEmpty()) {
                 entry_node = entries_->Remove(key);
             }
         }
+        if (node != NULL) {
+            BumpKeyVersions(key);
+        }
         if (entry_node != NULL) {
             std::lock_guard<std::mutex> lock(gc_mu_);
             entry_free_list_->Insert(gc_version_.load(std::memory_order_relaxed), entry_node);
@@ -685,6 +906,7 @@ void Segment::Gc4TTLAndHead(const uint64_t time, const uint64_t keep_cnt, uint64
     it->SeekToFirst();
     while (it->Valid()) {
         KeyEntry* entry = (KeyEntry*)it->GetValue();  // NOLINT
+        Slice key = it->GetKey();
         ::openmldb::base::Node<uint64_t, DataBlock*>* node = entry->entries.GetLast();
         it->Next();
         if (node == NULL) {
@@ -698,11 +920,15 @@ void Segment::Gc4TTLAndHead(const uint64_t time, const uint64_t keep_cnt, uint64
         }
         node = NULL;
         {
-            std::lock_guard<std::mutex> lock(mu_);
+            std::lock_guard<SegmentMutex> lock(mu_);
             if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                 node = entry->entries.SplitByKeyAndPos(time, keep_cnt);
+                DropShadowRows(entry, node);
             }
         }
+        if (node != NULL) {
+            BumpKeyVersions(key);
+        }
         uint64_t entry_gc_idx_cnt = 0;
         FreeList(node, entry_gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
         entry->count_.fetch_sub(entry_gc_idx_cnt, std::memory_order_relaxed);
@@ -743,14 +969,18 @@ void Segment::Gc4TTLOrHead(const uint64_t time, const uint64_t keep_cnt, uint64_
         node = NULL;
         ::openmldb::base::Node<Slice, void*>* entry_node = NULL;
         {
-            std::lock_guard<std::mutex> lock(mu_);
+            std::lock_guard<SegmentMutex> lock(mu_);
             if (entry->refs_.load(std::memory_order_acquire) <= 0) {
                 node = entry->entries.SplitByKeyOrPos(time, keep_cnt);
+                DropShadowRows(entry, node);
             }
             if (entry->entries.IsEmpty()) {
                 entry_node = entries_->Remove(key);
             }
         }
+        if (node != NULL) {
+            BumpKeyVersions(key);
+        }
         if (entry_node != NULL) {
             std::lock_guard<std::mutex> lock(gc_mu_);
             entry_free_list_->Insert(gc_version_.load(std::memory_order_relaxed), entry_node);
@@ -21,11 +21,17 @@
 #include <map>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <new>
+#include <shared_mutex>  // NOLINT
+#include <utility>
 #include <vector>
 
 #include "base/skiplist.h"
+#include "base/slab_allocator.h"
 #include "base/slice.h"
+#include "base/spinlock.h"
 #include "proto/tablet.pb.h"
+#include "storage/columnar_shadow.h"
 #include "storage/iterator.h"
 #include "storage/schema.h"
 #include "storage/ticket.h"
@@ -37,22 +43,69 @@ typedef google::protobuf::RepeatedPtrField<::openmldb::api::TSDimension> TSDimen
 
 using ::openmldb::base::Slice;
 
+// SegmentMutex is a std::mutex by default. if the concurrent put is enabled, it is a SharedSpinMutex whose shared
+// lock is held by the puts. in the default mode lock_shared takes the exclusive lock
+class SegmentMutex {
+ public:
+    explicit SegmentMutex(bool shared) : shared_(shared) {}
+
+    void lock() {
+        if (shared_) {
+            spin_mu_.lock();
+        } else {
+            mu_.lock();
+        }
+    }
+
+    void unlock() {
+        if (shared_) {
+            spin_mu_.unlock();
+        } else {
+            mu_.unlock();
+        }
+    }
+
+    void lock_shared() {
+        if (shared_) {
+            spin_mu_.lock_shared();
+        } else {
+            mu_.lock();
+        }
+    }
+
+    void unlock_shared() {
+        if (shared_) {
+            spin_mu_.unlock_shared();
+        } else {
+            mu_.unlock();
+        }
+    }
+
+ private:
+    const bool shared_;
+    std::mutex mu_;
+    ::openmldb::base::SharedSpinMutex spin_mu_;
+};
+
 class Segment;
 class Ticket;
 
 struct DataBlock {
     // dimension count down
     uint8_t dim_cnt_down;
+    // the block and its data are one chunk of SlabAllocator
+    bool in_slab;
     uint32_t size;
     char* data;
 
-    DataBlock(uint8_t dim_cnt, const char* input, uint32_t len) : dim_cnt_down(dim_cnt), size(len), data(NULL) {
+    DataBlock(uint8_t dim_cnt, const char* input, uint32_t len)
+        : dim_cnt_down(dim_cnt), in_slab(false), size(len), data(NULL) {
         data = new char[len];
         memcpy(data, input, len);
     }
 
     DataBlock(uint8_t dim_cnt, char* input, uint32_t len, bool skip_copy)
-        : dim_cnt_down(dim_cnt), size(len), data(NULL) {
+        : dim_cnt_down(dim_cnt), in_slab(false), size(len), data(NULL) {
         if (skip_copy) {
             data = input;
         } else {
@@ -62,9 +115,44 @@ struct DataBlock {
     }
 
     ~DataBlock() {
-        delete[] data;
+        if (!in_slab) {
+            delete[] data;
+        }
         data = NULL;
     }
+
+    // Create a block whose data follows the header in one chunk of allocator,
+    // fallback to heap if allocator is null. The chunk starts with the owner
+    // allocator, so the block goes back to the slab it came from whichever
+    // segment drops the last reference
+    static DataBlock* New(::openmldb::base::SlabAllocator* allocator, uint8_t dim_cnt, const char* input,
+                          uint32_t len) {
+        if (allocator == NULL) {
+            return new DataBlock(dim_cnt, input, len);
+        }
+        char* chunk = allocator->Allocate(kOwnerSize + sizeof(DataBlock) + len);
+        *reinterpret_cast<::openmldb::base::SlabAllocator**>(chunk) = allocator;
+        char* payload = chunk + kOwnerSize + sizeof(DataBlock);
+        memcpy(payload, input, len);
+        auto* block = new (chunk + kOwnerSize) DataBlock(dim_cnt, payload, len, true);
+        block->in_slab = true;
+        return block;
+    }
+
+    static void Delete(DataBlock* block) {
+        if (!block->in_slab) {
+            delete block;
+            return;
+        }
+        char* chunk = reinterpret_cast<char*>(block) - kOwnerSize;
+        auto* owner = *reinterpret_cast<::openmldb::base::SlabAllocator**>(chunk);
+        uint32_t chunk_size = kOwnerSize + sizeof(DataBlock) + block->size;
+        block->~DataBlock();
+        owner->Free(chunk, chunk_size);
+    }
+
+ private:
+    static constexpr uint32_t kOwnerSize = sizeof(::openmldb::base::SlabAllocator*);
 };
 
 // the desc time comparator
@@ -100,9 +188,11 @@ class MemTableIterator : public TableIterator {
 
 class KeyEntry {
  public:
-    KeyEntry() : entries(12, 4, tcmp), refs_(0), count_(0) {}
-    explicit KeyEntry(uint8_t height) : entries(height, 4, tcmp), refs_(0), count_(0) {}
-    ~KeyEntry() {}
+    KeyEntry() : entries(12, 4, tcmp), refs_(0), count_(0), shadow_(NULL) {}
+    explicit KeyEntry(uint8_t height) : entries(height, 4, tcmp), refs_(0), count_(0), shadow_(NULL) {}
+    KeyEntry(uint8_t height, uint8_t branch, ::openmldb::base::SlabAllocator* allocator)
+        : entries(height, branch, tcmp, allocator), refs_(0), count_(0), shadow_(NULL) {}
+    ~KeyEntry() { delete shadow_; }
 
     // just return the count of datablock
     uint64_t Release() {
@@ -116,12 +206,15 @@ class KeyEntry {
             if (block->dim_cnt_down > 1) {
                 block->dim_cnt_down--;
             } else {
-                delete block;
+                DataBlock::Delete(block);
             }
             it->Next();
         }
         entries.Clear();
         delete it;
+        if (shadow_ != NULL) {
+            shadow_->Clear();
+        }
         return cnt;
     }
 
@@ -135,6 +228,8 @@ class KeyEntry {
     TimeEntries entries;
     std::atomic<uint64_t> refs_;
     std::atomic<uint64_t> count_;
+    // the columns of the rows kept in arrays, null if the index keeps no column
+    ColumnarShadow* shadow_;
     friend Segment;
 };
 
@@ -161,6 +256,10 @@ class Segment {
 
     void BulkLoadPut(unsigned int key_entry_id, const Slice& key, uint64_t time, DataBlock* row);
 
+    // put the rows of one key entry, they are appended to the tail if in order of time desc
+    void BulkLoadPut(unsigned int key_entry_id, const Slice& key,
+                     const std::vector<std::pair<uint64_t, DataBlock*>>& rows);
+
     void Put(const Slice& key, const std::map<int32_t, uint64_t>& ts_map, DataBlock* row);
 
     // Get time data
@@ -241,10 +340,28 @@ class Segment {
 
     void IncrGcVersion() { gc_version_.fetch_add(1, std::memory_order_relaxed); }
 
+    // the allocator of data blocks and index nodes, null if slab is disabled
+    ::openmldb::base::SlabAllocator* GetAllocator() { return allocator_; }
+
+    inline uint64_t GetSlabByteSize() { return allocator_ == NULL ? 0 : allocator_->GetByteSize(); }
+
+    inline uint64_t GetSlabUsedByteSize() { return allocator_ == NULL ? 0 : allocator_->GetUsedByteSize(); }
+
     void ReleaseAndCount(uint64_t& gc_idx_cnt,            // NOLINT
                          uint64_t& gc_record_cnt,         // NOLINT
                          uint64_t& gc_record_byte_size);  // NOLINT
 
+    // keep the columns of spec for the rows of the ts column `ts_idx`, need be
+    // called before any put
+    bool EnableColumnarShadow(uint32_t ts_idx, const std::shared_ptr<ColumnarShadowSpec>& spec);
+
+    // bump the key versions of the indexes when the rows of a key are bulk loaded or dropped by gc, see
+    // KeyVersions. need be called before any put
+    void TrackKeyVersions(uint32_t tid, const std::vector<uint32_t>& index_ids) {
+        version_tid_ = tid;
+        version_index_ids_ = index_ids;
+    }
+
  private:
     void FreeList(::openmldb::base::Node<uint64_t, DataBlock*>* node, uint64_t& gc_idx_cnt,  // NOLINT
                   uint64_t& gc_record_cnt,         // NOLINT
@@ -258,10 +375,29 @@ class Segment {
                    uint64_t& gc_record_cnt,         // NOLINT
                    uint64_t& gc_record_byte_size);  // NOLINT
 
+    Slice NewKey(const Slice& key);
+    void FreeKey(const Slice& key);
+
+    // return the KeyEntry or the KeyEntry array of key, need hold the shared lock of mu_
+    void* GetOrInsertEntryConcurrently(const Slice& key, uint32_t* byte_size);
+
+    // the entry of the `pos`th ts column
+    KeyEntry* NewKeyEntry(uint32_t pos);
+
+    // insert the row to the time entries and the columnar shadow of entry
+    uint8_t InsertToEntry(KeyEntry* entry, uint64_t time, DataBlock* row, bool concurrent);
+
+    // rebuild the columnar shadow of entry from its time entries
+    void ResetShadow(KeyEntry* entry);
+
+    void BumpKeyVersions(const Slice& key);
+
  private:
     KeyEntries* entries_;
-    // only Put need mutex
-    std::mutex mu_;
+    // Put holds the shared lock if concurrent_put_ is true, otherwise the exclusive lock.
+    // Delete and gc which remove nodes from the lists always hold the exclusive lock, which is preferred so they
+    // are not starved by the continuous puts. it is a plain std::mutex unless concurrent_put_ is true
+    SegmentMutex mu_;
     std::mutex gc_mu_;
     std::atomic<uint64_t> idx_cnt_;
     std::atomic<uint64_t> idx_byte_size_;
@@ -273,6 +409,16 @@ class Segment {
     std::map<uint32_t, uint32_t> ts_idx_map_;
     std::vector<std::shared_ptr<std::atomic<uint64_t>>> idx_cnt_vec_;
     uint64_t ttl_offset_;
+    uint8_t skiplist_branch_;
+    // insert into the skiplists by CAS instead of holding the exclusive lock
+    bool concurrent_put_;
+    uint32_t version_tid_ = 0;
+    // the indexes of the keys, whose versions are bumped by the changes of the segment other than Put
+    std::vector<uint32_t> version_index_ids_;
+    // hold the pk, the skiplist nodes and the data blocks put from this segment
+    ::openmldb::base::SlabAllocator* allocator_;
+    // the columnar shadow spec of each ts column, null if no column is kept
+    std::vector<std::shared_ptr<ColumnarShadowSpec>> shadow_specs_;
 };
 
 }  // namespace storage
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "base/slice.h"
+#include "benchmark/benchmark.h"
+#include "gflags/gflags.h"
+#include "storage/segment.h"
+
+DECLARE_bool(enable_concurrent_put);
+
+namespace openmldb {
+namespace storage {
+
+static const uint32_t kPutCntPerThread = 100000;
+
+// range(0) is the thread count and range(1) is the pk count, all threads put to one segment
+static void RunSegmentPut(benchmark::State& state, bool concurrent) {  // NOLINT
+    FLAGS_enable_concurrent_put = concurrent;
+    uint32_t thread_cnt = state.range(0);
+    uint32_t pk_cnt = state.range(1);
+    std::vector<std::string> keys;
+    for (uint32_t i = 0; i < pk_cnt; i++) {
+        keys.push_back("pk" + std::to_string(i));
+    }
+    std::string value(128, 'a');
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::unique_ptr<Segment> segment(new Segment());
+        state.ResumeTiming();
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t < thread_cnt; t++) {
+            threads.emplace_back([&segment, &keys, &value, t] {
+                for (uint32_t i = 0; i < kPutCntPerThread; i++) {
+                    const std::string& key = keys[(i * 7 + t) % keys.size()];
+                    segment->Put(::openmldb::base::Slice(key), 1000000 + i, value.c_str(), value.size());
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        state.PauseTiming();
+        segment->Release();
+        segment.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * thread_cnt * kPutCntPerThread);
+    FLAGS_enable_concurrent_put = true;
+}
+
+static void BM_SegmentConcurrentPut(benchmark::State& state) {  // NOLINT
+    RunSegmentPut(state, true);
+}
+
+static void BM_SegmentLockedPut(benchmark::State& state) {  // NOLINT
+    RunSegmentPut(state, false);
+}
+
+static void PutArgs(benchmark::internal::Benchmark* b) {
+    for (int threads : {1, 2, 4, 8, 16}) {
+        // hot keys and scattered keys
+        for (int pk_cnt : {4, 100000}) {
+            b->Args({threads, pk_cnt});
+        }
+    }
+}
+
+BENCHMARK(BM_SegmentConcurrentPut)->Apply(PutArgs)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SegmentLockedPut)->Apply(PutArgs)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+}  // namespace storage
+}  // namespace openmldb
+
+BENCHMARK_MAIN();
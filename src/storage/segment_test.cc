@@ -16,16 +16,27 @@
 
 #include "storage/segment.h"
 
+#include <atomic>
 #include <iostream>
 #include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "base/glog_wapper.h"  // NOLINT
 #include "base/slice.h"
+#include "codec/codec.h"
+#include "codec/schema_codec.h"
+#include "gflags/gflags.h"
 #include "gtest/gtest.h"
+#include "storage/key_versions.h"
 #include "storage/record.h"
 
 using ::openmldb::base::Slice;
 
+DECLARE_bool(enable_segment_slab);
+DECLARE_bool(enable_concurrent_put);
+
 namespace openmldb {
 namespace storage {
 
@@ -37,7 +48,7 @@ class SegmentTest : public ::testing::Test {
 
 TEST_F(SegmentTest, Size) {
     ASSERT_EQ(16, (int64_t)sizeof(DataBlock));
-    ASSERT_EQ(40, (int64_t)sizeof(KeyEntry));
+    ASSERT_EQ(56, (int64_t)sizeof(KeyEntry));
 }
 
 TEST_F(SegmentTest, DataBlock) {
@@ -250,6 +261,42 @@ TEST_F(SegmentTest, TestGc4TTL) {
     ASSERT_EQ(2 * GetRecordSize(5), (int64_t)gc_record_byte_size);
 }
 
+TEST_F(SegmentTest, GcUnderContinuousPut) {
+    bool concurrent_put = FLAGS_enable_concurrent_put;
+    FLAGS_enable_concurrent_put = true;
+    Segment segment;
+    const uint64_t put_cnt = 20000;
+    std::atomic<uint64_t> time(1);
+    std::atomic<int> running(4);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([&segment, &time, &running, put_cnt, i]() {
+            std::string pk = "pk" + std::to_string(i);
+            for (uint64_t cnt = 0; cnt < put_cnt; cnt++) {
+                segment.Put(Slice(pk), time.fetch_add(1), "value", 5);
+            }
+            running.fetch_sub(1);
+        });
+    }
+    // the puts hold the shared lock continuously, gc still gets the exclusive lock while they run
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    int gc_rounds = 0;
+    while (running.load() > 0) {
+        segment.Gc4TTL(time.load(), gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+        gc_rounds++;
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_GT(gc_rounds, 0);
+    segment.Gc4TTL(time.load(), gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(4 * put_cnt, gc_record_cnt);
+    ASSERT_EQ(4 * put_cnt, gc_idx_cnt);
+    FLAGS_enable_concurrent_put = concurrent_put;
+}
+
 TEST_F(SegmentTest, TestGc4TTLAndHead) {
     Segment segment;
     segment.Put("PK1", 9766, "test1", 5);
@@ -407,6 +454,253 @@ TEST_F(SegmentTest, PutAndGetTS) {
     ASSERT_EQ(e, t);
 }
 
+TEST_F(SegmentTest, BulkLoadPut) {
+    Segment segment;
+    std::vector<DataBlock*> blocks;
+    std::vector<std::pair<uint64_t, DataBlock*>> rows;
+    for (int i = 0; i < 100; i++) {
+        std::string value = "value" + std::to_string(i);
+        blocks.push_back(new DataBlock(1, value.c_str(), value.size()));
+        // in order of time desc except the last one
+        rows.emplace_back(i == 99 ? 9050 : 9100 - i, blocks.back());
+    }
+    segment.BulkLoadPut(0, Slice("pk1"), rows);
+    ASSERT_EQ(1, (int64_t)segment.GetPkCnt());
+    ASSERT_EQ(100, (int64_t)segment.GetIdxCnt());
+    {
+        Ticket ticket;
+        MemTableIterator* it = segment.NewIterator("pk1", ticket);
+        it->SeekToFirst();
+        uint64_t last_time = UINT64_MAX;
+        int cnt = 0;
+        while (it->Valid()) {
+            ASSERT_LE(it->GetKey(), last_time);
+            last_time = it->GetKey();
+            cnt++;
+            it->Next();
+        }
+        ASSERT_EQ(100, cnt);
+        it->Seek(9100);
+        ASSERT_TRUE(it->Valid());
+        ::openmldb::base::Slice val = it->GetValue();
+        ASSERT_EQ("value0", std::string(val.data(), val.size()));
+        delete it;
+    }
+    ASSERT_EQ(100u, segment.Release());
+}
+
+TEST_F(SegmentTest, KeyVersionsOfBulkLoadAndGc) {
+    KeyVersions::Enable();
+    Segment segment;
+    segment.TrackKeyVersions(100, {0, 1});
+    uint32_t slot = KeyVersions::GetSlot(100, 1, Slice("pk1"));
+    uint64_t version = KeyVersions::GetVersion(slot);
+    uint64_t append_version = KeyVersions::GetAppendVersion(slot);
+    std::vector<std::pair<uint64_t, DataBlock*>> rows;
+    for (int i = 0; i < 10; i++) {
+        std::string value = "value" + std::to_string(i);
+        rows.emplace_back(9100 - i, new DataBlock(1, value.c_str(), value.size()));
+    }
+    segment.BulkLoadPut(0, Slice("pk1"), rows);
+    ASSERT_LT(version, KeyVersions::GetVersion(slot));
+    ASSERT_LT(append_version, KeyVersions::GetAppendVersion(slot));
+
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    // nothing is dropped
+    version = KeyVersions::GetVersion(slot);
+    segment.Gc4TTL(9000, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(version, KeyVersions::GetVersion(slot));
+    segment.Gc4TTL(9095, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(5u, gc_record_cnt);
+    ASSERT_LT(version, KeyVersions::GetVersion(slot));
+    version = KeyVersions::GetVersion(slot);
+    segment.Gc4Head(2, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(8u, gc_record_cnt);
+    ASSERT_LT(version, KeyVersions::GetVersion(slot));
+    ASSERT_EQ(2u, segment.Release());
+}
+
+TEST_F(SegmentTest, PutAndGcWithSlab) {
+    FLAGS_enable_segment_slab = true;
+    Segment segment;
+    ASSERT_TRUE(segment.GetAllocator() != NULL);
+    for (int i = 0; i < 100; i++) {
+        std::string pk = "pk" + std::to_string(i % 10);
+        std::string value = "value" + std::to_string(i);
+        segment.Put(Slice(pk), 9000 + i, value.c_str(), value.size());
+    }
+    ASSERT_EQ(10, (int64_t)segment.GetPkCnt());
+    ASSERT_EQ(100, (int64_t)segment.GetIdxCnt());
+    uint64_t used_byte_size = segment.GetSlabUsedByteSize();
+    ASSERT_GT(used_byte_size, 0u);
+    ASSERT_GE(segment.GetSlabByteSize(), used_byte_size);
+    {
+        // the ticket holds the entry from gc
+        Ticket ticket;
+        MemTableIterator* it = segment.NewIterator("pk3", ticket);
+        it->SeekToFirst();
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(9093, (int64_t)it->GetKey());
+        ::openmldb::base::Slice val = it->GetValue();
+        ASSERT_EQ("value93", std::string(val.data(), val.size()));
+        delete it;
+    }
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    segment.Gc4Head(1, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(90, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(90, (int64_t)gc_record_cnt);
+    ASSERT_LT(segment.GetSlabUsedByteSize(), used_byte_size);
+    // the freed chunks are reused
+    uint64_t byte_size = segment.GetSlabByteSize();
+    for (int i = 0; i < 90; i++) {
+        std::string pk = "pk" + std::to_string(i % 10);
+        std::string value = "value" + std::to_string(i);
+        segment.Put(Slice(pk), 8000 + i, value.c_str(), value.size());
+    }
+    ASSERT_EQ(byte_size, segment.GetSlabByteSize());
+    ASSERT_TRUE(segment.Delete(Slice("pk1")));
+    segment.IncrGcVersion();
+    segment.IncrGcVersion();
+    segment.IncrGcVersion();
+    gc_idx_cnt = 0;
+    gc_record_cnt = 0;
+    segment.GcFreeList(gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(10, (int64_t)gc_idx_cnt);
+    ASSERT_EQ(9, (int64_t)segment.GetPkCnt());
+    segment.Release();
+    ASSERT_EQ(0u, segment.GetSlabUsedByteSize());
+    FLAGS_enable_segment_slab = false;
+}
+
+TEST_F(SegmentTest, ReleaseSharedBlockWithSlab) {
+    FLAGS_enable_segment_slab = true;
+    Segment segment0;
+    Segment segment1;
+    for (int i = 0; i < 100; i++) {
+        std::string pk = "pk" + std::to_string(i % 10);
+        std::string value = "value" + std::to_string(i);
+        // the block is put into the segments of two indexes like MemTable::Put
+        DataBlock* block = DataBlock::New(segment0.GetAllocator(), 2, value.c_str(), value.size());
+        segment0.Put(Slice(pk), 9000 + i, block);
+        segment1.Put(Slice(pk), 9000 + i, block);
+    }
+    uint64_t used_byte_size0 = segment0.GetSlabUsedByteSize();
+    uint64_t used_byte_size1 = segment1.GetSlabUsedByteSize();
+    ASSERT_GT(used_byte_size0, used_byte_size1);
+    ASSERT_EQ(100u, segment0.Release());
+    ASSERT_EQ(used_byte_size1, segment1.GetSlabUsedByteSize());
+    // the last reference is dropped by segment1, the blocks go back to the slab of segment0
+    ASSERT_EQ(100u, segment1.Release());
+    ASSERT_EQ(0u, segment0.GetSlabUsedByteSize());
+    ASSERT_EQ(0u, segment1.GetSlabUsedByteSize());
+    FLAGS_enable_segment_slab = false;
+}
+
+TEST_F(SegmentTest, ColumnarShadow) {
+    codec::Schema schema;
+    codec::SchemaCodec::SetColumnDesc(schema.Add(), "card", ::openmldb::type::kString);
+    codec::SchemaCodec::SetColumnDesc(schema.Add(), "amt", ::openmldb::type::kDouble);
+    codec::SchemaCodec::SetColumnDesc(schema.Add(), "cnt", ::openmldb::type::kInt);
+    codec::SchemaCodec::SetColumnDesc(schema.Add(), "ts", ::openmldb::type::kTimestamp);
+    ASSERT_FALSE(ColumnarShadowSpec::Create(schema, 1, {0}));
+    auto spec = ColumnarShadowSpec::Create(schema, 1, {1, 2});
+    ASSERT_TRUE(spec);
+    auto encode = [&schema](double amt, int32_t cnt, int64_t ts, uint8_t version) {
+        codec::RowBuilder builder(schema);
+        std::string row;
+        row.resize(builder.CalTotalLength(4));
+        builder.SetSchemaVersion(version);
+        builder.SetBuffer(reinterpret_cast<int8_t*>(&(row[0])), row.size());
+        builder.AppendString("card", 4);
+        builder.AppendDouble(amt);
+        if (cnt < 0) {
+            builder.AppendNULL();
+        } else {
+            builder.AppendInt32(cnt);
+        }
+        builder.AppendTimestamp(ts);
+        return row;
+    };
+    std::vector<uint32_t> ts_idx = {3};
+    Segment segment(8, ts_idx);
+    ASSERT_TRUE(segment.EnableColumnarShadow(3, spec));
+    for (int i = 0; i < 10; i++) {
+        std::string row = encode(i, i == 4 ? -1 : i, 1000 + i, 1);
+        segment.Put(Slice("pk1"), 1000 + i, row.c_str(), row.size());
+    }
+    // out of order and with the same ts
+    std::string row = encode(100, 100, 1003, 1);
+    segment.Put(Slice("pk1"), 1003, row.c_str(), row.size());
+    void* value = NULL;
+    ASSERT_EQ(0, segment.GetKeyEntries()->Get(Slice("pk1"), value));
+    KeyEntry* entry = reinterpret_cast<KeyEntry*>(value);
+    ASSERT_TRUE(entry->shadow_ != NULL);
+    ASSERT_EQ(11u, entry->shadow_->GetCount());
+
+    // the arrays are in the order of the time entries
+    auto check = [&schema, entry](uint64_t ts, uint64_t cnt) {
+        uint64_t version = entry->shadow_->GetVersion();
+        std::vector<::hybridse::codec::ColumnarArray> arrays;
+        ASSERT_TRUE(entry->shadow_->Append(version, ts, cnt, &arrays));
+        ASSERT_EQ(2u, arrays.size());
+        ASSERT_EQ(cnt, arrays[0].GetCount());
+        ASSERT_EQ(cnt, arrays[1].GetCount());
+        const double* amts = reinterpret_cast<const double*>(arrays[0].values.data());
+        const int32_t* cnts = reinterpret_cast<const int32_t*>(arrays[1].values.data());
+        codec::RowView view(schema);
+        std::unique_ptr<TimeEntries::Iterator> it(entry->entries.NewIterator());
+        it->Seek(ts);
+        for (uint64_t i = 0; i < cnt; i++) {
+            ASSERT_TRUE(it->Valid());
+            ASSERT_TRUE(view.Reset(reinterpret_cast<int8_t*>(it->GetValue()->data), it->GetValue()->size));
+            double amt = 0;
+            ASSERT_EQ(0, view.GetDouble(1, &amt));
+            ASSERT_EQ(amt, amts[i]);
+            int32_t val = 0;
+            int ret = view.GetInt32(2, &val);
+            ASSERT_EQ(ret == 1, arrays[1].nulls[i] == 1);
+            if (ret == 0) {
+                ASSERT_EQ(val, cnts[i]);
+            }
+            it->Next();
+        }
+    };
+    check(1005, 4);
+    check(UINT64_MAX, 11);
+    {
+        uint64_t version = entry->shadow_->GetVersion();
+        std::vector<::hybridse::codec::ColumnarArray> arrays;
+        ASSERT_FALSE(entry->shadow_->Append(version, 1005, 8, &arrays));
+        row = encode(10, 10, 1010, 1);
+        segment.Put(Slice("pk1"), 1010, row.c_str(), row.size());
+        // the shadow has been changed since version
+        ASSERT_FALSE(entry->shadow_->Append(version, 1005, 4, &arrays));
+    }
+    uint64_t gc_idx_cnt = 0;
+    uint64_t gc_record_cnt = 0;
+    uint64_t gc_record_byte_size = 0;
+    segment.Gc4Head(5, gc_idx_cnt, gc_record_cnt, gc_record_byte_size);
+    ASSERT_EQ(7u, gc_idx_cnt);
+    ASSERT_EQ(5u, entry->shadow_->GetCount());
+    check(UINT64_MAX, 5);
+
+    // the row of the other schema version makes the shadow invalid
+    row = encode(1, 1, 1000, 1);
+    segment.Put(Slice("pk2"), 1000, row.c_str(), row.size());
+    row = encode(2, 2, 1001, 2);
+    segment.Put(Slice("pk2"), 1001, row.c_str(), row.size());
+    ASSERT_EQ(0, segment.GetKeyEntries()->Get(Slice("pk2"), value));
+    entry = reinterpret_cast<KeyEntry*>(value);
+    ASSERT_FALSE(entry->shadow_->IsValid());
+    std::vector<::hybridse::codec::ColumnarArray> arrays;
+    ASSERT_FALSE(entry->shadow_->Append(entry->shadow_->GetVersion(), 1000, 1, &arrays));
+    ASSERT_EQ(7u, segment.Release());
+}
+
 }  // namespace storage
 }  // namespace openmldb
 
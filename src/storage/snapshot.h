@@ -18,6 +18,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "log/log_writer.h"
 #include "proto/tablet.pb.h"
@@ -38,9 +39,12 @@ class Snapshot {
     virtual bool Recover(std::shared_ptr<Table> table,
                          uint64_t& latest_offset) = 0;  // NOLINT
     uint64_t GetOffset() { return offset_; }
-    int GenManifest(const std::string& snapshot_name, uint64_t key_count, uint64_t offset, uint64_t term);
+    int GenManifest(const std::string& snapshot_name, uint64_t key_count, uint64_t offset, uint64_t term,
+                    const std::vector<std::string>& parts = {});
     static int GetLocalManifest(const std::string& full_path,
                                 ::openmldb::api::Manifest& manifest);  // NOLINT
+    // the names of all the files of the snapshot
+    static std::vector<std::string> GetSnapshotFiles(const ::openmldb::api::Manifest& manifest);
 
  protected:
     uint32_t tid_;
@@ -42,6 +42,8 @@
 
 DECLARE_string(db_root_path);
 DECLARE_string(snapshot_compression);
+DECLARE_uint32(snapshot_part_num);
+DECLARE_bool(recover_snapshot_with_mmap);
 
 using ::openmldb::api::LogEntry;
 namespace openmldb {
@@ -1168,6 +1170,50 @@ TEST_F(SnapshotTest, MakeSnapshotLatest) {
     ASSERT_EQ(7, (int64_t)manifest.term());
 }
 
+TEST_F(SnapshotTest, MakeSnapshotBadRecordAfterEndOffset) {
+    LogParts* log_part = new LogParts(12, 4, scmp);
+    MemTableSnapshot snapshot(6, 1, log_part, FLAGS_db_root_path);
+    snapshot.Init();
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::shared_ptr<MemTable> table =
+        std::make_shared<MemTable>("tx_log", 6, 1, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    uint64_t offset = 0;
+    uint32_t binlog_index = 0;
+    std::string log_path = FLAGS_db_root_path + "/6_1/binlog/";
+    std::string snapshot_path = FLAGS_db_root_path + "/6_1/snapshot/";
+    WriteHandle* wh = NULL;
+    RollWLogFile(&wh, log_part, log_path, binlog_index, offset++);
+    for (int count = 0; count < 10; count++) {
+        auto entry = ::openmldb::test::PackKVEntry(offset, "key" + std::to_string(count), "value",
+                                                   ::baidu::common::timer::get_micros() / 1000, 5);
+        std::string buffer;
+        entry.SerializeToString(&buffer);
+        ::openmldb::base::Slice slice(buffer);
+        ASSERT_TRUE(wh->Write(slice).ok());
+        offset++;
+    }
+    // the records past the end offset are not part of the snapshot, even if they can not be parsed
+    std::string bad_record(16, '\xff');
+    ::openmldb::base::Slice bad_slice(bad_record);
+    ASSERT_TRUE(wh->Write(bad_slice).ok());
+    wh->Sync();
+
+    uint64_t offset_value = 0;
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, offset - 1));
+    ASSERT_EQ(offset - 1, offset_value);
+    ::openmldb::api::Manifest manifest;
+    {
+        int fd = open((snapshot_path + "MANIFEST").c_str(), O_RDONLY);
+        google::protobuf::io::FileInputStream fileInput(fd);
+        fileInput.SetCloseOnDelete(true);
+        google::protobuf::TextFormat::Parse(&fileInput, &manifest);
+    }
+    ASSERT_EQ(10, (int64_t)manifest.offset());
+    ASSERT_EQ(10, (int64_t)manifest.count());
+}
+
 TEST_F(SnapshotTest, RecordOffset) {
     std::string snapshot_path = FLAGS_db_root_path + "/1_1/snapshot/";
     MemTableSnapshot snapshot(1, 1, NULL, FLAGS_db_root_path);
@@ -1575,6 +1621,85 @@ TEST_F(SnapshotTest, MakeSnapshotWithEndOffset) {
     ASSERT_EQ(7, (int64_t)manifest.term());
 }
 
+TEST_F(SnapshotTest, MakeSnapshotMultiPart) {
+    FLAGS_snapshot_part_num = 3;
+    LogParts* log_part = new LogParts(12, 4, scmp);
+    MemTableSnapshot snapshot(102, 0, log_part, FLAGS_db_root_path);
+    snapshot.Init();
+    std::map<std::string, uint32_t> mapping;
+    mapping.insert(std::make_pair("idx0", 0));
+    std::shared_ptr<MemTable> table =
+        std::make_shared<MemTable>("test", 102, 0, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    table->Init();
+    std::string log_path = FLAGS_db_root_path + "/102_0/binlog/";
+    std::string snapshot_path = FLAGS_db_root_path + "/102_0/snapshot/";
+    uint64_t offset = 0;
+    uint32_t binlog_index = 0;
+    WriteHandle* wh = NULL;
+    RollWLogFile(&wh, log_part, log_path, binlog_index, offset);
+    uint32_t count = 0;
+    for (; count < 5000; count++) {
+        offset++;
+        auto entry = ::openmldb::test::PackKVEntry(offset, "key" + std::to_string(count), "value", count + 1, 1);
+        std::string buffer;
+        entry.SerializeToString(&buffer);
+        ::openmldb::base::Slice slice(buffer);
+        ASSERT_TRUE(wh->Write(slice).ok());
+    }
+    wh->Sync();
+    uint64_t offset_value = 0;
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    ::openmldb::api::Manifest manifest;
+    ASSERT_EQ(0, GetManifest(snapshot_path + "MANIFEST", &manifest));
+    ASSERT_EQ(3, manifest.parts_size());
+    ASSERT_EQ(manifest.name(), manifest.parts(0));
+    ASSERT_EQ(5000u, manifest.count());
+    ASSERT_EQ(5000u, manifest.offset());
+    std::vector<std::string> vec;
+    ASSERT_EQ(0, ::openmldb::base::GetFileName(snapshot_path, vec));
+    ASSERT_EQ(4u, vec.size());
+
+    // the old parts are read back and replaced by the new ones
+    RollWLogFile(&wh, log_part, log_path, binlog_index, offset);
+    for (; count < 6000; count++) {
+        offset++;
+        auto entry = ::openmldb::test::PackKVEntry(offset, "key" + std::to_string(count), "value", count + 1, 1);
+        std::string buffer;
+        entry.SerializeToString(&buffer);
+        ::openmldb::base::Slice slice(buffer);
+        ASSERT_TRUE(wh->Write(slice).ok());
+    }
+    wh->Sync();
+    ASSERT_EQ(0, snapshot.MakeSnapshot(table, offset_value, 0));
+    ASSERT_EQ(0, GetManifest(snapshot_path + "MANIFEST", &manifest));
+    ASSERT_EQ(3, manifest.parts_size());
+    ASSERT_EQ(6000u, manifest.count());
+    ASSERT_EQ(6000u, manifest.offset());
+    vec.clear();
+    ASSERT_EQ(0, ::openmldb::base::GetFileName(snapshot_path, vec));
+    ASSERT_EQ(4u, vec.size());
+
+    std::shared_ptr<MemTable> new_table =
+        std::make_shared<MemTable>("test", 102, 0, 8, mapping, 0, ::openmldb::type::TTLType::kAbsoluteTime);
+    new_table->Init();
+    MemTableSnapshot new_snapshot(102, 0, log_part, FLAGS_db_root_path);
+    new_snapshot.Init();
+    uint64_t snapshot_offset = 0;
+    ASSERT_TRUE(new_snapshot.Recover(new_table, snapshot_offset));
+    ASSERT_EQ(6000u, snapshot_offset);
+    ASSERT_EQ(6000u, new_table->GetRecordCnt());
+    for (uint32_t i = 0; i < count; i += 97) {
+        Ticket ticket;
+        TableIterator* it = new_table->NewIterator("key" + std::to_string(i), ticket);
+        it->SeekToFirst();
+        ASSERT_TRUE(it->Valid());
+        ASSERT_EQ(i + 1, it->GetKey());
+        delete it;
+    }
+    FLAGS_snapshot_part_num = 1;
+    RemoveData(FLAGS_db_root_path);
+}
+
 TEST_F(SnapshotTest, Recover_large_snapshot) {
     std::string snapshot_dir = FLAGS_db_root_path + "/100_0/snapshot/";
     std::string binlog_dir = FLAGS_db_root_path + "/100_0/binlog/";
@@ -1723,5 +1848,10 @@ int main(int argc, char** argv) {
         FLAGS_snapshot_compression = vec[i];
         ret += RUN_ALL_TESTS();
     }
+    std::cout << "compress type: off, recover with mmap" << std::endl;
+    FLAGS_db_root_path = "/tmp/" + std::to_string(::openmldb::storage::GenRand());
+    FLAGS_snapshot_compression = "off";
+    FLAGS_recover_snapshot_with_mmap = true;
+    ret += RUN_ALL_TESTS();
     return ret;
 }
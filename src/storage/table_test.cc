@@ -38,6 +38,7 @@ DECLARE_string(ssd_root_path);
 DECLARE_string(hdd_root_path);
 DECLARE_uint32(max_traverse_cnt);
 DECLARE_int32(gc_safe_offset);
+DECLARE_bool(enable_segment_slab);
 
 namespace openmldb {
 namespace storage {
@@ -1646,6 +1647,49 @@ TEST_F(TableTest, Release) {
     delete table;
 }
 
+TEST_F(TableTest, ReleaseWithSlab) {
+    FLAGS_enable_segment_slab = true;
+    ::openmldb::api::TableMeta table_meta;
+    table_meta.set_name("t0");
+    table_meta.set_tid(1);
+    table_meta.set_pid(0);
+    table_meta.set_seg_cnt(8);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "card", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "mcc", ::openmldb::type::kString);
+    SchemaCodec::SetColumnDesc(table_meta.add_column_desc(), "ts", ::openmldb::type::kBigInt);
+    SchemaCodec::SetIndex(table_meta.add_column_key(), "card", "card", "ts", ::openmldb::type::kAbsoluteTime, 0, 0);
+    SchemaCodec::SetIndex(table_meta.add_column_key(), "mcc", "mcc", "ts", ::openmldb::type::kAbsoluteTime, 0, 0);
+    MemTable* table = new MemTable(table_meta);
+    table->Init();
+    codec::SDKCodec codec(table_meta);
+    for (int i = 0; i < 100; i++) {
+        std::vector<std::string> row = {"card" + std::to_string(i % 10), "mcc" + std::to_string(i % 7),
+                                        std::to_string(9527 + i)};
+        ::openmldb::api::PutRequest request;
+        ::openmldb::api::Dimension* dim = request.add_dimensions();
+        dim->set_idx(0);
+        dim->set_key(row[0]);
+        dim = request.add_dimensions();
+        dim->set_idx(1);
+        dim->set_key(row[1]);
+        std::string value;
+        ASSERT_EQ(0, codec.EncodeRow(row, &value));
+        ASSERT_TRUE(table->Put(0, value, request.dimensions()));
+    }
+    uint64_t byte_size = 0;
+    uint64_t used_byte_size = 0;
+    table->GetSlabByteSize(&byte_size, &used_byte_size);
+    ASSERT_GT(used_byte_size, 0u);
+    ASSERT_GE(byte_size, used_byte_size);
+    // dropping the table frees the segments with their slabs
+    ASSERT_EQ(200, (int64_t)table->Release());
+    table->GetSlabByteSize(&byte_size, &used_byte_size);
+    ASSERT_EQ(0u, byte_size);
+    ASSERT_EQ(0u, used_byte_size);
+    delete table;
+    FLAGS_enable_segment_slab = false;
+}
+
 TEST_P(TableTest, TSColIDLength) {
     ::openmldb::common::StorageMode storageMode = GetParam();
     ::openmldb::api::TableMeta table_meta;
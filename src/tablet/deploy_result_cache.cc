@@ -0,0 +1,122 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/deploy_result_cache.h"
+
+#include <algorithm>
+
+#include "base/hash.h"
+#include "common/timer.h"
+#include "storage/key_versions.h"
+
+namespace openmldb {
+namespace tablet {
+
+DeployResultCache::DeployResultCache(uint32_t capacity, uint64_t ttl_ms)
+    : shard_capacity_(std::max(capacity / kShardCnt, 1u)), ttl_us_(ttl_ms * 1000), shards_() {}
+
+std::string DeployResultCache::GetKey(const std::string& deploy_name, const std::string& request) {
+    std::string key;
+    key.reserve(deploy_name.size() + 1 + request.size());
+    key.append(deploy_name).push_back('\0');
+    key.append(request);
+    return key;
+}
+
+DeployResultCache::Shard& DeployResultCache::GetShard(const std::string& key) {
+    return shards_[::openmldb::base::hash(key.c_str(), key.length(), 0xe17a1465) % kShardCnt];
+}
+
+bool DeployResultCache::Get(const std::string& deploy_name, const std::string& request, butil::IOBuf* output) {
+    std::string key = GetKey(deploy_name, request);
+    auto& shard = GetShard(key);
+    uint64_t now = ::baidu::common::timer::get_micros();
+    std::lock_guard<std::mutex> lock(shard.mu);
+    auto& stat = shard.stats[deploy_name];
+    auto iter = shard.index.find(key);
+    if (iter == shard.index.end()) {
+        stat.miss++;
+        return false;
+    }
+    auto entry = iter->second;
+    bool stale = entry->expire_time <= now;
+    for (auto it = entry->slots.begin(); !stale && it != entry->slots.end(); ++it) {
+        stale = ::openmldb::storage::KeyVersions::GetVersion(it->first) != it->second;
+    }
+    if (stale) {
+        shard.index.erase(iter);
+        shard.entries.erase(entry);
+        stat.miss++;
+        return false;
+    }
+    shard.entries.splice(shard.entries.begin(), shard.entries, entry);
+    output->append(entry->output);
+    stat.hit++;
+    return true;
+}
+
+void DeployResultCache::Put(const std::string& deploy_name, const std::string& request,
+                            const butil::IOBuf& output, std::vector<std::pair<uint32_t, uint64_t>> slots) {
+    std::string key = GetKey(deploy_name, request);
+    auto& shard = GetShard(key);
+    uint64_t expire_time = ::baidu::common::timer::get_micros() + ttl_us_;
+    std::lock_guard<std::mutex> lock(shard.mu);
+    auto iter = shard.index.find(key);
+    if (iter != shard.index.end()) {
+        shard.entries.erase(iter->second);
+        shard.index.erase(iter);
+    }
+    shard.entries.push_front(Entry{key, output, std::move(slots), expire_time});
+    shard.index.emplace(std::move(key), shard.entries.begin());
+    while (shard.entries.size() > shard_capacity_) {
+        shard.index.erase(shard.entries.back().key);
+        shard.entries.pop_back();
+    }
+}
+
+void DeployResultCache::DropDeploy(const std::string& deploy_name) {
+    std::string prefix = deploy_name;
+    prefix.push_back('\0');
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mu);
+        for (auto it = shard.entries.begin(); it != shard.entries.end();) {
+            if (it->key.compare(0, prefix.size(), prefix) == 0) {
+                shard.index.erase(it->key);
+                it = shard.entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        shard.stats.erase(deploy_name);
+    }
+}
+
+std::map<std::string, DeployResultCache::Stat> DeployResultCache::FlushStats() {
+    std::map<std::string, Stat> stats;
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mu);
+        for (const auto& kv : shard.stats) {
+            auto& stat = stats[kv.first];
+            stat.hit += kv.second.hit;
+            stat.miss += kv.second.miss;
+        }
+        shard.stats.clear();
+    }
+    return stats;
+}
+
+}  // namespace tablet
+}  // namespace openmldb
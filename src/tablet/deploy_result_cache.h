@@ -0,0 +1,88 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_TABLET_DEPLOY_RESULT_CACHE_H_
+#define SRC_TABLET_DEPLOY_RESULT_CACHE_H_
+
+#include <array>
+#include <list>
+#include <map>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "butil/iobuf.h"
+
+namespace openmldb {
+namespace tablet {
+
+// the encoded output rows of the deployments keyed by the deployment and the request row. an entry is dropped if one of
+// the keys read to compute it is updated on this tablet, see storage::KeyVersions, or it is older than the ttl,
+// which bounds the staleness of the rows read from the other tablets
+class DeployResultCache {
+ public:
+    struct Stat {
+        uint64_t hit = 0;
+        uint64_t miss = 0;
+    };
+
+    DeployResultCache(uint32_t capacity, uint64_t ttl_ms);
+
+    // append the cached output to `output`, the blocks of the buffer are shared instead of copied
+    bool Get(const std::string& deploy_name, const std::string& request, butil::IOBuf* output);
+
+    // `slots` are the slots and the versions of the keys read before the output is computed
+    void Put(const std::string& deploy_name, const std::string& request, const butil::IOBuf& output,
+             std::vector<std::pair<uint32_t, uint64_t>> slots);
+
+    // drop the entries of a deployment which is dropped or deployed again
+    void DropDeploy(const std::string& deploy_name);
+
+    // the hit and miss counts of the deployments since the last flush
+    std::map<std::string, Stat> FlushStats();
+
+ private:
+    static constexpr uint32_t kShardCnt = 16;
+
+    struct Entry {
+        std::string key;
+        butil::IOBuf output;
+        std::vector<std::pair<uint32_t, uint64_t>> slots;
+        uint64_t expire_time;
+    };
+
+    // the entries in lru order, the most recently used one is at the front
+    struct Shard {
+        std::mutex mu;
+        std::list<Entry> entries;
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+        std::map<std::string, Stat> stats;
+    };
+
+    static std::string GetKey(const std::string& deploy_name, const std::string& request);
+
+    Shard& GetShard(const std::string& key);
+
+    const uint32_t shard_capacity_;
+    const uint64_t ttl_us_;
+    std::array<Shard, kShardCnt> shards_;
+};
+
+}  // namespace tablet
+}  // namespace openmldb
+#endif  // SRC_TABLET_DEPLOY_RESULT_CACHE_H_
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tablet/deploy_result_cache.h"
+
+#include <string>
+#include <vector>
+
+#include "base/glog_wapper.h"
+#include "catalog/read_key_recorder.h"
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+#include "storage/key_versions.h"
+
+namespace openmldb::tablet {
+
+using ::openmldb::catalog::ReadKeyRecorder;
+using ::openmldb::storage::KeyVersions;
+
+class DeployResultCacheTest : public ::testing::Test {
+ protected:
+    void SetUp() override { KeyVersions::Enable(); }
+};
+
+static butil::IOBuf Output(const std::string& value) {
+    butil::IOBuf buf;
+    buf.append(value);
+    return buf;
+}
+
+static std::vector<std::pair<uint32_t, uint64_t>> ReadKeys(uint32_t tid, const std::vector<std::string>& keys) {
+    ReadKeyRecorder recorder;
+    for (const auto& key : keys) {
+        ReadKeyRecorder::Record(tid, 0, key);
+    }
+    return recorder.TakeReadSlots();
+}
+
+TEST_F(DeployResultCacheTest, HitAndInvalidate) {
+    DeployResultCache cache(100, 60000);
+    butil::IOBuf output;
+    ASSERT_FALSE(cache.Get("db.d1", "req1", &output));
+    cache.Put("db.d1", "req1", Output("out1"), ReadKeys(1, {"k1", "k2"}));
+    ASSERT_TRUE(cache.Get("db.d1", "req1", &output));
+    ASSERT_EQ("out1", output.to_string());
+    // the same request of another deployment
+    ASSERT_FALSE(cache.Get("db.d2", "req1", &output));
+
+    // a put on another table or key keeps the entry
+    KeyVersions::Bump(2, 0, "k1");
+    KeyVersions::Bump(1, 0, "k3");
+    ASSERT_TRUE(cache.Get("db.d1", "req1", &output));
+    KeyVersions::Bump(1, 0, "k2");
+    ASSERT_FALSE(cache.Get("db.d1", "req1", &output));
+
+    auto stats = cache.FlushStats();
+    ASSERT_EQ(2u, stats.size());
+    ASSERT_EQ(2u, stats["db.d1"].hit);
+    ASSERT_EQ(2u, stats["db.d1"].miss);
+    ASSERT_EQ(0u, stats["db.d2"].hit);
+    ASSERT_EQ(1u, stats["db.d2"].miss);
+    ASSERT_TRUE(cache.FlushStats().empty());
+}
+
+TEST_F(DeployResultCacheTest, FullScan) {
+    ReadKeyRecorder recorder;
+    ReadKeyRecorder::Record(1, 0, "k1");
+    ASSERT_TRUE(recorder.IsCacheable());
+    ReadKeyRecorder::RecordFullScan();
+    ASSERT_FALSE(recorder.IsCacheable());
+}
+
+TEST_F(DeployResultCacheTest, Expire) {
+    DeployResultCache cache(100, 0);
+    butil::IOBuf output;
+    cache.Put("db.d1", "req1", Output("out1"), {});
+    ASSERT_FALSE(cache.Get("db.d1", "req1", &output));
+}
+
+TEST_F(DeployResultCacheTest, EvictAndDrop) {
+    // one entry per shard
+    DeployResultCache cache(1, 60000);
+    butil::IOBuf output;
+    for (int i = 0; i < 100; i++) {
+        cache.Put("db.d1", "req" + std::to_string(i), Output("out"), {});
+    }
+    int hit = 0;
+    for (int i = 0; i < 100; i++) {
+        output.clear();
+        hit += cache.Get("db.d1", "req" + std::to_string(i), &output);
+    }
+    ASSERT_GT(hit, 0);
+    ASSERT_LE(hit, 16);
+
+    cache.Put("db.d2", "req", Output("out"), {});
+    cache.DropDeploy("db.d2");
+    ASSERT_FALSE(cache.Get("db.d2", "req", &output));
+}
+
+}  // namespace openmldb::tablet
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::openmldb::base::SetLogLevel(INFO);
+    ::google::ParseCommandLineFlags(&argc, &argv, true);
+    return RUN_ALL_TESTS();
+}
@@ -55,12 +55,16 @@
 #include "common/timer.h"
 #include "glog/logging.h"
 #include "schema/schema_adapter.h"
+#include "catalog/read_key_recorder.h"
 #include "storage/binlog.h"
+#include "storage/key_versions.h"
 #include "storage/segment.h"
 #include "tablet/file_sender.h"
 #include "storage/table.h"
 #include "storage/disk_table_snapshot.h"
 #include "absl/cleanup/cleanup.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
 
 using google::protobuf::RepeatedPtrField;
 using ::openmldb::base::ReturnCode;
@@ -70,11 +74,26 @@ using ::openmldb::storage::Table;
 using ::openmldb::storage::DiskTable;
 
 DECLARE_int32(gc_interval);
+DECLARE_bool(enable_jit_object_cache);
+DECLARE_uint32(jit_object_cache_max_mb);
+DECLARE_bool(enable_deploy_result_cache);
+DECLARE_uint32(deploy_result_cache_capacity);
+DECLARE_uint32(deploy_result_cache_ttl_ms);
+DECLARE_uint64(request_window_cache_rows);
+DECLARE_uint32(batch_window_agg_parallelism);
+DECLARE_uint32(batch_sort_parallelism);
+DECLARE_uint32(binlog_sync_reorder_wait_ms);
+DECLARE_bool(enable_tiered_jit);
+DECLARE_uint64(tiered_jit_threshold);
 DECLARE_int32(gc_pool_size);
 DECLARE_int32(disk_gc_interval);
 DECLARE_int32(statdb_ttl);
 DECLARE_uint32(scan_max_bytes_size);
 DECLARE_uint32(scan_reserve_size);
+DECLARE_int32(stream_scan_pool_size);
+DECLARE_uint32(stream_scan_chunk_size);
+DECLARE_uint32(stream_scan_window_size);
+DECLARE_int32(stream_scan_idle_timeout_ms);
 DECLARE_double(mem_release_rate);
 DECLARE_string(db_root_path);
 DECLARE_string(ssd_root_path);
@@ -136,6 +155,7 @@ TabletImpl::TabletImpl()
       task_pool_(FLAGS_task_pool_size),
       io_pool_(FLAGS_io_pool_size),
       snapshot_pool_(FLAGS_snapshot_pool_size),
+      stream_scan_pool_(FLAGS_stream_scan_pool_size),
       mode_root_paths_(),
       mode_recycle_root_paths_(),
       follower_(false),
@@ -155,6 +175,7 @@ TabletImpl::~TabletImpl() {
     gc_pool_.Stop(true);
     io_pool_.Stop(true);
     snapshot_pool_.Stop(true);
+    stream_scan_pool_.Stop(true);
     delete zk_client_;
 }
 
@@ -185,6 +206,11 @@ bool TabletImpl::Init(const std::string& zk_cluster, const std::string& zk_path,
     ::openmldb::base::SplitString(FLAGS_recycle_bin_hdd_root_path, ",",
                                   mode_recycle_root_paths_[::openmldb::common::kHDD]);
     deploy_collector_ = std::make_unique<::openmldb::statistics::DeployQueryTimeCollector>();
+    if (FLAGS_enable_deploy_result_cache) {
+        ::openmldb::storage::KeyVersions::Enable();
+        deploy_result_cache_ = std::make_unique<DeployResultCache>(FLAGS_deploy_result_cache_capacity,
+                                                                   FLAGS_deploy_result_cache_ttl_ms);
+    }
 
     if (!zk_cluster.empty()) {
         zk_client_ = new ZkClient(zk_cluster, real_endpoint, FLAGS_zk_session_timeout, endpoint, zk_path);
@@ -205,6 +231,18 @@ bool TabletImpl::Init(const std::string& zk_cluster, const std::string& zk_path,
     } else {
         options.SetClusterOptimized(false);
     }
+    if (FLAGS_enable_jit_object_cache && !mode_root_paths_[::openmldb::common::kMemory].empty()) {
+        options.jit_options().SetObjectCacheDir(mode_root_paths_[::openmldb::common::kMemory][0] + "/jit_object_cache");
+        options.jit_options().SetObjectCacheMaxBytes(static_cast<uint64_t>(FLAGS_jit_object_cache_max_mb) << 20);
+    }
+    if (FLAGS_request_window_cache_rows > 0) {
+        ::openmldb::storage::KeyVersions::Enable();
+        options.SetRequestWindowCacheRows(FLAGS_request_window_cache_rows);
+    }
+    options.SetWindowAggParallelism(FLAGS_batch_window_agg_parallelism);
+    options.SetSortParallelism(FLAGS_batch_sort_parallelism);
+    options.jit_options().SetEnableTieredJit(FLAGS_enable_tiered_jit);
+    options.jit_options().SetTieredJitThreshold(FLAGS_tiered_jit_threshold);
     engine_ = std::unique_ptr<::hybridse::vm::Engine>(new ::hybridse::vm::Engine(catalog_, options));
     catalog_->SetLocalTablet(
         std::shared_ptr<::hybridse::vm::Tablet>(new ::hybridse::vm::LocalTablet(engine_.get(), sp_cache_)));
@@ -806,6 +844,105 @@ void TabletImpl::Put(RpcController* controller, const ::openmldb::api::PutReques
     }
 }
 
+void TabletImpl::PutBatch(RpcController* controller, const ::openmldb::api::PutBatchRequest* request,
+                          ::openmldb::api::PutBatchResponse* response, Closure* done) {
+    brpc::ClosureGuard done_guard(done);
+    if (follower_.load(std::memory_order_relaxed)) {
+        response->set_code(::openmldb::base::ReturnCode::kIsFollowerCluster);
+        response->set_msg("is follower cluster");
+        return;
+    }
+    uint64_t start_time = ::baidu::common::timer::get_micros();
+    uint32_t tid = request->tid();
+    uint32_t pid = request->pid();
+    std::shared_ptr<Table> table = GetTable(tid, pid);
+    if (!table) {
+        PDLOG(WARNING, "table is not exist. tid %u, pid %u", tid, pid);
+        response->set_code(::openmldb::base::ReturnCode::kTableIsNotExist);
+        response->set_msg("table is not exist");
+        return;
+    }
+    if (!table->IsLeader()) {
+        response->set_code(::openmldb::base::ReturnCode::kTableIsFollower);
+        response->set_msg("table is follower");
+        return;
+    }
+    if (table->GetTableStat() == ::openmldb::storage::kLoading) {
+        PDLOG(WARNING, "table is loading. tid %u, pid %u", tid, pid);
+        response->set_code(::openmldb::base::ReturnCode::kTableIsLoading);
+        response->set_msg("table is loading");
+        return;
+    }
+    std::shared_ptr<LogReplicator> replicator = GetReplicator(tid, pid);
+    if (!replicator) {
+        PDLOG(WARNING, "fail to find table tid %u pid %u leader's log replicator", tid, pid);
+    }
+    uint64_t term = replicator ? replicator->GetLeaderTerm() : 0;
+    std::vector<::openmldb::api::LogEntry> entries;
+    // the position in request of every entry
+    std::vector<int> entry_pos;
+    entries.reserve(request->rows_size());
+    entry_pos.reserve(request->rows_size());
+    uint32_t failed_cnt = 0;
+    for (int i = 0; i < request->rows_size(); i++) {
+        const auto& row = request->rows(i);
+        if (row.dimensions_size() == 0 || CheckDimessionPut(row.dimensions(), table->GetIdxCnt()) != 0) {
+            response->add_row_code(::openmldb::base::ReturnCode::kInvalidDimensionParameter);
+            failed_cnt++;
+            continue;
+        }
+        if (!table->Put(row.time(), row.value(), row.dimensions())) {
+            response->add_row_code(::openmldb::base::ReturnCode::kPutFailed);
+            failed_cnt++;
+            continue;
+        }
+        response->add_row_code(::openmldb::base::ReturnCode::kOk);
+        // the entries are kept without the replicator too, so the aggregators are updated as Put does
+        entries.emplace_back();
+        ::openmldb::api::LogEntry& entry = entries.back();
+        entry.set_ts(row.time());
+        entry.set_value(row.value());
+        entry.set_term(term);
+        entry.mutable_dimensions()->CopyFrom(row.dimensions());
+        entry_pos.push_back(i);
+    }
+    // the rows are already in the table, so they stay ok as in Put. reporting them as failed would make the client
+    // insert them again on retry
+    if (replicator && !replicator->AppendEntryBatch(&entries)) {
+        PDLOG(WARNING, "fail to append %lu entries to binlog. tid %u pid %u", entries.size(), tid, pid);
+    }
+
+    auto aggrs = GetAggregators(tid, pid);
+    if (aggrs) {
+        for (size_t i = 0; i < entries.size(); i++) {
+            const auto& row = request->rows(entry_pos[i]);
+            if (!UpdateAggrs(aggrs, tid, pid, row.value(), row.dimensions(), entries[i].log_index())) {
+                response->set_row_code(entry_pos[i], ::openmldb::base::ReturnCode::kError);
+                failed_cnt++;
+            }
+        }
+    }
+    if (failed_cnt > 0) {
+        response->set_code(::openmldb::base::ReturnCode::kPutFailed);
+        response->set_msg("put failed for " + std::to_string(failed_cnt) + " rows");
+    } else {
+        response->set_code(::openmldb::base::ReturnCode::kOk);
+    }
+
+    uint64_t end_time = ::baidu::common::timer::get_micros();
+    if (start_time + FLAGS_put_slow_log_threshold < end_time) {
+        PDLOG(INFO, "slow log[put_batch]. row count %d time %lu. tid %u, pid %u", request->rows_size(),
+              end_time - start_time, tid, pid);
+    }
+    if (replicator && FLAGS_binlog_notify_on_put) {
+        replicator->Notify();
+    }
+    if (!IsClusterMode() && table->GetDB() == openmldb::nameserver::INFORMATION_SCHEMA_DB &&
+        table->GetName() == openmldb::nameserver::GLOBAL_VARIABLES) {
+        UpdateGlobalVarTable();
+    }
+}
+
 int TabletImpl::CheckTableMeta(const openmldb::api::TableMeta* table_meta, std::string& msg) {
     msg.clear();
     if (table_meta->name().empty()) {
@@ -1178,23 +1315,15 @@ int32_t TabletImpl::CountIndex(uint64_t expire_time, uint64_t expire_cnt, ::open
     return 0;
 }
 
-void TabletImpl::Scan(RpcController* controller, const ::openmldb::api::ScanRequest* request,
-                      ::openmldb::api::ScanResponse* response, Closure* done) {
-    brpc::ClosureGuard done_guard(done);
-    uint64_t start_time = ::baidu::common::timer::get_micros();
-    if (request->st() < request->et()) {
-        response->set_code(::openmldb::base::ReturnCode::kStLessThanEt);
-        response->set_msg("starttime less than endtime");
-        return;
-    }
+bool TabletImpl::GetScanIterators(const ::openmldb::api::ScanRequest* request, std::vector<QueryIt>* query_its,
+                                  ::openmldb::storage::TTLSt* expired_value, ::openmldb::api::ScanResponse* response) {
     uint32_t tid = request->tid();
     uint32_t pid_num = 1;
     if (request->pid_group_size() > 0) {
         pid_num = request->pid_group_size();
     }
-    std::vector<QueryIt> query_its(pid_num);
+    query_its->resize(pid_num);
     std::shared_ptr<::openmldb::storage::TTLSt> ttl;
-    ::openmldb::storage::TTLSt expired_value;
     for (uint32_t idx = 0; idx < pid_num; idx++) {
         uint32_t pid = 0;
         if (request->pid_group_size() > 0) {
@@ -1207,13 +1336,13 @@ void TabletImpl::Scan(RpcController* controller, const ::openmldb::api::ScanRequ
             PDLOG(WARNING, "table is not exist. tid %u, pid %u", tid, pid);
             response->set_code(::openmldb::base::ReturnCode::kTableIsNotExist);
             response->set_msg("table is not exist");
-            return;
+            return false;
         }
         if (table->GetTableStat() == ::openmldb::storage::kLoading) {
             PDLOG(WARNING, "table is loading. tid %u, pid %u", tid, pid);
             response->set_code(::openmldb::base::ReturnCode::kTableIsLoading);
             response->set_msg("table is loading");
-            return;
+            return false;
         }
         uint32_t index = 0;
         std::string index_name;
@@ -1228,21 +1357,38 @@ void TabletImpl::Scan(RpcController* controller, const ::openmldb::api::ScanRequ
             PDLOG(WARNING, "idx name %s not found in table tid %u, pid %u", index_name.c_str(), tid, pid);
             response->set_code(::openmldb::base::ReturnCode::kIdxNameNotFound);
             response->set_msg("idx name not found");
-            return;
+            return false;
         }
         index = index_def->GetId();
         if (!ttl) {
             ttl = index_def->GetTTL();
-            expired_value = *ttl;
-            expired_value.abs_ttl = table->GetExpireTime(expired_value);
+            *expired_value = *ttl;
+            expired_value->abs_ttl = table->GetExpireTime(*expired_value);
         }
-        GetIterator(table, request->pk(), index, &query_its[idx].it, &query_its[idx].ticket);
-        if (!query_its[idx].it) {
+        GetIterator(table, request->pk(), index, &(*query_its)[idx].it, &(*query_its)[idx].ticket);
+        if (!(*query_its)[idx].it) {
             response->set_code(::openmldb::base::ReturnCode::kTsNameNotFound);
             response->set_msg("ts name not found");
-            return;
+            return false;
         }
-        query_its[idx].table = table;
+        (*query_its)[idx].table = table;
+    }
+    return true;
+}
+
+void TabletImpl::Scan(RpcController* controller, const ::openmldb::api::ScanRequest* request,
+                      ::openmldb::api::ScanResponse* response, Closure* done) {
+    brpc::ClosureGuard done_guard(done);
+    uint64_t start_time = ::baidu::common::timer::get_micros();
+    if (request->st() < request->et()) {
+        response->set_code(::openmldb::base::ReturnCode::kStLessThanEt);
+        response->set_msg("starttime less than endtime");
+        return;
+    }
+    std::vector<QueryIt> query_its;
+    ::openmldb::storage::TTLSt expired_value;
+    if (!GetScanIterators(request, &query_its, &expired_value, response)) {
+        return;
     }
     auto table_meta = query_its.begin()->table->GetTableMeta();
     const std::map<int32_t, std::shared_ptr<Schema>> vers_schema = query_its.begin()->table->GetAllVersionSchema();
@@ -1292,6 +1438,61 @@ void TabletImpl::Scan(RpcController* controller, const ::openmldb::api::ScanRequ
     }
 }
 
+void TabletImpl::MultiGet(RpcController* controller, const ::openmldb::api::MultiGetRequest* request,
+                          ::openmldb::api::MultiGetResponse* response, Closure* done) {
+    brpc::ClosureGuard done_guard(done);
+    uint64_t start_time = ::baidu::common::timer::get_micros();
+    auto* cntl = dynamic_cast<brpc::Controller*>(controller);
+    butil::IOBuf& buf = cntl->response_attachment();
+    ::openmldb::api::ScanRequest scan_request;
+    scan_request.set_tid(request->tid());
+    scan_request.set_pid(request->pid());
+    std::string pairs;
+    for (const auto& key : request->keys()) {
+        auto* result = response->add_results();
+        if (key.st() < key.et()) {
+            result->set_code(::openmldb::base::ReturnCode::kStLessThanEt);
+            continue;
+        }
+        scan_request.set_pk(key.pk());
+        scan_request.set_idx_name(key.idx_name());
+        scan_request.set_st(key.st());
+        scan_request.set_et(key.et());
+        scan_request.set_limit(key.limit());
+        std::vector<QueryIt> query_its;
+        ::openmldb::storage::TTLSt expired_value;
+        ::openmldb::api::ScanResponse scan_response;
+        if (!GetScanIterators(&scan_request, &query_its, &expired_value, &scan_response)) {
+            result->set_code(scan_response.code());
+            continue;
+        }
+        auto table_meta = query_its.begin()->table->GetTableMeta();
+        const std::map<int32_t, std::shared_ptr<Schema>> vers_schema =
+            query_its.begin()->table->GetAllVersionSchema();
+        CombineIterator combine_it(std::move(query_its), key.st(), openmldb::api::GetType::kSubKeyLe, expired_value);
+        uint32_t count = 0;
+        bool is_finish = true;
+        pairs.clear();
+        int32_t code = ScanIndex(&scan_request, *table_meta, vers_schema, &combine_it, &pairs, &count, &is_finish);
+        if (code != 0) {
+            result->set_code(code == -4 ? ::openmldb::base::ReturnCode::kEncodeError
+                                        : ::openmldb::base::ReturnCode::kInvalidParameter);
+            continue;
+        }
+        buf.append(pairs);
+        result->set_code(::openmldb::base::ReturnCode::kOk);
+        result->set_count(count);
+        result->set_byte_size(pairs.size());
+        result->set_is_finish(is_finish);
+    }
+    response->set_code(::openmldb::base::ReturnCode::kOk);
+    uint64_t end_time = ::baidu::common::timer::get_micros();
+    if (start_time + FLAGS_query_slow_log_threshold < end_time) {
+        PDLOG(INFO, "slow log[multi get]. keys %d time %lu. tid %u, pid %u", request->keys_size(),
+              end_time - start_time, request->tid(), request->pid());
+    }
+}
+
 void TabletImpl::Count(RpcController* controller, const ::openmldb::api::CountRequest* request,
                        ::openmldb::api::CountResponse* response, Closure* done) {
     brpc::ClosureGuard done_guard(done);
@@ -1507,6 +1708,300 @@ void TabletImpl::Traverse(RpcController* controller, const ::openmldb::api::Trav
     response->set_is_finish(is_finish);
 }
 
+// write a chunk of a streaming scan, wait if the window of the stream is full until the client receives it
+static bool WriteStreamChunk(brpc::StreamId stream, const ::google::protobuf::Message& chunk) {
+    butil::IOBuf buf;
+    {
+        butil::IOBufAsZeroCopyOutputStream output(&buf);
+        if (!chunk.SerializeToZeroCopyStream(&output)) {
+            PDLOG(WARNING, "fail to serialize chunk of stream %lu", stream);
+            return false;
+        }
+    }
+    while (true) {
+        int ret = brpc::StreamWrite(stream, buf);
+        if (ret == 0) {
+            return true;
+        }
+        if (ret != EAGAIN) {
+            PDLOG(WARNING, "fail to write stream %lu. error %d", stream, ret);
+            return false;
+        }
+        timespec deadline = butil::milliseconds_from_now(FLAGS_stream_scan_idle_timeout_ms);
+        ret = brpc::StreamWait(stream, &deadline);
+        if (ret != 0) {
+            PDLOG(WARNING, "stream %lu is not consumed. error %d", stream, ret);
+            return false;
+        }
+    }
+}
+
+void TabletImpl::ScanStream(RpcController* controller, const ::openmldb::api::ScanRequest* request,
+                            ::openmldb::api::ScanResponse* response, Closure* done) {
+    brpc::ClosureGuard done_guard(done);
+    if (request->st() < request->et()) {
+        response->set_code(::openmldb::base::ReturnCode::kStLessThanEt);
+        response->set_msg("starttime less than endtime");
+        return;
+    }
+    std::vector<QueryIt> query_its;
+    ::openmldb::storage::TTLSt expired_value;
+    if (!GetScanIterators(request, &query_its, &expired_value, response)) {
+        return;
+    }
+    auto table_meta = query_its.begin()->table->GetTableMeta();
+    if (!request->projection().empty() && table_meta->compress_type() == ::openmldb::type::kSnappy) {
+        response->set_code(::openmldb::base::ReturnCode::kInvalidParameter);
+        response->set_msg("project on compress row data, not supported");
+        return;
+    }
+    auto vers_schema = query_its.begin()->table->GetAllVersionSchema();
+    auto combine_it = std::make_shared<CombineIterator>(std::move(query_its), request->st(),
+                                                        openmldb::api::GetType::kSubKeyLe, expired_value);
+    auto* cntl = dynamic_cast<brpc::Controller*>(controller);
+    brpc::StreamId stream;
+    brpc::StreamOptions stream_options;
+    stream_options.max_buf_size = FLAGS_stream_scan_window_size;
+    if (brpc::StreamAccept(&stream, *cntl, &stream_options) != 0) {
+        PDLOG(WARNING, "fail to accept stream. tid %u, pid %u", request->tid(), request->pid());
+        response->set_code(::openmldb::base::ReturnCode::kInvalidParameter);
+        response->set_msg("fail to accept stream");
+        return;
+    }
+    // the iterators and the tickets are held by the task until all the rows are pushed
+    stream_scan_pool_.AddTask(boost::bind(&TabletImpl::StreamScanIndex, this, stream,
+                                          std::make_shared<::openmldb::api::ScanRequest>(*request), vers_schema,
+                                          combine_it));
+    response->set_code(::openmldb::base::ReturnCode::kOk);
+}
+
+void TabletImpl::StreamScanIndex(brpc::StreamId stream, std::shared_ptr<::openmldb::api::ScanRequest> request,
+                                 std::map<int32_t, std::shared_ptr<Schema>> vers_schema,
+                                 std::shared_ptr<CombineIterator> combine_it) {
+    absl::Cleanup close_stream = [stream] { brpc::StreamClose(stream); };
+    ::openmldb::api::ScanResponse chunk;
+    uint64_t st = request->st();
+    uint64_t et = request->et();
+    uint64_t expire_time = combine_it->GetExpireTime();
+    ::openmldb::storage::TTLType ttl_type = combine_it->GetTTLType();
+    if (ttl_type == ::openmldb::storage::TTLType::kAbsoluteTime ||
+        ttl_type == ::openmldb::storage::TTLType::kAbsOrLat) {
+        et = std::max(et, expire_time);
+    }
+    if (st > 0 && st < et) {
+        PDLOG(WARNING, "invalid args for st %lu less than et %lu or expire time %lu", st, et, expire_time);
+        chunk.set_code(::openmldb::base::ReturnCode::kInvalidParameter);
+        chunk.set_msg("invalid args");
+        WriteStreamChunk(stream, chunk);
+        return;
+    }
+    bool enable_project = false;
+    ::openmldb::codec::RowProject row_project(vers_schema, request->projection());
+    if (!request->projection().empty()) {
+        if (!row_project.Init()) {
+            PDLOG(WARNING, "invalid project list");
+            chunk.set_code(::openmldb::base::ReturnCode::kInvalidParameter);
+            chunk.set_msg("invalid args");
+            WriteStreamChunk(stream, chunk);
+            return;
+        }
+        enable_project = true;
+    }
+    uint32_t limit = request->limit();
+    bool remove_duplicated_record = request->enable_remove_duplicated_record();
+    uint32_t skip_record_num = request->skip_record_num();
+    uint64_t last_time = 0;
+    uint32_t record_count = 0;
+    bool is_finish = false;
+    // the stream stops at the limit, so a pool thread is not held by a long key
+    bool limit_reached = false;
+    combine_it->SeekToFirst();
+    while (!is_finish) {
+        boost::container::deque<std::pair<uint64_t, ::openmldb::base::Slice>> rows;
+        uint32_t total_block_size = 0;
+        is_finish = true;
+        while (combine_it->Valid()) {
+            if (limit > 0 && record_count >= limit) {
+                limit_reached = true;
+                break;
+            }
+            if (remove_duplicated_record && record_count > 0 && last_time == combine_it->GetTs()) {
+                combine_it->Next();
+                continue;
+            }
+            if (combine_it->GetTs() == st && skip_record_num > 0) {
+                skip_record_num--;
+                combine_it->Next();
+                continue;
+            }
+            uint64_t ts = combine_it->GetTs();
+            if (ts <= et) {
+                break;
+            }
+            last_time = ts;
+            openmldb::base::Slice data = combine_it->GetValue();
+            if (enable_project) {
+                int8_t* ptr = nullptr;
+                uint32_t size = 0;
+                const auto* row_ptr = reinterpret_cast<const int8_t*>(data.data());
+                if (!row_project.Project(row_ptr, data.size(), &ptr, &size)) {
+                    PDLOG(WARNING, "fail to make a projection");
+                    chunk.set_code(::openmldb::base::ReturnCode::kEncodeError);
+                    chunk.set_msg("fail to encode data rows");
+                    WriteStreamChunk(stream, chunk);
+                    return;
+                }
+                rows.emplace_back(ts, ::openmldb::base::Slice(reinterpret_cast<char*>(ptr), size, true));
+                total_block_size += size;
+            } else {
+                rows.emplace_back(ts, data);
+                total_block_size += data.size();
+            }
+            record_count++;
+            combine_it->Next();
+            if (total_block_size >= FLAGS_stream_scan_chunk_size) {
+                is_finish = false;
+                break;
+            }
+        }
+        chunk.Clear();
+        if (::openmldb::codec::EncodeRows(rows, total_block_size, chunk.mutable_pairs()) == -1) {
+            PDLOG(WARNING, "fail to encode rows");
+            chunk.Clear();
+            chunk.set_code(::openmldb::base::ReturnCode::kEncodeError);
+            chunk.set_msg("fail to encode data rows");
+            WriteStreamChunk(stream, chunk);
+            return;
+        }
+        chunk.set_code(::openmldb::base::ReturnCode::kOk);
+        chunk.set_count(rows.size());
+        chunk.set_is_finish(is_finish && !limit_reached);
+        if (!WriteStreamChunk(stream, chunk)) {
+            return;
+        }
+    }
+}
+
+void TabletImpl::TraverseStream(RpcController* controller, const ::openmldb::api::TraverseRequest* request,
+                                ::openmldb::api::TraverseResponse* response, Closure* done) {
+    brpc::ClosureGuard done_guard(done);
+    std::shared_ptr<Table> table = GetTable(request->tid(), request->pid());
+    if (!table) {
+        PDLOG(WARNING, "table is not exist. tid %u, pid %u", request->tid(), request->pid());
+        response->set_code(::openmldb::base::ReturnCode::kTableIsNotExist);
+        response->set_msg("table is not exist");
+        return;
+    }
+    if (table->GetTableStat() == ::openmldb::storage::kLoading) {
+        PDLOG(WARNING, "table is loading. tid %u, pid %u", request->tid(), request->pid());
+        response->set_code(::openmldb::base::ReturnCode::kTableIsLoading);
+        response->set_msg("table is loading");
+        return;
+    }
+    std::string index_name;
+    if (request->has_idx_name() && !request->idx_name().empty()) {
+        index_name = request->idx_name();
+    } else {
+        index_name = table->GetPkIndex()->GetName();
+    }
+    std::shared_ptr<IndexDef> index_def = table->GetIndex(index_name);
+    if (!index_def || !index_def->IsReady()) {
+        PDLOG(WARNING, "idx name %s not found in table. tid %u, pid %u", index_name.c_str(), request->tid(),
+              request->pid());
+        response->set_code(::openmldb::base::ReturnCode::kIdxNameNotFound);
+        response->set_msg("idx name not found");
+        return;
+    }
+    std::shared_ptr<::openmldb::storage::TableIterator> it(table->NewTraverseIterator(index_def->GetId()));
+    if (!it) {
+        response->set_code(::openmldb::base::ReturnCode::kTsNameNotFound);
+        response->set_msg("create iterator failed");
+        return;
+    }
+    auto* cntl = dynamic_cast<brpc::Controller*>(controller);
+    brpc::StreamId stream;
+    brpc::StreamOptions stream_options;
+    stream_options.max_buf_size = FLAGS_stream_scan_window_size;
+    if (brpc::StreamAccept(&stream, *cntl, &stream_options) != 0) {
+        PDLOG(WARNING, "fail to accept stream. tid %u, pid %u", request->tid(), request->pid());
+        response->set_code(::openmldb::base::ReturnCode::kInvalidParameter);
+        response->set_msg("fail to accept stream");
+        return;
+    }
+    stream_scan_pool_.AddTask(boost::bind(&TabletImpl::StreamTraverse, this, stream,
+                                          std::make_shared<::openmldb::api::TraverseRequest>(*request), table, it));
+    response->set_code(::openmldb::base::ReturnCode::kOk);
+}
+
+void TabletImpl::StreamTraverse(brpc::StreamId stream, std::shared_ptr<::openmldb::api::TraverseRequest> request,
+                                std::shared_ptr<Table> table, std::shared_ptr<::openmldb::storage::TableIterator> it) {
+    absl::Cleanup close_stream = [stream] { brpc::StreamClose(stream); };
+    uint64_t last_time = 0;
+    std::string last_pk;
+    if (request->has_pk() && request->pk().size() > 0) {
+        it->Seek(request->pk(), request->ts());
+        last_pk = request->pk();
+        last_time = request->ts();
+        auto traverse_it = dynamic_cast<::openmldb::storage::TraverseIterator*>(it.get());
+        if (traverse_it && traverse_it->Valid() && request->skip_current_pk() && traverse_it->GetPK() == last_pk) {
+            traverse_it->NextPK();
+        }
+    } else {
+        it->SeekToFirst();
+    }
+    bool remove_duplicated_record = request->enable_remove_duplicated_record();
+    uint32_t limit = request->limit();
+    uint32_t scount = 0;
+    bool is_finish = false;
+    bool limit_reached = false;
+    ::openmldb::api::TraverseResponse chunk;
+    while (!is_finish) {
+        // the rows of a traverse iterator are in the order of pk, so they are encoded in place
+        std::vector<std::pair<std::string, std::pair<uint64_t, openmldb::base::Slice>>> rows;
+        uint32_t total_size = 0;
+        is_finish = true;
+        for (; it->Valid(); it->Next()) {
+            if (limit > 0 && scount >= limit) {
+                limit_reached = true;
+                break;
+            }
+            if (remove_duplicated_record && last_time == it->GetKey() && last_pk == it->GetPK()) {
+                continue;
+            }
+            last_pk = it->GetPK();
+            last_time = it->GetKey();
+            openmldb::base::Slice value = it->GetValue();
+            total_size += 4 + 4 + 8 + last_pk.length() + value.size();
+            rows.emplace_back(last_pk, std::make_pair(last_time, value));
+            scount++;
+            if (total_size >= FLAGS_stream_scan_chunk_size) {
+                it->Next();
+                is_finish = !it->Valid();
+                break;
+            }
+        }
+        chunk.Clear();
+        std::string* pairs = chunk.mutable_pairs();
+        pairs->resize(total_size);
+        char* rbuffer = reinterpret_cast<char*>(&((*pairs)[0]));
+        uint32_t offset = 0;
+        for (const auto& row : rows) {
+            ::openmldb::codec::EncodeFull(row.first, row.second.first, row.second.second.data(),
+                                          row.second.second.size(), rbuffer, offset);
+            offset += (4 + 4 + 8 + row.first.length() + row.second.second.size());
+        }
+        chunk.set_code(::openmldb::base::ReturnCode::kOk);
+        chunk.set_count(rows.size());
+        chunk.set_pk(last_pk);
+        chunk.set_ts(last_time);
+        chunk.set_is_finish(is_finish && !limit_reached);
+        if (!WriteStreamChunk(stream, chunk)) {
+            return;
+        }
+    }
+    DEBUGLOG("traverse stream count %u. tid %u pid %u", scount, request->tid(), request->pid());
+}
+
 void TabletImpl::Delete(RpcController* controller, const ::openmldb::api::DeleteRequest* request,
                         openmldb::api::GeneralResponse* response, Closure* done) {
     brpc::ClosureGuard done_guard(done);
@@ -1686,7 +2181,12 @@ void TabletImpl::ProcessQuery(RpcController* ctrl, const openmldb::api::QueryReq
             }
             session.SetCompileInfo(request_compile_info);
             session.SetSpName(sp_name);
-            RunRequestQuery(ctrl, *request, session, *response, *buf);
+            bool use_result_cache = false;
+            if (deploy_result_cache_ && !request->is_debug() && !request->has_task_id()) {
+                auto sp_info = sp_cache_->FindSpProcedureInfo(db_name, sp_name);
+                use_result_cache = sp_info.ok() && sp_info.value()->GetType() == hybridse::sdk::kReqDeployment;
+            }
+            RunRequestQuery(ctrl, *request, session, *response, *buf, use_result_cache);
         } else {
             bool ok = engine_->Get(request->sql(), request->db(), session, status);
             if (!ok || session.GetCompileInfo() == nullptr) {
@@ -2171,7 +2671,7 @@ void TabletImpl::AppendEntries(RpcController* controller, const ::openmldb::api:
     response->set_code(::openmldb::base::ReturnCode::kOk);
     response->set_msg("ok");
     uint64_t last_log_offset = replicator->GetOffset();
-    if (request->pre_log_index() == 0 && request->entries_size() == 0) {
+    if (request->pre_log_index() == 0 && request->entries_size() == 0 && request->raw_entries_size() == 0) {
         response->set_log_offset(last_log_offset);
         if (!FLAGS_zk_cluster.empty() && request->term() > term) {
             replicator->SetLeaderTerm(request->term());
@@ -2182,10 +2682,33 @@ void TabletImpl::AppendEntries(RpcController* controller, const ::openmldb::api:
         PDLOG(INFO, "first sync log_index! log_offset[%lu] tid[%u] pid[%u]", last_log_offset, tid, pid);
         return;
     }
-    for (int32_t i = 0; i < request->entries_size(); i++) {
-        const auto& entry = request->entries(i);
+    // the leader may pipeline the requests, which arrive on different bthreads. a request waits for the previous
+    // ones and the requests are applied one by one, it is rejected if the gap is not filled in time
+    ::openmldb::replica::ApplyLock apply_lock;
+    if (request->entries_size() > 0 || request->raw_entries_size() > 0) {
+        if (!replicator->LockForApply(request->pre_log_index(), FLAGS_binlog_sync_reorder_wait_ms, &apply_lock)) {
+            last_log_offset = replicator->GetOffset();
+            PDLOG(WARNING, "log index gap. pre_log_index %lu cur log_offset %lu tid %u pid %u",
+                  request->pre_log_index(), last_log_offset, tid, pid);
+            response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
+            response->set_msg("log index gap");
+            response->set_log_offset(last_log_offset);
+            return;
+        }
+        last_log_offset = replicator->GetOffset();
+    }
+    int32_t entry_cnt = request->entries_size() > 0 ? request->entries_size() : request->raw_entries_size();
+    ::openmldb::api::LogEntry raw_entry;
+    for (int32_t i = 0; i < entry_cnt; i++) {
+        if (request->entries_size() == 0 && !raw_entry.ParseFromString(request->raw_entries(i))) {
+            PDLOG(WARNING, "fail to parse raw entry. tid %u pid %u", tid, pid);
+            response->set_code(::openmldb::base::ReturnCode::kFailToAppendEntriesToReplicator);
+            response->set_msg("fail to parse raw entry");
+            return;
+        }
+        const auto& entry = request->entries_size() > 0 ? request->entries(i) : raw_entry;
         if (entry.log_index() <= last_log_offset) {
-            PDLOG(WARNING, "entry log_index %lu cur log_offset %lu tid %u pid %u", request->entries(i).log_index(),
+            PDLOG(WARNING, "entry log_index %lu cur log_offset %lu tid %u pid %u", entry.log_index(),
                     last_log_offset, tid, pid);
             continue;
         }
@@ -2771,6 +3294,7 @@ void TabletImpl::SendSnapshotInternal(const std::string& endpoint, uint32_t tid,
         full_path.append("snapshot/");
         std::string manifest_file = full_path + "MANIFEST";
         std::string snapshot_file;
+        std::vector<std::string> snapshot_files;
         {
             int fd = open(manifest_file.c_str(), O_RDONLY);
             if (fd < 0) {
@@ -2786,11 +3310,19 @@ void TabletImpl::SendSnapshotInternal(const std::string& endpoint, uint32_t tid,
                 break;
             }
             snapshot_file = manifest.name();
+            snapshot_files = ::openmldb::storage::Snapshot::GetSnapshotFiles(manifest);
         }
         if (table->GetStorageMode() == common::kMemory) {
-            // send snapshot file
-            if (sender.SendFile(snapshot_file, full_path + snapshot_file) < 0) {
-                PDLOG(WARNING, "send snapshot failed. tid[%u] pid[%u]", tid, pid);
+            // send snapshot files, a snapshot may be split into parts
+            bool send_ok = true;
+            for (const auto& part_file : snapshot_files) {
+                if (sender.SendFile(part_file, full_path + part_file) < 0) {
+                    PDLOG(WARNING, "send snapshot %s failed. tid[%u] pid[%u]", part_file.c_str(), tid, pid);
+                    send_ok = false;
+                    break;
+                }
+            }
+            if (!send_ok) {
                 break;
             }
         } else {
@@ -3421,7 +3953,7 @@ void TabletImpl::GetTableFollower(RpcController* controller, const ::openmldb::a
         return;
     }
     response->set_offset(replicator->GetOffset());
-    std::map<std::string, uint64_t> info_map;
+    std::map<std::string, ::openmldb::replica::ReplicateInfo> info_map;
     replicator->GetReplicateInfo(info_map);
     if (info_map.empty()) {
         response->set_msg("has no follower");
@@ -3430,7 +3962,9 @@ void TabletImpl::GetTableFollower(RpcController* controller, const ::openmldb::a
     for (const auto& kv : info_map) {
         ::openmldb::api::FollowerInfo* follower_info = response->add_follower_info();
         follower_info->set_endpoint(kv.first);
-        follower_info->set_offset(kv.second);
+        follower_info->set_offset(kv.second.offset);
+        follower_info->set_lag_entries(kv.second.lag_entries);
+        follower_info->set_lag_bytes(kv.second.lag_bytes);
     }
     response->set_msg("ok");
     response->set_code(::openmldb::base::ReturnCode::kOk);
@@ -4129,7 +4663,12 @@ std::shared_ptr<Aggrs> TabletImpl::GetAggregatorsUnLock(uint32_t tid, uint32_t p
 
 bool TabletImpl::UpdateAggrs(uint32_t tid, uint32_t pid, const std::string& value,
                  const ::openmldb::storage::Dimensions& dimensions, uint64_t log_offset) {
-    auto aggrs = GetAggregators(tid, pid);
+    return UpdateAggrs(GetAggregators(tid, pid), tid, pid, value, dimensions, log_offset);
+}
+
+bool TabletImpl::UpdateAggrs(const std::shared_ptr<Aggrs>& aggrs, uint32_t tid, uint32_t pid,
+                             const std::string& value, const ::openmldb::storage::Dimensions& dimensions,
+                             uint64_t log_offset) {
     if (!aggrs) {
         return true;
     }
@@ -4162,10 +4701,78 @@ void TabletImpl::ShowMemPool(RpcController* controller, const ::openmldb::api::H
     tcmalloc->GetStats(buffer, 1024);
     cntl->response_attachment().append("<html><head><title>Mem Stat</title></head><body><pre>");
     cntl->response_attachment().append(stat);
+    AppendSlabStat(&cntl->response_attachment());
     cntl->response_attachment().append("</pre></body></html>");
 #endif
 }
 
+void TabletImpl::ShowEngineStat(RpcController* controller, const ::openmldb::api::HttpRequest* request,
+                                ::openmldb::api::HttpResponse* response, Closure* done) {
+    brpc::ClosureGuard done_guard(done);
+    brpc::Controller* cntl = static_cast<brpc::Controller*>(controller);
+    cntl->http_response().set_content_type("text/plain");
+    uint64_t hit_cnt = 0;
+    uint64_t miss_cnt = 0;
+    ::hybridse::vm::Engine::GetJitObjectCacheStats(&hit_cnt, &miss_cnt);
+    cntl->response_attachment().append(absl::StrCat("jit object cache: hit ", hit_cnt, ", miss ", miss_cnt,
+                                                    ", evict ", ::hybridse::vm::Engine::GetJitObjectCacheEvictCount(),
+                                                    "\n"));
+    std::vector<::hybridse::vm::CompileTimeStats> compile_stats;
+    engine_->GetCompileTimeStats(&compile_stats);
+    cntl->response_attachment().append(absl::StrCat("compile time of ", compile_stats.size(), " sqls\n"));
+    for (const auto& stats : compile_stats) {
+        cntl->response_attachment().append(absl::StrCat("db ", stats.db, " sql ", stats.sql_digest, ": count ",
+                                                        stats.count, ", total ", stats.total_us, "us, max ",
+                                                        stats.max_us, "us, buckets(<1ms, <2ms, <4ms, ...) ",
+                                                        absl::StrJoin(stats.buckets, " "), "\n"));
+    }
+}
+
+void TabletImpl::AppendSlabStat(butil::IOBuf* buf) {
+    std::vector<std::shared_ptr<Table>> tables;
+    {
+        std::lock_guard<SpinMutex> spin_lock(spin_mutex_);
+        for (const auto& tit : tables_) {
+            for (const auto& pit : tit.second) {
+                tables.push_back(pit.second);
+            }
+        }
+    }
+    uint64_t total_byte_size = 0;
+    uint64_t total_used_byte_size = 0;
+    uint64_t total_record_byte_size = 0;
+    std::string table_stat;
+    for (const auto& table : tables) {
+        if (table->GetStorageMode() != common::kMemory) {
+            continue;
+        }
+        MemTable* mem_table = dynamic_cast<MemTable*>(table.get());
+        if (mem_table == nullptr) {
+            continue;
+        }
+        uint64_t byte_size = 0;
+        uint64_t used_byte_size = 0;
+        mem_table->GetSlabByteSize(&byte_size, &used_byte_size);
+        if (byte_size == 0) {
+            continue;
+        }
+        uint64_t record_byte_size = mem_table->GetRecordByteSize() + mem_table->GetRecordIdxByteSize();
+        table_stat.append(absl::StrCat("tid ", table->GetId(), " pid ", table->GetPid(), ": slab ", byte_size,
+                                       " bytes, in use ", used_byte_size, " bytes, record and index ",
+                                       record_byte_size, " bytes\n"));
+        total_byte_size += byte_size;
+        total_used_byte_size += used_byte_size;
+        total_record_byte_size += record_byte_size;
+    }
+    if (total_byte_size == 0) {
+        return;
+    }
+    buf->append("\n------------------------------------------------\n");
+    buf->append(absl::StrCat("MemTable slab: ", total_byte_size, " bytes, in use ", total_used_byte_size,
+                             " bytes, record and index ", total_record_byte_size, " bytes\n"));
+    buf->append(table_stat);
+}
+
 void TabletImpl::CheckZkClient() {
     if (zk_client_) {
         if (!zk_client_->IsConnected()) {
@@ -4319,6 +4926,7 @@ void TabletImpl::RefreshTableInfo() {
     auto old_db_sp_map = catalog_->GetProcedures();
     catalog_->Refresh(table_info_vec, version, db_sp_map);
     // skip exist procedure, don`t need recompile
+    std::vector<std::shared_ptr<hybridse::sdk::ProcedureInfo>> new_sp_infos;
     for (const auto& db_sp_map_kv : db_sp_map) {
         const auto& db = db_sp_map_kv.first;
         auto old_db_sp_map_it = old_db_sp_map.find(db);
@@ -4330,15 +4938,16 @@ void TabletImpl::RefreshTableInfo() {
                 if (old_sp_map_it != old_sp_map.end()) {
                     continue;
                 } else {
-                    CreateProcedure(sp_map_kv.second);
+                    new_sp_infos.push_back(sp_map_kv.second);
                 }
             }
         } else {
             for (const auto& sp_map_kv : db_sp_map_kv.second) {
-                CreateProcedure(sp_map_kv.second);
+                new_sp_infos.push_back(sp_map_kv.second);
             }
         }
     }
+    CreateProcedures(new_sp_infos);
 
     RefreshAggrCatalog();
 }
@@ -4392,16 +5001,20 @@ bool TabletImpl::RefreshAggrCatalog() {
 }
 
 int TabletImpl::CheckDimessionPut(const ::openmldb::api::PutRequest* request, uint32_t idx_cnt) {
-    for (int32_t i = 0; i < request->dimensions_size(); i++) {
-        if (idx_cnt <= request->dimensions(i).idx()) {
+    return CheckDimessionPut(request->dimensions(), idx_cnt);
+}
+
+int TabletImpl::CheckDimessionPut(const ::openmldb::storage::Dimensions& dimensions, uint32_t idx_cnt) {
+    for (const auto& dimension : dimensions) {
+        if (idx_cnt <= dimension.idx()) {
             PDLOG(WARNING,
                   "invalid put request dimensions, request idx %u is greater "
                   "than table idx cnt %u",
-                  request->dimensions(i).idx(), idx_cnt);
+                  dimension.idx(), idx_cnt);
             return -1;
         }
-        if (request->dimensions(i).key().length() <= 0) {
-            PDLOG(WARNING, "invalid put request dimension key is empty with idx %u", request->dimensions(i).idx());
+        if (dimension.key().length() <= 0) {
+            PDLOG(WARNING, "invalid put request dimension key is empty with idx %u", dimension.idx());
             return 1;
         }
     }
@@ -5303,16 +5916,10 @@ void TabletImpl::CreateProcedure(RpcController* controller, const openmldb::api:
         options->emplace(hybridse::vm::LONG_WINDOWS, *long_windows);
     }
 
-    // build for single request
-    ::hybridse::vm::RequestRunSession session;
-    session.SetOptions(options);
-    bool ok = engine_->Get(sql, db_name, session, status);
-    if (!ok || session.GetCompileInfo() == nullptr) {
-        response->set_msg(status.str());
-        response->set_code(::openmldb::base::kSQLCompileError);
-        LOG(WARNING) << "fail to compile sql " << sql << std::endl << status.str();
-        return;
-    }
+    // build for single request in the background while building for batch request
+    auto session = std::make_shared<::hybridse::vm::RequestRunSession>();
+    session->SetOptions(options);
+    auto request_future = engine_->GetAsync(sql, db_name, session);
 
     // build for batch request
     ::hybridse::vm::BatchRequestRunSession batch_session;
@@ -5323,10 +5930,19 @@ void TabletImpl::CreateProcedure(RpcController* controller, const openmldb::api:
             batch_session.AddCommonColumnIdx(i);
         }
     }
-    ok = engine_->Get(sql, db_name, batch_session, status);
-    if (!ok || batch_session.GetCompileInfo() == nullptr) {
+    ::hybridse::base::Status batch_status;
+    bool batch_ok = engine_->Get(sql, db_name, batch_session, batch_status);
+
+    auto request_info = request_future->Wait(&status);
+    if (!request_info) {
         response->set_msg(status.str());
         response->set_code(::openmldb::base::kSQLCompileError);
+        LOG(WARNING) << "fail to compile sql " << sql << std::endl << status.str();
+        return;
+    }
+    if (!batch_ok || batch_session.GetCompileInfo() == nullptr) {
+        response->set_msg(batch_status.str());
+        response->set_code(::openmldb::base::kSQLCompileError);
         LOG(WARNING) << "fail to compile batch request for sql " << sql;
         return;
     }
@@ -5337,14 +5953,14 @@ void TabletImpl::CreateProcedure(RpcController* controller, const openmldb::api:
         LOG(WARNING) << "convert procedure info failed, sp_name: " << sp_name << " db: " << db_name;
         return;
     }
-    ok = catalog_->AddProcedure(db_name, sp_name, sp_info_impl);
+    bool ok = catalog_->AddProcedure(db_name, sp_name, sp_info_impl);
     if (ok) {
         LOG(INFO) << "add procedure " << sp_name << " to catalog with db " << db_name;
     } else {
         LOG(WARNING) << "fail to add procedure " << sp_name << " to catalog with db " << db_name;
     }
 
-    sp_cache_->InsertSQLProcedureCacheEntry(db_name, sp_name, sp_info_impl, session.GetCompileInfo(),
+    sp_cache_->InsertSQLProcedureCacheEntry(db_name, sp_name, sp_info_impl, request_info,
                                             batch_session.GetCompileInfo());
 
     response->set_code(::openmldb::base::ReturnCode::kOk);
@@ -5368,6 +5984,9 @@ void TabletImpl::DropProcedure(RpcController* controller, const ::openmldb::api:
 
     if (is_deployment_procedure) {
         auto collector_key = absl::StrCat(db_name, ".", sp_name);
+        if (deploy_result_cache_) {
+            deploy_result_cache_->DropDeploy(collector_key);
+        }
         auto s = deploy_collector_->DeleteDeploy(collector_key);
         if (!s.ok()) {
             LOG(ERROR) << "[ERROR] delete deploy collector: " << s;
@@ -5382,7 +6001,7 @@ void TabletImpl::DropProcedure(RpcController* controller, const ::openmldb::api:
 
 void TabletImpl::RunRequestQuery(RpcController* ctrl, const openmldb::api::QueryRequest& request,
                                  ::hybridse::vm::RequestRunSession& session, openmldb::api::QueryResponse& response,
-                                 butil::IOBuf& buf) {
+                                 butil::IOBuf& buf, bool use_result_cache) {
     if (request.is_debug()) {
         session.EnableDebug();
     }
@@ -5394,28 +6013,48 @@ void TabletImpl::RunRequestQuery(RpcController* ctrl, const openmldb::api::Query
         response.set_msg("fail to decode input row");
         return;
     }
-    ::hybridse::codec::Row output;
-    int32_t ret = 0;
-    if (request.has_task_id()) {
-        ret = session.Run(request.task_id(), row, &output);
-    } else {
-        ret = session.Run(row, &output);
-    }
-    if (ret != 0) {
-        response.set_code(::openmldb::base::kSQLRunError);
-        response.set_msg("fail to run sql");
-        return;
-    } else if (row.GetRowPtrCnt() != 1) {
-        response.set_code(::openmldb::base::kSQLRunError);
-        response.set_msg("do not support multiple output row slices");
-        return;
+    // the request row of a deployment is encoded in one slice, so its bytes are the key of the cached output
+    std::string deploy_name;
+    std::string cache_key;
+    if (use_result_cache && row.GetRowPtrCnt() == 1) {
+        deploy_name = absl::StrCat(request.db(), ".", request.sp_name());
+        cache_key.assign(reinterpret_cast<const char*>(row.buf()), row.size());
     }
-    size_t buf_total_size;
-    if (!codec::EncodeRpcRow(output, &buf, &buf_total_size)) {
-        response.set_code(::openmldb::base::kSQLRunError);
-        response.set_msg("fail to encode sql output row");
-        return;
+    butil::IOBuf output_buf;
+    if (cache_key.empty() || !deploy_result_cache_->Get(deploy_name, cache_key, &output_buf)) {
+        std::unique_ptr<::openmldb::catalog::ReadKeyRecorder> recorder;
+        if (!cache_key.empty()) {
+            recorder = std::make_unique<::openmldb::catalog::ReadKeyRecorder>();
+        }
+        ::hybridse::codec::Row output;
+        int32_t ret = 0;
+        if (request.has_task_id()) {
+            ret = session.Run(request.task_id(), row, &output);
+        } else {
+            ret = session.Run(row, &output);
+        }
+        if (ret != 0) {
+            response.set_code(::openmldb::base::kSQLRunError);
+            response.set_msg("fail to run sql");
+            return;
+        } else if (row.GetRowPtrCnt() != 1) {
+            response.set_code(::openmldb::base::kSQLRunError);
+            response.set_msg("do not support multiple output row slices");
+            return;
+        }
+        size_t output_size;
+        if (!codec::EncodeRpcRow(output, &output_buf, &output_size)) {
+            response.set_code(::openmldb::base::kSQLRunError);
+            response.set_msg("fail to encode sql output row");
+            return;
+        }
+        // the output row may refer to the request attachment, so the encoded one is cached
+        if (recorder && recorder->IsCacheable()) {
+            deploy_result_cache_->Put(deploy_name, cache_key, output_buf, recorder->TakeReadSlots());
+        }
     }
+    size_t buf_total_size = output_buf.size();
+    buf.append(output_buf);
     if (!request.has_task_id()) {
         response.set_schema(session.GetEncodedSchema());
     }
@@ -5425,44 +6064,59 @@ void TabletImpl::RunRequestQuery(RpcController* ctrl, const openmldb::api::Query
     response.set_code(::openmldb::base::kOk);
 }
 
-void TabletImpl::CreateProcedure(const std::shared_ptr<hybridse::sdk::ProcedureInfo>& sp_info) {
-    const std::string& db_name = sp_info->GetDbName();
-    const std::string& sp_name = sp_info->GetSpName();
-    const std::string& sql = sp_info->GetSql();
-    auto long_windows = sp_info->GetOption(hybridse::vm::LONG_WINDOWS);
-    std::shared_ptr<std::unordered_map<std::string, std::string>> options = nullptr;
-    if (long_windows) {
-        options = std::make_shared<std::unordered_map<std::string, std::string>>();
-        options->emplace(hybridse::vm::LONG_WINDOWS, *long_windows);
-    }
-
-    ::hybridse::base::Status status;
-    // build for single request
-    ::hybridse::vm::RequestRunSession session;
-    session.SetOptions(options);
-    bool ok = engine_->Get(sql, db_name, session, status);
-    if (!ok || session.GetCompileInfo() == nullptr) {
-        LOG(WARNING) << "fail to compile sql " << sql;
-        return;
-    }
-    // build for batch request
-    ::hybridse::vm::BatchRequestRunSession batch_session;
-    batch_session.SetOptions(options);
-    for (auto i = 0; i < sp_info->GetInputSchema().GetColumnCnt(); ++i) {
-        bool is_constant = sp_info->GetInputSchema().IsConstant(i);
-        if (is_constant) {
-            batch_session.AddCommonColumnIdx(i);
+void TabletImpl::CreateProcedures(const std::vector<std::shared_ptr<hybridse::sdk::ProcedureInfo>>& sp_infos) {
+    if (sp_infos.empty()) {
+        return;
+    }
+    // compile all the procedures in parallel, the request and batch request plans of a procedure as well
+    std::vector<std::shared_ptr<::hybridse::vm::CompileFuture>> request_futures;
+    std::vector<std::shared_ptr<::hybridse::vm::CompileFuture>> batch_request_futures;
+    for (const auto& sp_info : sp_infos) {
+        auto long_windows = sp_info->GetOption(hybridse::vm::LONG_WINDOWS);
+        std::shared_ptr<std::unordered_map<std::string, std::string>> options = nullptr;
+        if (long_windows) {
+            options = std::make_shared<std::unordered_map<std::string, std::string>>();
+            options->emplace(hybridse::vm::LONG_WINDOWS, *long_windows);
+        }
+        // build for single request
+        auto session = std::make_shared<::hybridse::vm::RequestRunSession>();
+        session->SetOptions(options);
+        request_futures.push_back(engine_->GetAsync(sp_info->GetSql(), sp_info->GetDbName(), session));
+        // build for batch request
+        auto batch_session = std::make_shared<::hybridse::vm::BatchRequestRunSession>();
+        batch_session->SetOptions(options);
+        for (auto i = 0; i < sp_info->GetInputSchema().GetColumnCnt(); ++i) {
+            bool is_constant = sp_info->GetInputSchema().IsConstant(i);
+            if (is_constant) {
+                batch_session->AddCommonColumnIdx(i);
+            }
         }
-    }
-    ok = engine_->Get(sql, db_name, batch_session, status);
-    if (!ok || batch_session.GetCompileInfo() == nullptr) {
-        LOG(WARNING) << "fail to compile batch request for sql " << sql;
-        return;
-    }
-    sp_cache_->InsertSQLProcedureCacheEntry(db_name, sp_name, sp_info, session.GetCompileInfo(),
-                                            batch_session.GetCompileInfo());
+        batch_request_futures.push_back(engine_->GetAsync(sp_info->GetSql(), sp_info->GetDbName(), batch_session));
+    }
+    uint64_t hit_cnt = 0;
+    uint64_t miss_cnt = 0;
+    for (size_t i = 0; i < sp_infos.size(); i++) {
+        const auto& sp_info = sp_infos[i];
+        const std::string& db_name = sp_info->GetDbName();
+        const std::string& sp_name = sp_info->GetSpName();
+        const std::string& sql = sp_info->GetSql();
+        ::hybridse::base::Status status;
+        auto request_info = request_futures[i]->Wait(&status);
+        if (!request_info) {
+            LOG(WARNING) << "fail to compile sql " << sql << std::endl << status.str();
+            continue;
+        }
+        auto batch_request_info = batch_request_futures[i]->Wait(&status);
+        if (!batch_request_info) {
+            LOG(WARNING) << "fail to compile batch request for sql " << sql;
+            continue;
+        }
+        sp_cache_->InsertSQLProcedureCacheEntry(db_name, sp_name, sp_info, request_info, batch_request_info);
 
-    LOG(INFO) << "refresh procedure success! sp_name: " << sp_name << ", db: " << db_name << ", sql: " << sql;
+        ::hybridse::vm::Engine::GetJitObjectCacheStats(&hit_cnt, &miss_cnt);
+        LOG(INFO) << "refresh procedure success! sp_name: " << sp_name << ", db: " << db_name << ", sql: " << sql
+                  << ", jit object cache hit " << hit_cnt << " miss " << miss_cnt;
+    }
 }
 
 void TabletImpl::GetBulkLoadInfo(RpcController* controller, const ::openmldb::api::BulkLoadInfoRequest* request,
@@ -5810,6 +6464,14 @@ void TabletImpl::GetAndFlushDeployStats(::google::protobuf::RpcController* contr
         new_row->set_count(r.count_);
         new_row->set_total(r.GetTotalAsStr(statistics::TimeUnit::MICRO_SECOND));
     }
+    if (deploy_result_cache_) {
+        for (const auto& kv : deploy_result_cache_->FlushStats()) {
+            auto cache_stat = response->add_cache_stats();
+            cache_stat->set_deploy_name(kv.first);
+            cache_stat->set_hit(kv.second.hit);
+            cache_stat->set_miss(kv.second.miss);
+        }
+    }
     response->set_code(ReturnCode::kOk);
 }
 
@@ -18,6 +18,7 @@
 #define SRC_TABLET_TABLET_IMPL_H_
 
 #include <brpc/server.h>
+#include <brpc/stream.h>
 
 #include <list>
 #include <map>
@@ -41,6 +42,7 @@
 #include "storage/mem_table_snapshot.h"
 #include "tablet/bulk_load_mgr.h"
 #include "tablet/combine_iterator.h"
+#include "tablet/deploy_result_cache.h"
 #include "tablet/file_receiver.h"
 #include "tablet/sp_cache.h"
 #include "vm/engine.h"
@@ -86,6 +88,9 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     void Put(RpcController* controller, const ::openmldb::api::PutRequest* request,
              ::openmldb::api::PutResponse* response, Closure* done);
 
+    void PutBatch(RpcController* controller, const ::openmldb::api::PutBatchRequest* request,
+                  ::openmldb::api::PutBatchResponse* response, Closure* done);
+
     void Get(RpcController* controller, const ::openmldb::api::GetRequest* request,
              ::openmldb::api::GetResponse* response, Closure* done);
 
@@ -101,6 +106,15 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     void Traverse(RpcController* controller, const ::openmldb::api::TraverseRequest* request,
                   ::openmldb::api::TraverseResponse* response, Closure* done);
 
+    void ScanStream(RpcController* controller, const ::openmldb::api::ScanRequest* request,
+                    ::openmldb::api::ScanResponse* response, Closure* done);
+
+    void TraverseStream(RpcController* controller, const ::openmldb::api::TraverseRequest* request,
+                        ::openmldb::api::TraverseResponse* response, Closure* done);
+
+    void MultiGet(RpcController* controller, const ::openmldb::api::MultiGetRequest* request,
+                  ::openmldb::api::MultiGetResponse* response, Closure* done);
+
     void CreateTable(RpcController* controller, const ::openmldb::api::CreateTableRequest* request,
                      ::openmldb::api::CreateTableResponse* response, Closure* done);
 
@@ -168,6 +182,10 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     void ShowMemPool(RpcController* controller, const ::openmldb::api::HttpRequest* request,
                      ::openmldb::api::HttpResponse* response, Closure* done);
 
+    // the jit object cache and the compile time stats of the sql engine in plain text
+    void ShowEngineStat(RpcController* controller, const ::openmldb::api::HttpRequest* request,
+                        ::openmldb::api::HttpResponse* response, Closure* done);
+
     void GetAllSnapshotOffset(RpcController* controller, const ::openmldb::api::EmptyRequest* request,
                               ::openmldb::api::TableSnapshotOffsetResponse* response, Closure* done);
 
@@ -255,12 +273,24 @@ class TabletImpl : public ::openmldb::api::TabletServer {
                       const std::map<int32_t, std::shared_ptr<Schema>>& vers_schema, CombineIterator* combine_it,
                       butil::IOBuf* buf, uint32_t* count, bool* is_finish);
 
+    // push the rows of a streaming scan chunk by chunk and close the stream at last
+    void StreamScanIndex(brpc::StreamId stream, std::shared_ptr<::openmldb::api::ScanRequest> request,
+                         std::map<int32_t, std::shared_ptr<Schema>> vers_schema,
+                         std::shared_ptr<CombineIterator> combine_it);
+
+    void StreamTraverse(brpc::StreamId stream, std::shared_ptr<::openmldb::api::TraverseRequest> request,
+                        std::shared_ptr<Table> table, std::shared_ptr<::openmldb::storage::TableIterator> it);
+
     int32_t CountIndex(uint64_t expire_time, uint64_t expire_cnt, ::openmldb::storage::TTLType ttl_type,
                        ::openmldb::storage::TableIterator* it, const ::openmldb::api::CountRequest* request,
                        uint32_t* count);
 
     std::shared_ptr<Table> GetTable(uint32_t tid, uint32_t pid);
 
+    // create the iterators of the partitions to scan, set the response if failed
+    bool GetScanIterators(const ::openmldb::api::ScanRequest* request, std::vector<QueryIt>* query_its,
+                          ::openmldb::storage::TTLSt* expired_value, ::openmldb::api::ScanResponse* response);
+
     void CreateProcedure(RpcController* controller, const openmldb::api::CreateProcedureRequest* request,
                          openmldb::api::GeneralResponse* response, Closure* done);
 
@@ -377,6 +407,8 @@ class TabletImpl : public ::openmldb::api::TabletServer {
 
     int CheckDimessionPut(const ::openmldb::api::PutRequest* request, uint32_t idx_cnt);
 
+    int CheckDimessionPut(const ::openmldb::storage::Dimensions& dimensions, uint32_t idx_cnt);
+
     // sync log data from page cache to disk
     void SchedSyncDisk(uint32_t tid, uint32_t pid);
 
@@ -417,6 +449,12 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     bool UpdateAggrs(uint32_t tid, uint32_t pid, const std::string& value,
                      const ::openmldb::storage::Dimensions& dimensions, uint64_t log_offset);
 
+    // append the memory used by segment slabs of memory tables
+    void AppendSlabStat(butil::IOBuf* buf);
+
+    bool UpdateAggrs(const std::shared_ptr<Aggrs>& aggrs, uint32_t tid, uint32_t pid, const std::string& value,
+                     const ::openmldb::storage::Dimensions& dimensions, uint64_t log_offset);
+
     bool CreateAggregatorInternal(const ::openmldb::api::CreateAggregatorRequest* request,
                                   std::string& msg); //NOLINT
 
@@ -431,11 +469,14 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     // collect deploy statistics into memory
     void TryCollectDeployStats(const std::string& db, const std::string& name, absl::Time start_time);
 
+    // the output of a deployment is looked up in the deploy result cache first if `use_result_cache` is set
     void RunRequestQuery(RpcController* controller, const openmldb::api::QueryRequest& request,
-                         ::hybridse::vm::RequestRunSession& session,                  // NOLINT
-                         openmldb::api::QueryResponse& response, butil::IOBuf& buf);  // NOLINT
+                         ::hybridse::vm::RequestRunSession& session,                 // NOLINT
+                         openmldb::api::QueryResponse& response, butil::IOBuf& buf,  // NOLINT
+                         bool use_result_cache = false);
 
-    void CreateProcedure(const std::shared_ptr<hybridse::sdk::ProcedureInfo>& sp_info);
+    // compile the procedures on the background compiling threads of the engine
+    void CreateProcedures(const std::vector<std::shared_ptr<hybridse::sdk::ProcedureInfo>>& sp_infos);
 
     // refresh the pre-aggr tables info
     bool RefreshAggrCatalog();
@@ -453,6 +494,8 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     ThreadPool task_pool_;
     ThreadPool io_pool_;
     ThreadPool snapshot_pool_;
+    // push the rows of the streaming scans, a task waits if the client does not consume the stream
+    ThreadPool stream_scan_pool_;
     std::map<uint64_t, std::list<std::shared_ptr<::openmldb::api::TaskInfo>>> task_map_;
     std::set<std::string> sync_snapshot_set_;
     std::map<std::string, std::shared_ptr<FileReceiver>> file_receiver_map_;
@@ -480,6 +523,8 @@ class TabletImpl : public ::openmldb::api::TabletServer {
     std::shared_ptr<std::map<std::string, std::string>> global_variables_;
 
     std::unique_ptr<openmldb::statistics::DeployQueryTimeCollector> deploy_collector_;
+    // null unless enable_deploy_result_cache is set
+    std::unique_ptr<DeployResultCache> deploy_result_cache_;
 };
 
 }  // namespace tablet
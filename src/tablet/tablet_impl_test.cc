@@ -1816,6 +1816,116 @@ TEST_P(TabletImplTest, Scan) {
     ASSERT_EQ(1, (signed)srp.count());
 }
 
+TEST_P(TabletImplTest, MultiGetKeys) {
+    ::openmldb::common::StorageMode storage_mode = GetParam();
+    TabletImpl tablet;
+    uint32_t id = counter++;
+    tablet.Init("");
+    ASSERT_EQ(0, CreateDefaultTable("", "t0", id, 1, 0, 0, kAbsoluteTime, storage_mode, &tablet));
+    MockClosure closure;
+    for (int i = 0; i < 3; i++) {
+        std::string key = "test" + std::to_string(i);
+        for (int j = 0; j <= i; j++) {
+            ::openmldb::api::PutRequest prequest;
+            PackDefaultDimension(key, &prequest);
+            prequest.set_time(9527 + j);
+            prequest.set_value(::openmldb::test::EncodeKV(key, "value" + std::to_string(j)));
+            prequest.set_tid(id);
+            prequest.set_pid(1);
+            ::openmldb::api::PutResponse presponse;
+            tablet.Put(NULL, &prequest, &presponse, &closure);
+            ASSERT_EQ(0, presponse.code());
+        }
+    }
+    ::openmldb::api::MultiGetRequest request;
+    request.set_tid(id);
+    request.set_pid(1);
+    for (const std::string key : {"test0", "test1", "test2", "test3"}) {
+        auto* multi_get_key = request.add_keys();
+        multi_get_key->set_pk(key);
+        multi_get_key->set_limit(2);
+    }
+    ::openmldb::api::MultiGetResponse response;
+    brpc::Controller cntl;
+    tablet.MultiGet(&cntl, &request, &response, &closure);
+    ASSERT_EQ(0, response.code());
+    ASSERT_EQ(4, response.results_size());
+    std::vector<uint32_t> counts = {1, 2, 2, 0};
+    std::vector<bool> finishes = {true, true, false, true};
+    butil::IOBuf& buf = cntl.response_attachment();
+    for (int i = 0; i < 4; i++) {
+        const auto& result = response.results(i);
+        ASSERT_EQ(0, result.code());
+        ASSERT_EQ(counts[i], result.count());
+        ASSERT_EQ(finishes[i], result.is_finish());
+        auto scan_response = std::make_shared<::openmldb::api::ScanResponse>();
+        buf.cutn(scan_response->mutable_pairs(), result.byte_size());
+        ::openmldb::base::ScanKvIterator it("test" + std::to_string(i), scan_response);
+        uint64_t ts = 9527 + i;
+        for (uint32_t k = 0; k < counts[i]; k++) {
+            ASSERT_TRUE(it.Valid());
+            ASSERT_EQ(ts - k, it.GetKey());
+            it.Next();
+        }
+        ASSERT_FALSE(it.Valid());
+    }
+    ASSERT_EQ(0u, buf.size());
+}
+
+
+TEST_P(TabletImplTest, PutBatch) {
+    ::openmldb::common::StorageMode storage_mode = GetParam();
+    TabletImpl tablet;
+    uint32_t id = counter++;
+    tablet.Init("");
+    ASSERT_EQ(0, CreateDefaultTable("", "t0", id, 1, 0, 0, kAbsoluteTime, storage_mode, &tablet));
+    MockClosure closure;
+    ::openmldb::api::PutBatchRequest prequest;
+    prequest.set_tid(id);
+    prequest.set_pid(1);
+    for (int i = 0; i < 10; i++) {
+        auto row = prequest.add_rows();
+        row->set_time(9527 + i);
+        row->set_value(::openmldb::test::EncodeKV("test1", "value" + std::to_string(i)));
+        auto dimension = row->add_dimensions();
+        dimension->set_key(i % 2 == 0 ? "test1" : "test2");
+        dimension->set_idx(0);
+    }
+    // the row with empty key is rejected alone
+    auto row = prequest.add_rows();
+    row->set_time(9527);
+    row->set_value(::openmldb::test::EncodeKV("test1", "value"));
+    auto dimension = row->add_dimensions();
+    dimension->set_key("");
+    dimension->set_idx(0);
+    ::openmldb::api::PutBatchResponse presponse;
+    tablet.PutBatch(NULL, &prequest, &presponse, &closure);
+    ASSERT_EQ(::openmldb::base::ReturnCode::kPutFailed, presponse.code());
+    ASSERT_EQ(11, presponse.row_code_size());
+    for (int i = 0; i < 10; i++) {
+        ASSERT_EQ(0, presponse.row_code(i));
+    }
+    ASSERT_EQ(::openmldb::base::ReturnCode::kInvalidDimensionParameter, presponse.row_code(10));
+
+    ::openmldb::api::ScanRequest sr;
+    sr.set_tid(id);
+    sr.set_pid(1);
+    sr.set_pk("test1");
+    sr.set_st(9600);
+    sr.set_et(0);
+    ::openmldb::api::ScanResponse srp;
+    tablet.Scan(NULL, &sr, &srp, &closure);
+    ASSERT_EQ(0, srp.code());
+    ASSERT_EQ(5, (signed)srp.count());
+    sr.set_pk("test2");
+    tablet.Scan(NULL, &sr, &srp, &closure);
+    ASSERT_EQ(0, srp.code());
+    ASSERT_EQ(5, (signed)srp.count());
+
+    prequest.set_tid(id + 10000);
+    tablet.PutBatch(NULL, &prequest, &presponse, &closure);
+    ASSERT_EQ(::openmldb::base::ReturnCode::kTableIsNotExist, presponse.code());
+}
 
 TEST_P(TabletImplTest, GCWithUpdateLatest) {
     ::openmldb::common::StorageMode storage_mode = GetParam();